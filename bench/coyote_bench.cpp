@@ -0,0 +1,497 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**Offline microbenchmarks for the serialization layer.
+ * Everything here runs against canned payloads, no Coyote unit or network involved.
+ * Allocation counts come from the operator new override below. msgpack zones grab their chunks with malloc,
+ * so zone growth isn't in the count, but every std::string, map node and Coyote::Object is.**/
+
+#define MSGPACK_DEFAULT_API_VERSION 2
+#include "msgpack.hpp"
+
+#include "include/common.h"
+#include "include/datastructures.h"
+#include "msgpackproc.h"
+#include "compactwire.h"
+#include "pools.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+static std::atomic<uint64_t> NumAllocs { 0u };
+
+void *operator new(size_t Size)
+{
+	NumAllocs.fetch_add(1u, std::memory_order_relaxed);
+
+	void *const RetVal = malloc(Size ? Size : 1u);
+
+	if (!RetVal) throw std::bad_alloc();
+
+	return RetVal;
+}
+
+void operator delete(void *Ptr) noexcept
+{
+	free(Ptr);
+}
+
+void operator delete(void *Ptr, size_t) noexcept
+{
+	free(Ptr);
+}
+
+struct BenchCase
+{
+	std::string Name;
+	size_t BytesPerIter; //Size of the wire payload, for throughput. Zero if it doesn't make sense.
+	std::function<void(void)> Body;
+};
+
+template <typename T>
+static inline void DoNotOptimize(const T &Value)
+{
+	asm volatile("" : : "g"(&Value) : "memory");
+}
+
+static void RunCase(const BenchCase &Case, const uint64_t MinMS)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	Case.Body(); //Warm up pools and static lookup tables
+
+	uint64_t Iterations = 1u;
+	uint64_t TotalIters = 0u;
+	uint64_t TotalAllocs = 0u;
+	Clock::duration Elapsed {};
+
+	while (std::chrono::duration_cast<std::chrono::milliseconds>(Elapsed).count() < static_cast<int64_t>(MinMS))
+	{
+		const uint64_t AllocsBefore = NumAllocs.load(std::memory_order_relaxed);
+		const Clock::time_point Start = Clock::now();
+
+		for (uint64_t Inc = 0u; Inc < Iterations; ++Inc)
+		{
+			Case.Body();
+		}
+
+		Elapsed += Clock::now() - Start;
+		TotalAllocs += NumAllocs.load(std::memory_order_relaxed) - AllocsBefore;
+		TotalIters += Iterations;
+
+		if (Iterations < (1u << 20)) Iterations *= 2u;
+	}
+
+	const double NSPerIter = std::chrono::duration<double, std::nano>(Elapsed).count() / TotalIters;
+	const double AllocsPerIter = static_cast<double>(TotalAllocs) / TotalIters;
+
+	char Line[256];
+
+	if (Case.BytesPerIter)
+	{
+		const double MiBPerSec = (Case.BytesPerIter / (1024.0 * 1024.0)) / (NSPerIter / 1e9);
+		snprintf(Line, sizeof Line, "%-40s %10llu iters %14.1f ns/op %10.1f MiB/s %12.1f allocs/op", Case.Name.c_str(), (unsigned long long)TotalIters, NSPerIter, MiBPerSec, AllocsPerIter);
+	}
+	else
+	{
+		snprintf(Line, sizeof Line, "%-40s %10llu iters %14.1f ns/op %16s %12.1f allocs/op", Case.Name.c_str(), (unsigned long long)TotalIters, NSPerIter, "", AllocsPerIter);
+	}
+
+	std::cout << Line << std::endl;
+}
+
+//Payload builders
+static Coyote::PresetMark MakeMark(const int32_t ID)
+{
+	Coyote::PresetMark Mark;
+
+	Mark.ID = ID;
+	Mark.TimeMS = ID * 1000;
+	Mark.Name = "Mark " + std::to_string(ID);
+
+	return Mark;
+}
+
+static Coyote::Preset MakePreset(const size_t NumCanvases)
+{
+	Coyote::Preset P {};
+
+	P.PK = 1;
+	P.Name = "Benchmark preset";
+	P.Notes = "Some notes that an operator typed in during rehearsal.";
+	P.Color = "#3070C0";
+	P.Loop = 1;
+	P.Volume = { 100, 100, 100, 100, 100, 100, 100, 100 };
+	P.SinkOptions = { { "kona", "1" } };
+
+	for (int32_t Inc = 1; Inc <= 50; ++Inc)
+	{
+		P.Gotos.emplace(Inc, MakeMark(Inc));
+		P.Countdowns.emplace(Inc, MakeMark(Inc + 50));
+	}
+
+	for (size_t Inc = 0u; Inc < NumCanvases; ++Inc)
+	{
+		Coyote::CanvasInfo Canvas {};
+
+		Canvas.Index = Inc + 1;
+		Canvas.SinkTypes = Coyote::COYOTE_SINK_KONA;
+		Canvas.CanvasCfg = Coyote::ProjectorCanvasConfig{ Coyote::CanvasOrientation{ Coyote::CanvasOrientationEnum::Standard }, Coyote::Size2D{ 1920, 1080 }, 1 };
+
+		for (int Asset = 0; Asset < 4; ++Asset)
+		{
+			Coyote::PinnedAsset Pinned {};
+
+			Pinned.FullPath = "/Volumes/Media/Show/Canvas" + std::to_string(Inc) + "/clip" + std::to_string(Asset) + ".mov";
+			Pinned.Hue = Pinned.Saturation = Pinned.Brightness = Pinned.Contrast = 1.0f;
+
+			Canvas.Assets.emplace_back(std::move(Pinned));
+		}
+
+		P.Canvases.emplace_back(std::move(Canvas));
+		P.TabDisplayOrder.emplace(std::to_string(Inc), Coyote::TabOrdering{ "Tab" + std::to_string(Inc), static_cast<int32_t>(Inc) });
+	}
+
+	return P;
+}
+
+static std::vector<Coyote::Asset> MakeAssets(const size_t Count)
+{
+	std::vector<Coyote::Asset> RetVal;
+	RetVal.reserve(Count);
+
+	for (size_t Inc = 0u; Inc < Count; ++Inc)
+	{
+		Coyote::Asset A {};
+
+		A.FullPath = "/Volumes/Media/Library/Folder" + std::to_string(Inc / 100) + "/asset_" + std::to_string(Inc) + ".mov";
+		A.Checksum = "d41d8cd98f00b204e9800998ecf8427e";
+		A.LastModified = 1650000000 + Inc;
+		A.TotalSize = A.CurrentSize = 1024 * 1024 * 512;
+		A.Status = Coyote::COYOTE_ASSETSTATE_READY;
+
+		RetVal.emplace_back(std::move(A));
+	}
+
+	return RetVal;
+}
+
+static Coyote::TimeCode MakeTimeCode(void)
+{
+	Coyote::TimeCode TC {};
+
+	TC.PK = 1;
+	TC.Time = 123456;
+	TC.VUData.resize(32);
+
+	for (size_t Inc = 0u; Inc < TC.VUData.size(); ++Inc) TC.VUData[Inc] = -(int32_t)(Inc * 3);
+
+	return TC;
+}
+
+static Coyote::KonaHardwareState MakeHWState(void)
+{
+	Coyote::KonaHardwareState HW {};
+
+	HW.Resolutions = { { Coyote::COYOTE_RES_1080P, Coyote::COYOTE_RES_1080P, Coyote::COYOTE_RES_2160P, Coyote::COYOTE_RES_INVALID } };
+	HW.RefreshRate = Coyote::COYOTE_REFRESH_59_94;
+	HW.HDRMode = Coyote::COYOTE_HDR_DISABLED;
+	HW.EOTFSetting = Coyote::COYOTE_EOTF_NORMAL;
+	HW.AudioConfig = Coyote::COYOTE_KAC_SDI1;
+	HW.ConstLumin = false;
+
+	return HW;
+}
+
+//Wire helpers, these build the exact bytes a server would send us.
+static std::string MakeSubscriptionEvent(const char *EventName, const msgpack::object &Data)
+{
+	msgpack::sbuffer Buffer;
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+	Pack.pack_map(2);
+	Pack.pack(std::string{"SubscriptionEvent"});
+	Pack.pack(std::string{EventName});
+	Pack.pack(std::string{"Data"});
+	Pack.pack(Data);
+
+	return std::string(Buffer.data(), Buffer.size());
+}
+
+static std::string PackToWire(const Coyote::Object &Obj)
+{
+	msgpack::zone TempZone;
+	msgpack::sbuffer Buffer;
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+	Pack.pack(MsgpackProc::PackCoyoteObject(&Obj, TempZone));
+
+	return std::string(Buffer.data(), Buffer.size());
+}
+
+template <typename T>
+static BenchCase MakePackCase(const std::string &Name, const T &Obj)
+{
+	const size_t WireSize = PackToWire(Obj).size();
+
+	return BenchCase { Name, WireSize, [Obj] (void)
+		{
+			POOLED_ZONE(TempZone);
+			POOLED_SBUFFER(Buffer);
+			msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+			Pack.pack(MsgpackProc::PackCoyoteObject(&Obj, TempZone));
+
+			DoNotOptimize(Buffer.size());
+		} };
+}
+
+template <typename T>
+static BenchCase MakeUnpackCase(const std::string &Name, const char *EventName, const T &Obj)
+{ //Full incoming path, header decode plus object conversion, same as the subscription handlers do it.
+	msgpack::zone TempZone;
+	const std::string Wire = MakeSubscriptionEvent(EventName, MsgpackProc::PackCoyoteObject(&Obj, TempZone));
+
+	return BenchCase { Name, Wire.size(), [Wire] (void)
+		{
+			POOLED_ZONE(TempZone);
+
+			const std::unordered_map<std::string, msgpack::object> &Values = MsgpackProc::InitIncomingMsg(Wire.data(), Wire.size(), TempZone);
+
+			std::unique_ptr<Coyote::Object> Result { MsgpackProc::UnpackCoyoteObject(Values.at("Data"), typeid(T)) };
+
+			DoNotOptimize(Result);
+		} };
+}
+
+static BenchCase MakeAssetPackCase(const size_t Count)
+{
+	const std::vector<Coyote::Asset> Assets = MakeAssets(Count);
+
+	auto Body = [Assets] (msgpack::packer<msgpack::sbuffer> &Pack, msgpack::zone &TempZone)
+	{
+		Pack.pack_array(Assets.size());
+
+		for (const Coyote::Asset &A : Assets)
+		{
+			Pack.pack(MsgpackProc::PackCoyoteObject(&A, TempZone));
+		}
+	};
+
+	msgpack::zone SizeZone;
+	msgpack::sbuffer SizeBuffer;
+	msgpack::packer<msgpack::sbuffer> SizePack { SizeBuffer };
+	Body(SizePack, SizeZone);
+
+	return BenchCase { "pack/AssetSync/" + std::to_string(Count), SizeBuffer.size(), [Body] (void)
+		{
+			POOLED_ZONE(TempZone);
+			POOLED_SBUFFER(Buffer);
+			msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+			Body(Pack, TempZone);
+
+			DoNotOptimize(Buffer.size());
+		} };
+}
+
+static std::string MakeCompactSubscriptionEvent(const char *EventName, const msgpack::object &Data)
+{ //What a server that negotiated compact-v1 would send.
+	msgpack::sbuffer Buffer;
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+	Pack.pack_map(2);
+	CompactWire::PackKey(Pack, WireSchema::WireKey::SubscriptionEvent);
+	Pack.pack(std::string{EventName});
+	CompactWire::PackKey(Pack, WireSchema::WireKey::Data);
+	CompactWire::PackObject(Pack, Data, WireSchema::NumWireKeys);
+
+	return std::string(Buffer.data(), Buffer.size());
+}
+
+static BenchCase MakeAssetUnpackCase(const size_t Count, const bool Compact)
+{
+	const std::vector<Coyote::Asset> Assets = MakeAssets(Count);
+
+	msgpack::zone TempZone;
+	std::vector<msgpack::object> Objects;
+	Objects.reserve(Assets.size());
+
+	for (const Coyote::Asset &A : Assets) Objects.emplace_back(MsgpackProc::PackCoyoteObject(&A, TempZone));
+
+	const msgpack::object Data { Objects, TempZone };
+	const std::string Wire = Compact ? MakeCompactSubscriptionEvent("AssetSync", Data) : MakeSubscriptionEvent("AssetSync", Data);
+
+	return BenchCase { "unpack/AssetSync/" + std::to_string(Count) + (Compact ? "/compact" : ""), Wire.size(), [Wire] (void)
+		{
+			POOLED_ZONE(TempZone);
+
+			const std::unordered_map<std::string, msgpack::object> &Values = MsgpackProc::InitIncomingMsg(Wire.data(), Wire.size(), TempZone);
+
+			std::vector<msgpack::object> AssetObjects;
+			Values.at("Data").convert(AssetObjects);
+
+			std::unordered_map<std::string, Coyote::Asset> Out;
+
+			for (const msgpack::object &Obj : AssetObjects)
+			{
+				std::unique_ptr<Coyote::Asset> Item { static_cast<Coyote::Asset*>(MsgpackProc::UnpackCoyoteObject(Obj, typeid(Coyote::Asset))) };
+
+				Out.emplace(Item->FullPath, std::move(*Item));
+			}
+
+			DoNotOptimize(Out);
+		} };
+}
+
+static std::vector<BenchCase> BuildCases(void)
+{
+	std::vector<BenchCase> Cases;
+
+	for (size_t NumCanvases : { 1u, 2u, 4u, 8u })
+	{
+		const Coyote::Preset P = MakePreset(NumCanvases);
+
+		Cases.emplace_back(MakePackCase("pack/Preset/" + std::to_string(NumCanvases) + "canvas", P));
+		Cases.emplace_back(MakeUnpackCase("unpack/Preset/" + std::to_string(NumCanvases) + "canvas", "PresetsUpdate", P));
+	}
+
+	for (size_t Count : { 1000u, 10000u, 100000u })
+	{
+		Cases.emplace_back(MakeAssetPackCase(Count));
+		Cases.emplace_back(MakeAssetUnpackCase(Count, false));
+		Cases.emplace_back(MakeAssetUnpackCase(Count, true));
+	}
+
+	Cases.emplace_back(MakePackCase("pack/TimeCode/VU32", MakeTimeCode()));
+	Cases.emplace_back(MakeUnpackCase("unpack/TimeCode/VU32", "TimeCode", MakeTimeCode()));
+
+	Cases.emplace_back(MakePackCase("pack/KonaHardwareState", MakeHWState()));
+	Cases.emplace_back(MakeUnpackCase("unpack/KonaHardwareState", "KonaHardwareStateUpdate", MakeHWState()));
+
+	Cases.emplace_back(BenchCase { "pack/CommandHeader/NoData", 0u, [] (void)
+		{
+			POOLED_SBUFFER(Buffer);
+			msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+			MsgpackProc::InitOutgoingMsg(Pack, "GetAssets", 42u);
+
+			DoNotOptimize(Buffer.size());
+		} });
+
+	Cases.emplace_back(BenchCase { "pack/CommandHeader/SmallData", 0u, [] (void)
+		{ //What a typical setter like SeekTo looks like on the wire.
+			POOLED_ZONE(TempZone);
+			POOLED_SBUFFER(Buffer);
+			msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+			const int32_t PK = 7;
+			const uint32_t TimeIndex = 1500;
+
+			std::unordered_map<std::string, msgpack::object> Values { { "PK", msgpack::object{ PK, TempZone } }, { "TimeIndex", msgpack::object{ TimeIndex, TempZone } } };
+			const msgpack::object Args { Values, TempZone };
+
+			MsgpackProc::InitOutgoingMsg(Pack, "SeekTo", 42u, &Args);
+
+			DoNotOptimize(Buffer.size());
+		} });
+
+	Cases.emplace_back(BenchCase { "pack/CommandHeader/SmallData/compact", 0u, [] (void)
+		{
+			POOLED_ZONE(TempZone);
+			POOLED_SBUFFER(Buffer);
+			msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+			const int32_t PK = 7;
+			const uint32_t TimeIndex = 1500;
+
+			std::unordered_map<std::string, msgpack::object> Values { { "PK", msgpack::object{ PK, TempZone } }, { "TimeIndex", msgpack::object{ TimeIndex, TempZone } } };
+			const msgpack::object Args { Values, TempZone };
+
+			MsgpackProc::InitOutgoingMsg(Pack, "SeekTo", 42u, &Args, WireSchema::NumWireKeys);
+
+			DoNotOptimize(Buffer.size());
+		} });
+
+	{ //Synchronous reply header decode, the other half of every command round trip.
+		msgpack::zone TempZone;
+		msgpack::sbuffer Buffer;
+		msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+
+		Pack.pack_map(4);
+		Pack.pack(std::string{"CommandName"});
+		Pack.pack(std::string{"SeekTo"});
+		Pack.pack(std::string{"CoyoteAPIVersion"});
+		Pack.pack(std::string{COYOTE_API_VERSION});
+		Pack.pack(std::string{"MsgID"});
+		Pack.pack(uint64_t{42u});
+		Pack.pack(std::string{"StatusInt"});
+		Pack.pack(int{Coyote::COYOTE_STATUS_OK});
+
+		const std::string Wire(Buffer.data(), Buffer.size());
+
+		Cases.emplace_back(BenchCase { "unpack/CommandReply/NoData", Wire.size(), [Wire] (void)
+			{
+				POOLED_ZONE(TempZone);
+				uint64_t MsgID = 0u;
+
+				const std::unordered_map<std::string, msgpack::object> &Values = MsgpackProc::InitIncomingMsg(Wire.data(), Wire.size(), TempZone, &MsgID);
+
+				DoNotOptimize(Values);
+				DoNotOptimize(MsgID);
+			} });
+	}
+
+	return Cases;
+}
+
+int main(const int argc, const char **argv)
+{
+	std::string Filter;
+	uint64_t MinMS = 500u;
+
+	for (int Inc = 1; Inc < argc; ++Inc)
+	{
+		if (!strncmp(argv[Inc], "--min-ms=", sizeof "--min-ms=" - 1))
+		{
+			MinMS = strtoull(argv[Inc] + sizeof "--min-ms=" - 1, nullptr, 10);
+		}
+		else if (!strcmp(argv[Inc], "--help"))
+		{
+			std::cout << "Usage: " << argv[0] << " [substring filter] [--min-ms=N]" << std::endl;
+			return 0;
+		}
+		else
+		{
+			Filter = argv[Inc];
+		}
+	}
+
+	const std::vector<BenchCase> &Cases = BuildCases();
+
+	for (const BenchCase &Case : Cases)
+	{
+		if (!Filter.empty() && Case.Name.find(Filter) == std::string::npos) continue;
+
+		RunCase(Case, MinMS);
+	}
+
+	return 0;
+}
@@ -18,6 +18,7 @@
 #include "../src/include/datastructures.h"
 #include "../src/include/session.h"
 #include "../src/include/easycanvasalign.h"
+#include "../src/wireschema.h"
 #include <stddef.h>
 #include <stdint.h>
 #include "pybind11/include/pybind11/pybind11.h"
@@ -35,10 +36,11 @@ namespace py = pybind11;
 
 #define EMEMDEF(a) .value(#a, Coyote::a)
 #define ECMEMDEF(a, b) .value(#b, Coyote::a::b)
+#define SCHEMAMEMDEF(a, ...) EMEMDEF(a)
 
 static void PBEventFunc(const Coyote::PlaybackEventType EType, const int32_t PK, const int32_t Time, void *const Pass_);
 static void StateEventFunc(const Coyote::StateEventType EType, void *const Pass_);
-static void MiniviewEventFunc(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Coyote::Size2D &Dimensions, std::vector<uint8_t> Bytes, void *const Pass_);
+static void MiniviewEventFunc(const Coyote::MiniviewFrame &Frame, void *const Pass_);
 static std::string PyResolutionMap(const Coyote::ResolutionMode Res);
 static std::string PyRefreshMap(const Coyote::RefreshMode Res);
 static Coyote::Size2D PyResolutionSizeMap(const Coyote::ResolutionMode Res);
@@ -49,30 +51,12 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	.def(py::init<>());
 
 	py::enum_<Coyote::RefreshMode>(ModObj, "RefreshMode")
-	EMEMDEF(COYOTE_REFRESH_INVALID)
-	EMEMDEF(COYOTE_REFRESH_23_98)
-	EMEMDEF(COYOTE_REFRESH_24)
-	EMEMDEF(COYOTE_REFRESH_25)
-	EMEMDEF(COYOTE_REFRESH_29_97)
-	EMEMDEF(COYOTE_REFRESH_30)
-	EMEMDEF(COYOTE_REFRESH_50)
-	EMEMDEF(COYOTE_REFRESH_59_94)
-	EMEMDEF(COYOTE_REFRESH_60)
+	COYOTE_REFRESH_SCHEMA(SCHEMAMEMDEF)
 	EMEMDEF(COYOTE_REFRESH_MAX)
 	.export_values();
 
 	py::enum_<Coyote::ResolutionMode>(ModObj, "ResolutionMode")
-	EMEMDEF(COYOTE_RES_INVALID)
-	EMEMDEF(COYOTE_RES_720P)
-	EMEMDEF(COYOTE_RES_1080P)
-	EMEMDEF(COYOTE_RES_1080PSF)
-	EMEMDEF(COYOTE_RES_2160P)
-	EMEMDEF(COYOTE_RES_2160PSF)
-	EMEMDEF(COYOTE_RES_DCI_2048)
-	EMEMDEF(COYOTE_RES_DCI_2048PSF)
-	EMEMDEF(COYOTE_RES_DCI_4096)
-	EMEMDEF(COYOTE_RES_DCI_4096PSF)
-	EMEMDEF(COYOTE_RES_1080I)
+	COYOTE_RESOLUTION_SCHEMA(SCHEMAMEMDEF)
 	EMEMDEF(COYOTE_RES_MAX)
 	.export_values();
 
@@ -219,34 +203,31 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	ECMEMDEF(CanvasOrientationEnum, Custom)
 	.export_values();
 
+	py::enum_<Coyote::MarkType>(ModObj, "MarkType")
+	EMEMDEF(COYOTE_MARK_GOTO)
+	EMEMDEF(COYOTE_MARK_COUNTDOWN)
+	.export_values();
+
+	py::enum_<Coyote::MarkEditAction>(ModObj, "MarkEditAction")
+	EMEMDEF(COYOTE_MARKEDIT_CREATE)
+	EMEMDEF(COYOTE_MARKEDIT_RENAME)
+	EMEMDEF(COYOTE_MARKEDIT_DELETE)
+	.export_values();
+
 	py::class_<Coyote::NetworkInfo, Coyote::Object>(ModObj, "NetworkInfo")
 	.def("__repr__", [] (Coyote::NetworkInfo &Obj) { return std::string{"<NetworkInfo, CableConnected: "} + (Obj.CableConnected ? "True" : "False") + ", IP: " + Obj.IP.c_str() + ", Subnet: " + Obj.Subnet.c_str() + ">"; })
 	.def(py::init<>())
-	ACLASSD(NetworkInfo, IP)
-	ACLASSD(NetworkInfo, Subnet)
-	ACLASSD(NetworkInfo, AdapterID)
-	ACLASSD(NetworkInfo, CableConnected);
+	COYOTE_NETWORKINFO_FIELDS(ACLASSD);
 	
 	py::class_<Coyote::LicensingStatus, Coyote::Object>(ModObj, "LicensingStatus")
 	.def("__repr__", [] (Coyote::LicensingStatus &Obj) { return std::string{"<LicensingStatus, Valid: "} + (Obj.ValidLicense ? "True" : "False") + ", Product: " + Obj.ProductName + ", Key: " + Obj.LicenseKey + ">"; })
 	.def(py::init<>())
-	ACLASSD(LicensingStatus, LicenseKey)
-	ACLASSD(LicensingStatus, LicenseMachineUUID)
-	ACLASSD(LicensingStatus, ProductName)
-	ACLASSD(LicensingStatus, UserName)
-	ACLASSD(LicensingStatus, UsedSeats)
-	ACLASSD(LicensingStatus, TotalSeats)
-	ACLASSD(LicensingStatus, ValidLicense)
-	ACLASSD(LicensingStatus, LicenseCaps);
+	COYOTE_LICENSINGSTATUS_FIELDS(ACLASSD);
 
 	py::class_<Coyote::Drive, Coyote::Object>(ModObj, "Drive")
 	.def("__repr__", [] (Coyote::Drive &Obj) { return std::string{"<Drive "} + Obj.Mountpoint.c_str() + ", " + std::to_string(Obj.Free / (1024ll * 1024ll * 1024ll)) + "/" + std::to_string(Obj.Total / (1024ll * 1024ll * 1024ll)) + " GiB free>"; })
 	.def(py::init<>())
-	ACLASSD(Drive, Mountpoint)
-	ACLASSD(Drive, Total)
-	ACLASSD(Drive, Used)
-	ACLASSD(Drive, Free)
-	ACLASSD(Drive, IsExternal);
+	COYOTE_DRIVE_FIELDS(ACLASSD);
 
 	py::class_<Coyote::KonaHardwareState, Coyote::Object>(ModObj, "KonaHardwareState")
 	.def(py::init<>())
@@ -269,20 +250,13 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	})
 	ACLASSD(KonaHardwareState, Resolutions)
 	ACLASSD(KonaHardwareState, RefreshRate)
-	ACLASSD(KonaHardwareState, HDRMode)
-	ACLASSD(KonaHardwareState, EOTFSetting)
-	ACLASSD(KonaHardwareState, ConstLumin);
+	COYOTE_KONAHARDWARESTATE_FIELDS(ACLASSD);
 
 	py::class_<Coyote::LANCoyote, Coyote::Object>(ModObj, "LANCoyote")
 	.def(py::init<>())
 	.def("__repr__", [] (Coyote::LANCoyote &Obj) { return std::string{"<LANCoyote with GUID "} + Obj.GUID + (Obj.GUID == Obj.Nickname ? std::string{""} : (std::string{" and nick \""} + Obj.Nickname + "\" ")) + "at IP " + Obj.IP + " running version " + Obj.CommunicatorVersion + ">"; })
-	ACLASSD(LANCoyote, APIVersion)
-	ACLASSD(LANCoyote, CommunicatorVersion)
-	ACLASSD(LANCoyote, GUID)
-	ACLASSD(LANCoyote, Nickname)
-	ACLASSD(LANCoyote, IP)
-	ACLASSD(LANCoyote, CurrentRole)
-	ACLASSD(LANCoyote, Type);
+	COYOTE_LANCOYOTE_FIELDS(ACLASSD)
+	ACLASSD(LANCoyote, IP);
 
 	py::class_<Coyote::TabOrdering, Coyote::Object>(ModObj, "TabOrdering")
 	.def(py::init<>())
@@ -293,41 +267,20 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	py::class_<Coyote::ExternalAsset, Coyote::Object>(ModObj, "ExternalAsset")
 	.def(py::init<>())
 	.def("__repr__", [] (Coyote::ExternalAsset &Obj) { return std::string{"<ExternalAsset at path "} + Obj.FullPath + ">"; })
-	ACLASSD(ExternalAsset, Filename)
-	ACLASSD(ExternalAsset, FullPath)
-	ACLASSD(ExternalAsset, IsDirectory)
-	ACLASSD(ExternalAsset, FileSize);
+	COYOTE_EXTERNALASSET_FIELDS(ACLASSD);
 
 	py::class_<Coyote::PresetMark, Coyote::Object>(ModObj, "PresetMark")
 	.def(py::init<>())
-	ACLASSD(PresetMark, ID)
-	ACLASSD(PresetMark,	Name)
-	ACLASSD(PresetMark, TimeMS)
+	COYOTE_PRESETMARK_FIELDS(ACLASSD)
 	.def("__repr__", [] (Coyote::PresetMark &Obj) { return std::string{"<PresetMark \""} + Obj.Name.c_str() + "\", time " + std::to_string(Obj.TimeMS) + ">"; });
 
 
 	py::class_<Coyote::Preset, Coyote::Object>(ModObj, "Preset")
 	.def(py::init<>())
 	.def("__repr__", [] (Coyote::Preset &Obj) { return std::string{"<Preset \""} + Obj.Name.c_str() + "\", PK " + std::to_string(Obj.PK) + ">"; })
-	ACLASSD(Preset, PK)
-	ACLASSD(Preset, Name)
+	COYOTE_PRESET_FIELDS(ACLASSD)
 	ACLASSD(Preset, Canvases)
-	ACLASSD(Preset, Notes)
-	ACLASSD(Preset, Loop)
-	ACLASSD(Preset, Link)
-	ACLASSD(Preset, FadeInMS)
-	ACLASSD(Preset, FadeOutMS)
-	ACLASSD(Preset, Color)
-	ACLASSD(Preset, InPosition)
-	ACLASSD(Preset, OutPosition)
 	ACLASSD(Preset, TabDisplayOrder)
-	ACLASSD(Preset, Gotos)
-	ACLASSD(Preset, Countdowns)
-	ACLASSD(Preset, FreezeAtEnd)
-	ACLASSD(Preset, DissolveInMS)
-	ACLASSD(Preset, DissolveOutMS)
-	ACLASSD(Preset, Volume)
-	ACLASSD(Preset, SinkOptions)
 	ACLASSF(Preset, GetPlayersForCanvas)
 	ACLASSFREFPTR(Preset, LookupCanvasByPlayer)
 	ACLASSF(Preset, GetPlayerRangeForCanvas)
@@ -336,9 +289,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	py::class_<Coyote::TimeCode, Coyote::Object>(ModObj, "TimeCode")
 	.def(py::init<>())
 	.def("__repr__", [] (Coyote::TimeCode &Obj) { return std::string{"<TimeCode for PK "} + std::to_string(Obj.PK) + " with time " + std::to_string(Obj.Time) + ">"; })
-	ACLASSD(TimeCode, PK)
-	ACLASSD(TimeCode, Time)
-	ACLASSD(TimeCode, VUData);
+	COYOTE_TIMECODE_FIELDS(ACLASSD);
 
 	py::class_<Coyote::GenlockSettings, Coyote::Object>(ModObj, "GenlockSettings")
 	.def(py::init<>())
@@ -349,10 +300,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 						", Horz " + std::to_string(Obj.HorzValue) +
 						", Vert " + std::to_string(Obj.VertValue) + ">";
 	})
-	ACLASSD(GenlockSettings, FormatString)
-	ACLASSD(GenlockSettings, HorzValue)
-	ACLASSD(GenlockSettings, VertValue)
-	ACLASSD(GenlockSettings, Genlocked);
+	COYOTE_GENLOCKSETTINGS_FIELDS(ACLASSD);
 
 	py::class_<Coyote::PresetState, Coyote::Object>(ModObj, "PresetState")
 	.def(py::init<>())
@@ -365,12 +313,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 							", CurrentLoop: " + std::to_string(Obj.CurrentLoop) +
 							", TRT: " + std::to_string(Obj.TRT) + ">";
 	})
-	ACLASSD(PresetState, PK)
-	ACLASSD(PresetState, TRT)
-	ACLASSD(PresetState, CurrentLoop)
-	ACLASSD(PresetState, IsPlaying)
-	ACLASSD(PresetState, IsPaused)
-	ACLASSD(PresetState, IsSelected);
+	COYOTE_PRESETSTATE_FIELDS(ACLASSD);
 
 
 	py::class_<Coyote::Mirror, Coyote::Object>(ModObj, "Mirror")
@@ -382,11 +325,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 							", Busy: " + (Obj.Busy ? "True" : "False") +
 							", IsAlive: " + (Obj.IsAlive ? "True" : "False") + ">";
 	})
-	ACLASSD(Mirror, UnitID)
-	ACLASSD(Mirror, IP)
-	ACLASSD(Mirror, Busy)
-	ACLASSD(Mirror, Type)
-	ACLASSD(Mirror, IsAlive);
+	COYOTE_MIRROR_FIELDS(ACLASSD);
 
 	py::class_<Coyote::Coords2D>(ModObj, "Coords2D")
 	.def(py::init<>())
@@ -395,8 +334,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 					return Coyote::Coords2D{ X, Y };
 				}))
 	.def("__repr__", [] (Coyote::Coords2D &Obj) { return std::string{"<Coords2D of "} + std::to_string(Obj.X) + ',' + std::to_string(Obj.Y) + ">"; })
-	ACLASSD(Coords2D, X)
-	ACLASSD(Coords2D, Y);
+	COYOTE_COORDS2D_FIELDS(ACLASSD);
 
 	py::class_<Coyote::Size2D>(ModObj, "Size2D")
 	.def(py::init<>())
@@ -405,8 +343,7 @@ PYBIND11_MODULE(pycoyote, ModObj)
 					return Coyote::Size2D{ Width, Height };
 				}))
 	.def("__repr__", [] (Coyote::Size2D &Obj) { return std::string{"<Size2D of "} + std::to_string(Obj.Width) + ',' + std::to_string(Obj.Height) + ">"; })
-	ACLASSD(Size2D, Width)
-	ACLASSD(Size2D, Height);
+	COYOTE_SIZE2D_FIELDS(ACLASSD);
 
 	py::class_<Coyote::Rect, Coyote::Size2D, Coyote::Coords2D>(ModObj, "Rect")
 	.def("__repr__", [] (Coyote::Rect &Obj)
@@ -437,37 +374,16 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	py::class_<Coyote::Asset, Coyote::Object>(ModObj, "Asset")
 	.def(py::init<>())
 	.def("__repr__", [] (Coyote::Asset &Obj) { return std::string{"<Asset \""} + Obj.FullPath + "\">"; })
-	ACLASSD(Asset, FullPath)
-	ACLASSD(Asset, Checksum)
-	ACLASSD(Asset, LastModified)
-	ACLASSD(Asset, TotalSize)
-	ACLASSD(Asset, CurrentSize)
-	ACLASSD(Asset, Status);
+	COYOTE_ASSET_FIELDS(ACLASSD);
 
 	py::class_<Coyote::AssetMetadata, Coyote::Object>(ModObj, "AssetMetadata")
 	.def(py::init<>())
-	ACLASSD(AssetMetadata, FilePath)
-	ACLASSD(AssetMetadata, VideoFormat)
-	ACLASSD(AssetMetadata, AudioFormat)
-	ACLASSD(AssetMetadata, ContainerFormat)
-	ACLASSD(AssetMetadata, Resolution)
-	ACLASSD(AssetMetadata, TotalSize)
-	ACLASSD(AssetMetadata, VBitrate)
-	ACLASSD(AssetMetadata, ABitrate)
-	ACLASSD(AssetMetadata, ASampleRate)
-	ACLASSD(AssetMetadata, AChannels)
-	ACLASSD(AssetMetadata, FPS)
-	ACLASSD(AssetMetadata, Duration)
+	COYOTE_ASSETMETADATA_FIELDS(ACLASSD)
 	.def("__repr__", [] (Coyote::AssetMetadata &Obj) { return std::string{"<AssetMetadata for \""} + Obj.FilePath.c_str() + "\">"; });
 
 	py::class_<Coyote::PinnedAsset, Coyote::Object>(ModObj, "PinnedAsset")
 	.def(py::init<>())
-	ACLASSD(PinnedAsset, FullPath)
-	ACLASSD(PinnedAsset, Hue)
-	ACLASSD(PinnedAsset, Saturation)
-	ACLASSD(PinnedAsset, Contrast)
-	ACLASSD(PinnedAsset, Brightness)
-	ACLASSD(PinnedAsset, PinnedCoords);
+	COYOTE_PINNEDASSET_FIELDS(ACLASSD);
 
 	py::class_<Coyote::CanvasOrientation, Coyote::Object>(ModObj, "CanvasOrientation")
 	.def(py::init<>())
@@ -485,16 +401,35 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	py::class_<Coyote::ProjectorCanvasConfig, Coyote::Object>(ModObj, "ProjectorCanvasConfig")
 	.def(py::init<>())
 	ACLASSD(ProjectorCanvasConfig, Orientation)
-	ACLASSD(ProjectorCanvasConfig, Dimensions)
-	ACLASSD(ProjectorCanvasConfig, NumOutputs);
+	COYOTE_PROJECTORCANVASCONFIG_FIELDS(ACLASSD);
 
 
 	py::class_<Coyote::CanvasInfo, Coyote::Object>(ModObj, "CanvasInfo")
 	.def(py::init<>())
-	ACLASSD(CanvasInfo, Index)
-	ACLASSD(CanvasInfo, CanvasCfg)
-	ACLASSD(CanvasInfo, Assets)
-	ACLASSD(CanvasInfo, SinkTypes);
+	COYOTE_CANVASINFO_FIELDS(ACLASSD)
+	ACLASSD(CanvasInfo, CanvasCfg);
+
+	py::class_<Coyote::MarkEdit>(ModObj, "MarkEdit")
+	.def(py::init<>())
+	ACLASSD(MarkEdit, PK)
+	ACLASSD(MarkEdit, Type)
+	ACLASSD(MarkEdit, Action)
+	ACLASSD(MarkEdit, TimeMS)
+	ACLASSD(MarkEdit, Name);
+
+	py::class_<Coyote::DiskCrawlStats>(ModObj, "DiskCrawlStats")
+	.def(py::init<>())
+	ACLASSD(DiskCrawlStats, Directories)
+	ACLASSD(DiskCrawlStats, Entries)
+	ACLASSD(DiskCrawlStats, Requests)
+	ACLASSD(DiskCrawlStats, Failed);
+
+	py::class_<Coyote::ResponseCacheStats>(ModObj, "ResponseCacheStats")
+	.def(py::init<>())
+	ACLASSD(ResponseCacheStats, Hits)
+	ACLASSD(ResponseCacheStats, Misses)
+	ACLASSD(ResponseCacheStats, Invalidations)
+	ACLASSD(ResponseCacheStats, Entries);
 
 	py::class_<Coyote::Session>(ModObj, "Session")
 	.def(py::init<const std::string &, const int>(), py::call_guard<py::gil_scoped_release>(), py::arg("IP"), py::arg("NumAttempts") = -1)
@@ -523,6 +458,56 @@ PYBIND11_MODULE(pycoyote, ModObj)
 
 		return std::make_tuple(Status, py::bytes((const char*)Bytes.data(), Bytes.size()));
 	}, py::call_guard<py::gil_scoped_release>())
+	.def("CreatePresets",
+	[] (Coyote::Session &Obj, const std::vector<Coyote::Preset> &Presets)
+	{
+		std::vector<Coyote::StatusCode> Statuses;
+		const Coyote::StatusCode Status = Obj.CreatePresets(Presets, &Statuses);
+
+		return std::make_tuple(Status, Statuses);
+	}, py::call_guard<py::gil_scoped_release>())
+	.def("UpdatePresets",
+	[] (Coyote::Session &Obj, const std::vector<Coyote::Preset> &Presets)
+	{
+		std::vector<Coyote::StatusCode> Statuses;
+		const Coyote::StatusCode Status = Obj.UpdatePresets(Presets, &Statuses);
+
+		return std::make_tuple(Status, Statuses);
+	}, py::call_guard<py::gil_scoped_release>())
+	.def("ApplyMarkEdits",
+	[] (Coyote::Session &Obj, const std::vector<Coyote::MarkEdit> &Edits)
+	{
+		std::vector<Coyote::StatusCode> Statuses;
+		const Coyote::StatusCode Status = Obj.ApplyMarkEdits(Edits, &Statuses);
+
+		return std::make_tuple(Status, Statuses);
+	}, py::call_guard<py::gil_scoped_release>())
+	.def("StreamLogsZipToFD",
+	[] (Coyote::Session &Obj, const int FD)
+	{
+		return Obj.StreamLogsZipToFD(FD);
+	}, py::call_guard<py::gil_scoped_release>())
+	.def("StreamLogToFD",
+	[] (Coyote::Session &Obj, const std::string SpokeName, const int Year, const int Month, const int Day, const int FD)
+	{
+		return Obj.StreamLogToFD(SpokeName, Year, Month, Day, FD);
+	}, py::call_guard<py::gil_scoped_release>())
+	.def("ReadLogs",
+	[] (Coyote::Session &Obj, const std::vector<std::tuple<std::string, int, int, int> > &Days, const uint32_t MaxConcurrent)
+	{
+		std::vector<Coyote::LogDay> Input;
+
+		for (const auto &Item : Days) Input.push_back({ std::get<0>(Item), std::get<1>(Item), std::get<2>(Item), std::get<3>(Item) });
+
+		std::vector<Coyote::LogDayResult> Results;
+		const Coyote::StatusCode Status = Obj.ReadLogs(Input, Results, MaxConcurrent);
+
+		std::vector<std::tuple<Coyote::StatusCode, std::string> > RetVal;
+
+		for (Coyote::LogDayResult &Result : Results) RetVal.emplace_back(Result.Status, std::move(Result.LogText));
+
+		return std::make_tuple(Status, RetVal);
+	}, py::call_guard<py::gil_scoped_release>(), py::arg("Days"), py::arg("MaxConcurrent") = 4u)
 	.def("IsMirror",
 	[] (Coyote::Session &Obj)
 	{
@@ -568,10 +553,11 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	[] (Coyote::Session &Obj, py::object Func, py::object PyUserData)
 	{
 		static auto &Pass = *new std::map<Coyote::Session*, std::pair<py::object, py::object> >; //Prevents the destructor from being called on program exit, because we don't care and it could segfault.
+		static auto &Subs = *new std::map<Coyote::Session*, Coyote::Subscription>;
 
 		if (Func.ptr() == Py_None)
 		{
-			Obj.SetMiniviewCallback(nullptr, nullptr);
+			Subs.erase(&Obj);
 			return;
 		}
 
@@ -580,7 +566,10 @@ PYBIND11_MODULE(pycoyote, ModObj)
 							std::move(PyUserData)
 						};
 
-		Obj.SetMiniviewCallback(MiniviewEventFunc, &Pass[&Obj]);
+		void *const PassPtr = &Pass[&Obj];
+		
+		//Frame handles go straight to bytes, no intermediate vector copy.
+		Subs[&Obj] = Obj.OnMiniviewFrame([PassPtr] (const Coyote::MiniviewFrame &Frame) { MiniviewEventFunc(Frame, PassPtr); });
 	})
 	.def("SetPlaybackEventCallback",
 	[] (Coyote::Session &Obj, py::object Func, py::object PyUserData)
@@ -756,6 +745,52 @@ PYBIND11_MODULE(pycoyote, ModObj)
 
 		return std::make_tuple(Status, DiskAssets);
 	}, py::call_guard<py::gil_scoped_release>(), py::arg("DriveName"), py::arg("Subpath") = "")
+	.def("GetDiskAssetsPage",
+	[] (Coyote::Session &Obj, const std::string DriveName, const std::string Subpath, const std::string ContinuationToken, const uint32_t PageSize)
+	{
+		Coyote::DiskAssetsPage Page;
+
+		const Coyote::StatusCode Status = Obj.GetDiskAssetsPage(Page, DriveName, Subpath, ContinuationToken, PageSize);
+
+		return std::make_tuple(Status, Page.Items, Page.ContinuationToken);
+	}, py::call_guard<py::gil_scoped_release>(), py::arg("DriveName"), py::arg("Subpath") = "", py::arg("ContinuationToken") = "", py::arg("PageSize") = 500u)
+	.def("CrawlDiskAssets",
+	[] (Coyote::Session &Obj, const std::string DriveName, const std::string Subpath, const py::object &Callback, const uint32_t MaxConcurrent, const uint32_t MaxDepth, const uint32_t PageSize)
+	{
+		bool Raised = false;
+
+		//Callback returns True to keep going. An exception stops the crawl and is raised once it's wound down.
+		auto Wrapper = [&Callback, &Raised] (const std::string &Subpath, const Coyote::ExternalAsset &Entry)
+		{
+			py::gil_scoped_acquire GILLock;
+
+			try
+			{
+				return Callback(Subpath, Entry).cast<bool>();
+			}
+			catch (py::error_already_set &Err)
+			{
+				Err.restore();
+				Raised = true;
+				return false;
+			}
+		};
+
+		Coyote::DiskCrawlOptions Options;
+		Options.MaxConcurrent = MaxConcurrent;
+		Options.MaxDepth = MaxDepth;
+		Options.PageSize = PageSize;
+
+		Coyote::DiskCrawlStats Stats{};
+
+		const Coyote::StatusCode Status = Obj.CrawlDiskAssets(DriveName, Subpath, Wrapper, Options, &Stats);
+
+		py::gil_scoped_acquire GILLock;
+
+		if (Raised) throw py::error_already_set();
+
+		return std::make_tuple(Status, Stats);
+	}, py::call_guard<py::gil_scoped_release>(), py::arg("DriveName"), py::arg("Subpath"), py::arg("Callback"), py::arg("MaxConcurrent") = 8u, py::arg("MaxDepth") = 0u, py::arg("PageSize") = 500u)
 	.def("GetPresetsMap",
 	[] (Coyote::Session &Obj)
 	{
@@ -932,6 +967,13 @@ PYBIND11_MODULE(pycoyote, ModObj)
 	ACLASSF(Session, DeleteWatchPath)
 	ACLASSF(Session, SetCommandTimeoutSecs)
 	ACLASSF(Session, GetCommandTimeoutSecs)
+	.def("SetResponseCacheTTL",
+	[] (Coyote::Session &Obj, const std::string &CommandName, const uint32_t TTLMS)
+	{
+		Obj.SetResponseCacheTTL(CommandName, std::chrono::milliseconds{ TTLMS });
+	}, py::call_guard<py::gil_scoped_release>(), py::arg("CommandName"), py::arg("TTLMS"))
+	.def("InvalidateResponseCache", &Coyote::Session::InvalidateResponseCache, py::call_guard<py::gil_scoped_release>(), py::arg("CommandName") = "")
+	ACLASSF(Session, GetResponseCacheStats)
 	ACLASSF(Session, SetMaxCPUPercentage)
 	ACLASSF(Session, HasConnectionError)
 	ACLASSF(Session, ActivateMachine)
@@ -981,7 +1023,7 @@ static std::string PyResolutionMap(const Coyote::ResolutionMode Res)
 	return ResolutionMap.at(Res);
 }
 
-static void MiniviewEventFunc(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Coyote::Size2D &Dimensions, std::vector<uint8_t> Bytes, void *const Pass_)
+static void MiniviewEventFunc(const Coyote::MiniviewFrame &Frame, void *const Pass_)
 {
 	py::gil_scoped_acquire GILLock;
 
@@ -993,7 +1035,7 @@ static void MiniviewEventFunc(const int32_t PK, const uint32_t CanvasIndex, cons
 		return;
 	}
 
-	Pass->first(PK, CanvasIndex, OutputNum, Dimensions, py::bytes((const char*)Bytes.data(), Bytes.size()), Pass->second);
+	Pass->first(Frame.PK, Frame.CanvasIndex, Frame.OutputNum, Frame.Dimensions, py::bytes((const char*)Frame.Data(), Frame.Size()), Pass->second);
 }
 
 static void PBEventFunc(const Coyote::PlaybackEventType EType, const int32_t PK, const int32_t Time, void *const Pass_)
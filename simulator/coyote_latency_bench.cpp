@@ -0,0 +1,463 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**End to end latency benchmarks for Coyote::Session, against simulated units running in this same process.
+ * Commands are timed from the call to its return. Subscription events are timed from the simulator handing a TimeCode
+ * to its socket until the session's OnTimeCode() handler runs, both sides read the same steady_clock.
+ * Results go out as one JSON document on stdout (or --json=PATH), a readable summary goes to stderr.**/
+
+#include "coyotesim.h"
+#include "include/session.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+typedef std::chrono::steady_clock Clock;
+
+static constexpr int32_t ProbePK = INT32_MAX; //Never a real preset, so probes can't be confused with simulated playback
+
+struct BenchConfig
+{
+	uint32_t Sessions = 8; //For fanout, one unit each
+	uint32_t Depth = 16; //Callers in flight at once on one session, for pipelined
+	double Secs = 5.0; //Per command scenario
+	uint32_t WarmupOps = 200; //Per caller, not timed
+	uint32_t Probes = 5000;
+	uint32_t Subscriptions = Coyote::COYOTE_SUB_ALL;
+	std::string Filter;
+	std::string Label; //e.g. the libcoyote release, copied into the JSON as is
+	std::string JSONPath;
+	CoyoteSim::FarmConfig Farm;
+};
+
+struct Result
+{
+	std::string Name;
+	uint32_t Sessions;
+	uint32_t Concurrency;
+	uint64_t Ops;
+	uint64_t Errors; //Failed commands, or probes that never arrived
+	double Secs;
+	std::vector<int64_t> LatencyNs;
+};
+
+static inline int64_t NowNs(void)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static double Percentile(const std::vector<int64_t> &Sorted, const double Fraction)
+{ //Nearest rank, so p99.9 of a small run is just the max rather than something made up.
+	if (Sorted.empty()) return 0.0;
+	
+	const size_t Rank = static_cast<size_t>(std::ceil(Fraction * Sorted.size()));
+	
+	return Sorted[std::min(std::max<size_t>(Rank, 1u), Sorted.size()) - 1u] / 1000.0;
+}
+
+static std::string JSONString(const std::string &In)
+{
+	std::string RetVal { "\"" };
+	
+	for (const char C : In)
+	{
+		switch (C)
+		{
+			case '"': RetVal += "\\\""; break;
+			case '\\': RetVal += "\\\\"; break;
+			case '\n': RetVal += "\\n"; break;
+			default:
+			{
+				if (static_cast<unsigned char>(C) < 0x20)
+				{
+					char Escaped[8];
+					snprintf(Escaped, sizeof Escaped, "\\u%04x", C);
+					RetVal += Escaped;
+				}
+				else RetVal += C;
+				break;
+			}
+		}
+	}
+	
+	return RetVal + '"';
+}
+
+static std::string JSONNumber(const double Value)
+{
+	char Buf[64];
+	
+	snprintf(Buf, sizeof Buf, "%.3f", std::isfinite(Value) ? Value : 0.0);
+	
+	return Buf;
+}
+
+static std::vector<std::unique_ptr<Coyote::Session> > Connect(const BenchConfig &Config, CoyoteSim::Farm &Sims, const uint32_t Count)
+{
+	std::vector<std::unique_ptr<Coyote::Session> > RetVal;
+	
+	Coyote::SessionOptions Options;
+	
+	Options.Subscriptions = Config.Subscriptions;
+	Options.NumAttempts = 5;
+	
+	for (uint32_t Inc = 0u; Inc < Count; ++Inc)
+	{
+		const std::string &Host { Sims.GetUnit(Inc % Sims.NumUnits()).GetConfig().Address };
+		
+		std::unique_ptr<Coyote::Session> Sess { new Coyote::Session { Host, Options } };
+		
+		if (!Sess->Connected())
+		{
+			std::cerr << "Couldn't connect to the simulated unit at " << Host << std::endl;
+			return {};
+		}
+		
+		RetVal.emplace_back(std::move(Sess));
+	}
+	
+	return RetVal;
+}
+
+static Result RunCommands(const std::string &Name, const BenchConfig &Config, const std::vector<Coyote::Session*> &Sessions, const uint32_t CallersPerSession)
+{ //Every caller loops on GetServerVersion, which the simulator answers straight away, so what's left is libcoyote and loopback.
+	struct Caller
+	{
+		std::thread Thread;
+		std::vector<int64_t> LatencyNs;
+		uint64_t Errors = 0u;
+	};
+	
+	std::vector<Caller> Callers(Sessions.size() * CallersPerSession);
+	std::atomic<uint32_t> Ready { 0u };
+	std::atomic<bool> Go { false };
+	std::atomic<int64_t> DeadlineNs { INT64_MAX };
+	
+	for (size_t Inc = 0u; Inc < Callers.size(); ++Inc)
+	{
+		Coyote::Session *const Sess = Sessions[Inc % Sessions.size()];
+		Caller &Self { Callers[Inc] };
+		
+		Self.LatencyNs.reserve(1u << 16);
+		
+		Self.Thread = std::thread([&Config, &Ready, &Go, &DeadlineNs, Sess, &Self]
+			{
+				std::string Version;
+				
+				for (uint32_t Warmup = 0u; Warmup < Config.WarmupOps; ++Warmup) Sess->GetServerVersion(Version);
+				
+				++Ready;
+				
+				while (!Go.load()) std::this_thread::yield();
+				
+				while (true)
+				{
+					const int64_t Start = NowNs();
+					
+					if (Start >= DeadlineNs.load(std::memory_order_relaxed)) break;
+					
+					const Coyote::StatusCode Status = Sess->GetServerVersion(Version);
+					
+					if (Status != Coyote::COYOTE_STATUS_OK)
+					{
+						++Self.Errors;
+						continue;
+					}
+					
+					Self.LatencyNs.push_back(NowNs() - Start);
+				}
+			});
+	}
+	
+	while (Ready.load() < Callers.size()) COYOTE_SLEEP(1);
+	
+	const int64_t StartNs = NowNs();
+	
+	DeadlineNs = StartNs + static_cast<int64_t>(Config.Secs * 1e9);
+	Go = true;
+	
+	Result RetVal { Name, static_cast<uint32_t>(Sessions.size()), static_cast<uint32_t>(Callers.size()), 0u, 0u, 0.0, {} };
+	
+	for (Caller &Item : Callers)
+	{
+		Item.Thread.join();
+		
+		RetVal.Errors += Item.Errors;
+		RetVal.LatencyNs.insert(RetVal.LatencyNs.end(), Item.LatencyNs.begin(), Item.LatencyNs.end());
+	}
+	
+	RetVal.Secs = (NowNs() - StartNs) / 1e9; //Includes the last call to finish past the deadline
+	RetVal.Ops = RetVal.LatencyNs.size();
+	
+	return RetVal;
+}
+
+static Result RunEvents(const BenchConfig &Config, Coyote::Session &Sess, CoyoteSim::Unit &Sim)
+{ //One probe in flight at a time, so the callback executor never gets the chance to coalesce them.
+	std::mutex Lock;
+	std::condition_variable Arrived;
+	int32_t Expected = -1;
+	int64_t ReceivedNs = 0;
+	std::atomic<int64_t> SentNs { 0 };
+	
+	Coyote::Subscription Probe { Sess.OnTimeCode([&Lock, &Arrived, &Expected, &ReceivedNs] (const Coyote::TimeCode &TC)
+		{
+			if (TC.PK != ProbePK) return;
+			
+			const int64_t Now = NowNs();
+			
+			std::lock_guard<std::mutex> Guard { Lock };
+			
+			if (TC.Time != Expected) return; //Late arrival of one we already gave up on
+			
+			ReceivedNs = Now;
+			Arrived.notify_one();
+		}) };
+	
+	Result RetVal { "events", 1u, 1u, 0u, 0u, 0.0, {} };
+	
+	RetVal.LatencyNs.reserve(Config.Probes);
+	
+	const int64_t StartNs = NowNs();
+	
+	for (uint32_t Inc = 0u; Inc < Config.Probes; ++Inc)
+	{
+		Coyote::TimeCode TC {};
+		
+		TC.PK = ProbePK;
+		TC.Time = static_cast<int32_t>(Inc);
+		
+		std::unique_lock<std::mutex> Guard { Lock };
+		
+		Expected = TC.Time;
+		ReceivedNs = 0;
+		
+		CoyoteSim::Unit *const Target = &Sim;
+		
+		QMetaObject::invokeMethod(Target, [Target, TC, &SentNs] { SentNs = NowNs(); Target->SendTimeCode(TC); }, Qt::QueuedConnection);
+		
+		if (!Arrived.wait_for(Guard, std::chrono::seconds(1), [&ReceivedNs] { return ReceivedNs != 0; }))
+		{
+			++RetVal.Errors;
+			continue;
+		}
+		
+		RetVal.LatencyNs.push_back(ReceivedNs - SentNs.load());
+	}
+	
+	RetVal.Secs = (NowNs() - StartNs) / 1e9;
+	RetVal.Ops = RetVal.LatencyNs.size();
+	
+	return RetVal;
+}
+
+static std::string ToJSON(const BenchConfig &Config, std::vector<Result> &Results)
+{
+	char StartedAt[64] {};
+	const time_t Now = time(nullptr);
+	struct tm UTC {};
+	
+	gmtime_r(&Now, &UTC);
+	strftime(StartedAt, sizeof StartedAt, "%Y-%m-%dT%H:%M:%SZ", &UTC);
+	
+	const CoyoteSim::UnitConfig &Sim { Config.Farm.Template };
+	
+	std::string RetVal = "{\n";
+	
+	RetVal += "  \"benchmark\": \"coyote_latency_bench\",\n";
+	RetVal += "  \"label\": " + JSONString(Config.Label) + ",\n";
+	RetVal += "  \"api_version\": " + JSONString(COYOTE_API_VERSION) + ",\n";
+	RetVal += "  \"started_at\": " + JSONString(StartedAt) + ",\n";
+	RetVal += "  \"config\": {";
+	RetVal += " \"sessions\": " + std::to_string(Config.Sessions);
+	RetVal += ", \"depth\": " + std::to_string(Config.Depth);
+	RetVal += ", \"secs\": " + JSONNumber(Config.Secs);
+	RetVal += ", \"probes\": " + std::to_string(Config.Probes);
+	RetVal += ", \"subscriptions\": " + std::to_string(Config.Subscriptions);
+	RetVal += ", \"sim_threads\": " + std::to_string(Config.Farm.NumThreads);
+	RetVal += ", \"sim_tc_hz\": " + JSONNumber(Sim.TimeCodeHz);
+	RetVal += ", \"sim_compact_wire\": " + std::string{ Sim.CompactWire ? "true" : "false" };
+	RetVal += ", \"sim_latency_ms\": " + std::to_string(Sim.LatencyMS);
+	RetVal += ", \"sim_jitter_ms\": " + std::to_string(Sim.JitterMS);
+	RetVal += " },\n";
+	RetVal += "  \"results\": [";
+	
+	for (size_t Inc = 0u; Inc < Results.size(); ++Inc)
+	{
+		Result &Item { Results[Inc] };
+		
+		std::sort(Item.LatencyNs.begin(), Item.LatencyNs.end());
+		
+		double MeanUs = 0.0;
+		
+		for (const int64_t Sample : Item.LatencyNs) MeanUs += Sample / 1000.0;
+		
+		if (!Item.LatencyNs.empty()) MeanUs /= Item.LatencyNs.size();
+		
+		RetVal += Inc ? ",\n    {" : "\n    {";
+		RetVal += " \"name\": " + JSONString(Item.Name);
+		RetVal += ", \"sessions\": " + std::to_string(Item.Sessions);
+		RetVal += ", \"concurrency\": " + std::to_string(Item.Concurrency);
+		RetVal += ", \"ops\": " + std::to_string(Item.Ops);
+		RetVal += ", \"errors\": " + std::to_string(Item.Errors);
+		RetVal += ", \"secs\": " + JSONNumber(Item.Secs);
+		RetVal += ", \"ops_per_sec\": " + JSONNumber(Item.Secs > 0.0 ? Item.Ops / Item.Secs : 0.0);
+		RetVal += ", \"latency_us\": {";
+		RetVal += " \"min\": " + JSONNumber(Percentile(Item.LatencyNs, 0.0));
+		RetVal += ", \"mean\": " + JSONNumber(MeanUs);
+		RetVal += ", \"p50\": " + JSONNumber(Percentile(Item.LatencyNs, 0.5));
+		RetVal += ", \"p99\": " + JSONNumber(Percentile(Item.LatencyNs, 0.99));
+		RetVal += ", \"p999\": " + JSONNumber(Percentile(Item.LatencyNs, 0.999));
+		RetVal += ", \"max\": " + JSONNumber(Percentile(Item.LatencyNs, 1.0));
+		RetVal += " } }";
+		
+		char Line[256];
+		
+		snprintf(Line, sizeof Line, "%-12s %4u sess %4u conc %10llu ops %12.1f ops/s  p50 %9.1f us  p99 %9.1f us  p99.9 %9.1f us  %llu errors",
+				Item.Name.c_str(), Item.Sessions, Item.Concurrency, (unsigned long long)Item.Ops, Item.Secs > 0.0 ? Item.Ops / Item.Secs : 0.0,
+				Percentile(Item.LatencyNs, 0.5), Percentile(Item.LatencyNs, 0.99), Percentile(Item.LatencyNs, 0.999), (unsigned long long)Item.Errors);
+		
+		std::cerr << Line << std::endl;
+	}
+	
+	RetVal += "\n  ]\n}\n";
+	
+	return RetVal;
+}
+
+struct Option
+{
+	const char *Name;
+	const char *Help;
+	std::function<void(const char *Value)> Apply;
+};
+
+int main(int argc, char **argv)
+{
+	QCoreApplication App { argc, argv };
+	
+	BenchConfig Config;
+	CoyoteSim::UnitConfig &Sim { Config.Farm.Template };
+	
+	Config.Farm.FirstAddress = "127.0.20.1"; //Out of the way of a coyote_sim that might be running with its defaults
+	Config.Farm.NumThreads = 2;
+	Sim.TimeCodeHz = 0.0; //Background load is opt in, so the default numbers are libcoyote's own overhead
+	
+	const Option Options[] =
+	{
+		{ "--sessions=", "Sessions (and units) for fanout", [&] (const char *V) { Config.Sessions = std::max(1ul, strtoul(V, nullptr, 10)); } },
+		{ "--depth=", "Concurrent callers on one session for pipelined", [&] (const char *V) { Config.Depth = std::max(1ul, strtoul(V, nullptr, 10)); } },
+		{ "--secs=", "Seconds per command scenario", [&] (const char *V) { Config.Secs = strtod(V, nullptr); } },
+		{ "--warmup=", "Untimed commands per caller first", [&] (const char *V) { Config.WarmupOps = strtoul(V, nullptr, 10); } },
+		{ "--probes=", "Subscription events to time", [&] (const char *V) { Config.Probes = strtoul(V, nullptr, 10); } },
+		{ "--subscriptions=", "SubscriptionFlags for every session", [&] (const char *V) { Config.Subscriptions = strtoul(V, nullptr, 0); } },
+		{ "--filter=", "Only run scenarios whose name contains this", [&] (const char *V) { Config.Filter = V; } },
+		{ "--label=", "Copied into the JSON, e.g. the release being measured", [&] (const char *V) { Config.Label = V; } },
+		{ "--json=", "Write the JSON here instead of stdout", [&] (const char *V) { Config.JSONPath = V; } },
+		{ "--address=", "First loopback address for the simulated units", [&] (const char *V) { Config.Farm.FirstAddress = V; } },
+		{ "--sim-threads=", "Threads the simulated units run on", [&] (const char *V) { Config.Farm.NumThreads = strtoul(V, nullptr, 10); } },
+		{ "--tc-hz=", "Background timecode rate per playing preset", [&] (const char *V) { Sim.TimeCodeHz = strtod(V, nullptr); } },
+		{ "--compact", "Have the simulated units offer the compact wire encoding", [&] (const char *) { Sim.CompactWire = true; } },
+		{ "--latency-ms=", "Simulated network latency", [&] (const char *V) { Sim.LatencyMS = strtoul(V, nullptr, 10); } },
+		{ "--jitter-ms=", "Simulated network jitter, plus or minus", [&] (const char *V) { Sim.JitterMS = strtoul(V, nullptr, 10); } },
+	};
+	
+	for (int Inc = 1; Inc < argc; ++Inc)
+	{
+		bool Matched = false;
+		
+		for (const Option &Opt : Options)
+		{
+			if (strncmp(argv[Inc], Opt.Name, strlen(Opt.Name))) continue;
+			
+			Opt.Apply(argv[Inc] + strlen(Opt.Name));
+			Matched = true;
+			break;
+		}
+		
+		if (Matched) continue;
+		
+		std::cerr << "Usage: " << argv[0] << " [options]" << std::endl;
+		
+		for (const Option &Opt : Options) std::cerr << "  " << Opt.Name << "N\t" << Opt.Help << std::endl;
+		
+		return !strcmp(argv[Inc], "--help") ? 0 : 1;
+	}
+	
+	auto Wanted = [&Config] (const char *Name) { return Config.Filter.empty() || strstr(Name, Config.Filter.c_str()); };
+	
+	Config.Farm.NumUnits = Config.Sessions;
+	
+	CoyoteSim::Farm Sims { Config.Farm };
+	
+	if (Sims.Start() != Config.Farm.NumUnits)
+	{
+		std::cerr << "Couldn't start " << Config.Farm.NumUnits << " simulated units from " << Config.Farm.FirstAddress << std::endl;
+		return 1;
+	}
+	
+	std::vector<Result> Results;
+	
+	{ //sync, pipelined and events share one session on the first unit.
+		const std::vector<std::unique_ptr<Coyote::Session> > &Single { Connect(Config, Sims, 1u) };
+		
+		if (Single.empty()) return 1;
+		
+		if (Wanted("sync")) Results.push_back(RunCommands("sync", Config, { Single[0].get() }, 1u));
+		if (Wanted("pipelined")) Results.push_back(RunCommands("pipelined", Config, { Single[0].get() }, Config.Depth));
+		if (Wanted("events")) Results.push_back(RunEvents(Config, *Single[0], Sims.GetUnit(0)));
+	}
+	
+	if (Wanted("fanout"))
+	{
+		const std::vector<std::unique_ptr<Coyote::Session> > &Many { Connect(Config, Sims, Config.Sessions) };
+		
+		if (Many.empty()) return 1;
+		
+		std::vector<Coyote::Session*> Ptrs;
+		
+		for (const std::unique_ptr<Coyote::Session> &Sess : Many) Ptrs.push_back(Sess.get());
+		
+		Results.push_back(RunCommands("fanout", Config, Ptrs, 1u));
+	}
+	
+	const std::string &JSON { ToJSON(Config, Results) };
+	
+	if (Config.JSONPath.empty())
+	{
+		std::cout << JSON << std::flush;
+	}
+	else
+	{
+		std::ofstream Out { Config.JSONPath, std::ios::out | std::ios::trunc };
+		
+		Out << JSON;
+		
+		if (!Out.good())
+		{
+			std::cerr << "Couldn't write " << Config.JSONPath << std::endl;
+			return 1;
+		}
+	}
+	
+	Sims.Stop();
+	
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+/**Command line front end for CoyoteSim::Farm. Runs until killed, printing totals every few seconds.**/
+
+#include "coyotesim.h"
+
+#include <cstring>
+
+struct Option
+{
+	const char *Name;
+	const char *Help;
+	std::function<void(const char *Value)> Apply;
+};
+
+int main(int argc, char **argv)
+{
+	QCoreApplication App { argc, argv };
+	
+	CoyoteSim::FarmConfig Config;
+	CoyoteSim::UnitConfig &Unit { Config.Template };
+	double StatsEverySecs = 5.0;
+	
+	const Option Options[] =
+	{
+		{ "--units=", "Number of simulated units", [&] (const char *V) { Config.NumUnits = strtoul(V, nullptr, 10); } },
+		{ "--threads=", "Threads to spread them over", [&] (const char *V) { Config.NumThreads = strtoul(V, nullptr, 10); } },
+		{ "--address=", "First loopback address, the rest follow on", [&] (const char *V) { Config.FirstAddress = V; } },
+		{ "--port=", "Port on every address", [&] (const char *V) { Unit.Port = static_cast<uint16_t>(strtoul(V, nullptr, 10)); } },
+		{ "--presets=", "Presets per unit", [&] (const char *V) { Unit.NumPresets = strtoul(V, nullptr, 10); } },
+		{ "--assets=", "Assets per unit", [&] (const char *V) { Unit.NumAssets = strtoul(V, nullptr, 10); } },
+		{ "--vu=", "VU channels per timecode", [&] (const char *V) { Unit.NumVUChannels = strtoul(V, nullptr, 10); } },
+		{ "--tc-hz=", "Timecode rate per playing preset", [&] (const char *V) { Unit.TimeCodeHz = strtod(V, nullptr); } },
+		{ "--preset-churn-hz=", "Preset edits per second", [&] (const char *V) { Unit.PresetChurnHz = strtod(V, nullptr); } },
+		{ "--asset-churn-hz=", "AssetPosts per second", [&] (const char *V) { Unit.AssetChurnHz = strtod(V, nullptr); } },
+		{ "--miniview-hz=", "Miniview frames per second per subscribed PK", [&] (const char *V) { Unit.MiniviewHz = strtod(V, nullptr); } },
+		{ "--miniview-size=", "Miniview WIDTHxHEIGHT", [&] (const char *V) { sscanf(V, "%dx%d", &Unit.MiniviewSize.Width, &Unit.MiniviewSize.Height); } },
+		{ "--compact", "Offer the compact wire encoding", [&] (const char *) { Unit.CompactWire = true; } },
+		{ "--latency-ms=", "Added to everything sent", [&] (const char *V) { Unit.LatencyMS = strtoul(V, nullptr, 10); } },
+		{ "--jitter-ms=", "Random extra latency, plus or minus", [&] (const char *V) { Unit.JitterMS = strtoul(V, nullptr, 10); } },
+		{ "--disconnect-every=", "Mean seconds between dropped clients per unit, 0 for never", [&] (const char *V) { Unit.DisconnectEverySecs = strtod(V, nullptr); } },
+		{ "--stats-every=", "Seconds between stats lines", [&] (const char *V) { StatsEverySecs = strtod(V, nullptr); } },
+	};
+	
+	for (int Inc = 1; Inc < argc; ++Inc)
+	{
+		bool Matched = false;
+		
+		for (const Option &Opt : Options)
+		{
+			if (strncmp(argv[Inc], Opt.Name, strlen(Opt.Name))) continue;
+			
+			Opt.Apply(argv[Inc] + strlen(Opt.Name));
+			Matched = true;
+			break;
+		}
+		
+		if (Matched) continue;
+		
+		std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+		
+		for (const Option &Opt : Options) std::cout << "  " << Opt.Name << "N\t" << Opt.Help << std::endl;
+		
+		return !strcmp(argv[Inc], "--help") ? 0 : 1;
+	}
+	
+	CoyoteSim::Farm Units { Config };
+	
+	const size_t Listening = Units.Start();
+	
+	std::cout << "coyotesim: " << Listening << " of " << Config.NumUnits << " units listening, starting at " << Config.FirstAddress << ":" << Unit.Port << std::endl;
+	
+	if (!Listening) return 1;
+	
+	QElapsedTimer Clock;
+	CoyoteSim::Stats Last {};
+	
+	Clock.start();
+	
+	QTimer StatsTimer;
+	
+	QObject::connect(&StatsTimer, &QTimer::timeout, [&]
+		{
+			const CoyoteSim::Stats Now { Units.GetStats() };
+			const double Secs = Clock.restart() / 1000.0;
+			
+			char Line[256];
+			
+			snprintf(Line, sizeof Line, "clients %6u accepted %8llu dropped %6llu commands/s %9.1f events/s %10.1f MiB/s %8.2f",
+				Now.Clients,
+				(unsigned long long)Now.Accepted,
+				(unsigned long long)Now.Dropped,
+				(Now.Commands - Last.Commands) / Secs,
+				(Now.Events - Last.Events) / Secs,
+				(Now.BytesSent - Last.BytesSent) / (1024.0 * 1024.0) / Secs);
+			
+			std::cout << Line << std::endl;
+			
+			Last = Now;
+		});
+	
+	if (StatsEverySecs > 0.0) StatsTimer.start(static_cast<int>(StatsEverySecs * 1000.0));
+	
+	return App.exec();
+}
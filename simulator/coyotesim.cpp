@@ -0,0 +1,992 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include "coyotesim.h"
+#include "compactwire.h"
+
+#include <cmath>
+
+static int argc = 1; //Fake argv/argc for Qt, same as native_ws.cpp
+static char **argv1 = new char* { (char*)"coyotesim" };
+
+static const char *StatusText(const Coyote::StatusCode Status)
+{
+	switch (Status)
+	{
+		case Coyote::COYOTE_STATUS_OK: return "OK";
+		case Coyote::COYOTE_STATUS_FAILED: return "Failed";
+		case Coyote::COYOTE_STATUS_UNIMPLEMENTED: return "Unimplemented";
+		case Coyote::COYOTE_STATUS_MISUSED: return "Misused";
+		case Coyote::COYOTE_STATUS_UNSUPPORTED: return "Unsupported";
+		default: return "Internal error";
+	}
+}
+
+static int32_t ArgPK(const msgpack::object &Args)
+{
+	std::unordered_map<std::string, msgpack::object> Map;
+	
+	Args.convert(Map);
+	
+	return Map.at("PK").as<int32_t>();
+}
+
+template <typename T>
+static msgpack::object PackArray(const std::vector<T> &Items, msgpack::zone &TempZone)
+{
+	std::vector<msgpack::object> Objects;
+	Objects.reserve(Items.size());
+	
+	for (const T &Item : Items) Objects.emplace_back(MsgpackProc::PackCoyoteObject(&Item, TempZone));
+	
+	return msgpack::object { Objects, TempZone };
+}
+
+CoyoteSim::Unit::Unit(const UnitConfig &Config)
+	: Config(Config),
+	Random(Config.Seed),
+	LastTimeCodeMS(),
+	HWState(),
+	Accepted(),
+	Dropped(),
+	Commands(),
+	Events(),
+	BytesSent(),
+	NumClients()
+{
+	this->BuildState();
+}
+
+CoyoteSim::Unit::~Unit(void)
+{
+	this->Stop();
+}
+
+void CoyoteSim::Unit::BuildState(void)
+{
+	this->Assets.reserve(this->Config.NumAssets);
+	
+	for (uint32_t Inc = 0u; Inc < this->Config.NumAssets; ++Inc)
+	{
+		Coyote::Asset A {};
+		
+		A.FullPath = "/Volumes/Media/Library/Folder" + std::to_string(Inc / 100) + "/asset_" + std::to_string(Inc) + ".mov";
+		A.Checksum = "d41d8cd98f00b204e9800998ecf8427e";
+		A.LastModified = 1650000000 + Inc;
+		A.TotalSize = A.CurrentSize = 1024 * 1024 * 512;
+		A.Status = Coyote::COYOTE_ASSETSTATE_READY;
+		
+		this->Assets.emplace_back(std::move(A));
+	}
+	
+	for (uint32_t Inc = 0u; Inc < this->Config.NumPresets; ++Inc)
+	{
+		const int32_t PK = Inc + 1;
+		
+		Coyote::Preset P {};
+		
+		P.PK = PK;
+		P.Name = "Preset " + std::to_string(PK);
+		P.Color = "#3070C0";
+		P.Loop = 1;
+		P.Volume = { 100, 100, 100, 100, 100, 100, 100, 100 };
+		
+		Coyote::CanvasInfo Canvas {};
+		
+		Canvas.Index = 1;
+		Canvas.SinkTypes = Coyote::COYOTE_SINK_KONA;
+		Canvas.CanvasCfg = Coyote::ProjectorCanvasConfig{ Coyote::CanvasOrientation{ Coyote::CanvasOrientationEnum::Standard }, Coyote::Size2D{ 1920, 1080 }, 1 };
+		
+		if (!this->Assets.empty())
+		{
+			Coyote::PinnedAsset Pinned {};
+			
+			Pinned.FullPath = this->Assets[Inc % this->Assets.size()].FullPath;
+			Pinned.Hue = Pinned.Saturation = Pinned.Brightness = Pinned.Contrast = 1.0f;
+			
+			Canvas.Assets.emplace_back(std::move(Pinned));
+		}
+		
+		P.Canvases.emplace_back(std::move(Canvas));
+		
+		Coyote::PresetState State {};
+		
+		State.PK = PK;
+		State.TRT = 60000 * (1 + Inc % 10);
+		State.IsSelected = !Inc;
+		
+		this->Presets.emplace_back(std::move(P));
+		this->PresetStates.push_back(State);
+		this->Playheads[PK] = 0.0;
+	}
+	
+	this->HWState.Resolutions = { { Coyote::COYOTE_RES_1080P, Coyote::COYOTE_RES_1080P, Coyote::COYOTE_RES_1080P, Coyote::COYOTE_RES_1080P } };
+	this->HWState.RefreshRate = Coyote::COYOTE_REFRESH_59_94;
+	this->HWState.HDRMode = Coyote::COYOTE_HDR_DISABLED;
+	this->HWState.EOTFSetting = Coyote::COYOTE_EOTF_NORMAL;
+	this->HWState.AudioConfig = Coyote::COYOTE_KAC_DISABLED;
+	
+	//A plain gradient. Miniview load is about bytes per second, what's in them doesn't matter.
+	const Coyote::Size2D &Size { this->Config.MiniviewSize };
+	
+	this->MiniviewPixels.resize(static_cast<size_t>(std::max(Size.Width, 0)) * std::max(Size.Height, 0) * 3u);
+	
+	for (size_t Inc = 0u; Inc < this->MiniviewPixels.size(); ++Inc) this->MiniviewPixels[Inc] = static_cast<uint8_t>(Inc / 3u);
+}
+
+bool CoyoteSim::Unit::Start(void)
+{
+	this->Server.reset(new QWebSocketServer { QString::fromStdString(this->Config.UnitID), QWebSocketServer::NonSecureMode });
+	
+	if (!this->Server->listen(QHostAddress { QString::fromStdString(this->Config.Address) }, this->Config.Port))
+	{
+		std::cerr << "coyotesim: Can't listen on " << this->Config.Address << ":" << this->Config.Port << ", " << qs2cs(this->Server->errorString()) << std::endl;
+		this->Server.reset();
+		return false;
+	}
+	
+	QObject::connect(this->Server.get(), &QWebSocketServer::newConnection, this, [this] { this->OnNewConnection(); });
+	
+	this->Clock.start();
+	this->LastTimeCodeMS = 0;
+	
+	this->StartTimer(this->Config.TimeCodeHz, [this] { this->TickTimeCode(); });
+	this->StartTimer(this->Config.PresetChurnHz, [this] { this->TickPresetChurn(); });
+	this->StartTimer(this->Config.AssetChurnHz, [this] { this->TickAssetChurn(); });
+	this->StartTimer(this->Config.MiniviewHz, [this] { this->TickMiniviews(); });
+	
+	if (this->Config.DisconnectEverySecs > 0.0)
+	{
+		this->DisconnectTimer.reset(new QTimer);
+		this->DisconnectTimer->setSingleShot(true);
+		
+		QObject::connect(this->DisconnectTimer.get(), &QTimer::timeout, this, [this]
+			{
+				if (!this->Clients.empty())
+				{
+					auto Iter = this->Clients.begin();
+					
+					std::advance(Iter, std::uniform_int_distribution<size_t>{ 0u, this->Clients.size() - 1u }(this->Random));
+					
+					++this->Dropped;
+					
+					Iter->first->abort(); //Disconnected handler cleans up
+				}
+				
+				this->ScheduleDisconnect();
+			});
+		
+		this->ScheduleDisconnect();
+	}
+	
+	return true;
+}
+
+void CoyoteSim::Unit::Stop(void)
+{
+	this->Timers.clear();
+	this->DisconnectTimer.reset();
+	
+	for (auto &Pair : this->Clients)
+	{
+		QObject::disconnect(Pair.first, nullptr, this, nullptr);
+		Pair.first->abort();
+		delete Pair.first;
+	}
+	
+	this->Clients.clear();
+	this->NumClients = 0u;
+	
+	if (this->Server) this->Server->close();
+	
+	this->Server.reset();
+}
+
+CoyoteSim::Stats CoyoteSim::Unit::GetStats(void) const
+{
+	return Stats { this->Accepted.load(), this->Dropped.load(), this->Commands.load(), this->Events.load(), this->BytesSent.load(), this->NumClients.load() };
+}
+
+void CoyoteSim::Unit::StartTimer(const double Hz, std::function<void(void)> Tick)
+{
+	if (!(Hz > 0.0)) return;
+	
+	std::unique_ptr<QTimer> Timer { new QTimer };
+	
+	Timer->setTimerType(Qt::PreciseTimer);
+	
+	QObject::connect(Timer.get(), &QTimer::timeout, this, std::move(Tick));
+	
+	Timer->start(std::max(1, static_cast<int>(std::lround(1000.0 / Hz))));
+	
+	this->Timers.emplace_back(std::move(Timer));
+}
+
+void CoyoteSim::Unit::ScheduleDisconnect(void)
+{ //Exponential gaps, so drops come at random like real network trouble does instead of in lockstep across units.
+	const double Secs = std::exponential_distribution<double>{ 1.0 / this->Config.DisconnectEverySecs }(this->Random);
+	
+	this->DisconnectTimer->start(static_cast<int>(std::min(Secs * 1000.0, 3600000.0)));
+}
+
+void CoyoteSim::Unit::OnNewConnection(void)
+{
+	while (this->Server->hasPendingConnections())
+	{
+		QWebSocket *const Socket = this->Server->nextPendingConnection();
+		
+		Client &Conn { this->Clients[Socket] };
+		
+		Conn.Socket = Socket;
+		Conn.Subscriptions = 0u;
+		Conn.PendingFullState = 0u;
+		Conn.LastDueMS = 0;
+		Conn.CompactKeyLimit = 0u;
+		Conn.PendingKeyLimit = 0u;
+		
+		//The server owns sockets it hands out until they're deleted, which we do ourselves.
+		Socket->setParent(nullptr);
+		
+		QObject::connect(Socket, &QWebSocket::binaryMessageReceived, this, [this, Socket] (const QByteArray &Data) { this->OnBinaryMessage(Socket, Data); });
+		QObject::connect(Socket, &QWebSocket::disconnected, this, [this, Socket] { this->OnDisconnected(Socket); });
+		
+		++this->Accepted;
+		this->NumClients = this->Clients.size();
+	}
+}
+
+void CoyoteSim::Unit::OnDisconnected(QWebSocket *Socket)
+{
+	if (!this->Clients.erase(Socket)) return;
+	
+	this->NumClients = this->Clients.size();
+	
+	Socket->deleteLater();
+}
+
+void CoyoteSim::Unit::OnBinaryMessage(QWebSocket *Socket, const QByteArray &Data)
+{ //Reassembled exactly the way WSConnection::AddFragment() does it on the client side.
+	const auto Iter = this->Clients.find(Socket);
+	
+	if (Iter == this->Clients.end()) return;
+	
+	Client &Conn { Iter->second };
+	
+	if (!Conn.Partial) Conn.Partial.reset(new WSMessage::Fragment(Data.data(), Data.size()));
+	else Conn.Partial->Append(Data.data(), Data.size());
+	
+	if (!Conn.Partial->IsComplete()) return;
+	
+	const std::unique_ptr<WSMessage> Msg { Conn.Partial->Graduate() };
+	
+	Conn.Partial.reset();
+	
+	this->HandleCommand(Conn, Msg->GetBody(), Msg->GetBodySize());
+}
+
+const std::unordered_map<std::string, CoyoteSim::Unit::CommandHandler> &CoyoteSim::Unit::CommandTable(void)
+{
+	static const std::unordered_map<std::string, CommandHandler> Table
+	{
+		{ "GetUnitType", &Unit::GetUnitType },
+		{ "SetWireEncoding", &Unit::SetWireEncoding },
+		{ "GetHostOS", &Unit::GetHostOS },
+		{ "GetSupportedSinks", &Unit::GetSupportedSinks },
+		{ "GetUnitID", &Unit::GetUnitID },
+		{ "GetServerVersion", &Unit::GetServerVersion },
+		{ "GetKonaHardwareState", &Unit::GetKonaHardwareState },
+		{ "GetDisks", &Unit::GetDisks },
+		{ "IsMirror", &Unit::IsMirror },
+		{ "SubscribeTC", &Unit::Subscribe },
+		{ "SubscribeAssets", &Unit::Subscribe },
+		{ "SubscribePresetStates", &Unit::Subscribe },
+		{ "SubscribePresets", &Unit::Subscribe },
+		{ "SubscribeHWState", &Unit::Subscribe },
+		{ "SubscribePlaybackEvents", &Unit::Subscribe },
+		{ "SubscribeMiniview", &Unit::SubscribeMiniview },
+		{ "UnsubscribeMiniview", &Unit::UnsubscribeMiniview },
+		{ "Take", &Unit::Playback },
+		{ "Pause", &Unit::Playback },
+		{ "SetPause", &Unit::Playback },
+		{ "UnsetPause", &Unit::Playback },
+		{ "End", &Unit::Playback },
+		{ "SeekTo", &Unit::Playback },
+		{ "SelectPreset", &Unit::SelectPreset },
+	};
+	
+	return Table;
+}
+
+void CoyoteSim::Unit::HandleCommand(Client &Conn, const uint8_t *Body, const size_t Length)
+{
+	POOLED_ZONE(TempZone);
+	
+	std::unordered_map<std::string, msgpack::object> Values;
+	
+	try
+	{ //Compact clients intern their keys, this expands them back the same way the client does for us.
+		Values = MsgpackProc::InitIncomingMsg(Body, Length, TempZone);
+	}
+	catch (const std::exception &Err)
+	{
+		std::cerr << "coyotesim: Undecodable message from client, " << Err.what() << std::endl;
+		return;
+	}
+	
+	if (!Values.count("CommandName") || !Values.count("MsgID")) return; //Pings and anything else nobody waits on
+	
+	const std::string Command { Values.at("CommandName").as<std::string>() };
+	const uint64_t MsgID = Values.at("MsgID").as<uint64_t>();
+	const msgpack::object Args { Values.count("Data") ? Values.at("Data") : msgpack::object{} };
+	
+	msgpack::object DataOut;
+	Coyote::StatusCode Status = Coyote::COYOTE_STATUS_UNIMPLEMENTED;
+	
+	const auto Iter = CommandTable().find(Command);
+	
+	if (Iter != CommandTable().end())
+	{
+		try
+		{
+			Status = (this->*Iter->second)(Conn, Command, Args, TempZone, DataOut);
+		}
+		catch (const std::exception &Err)
+		{ //Missing or mistyped arguments
+			LDEBUG_MSG("coyotesim: Bad arguments to " << Command << ", " << Err.what());
+			Status = Coyote::COYOTE_STATUS_MISUSED;
+			DataOut = msgpack::object{};
+		}
+	}
+	
+	++this->Commands;
+	
+	POOLED_SBUFFER(Buffer);
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+	
+	const bool HasData = DataOut.type != msgpack::type::NIL;
+	
+	Pack.pack_map(5 + HasData);
+	Pack.pack("CommandName");
+	Pack.pack(Command);
+	Pack.pack("CoyoteAPIVersion");
+	Pack.pack(COYOTE_API_VERSION);
+	Pack.pack("MsgID");
+	Pack.pack(MsgID);
+	Pack.pack("StatusInt");
+	Pack.pack(static_cast<int>(Status));
+	Pack.pack("StatusText");
+	Pack.pack(StatusText(Status));
+	
+	if (HasData)
+	{
+		Pack.pack("Data");
+		Pack.pack(DataOut);
+	}
+	
+	this->SendTo(Conn, Frame(Buffer));
+	
+	if (Conn.PendingKeyLimit)
+	{
+		Conn.CompactKeyLimit = Conn.PendingKeyLimit;
+		Conn.PendingKeyLimit = 0u;
+	}
+	
+	if (Conn.PendingFullState)
+	{
+		this->SendFullState(Conn, Conn.PendingFullState);
+		Conn.PendingFullState = 0u;
+	}
+}
+
+QByteArray CoyoteSim::Unit::Frame(const msgpack::sbuffer &Buffer)
+{ //Same bytes WSConnection::ProcessOutgoingMsgs() puts on the wire, WSMessage knows the length prefix.
+	WSMessage Msg { Buffer.data(), Buffer.size() };
+	
+	return QByteArray { reinterpret_cast<const char*>(Msg.GetSeekedBody() - sizeof(uint32_t)), static_cast<int>(Msg.GetRemainingSize() + sizeof(uint32_t)) };
+}
+
+QByteArray CoyoteSim::Unit::EventFrame(const char *EventName, const msgpack::object &Data)
+{
+	POOLED_SBUFFER(Buffer);
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+	
+	Pack.pack_map(2);
+	Pack.pack("SubscriptionEvent");
+	Pack.pack(EventName);
+	Pack.pack("Data");
+	Pack.pack(Data);
+	
+	return Frame(Buffer);
+}
+
+QByteArray CoyoteSim::Unit::CompactFrame(const QByteArray &PlainFrame, const uint16_t KeyLimit)
+{ //Re-encodes a finished frame. Only compact clients pay for it, and broadcasts only do it once.
+	POOLED_ZONE(TempZone);
+	POOLED_SBUFFER(Buffer);
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+	
+	const msgpack::object Plain { msgpack::unpack(TempZone, PlainFrame.constData() + sizeof(uint32_t), PlainFrame.size() - sizeof(uint32_t)) };
+	
+	CompactWire::PackObject(Pack, Plain, KeyLimit);
+	
+	return Frame(Buffer);
+}
+
+QByteArray CoyoteSim::Unit::PresetsFrame(void) const
+{
+	POOLED_ZONE(TempZone);
+	
+	return EventFrame("PresetsUpdate", PackArray(this->Presets, TempZone));
+}
+
+QByteArray CoyoteSim::Unit::PresetStatesFrame(void) const
+{
+	POOLED_ZONE(TempZone);
+	
+	return EventFrame("PresetStatesUpdate", PackArray(this->PresetStates, TempZone));
+}
+
+QByteArray CoyoteSim::Unit::AssetSyncFrame(void) const
+{
+	POOLED_ZONE(TempZone);
+	
+	return EventFrame("AssetSync", PackArray(this->Assets, TempZone));
+}
+
+QByteArray CoyoteSim::Unit::HWStateFrame(void) const
+{
+	POOLED_ZONE(TempZone);
+	
+	return EventFrame("KonaHardwareStateUpdate", MsgpackProc::PackCoyoteObject(&this->HWState, TempZone));
+}
+
+void CoyoteSim::Unit::SendTo(Client &Conn, const QByteArray &Frame)
+{
+	this->Transmit(Conn, Conn.CompactKeyLimit ? CompactFrame(Frame, Conn.CompactKeyLimit) : Frame);
+}
+
+void CoyoteSim::Unit::Transmit(Client &Conn, const QByteArray &Frame)
+{
+	this->BytesSent += Frame.size();
+	
+	if (!this->Config.LatencyMS && !this->Config.JitterMS)
+	{
+		Conn.Socket->sendBinaryMessage(Frame);
+		return;
+	}
+	
+	const int64_t Jitter = this->Config.JitterMS ? std::uniform_int_distribution<int64_t>{ -static_cast<int64_t>(this->Config.JitterMS), this->Config.JitterMS }(this->Random) : 0;
+	const qint64 Now = this->Clock.elapsed();
+	
+	//Never before the previous message to this client, a WebSocket doesn't reorder.
+	//Qt fires timers due at the same time in the order they were started, so equal due times are fine.
+	const qint64 Due = std::max<qint64>(Now + std::max<int64_t>(this->Config.LatencyMS + Jitter, 0), Conn.LastDueMS);
+	
+	Conn.LastDueMS = Due;
+	
+	const QPointer<QWebSocket> Target { Conn.Socket };
+	
+	QTimer::singleShot(static_cast<int>(Due - Now), Qt::PreciseTimer, this, [Target, Frame] { if (Target) Target->sendBinaryMessage(Frame); });
+}
+
+void CoyoteSim::Unit::Broadcast(const uint32_t Flag, const QByteArray &Frame)
+{ //Built once, sent to everyone who asked for it. Compact clients share one re-encoded copy per key limit.
+	std::map<uint16_t, QByteArray> Compacted;
+	
+	for (auto &Pair : this->Clients)
+	{
+		Client &Conn { Pair.second };
+		
+		if (!(Conn.Subscriptions & Flag)) continue;
+		
+		++this->Events;
+		
+		if (!Conn.CompactKeyLimit)
+		{
+			this->Transmit(Conn, Frame);
+			continue;
+		}
+		
+		QByteArray &Compact { Compacted[Conn.CompactKeyLimit] };
+		
+		if (Compact.isEmpty()) Compact = CompactFrame(Frame, Conn.CompactKeyLimit);
+		
+		this->Transmit(Conn, Compact);
+	}
+}
+
+void CoyoteSim::Unit::SendFullState(Client &Conn, const uint32_t Flags)
+{
+	const struct
+	{
+		uint32_t Flag;
+		QByteArray (Unit::*Build)(void) const;
+	} Feeds[] =
+	{
+		{ Coyote::COYOTE_SUB_PRESETS, &Unit::PresetsFrame },
+		{ Coyote::COYOTE_SUB_PRESETSTATES, &Unit::PresetStatesFrame },
+		{ Coyote::COYOTE_SUB_ASSETS, &Unit::AssetSyncFrame },
+		{ Coyote::COYOTE_SUB_HWSTATE, &Unit::HWStateFrame },
+	};
+	
+	for (const auto &Feed : Feeds)
+	{
+		if (!(Flags & Feed.Flag)) continue;
+		
+		++this->Events;
+		this->SendTo(Conn, (this->*Feed.Build)());
+	}
+}
+
+void CoyoteSim::Unit::BroadcastPlaybackEvent(const Coyote::PlaybackEventType EType, const int32_t PK, const int32_t NewTime)
+{
+	POOLED_ZONE(TempZone);
+	
+	const std::unordered_map<std::string, msgpack::object> Values
+	{
+		{ "EType", msgpack::object{ static_cast<int>(EType), TempZone } },
+		{ "PK", msgpack::object{ PK, TempZone } },
+		{ "NewTime", msgpack::object{ NewTime, TempZone } },
+	};
+	
+	this->Broadcast(Coyote::COYOTE_SUB_PLAYBACKEVENTS, EventFrame("PlaybackEvent", MsgpackProc::STLMapToMsgpackMap(Values, TempZone)));
+}
+
+Coyote::PresetState *CoyoteSim::Unit::FindState(const int32_t PK)
+{ //PK 0 is whatever's selected, same as on a real unit.
+	for (Coyote::PresetState &State : this->PresetStates)
+	{
+		if (PK ? State.PK == PK : State.IsSelected) return &State;
+	}
+	
+	return nullptr;
+}
+
+void CoyoteSim::Unit::TickTimeCode(void)
+{
+	const qint64 Now = this->Clock.elapsed();
+	const double StepMS = static_cast<double>(Now - this->LastTimeCodeMS);
+	
+	this->LastTimeCodeMS = Now;
+	
+	POOLED_ZONE(TempZone);
+	Coyote::TimeCode TC {};
+	
+	TC.VUData.resize(this->Config.NumVUChannels);
+	
+	bool StatesChanged = false;
+	
+	for (Coyote::PresetState &State : this->PresetStates)
+	{
+		if (!State.IsPlaying) continue;
+		
+		double &Playhead { this->Playheads[State.PK] };
+		
+		if (!State.IsPaused) Playhead += StepMS;
+		
+		if (State.TRT > 0 && Playhead >= State.TRT)
+		{
+			Playhead = std::fmod(Playhead, State.TRT);
+			++State.CurrentLoop;
+			StatesChanged = true;
+		}
+		
+		TC.PK = State.PK;
+		TC.Time = static_cast<int32_t>(Playhead);
+		
+		//Somewhere around program level, with enough movement to exercise meter ballistics.
+		std::uniform_int_distribution<int32_t> Level { -40, -3 };
+		
+		for (int32_t &Value : TC.VUData) Value = State.IsPaused ? -90 : Level(this->Random);
+		
+		this->Broadcast(Coyote::COYOTE_SUB_TIMECODE, EventFrame("TimeCode", MsgpackProc::PackCoyoteObject(&TC, TempZone)));
+	}
+	
+	if (StatesChanged) this->Broadcast(Coyote::COYOTE_SUB_PRESETSTATES, this->PresetStatesFrame());
+}
+
+void CoyoteSim::Unit::SendTimeCode(const Coyote::TimeCode &TC)
+{
+	POOLED_ZONE(TempZone);
+	
+	this->Broadcast(Coyote::COYOTE_SUB_TIMECODE, EventFrame("TimeCode", MsgpackProc::PackCoyoteObject(&TC, TempZone)));
+}
+
+void CoyoteSim::Unit::TickPresetChurn(void)
+{ //Real units send the whole list for any edit, so this costs what an operator editing a show costs.
+	if (this->Presets.empty()) return;
+	
+	Coyote::Preset &Target { this->Presets[std::uniform_int_distribution<size_t>{ 0u, this->Presets.size() - 1u }(this->Random)] };
+	
+	Target.Notes = "Edited at " + std::to_string(this->Clock.elapsed());
+	
+	this->Broadcast(Coyote::COYOTE_SUB_PRESETS, this->PresetsFrame());
+}
+
+void CoyoteSim::Unit::TickAssetChurn(void)
+{
+	if (this->Assets.empty()) return;
+	
+	Coyote::Asset &Target { this->Assets[std::uniform_int_distribution<size_t>{ 0u, this->Assets.size() - 1u }(this->Random)] };
+	
+	Target.LastModified += 1;
+	
+	POOLED_ZONE(TempZone);
+	
+	this->Broadcast(Coyote::COYOTE_SUB_ASSETS, EventFrame("AssetPost", MsgpackProc::PackCoyoteObject(&Target, TempZone)));
+}
+
+void CoyoteSim::Unit::TickMiniviews(void)
+{
+	std::map<int32_t, QByteArray> Frames; //Per PK, shared by every client watching it
+	
+	for (auto &Pair : this->Clients)
+	{
+		for (const int32_t PK : Pair.second.Miniviews)
+		{
+			QByteArray &Built { Frames[PK] };
+			
+			if (Built.isEmpty())
+			{
+				POOLED_SBUFFER(Buffer);
+				msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+				
+				Pack.pack_map(2);
+				Pack.pack("SubscriptionEvent");
+				Pack.pack("MiniviewPost");
+				Pack.pack("Data");
+				Pack.pack_map(6);
+				Pack.pack("PK");
+				Pack.pack(PK);
+				Pack.pack("CanvasIndex");
+				Pack.pack(0u);
+				Pack.pack("OutputNum");
+				Pack.pack(0u);
+				Pack.pack("Width");
+				Pack.pack(this->Config.MiniviewSize.Width);
+				Pack.pack("Height");
+				Pack.pack(this->Config.MiniviewSize.Height);
+				Pack.pack("Bytes");
+				Pack.pack_bin(this->MiniviewPixels.size());
+				Pack.pack_bin_body(reinterpret_cast<const char*>(this->MiniviewPixels.data()), this->MiniviewPixels.size());
+				
+				Built = Frame(Buffer);
+			}
+			
+			++this->Events;
+			this->SendTo(Pair.second, Built);
+		}
+	}
+}
+
+//Command handlers
+Coyote::StatusCode CoyoteSim::Unit::GetUnitType(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{ //WireEncodings is only advertised with CompactWire on, otherwise clients stay with plain maps.
+	std::unordered_map<std::string, msgpack::object> Values { { "UnitType", msgpack::object{ static_cast<int>(this->Config.UType), TempZone } } };
+	
+	if (this->Config.CompactWire)
+	{
+		const std::vector<std::string> Encodings { CompactWire::EncodingName };
+		
+		Values.emplace("WireEncodings", msgpack::object{ Encodings, TempZone });
+		Values.emplace("WireKeyCount", msgpack::object{ WireSchema::NumWireKeys, TempZone });
+	}
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::SetWireEncoding(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	if (!this->Config.CompactWire) return Coyote::COYOTE_STATUS_UNIMPLEMENTED;
+	
+	std::unordered_map<std::string, msgpack::object> Values;
+	Args.convert(Values);
+	
+	if (Values.at("Encoding").as<std::string>() != CompactWire::EncodingName) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	const uint16_t WireKeyCount = std::min<uint16_t>(Values.at("WireKeyCount").as<uint16_t>(), WireSchema::NumWireKeys);
+	
+	if (!WireKeyCount) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	Conn.PendingKeyLimit = WireKeyCount;
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetHostOS(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const std::unordered_map<std::string, msgpack::object> Values { { "HostOS", msgpack::object{ "Linux", TempZone } } };
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetSupportedSinks(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const std::unordered_map<std::string, msgpack::object> Values { { "SupportedSinks", msgpack::object{ this->Config.SupportedSinks, TempZone } } };
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetUnitID(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const std::unordered_map<std::string, msgpack::object> Values
+	{
+		{ "UnitID", msgpack::object{ this->Config.UnitID, TempZone } },
+		{ "Nickname", msgpack::object{ this->Config.Nickname, TempZone } },
+	};
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetServerVersion(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const std::unordered_map<std::string, msgpack::object> Values { { "Version", msgpack::object{ "coyotesim", TempZone } } };
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetKonaHardwareState(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	DataOut = MsgpackProc::PackCoyoteObject(&this->HWState, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::GetDisks(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	Coyote::Drive Media {};
+	
+	Media.Mountpoint = "/Volumes/Media";
+	Media.Total = 4ll * 1024 * 1024 * 1024 * 1024;
+	Media.Used = static_cast<int64_t>(this->Assets.size()) * 1024 * 1024 * 512;
+	Media.Free = std::max<int64_t>(Media.Total - Media.Used, 0);
+	
+	DataOut = PackArray(std::vector<Coyote::Drive>{ Media }, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::IsMirror(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const std::unordered_map<std::string, msgpack::object> Values { { "IsMirror", msgpack::object{ false, TempZone } } };
+	
+	DataOut = MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::Subscribe(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	static const std::unordered_map<std::string, uint32_t> Flags
+	{
+		{ "SubscribeTC", Coyote::COYOTE_SUB_TIMECODE },
+		{ "SubscribeAssets", Coyote::COYOTE_SUB_ASSETS },
+		{ "SubscribePresetStates", Coyote::COYOTE_SUB_PRESETSTATES },
+		{ "SubscribePresets", Coyote::COYOTE_SUB_PRESETS },
+		{ "SubscribeHWState", Coyote::COYOTE_SUB_HWSTATE },
+		{ "SubscribePlaybackEvents", Coyote::COYOTE_SUB_PLAYBACKEVENTS },
+	};
+	
+	const uint32_t Flag = Flags.at(Command);
+	
+	if (!(Conn.Subscriptions & Flag)) Conn.PendingFullState |= Flag;
+	
+	Conn.Subscriptions |= Flag;
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::SubscribeMiniview(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	Conn.Miniviews.insert(ArgPK(Args));
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::UnsubscribeMiniview(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	Conn.Miniviews.erase(ArgPK(Args));
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::Playback(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	std::unordered_map<std::string, msgpack::object> Map;
+	
+	Args.convert(Map);
+	
+	Coyote::PresetState *const State = this->FindState(Map.at("PK").as<int32_t>());
+	
+	if (!State) return Coyote::COYOTE_STATUS_FAILED;
+	
+	double &Playhead { this->Playheads[State->PK] };
+	Coyote::PlaybackEventType EType;
+	
+	if (Command == "Take")
+	{
+		State->IsPlaying = true;
+		State->IsPaused = false;
+		State->CurrentLoop = 0u;
+		Playhead = 0.0;
+		EType = Coyote::COYOTE_PBEVENT_TAKE;
+	}
+	else if (Command == "Pause" || Command == "SetPause")
+	{
+		State->IsPaused = true;
+		EType = Coyote::COYOTE_PBEVENT_PAUSE;
+	}
+	else if (Command == "UnsetPause")
+	{
+		State->IsPaused = false;
+		EType = Coyote::COYOTE_PBEVENT_UNPAUSE;
+	}
+	else if (Command == "End")
+	{
+		State->IsPlaying = State->IsPaused = false;
+		Playhead = 0.0;
+		EType = Coyote::COYOTE_PBEVENT_END;
+	}
+	else
+	{
+		Playhead = Map.at("TimeIndex").as<uint32_t>();
+		EType = Coyote::COYOTE_PBEVENT_SEEK;
+	}
+	
+	this->Broadcast(Coyote::COYOTE_SUB_PRESETSTATES, this->PresetStatesFrame());
+	this->BroadcastPlaybackEvent(EType, State->PK, static_cast<int32_t>(Playhead));
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode CoyoteSim::Unit::SelectPreset(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut)
+{
+	const int32_t PK = ArgPK(Args);
+	
+	if (!PK || !this->FindState(PK)) return Coyote::COYOTE_STATUS_FAILED;
+	
+	for (Coyote::PresetState &State : this->PresetStates) State.IsSelected = State.PK == PK;
+	
+	this->Broadcast(Coyote::COYOTE_SUB_PRESETSTATES, this->PresetStatesFrame());
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+//Farm
+std::string CoyoteSim::Farm::NthAddress(const std::string &First, const uint32_t N)
+{
+	const QHostAddress Base { QString::fromStdString(First) };
+	
+	return QHostAddress { Base.toIPv4Address() + N }.toString().toStdString();
+}
+
+size_t CoyoteSim::Farm::Start(void)
+{
+	//Qt networking needs an application object, and a process that only hosts simulated units might not have one yet.
+	if (!QCoreApplication::instance()) new QCoreApplication(argc, argv1);
+	
+	this->Stop();
+	
+	const uint32_t NumThreads = std::max(1u, std::min(this->Config.NumThreads, this->Config.NumUnits));
+	
+	for (uint32_t Inc = 0u; Inc < NumThreads; ++Inc)
+	{
+		this->Threads.emplace_back(new QThread);
+		this->Threads.back()->start();
+	}
+	
+	size_t Listening = 0u;
+	
+	for (uint32_t Inc = 0u; Inc < this->Config.NumUnits; ++Inc)
+	{
+		UnitConfig Cfg { this->Config.Template };
+		
+		Cfg.Address = NthAddress(this->Config.FirstAddress, Inc);
+		Cfg.UnitID = "SIMULATED-" + std::to_string(Inc);
+		Cfg.Nickname = this->Config.Template.Nickname + " " + std::to_string(Inc + 1);
+		Cfg.Seed = this->Config.Template.Seed + Inc;
+		
+		std::unique_ptr<Unit> NewUnit { new Unit { Cfg } };
+		
+		NewUnit->moveToThread(this->Threads[Inc % NumThreads].get());
+		
+		bool Started = false;
+		Unit *const Ptr = NewUnit.get();
+		
+		QMetaObject::invokeMethod(Ptr, [Ptr, &Started] { Started = Ptr->Start(); }, Qt::BlockingQueuedConnection);
+		
+		Listening += Started;
+		
+		this->Units.emplace_back(std::move(NewUnit));
+	}
+	
+	return Listening;
+}
+
+void CoyoteSim::Farm::Stop(void)
+{
+	//Sockets and timers have to go on the thread that made them.
+	for (std::unique_ptr<Unit> &Item : this->Units)
+	{
+		Unit *const Ptr = Item.get();
+		
+		QMetaObject::invokeMethod(Ptr, [Ptr] { Ptr->Stop(); }, Qt::BlockingQueuedConnection);
+	}
+	
+	for (std::unique_ptr<QThread> &Thread : this->Threads)
+	{
+		Thread->quit();
+		Thread->wait();
+	}
+	
+	this->Units.clear();
+	this->Threads.clear();
+}
+
+CoyoteSim::Stats CoyoteSim::Farm::GetStats(void) const
+{
+	Stats RetVal {};
+	
+	for (const std::unique_ptr<Unit> &Item : this->Units)
+	{
+		const Stats Part { Item->GetStats() };
+		
+		RetVal.Accepted += Part.Accepted;
+		RetVal.Dropped += Part.Dropped;
+		RetVal.Commands += Part.Commands;
+		RetVal.Events += Part.Events;
+		RetVal.BytesSent += Part.BytesSent;
+		RetVal.Clients += Part.Clients;
+	}
+	
+	return RetVal;
+}
+
+CoyoteSim::Farm::~Farm(void)
+{
+	this->Stop();
+}
@@ -0,0 +1,203 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#ifndef __LIBCOYOTE_COYOTESIM_H__
+#define __LIBCOYOTE_COYOTESIM_H__
+
+#include "msgpackproc.h"
+#include "native_ws.h"
+
+#include <set>
+#include <random>
+#include <QWebSocketServer>
+
+/**Loopback stand-ins for Coyote units, for load and latency testing libcoyote with no hardware.
+ * Each Unit listens on its own loopback address at WS::PortNum, speaks the same msgpack framing as a real unit,
+ * answers the connection handshake and the common playback commands, and pushes subscription traffic at configurable rates.
+ * Latency, jitter and dropped connections can be injected on top. A Farm spreads any number of units over a few threads,
+ * every address in 127.0.0.0/8 is local on Linux so thousands of units fit on one box.
+ * Nothing here has moc'd signals or slots, so it builds without running moc.**/
+
+namespace CoyoteSim
+{
+	struct UnitConfig
+	{
+		std::string Address = "127.0.0.1";
+		uint16_t Port = WS::PortNum;
+		std::string UnitID = "SIMULATED-0";
+		std::string Nickname = "Simulated Coyote";
+		Coyote::UnitType UType = Coyote::COYOTE_UTYPE_FLEX;
+		std::vector<std::string> SupportedSinks { "kona" };
+		bool CompactWire = false; //Advertise the compact encoding and switch to it for clients that ask, like a current unit would
+		
+		//Subscription load
+		uint32_t NumPresets = 16;
+		uint32_t NumAssets = 1000;
+		uint32_t NumVUChannels = 16;
+		double TimeCodeHz = 30.0; //Per playing preset
+		double PresetChurnHz = 0.0; //Edits to a random preset, each one sends a full PresetsUpdate
+		double AssetChurnHz = 0.0; //AssetPosts for random assets
+		double MiniviewHz = 0.0; //Per PK a client subscribed to with SubscribeMiniview
+		Coyote::Size2D MiniviewSize { 320, 180 }; //RGB24
+		
+		//Network misbehaviour
+		uint32_t LatencyMS = 0; //Added to everything sent, replies and events alike
+		uint32_t JitterMS = 0; //Up to this much more or less. Messages to one client still arrive in order.
+		double DisconnectEverySecs = 0.0; //Mean time between dropping a random client, zero for never
+		
+		uint32_t Seed = 1;
+	};
+	
+	struct Stats
+	{
+		uint64_t Accepted; //Connections
+		uint64_t Dropped; //Connections cut by DisconnectEverySecs
+		uint64_t Commands; //Answered, whether or not they're implemented
+		uint64_t Events; //Subscription messages sent, counted once per client
+		uint64_t BytesSent;
+		uint32_t Clients; //Connected right now
+	};
+	
+	class Unit : public QObject
+	{ //Lives on whatever thread it was moved to before Start(). Everything but GetStats() must be called from that thread.
+	private:
+		struct Client
+		{
+			QWebSocket *Socket;
+			std::unique_ptr<WSMessage::Fragment> Partial;
+			uint32_t Subscriptions; //SubscriptionFlags
+			std::set<int32_t> Miniviews;
+			uint32_t PendingFullState; //Feeds just subscribed to, their current state goes out right after the reply
+			qint64 LastDueMS; //Keeps injected jitter from reordering messages
+			uint16_t CompactKeyLimit; //Nonzero once this client has switched to the compact encoding
+			uint16_t PendingKeyLimit; //Takes effect after the SetWireEncoding reply, which still goes out as a plain map
+		};
+		
+		typedef Coyote::StatusCode (Unit::*CommandHandler)(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		
+		const UnitConfig Config;
+		std::unique_ptr<QWebSocketServer> Server;
+		std::map<QWebSocket*, Client> Clients;
+		std::vector<std::unique_ptr<QTimer> > Timers;
+		std::unique_ptr<QTimer> DisconnectTimer;
+		QElapsedTimer Clock;
+		std::mt19937 Random;
+		
+		std::vector<Coyote::Preset> Presets;
+		std::vector<Coyote::PresetState> PresetStates;
+		std::unordered_map<int32_t, double> Playheads; //Milliseconds, per PK
+		qint64 LastTimeCodeMS;
+		std::vector<Coyote::Asset> Assets;
+		Coyote::KonaHardwareState HWState;
+		std::vector<uint8_t> MiniviewPixels;
+		
+		std::atomic<uint64_t> Accepted, Dropped, Commands, Events, BytesSent;
+		std::atomic<uint32_t> NumClients;
+		
+		static const std::unordered_map<std::string, CommandHandler> &CommandTable(void);
+		
+		void OnNewConnection(void);
+		void OnBinaryMessage(QWebSocket *Socket, const QByteArray &Data);
+		void OnDisconnected(QWebSocket *Socket);
+		void HandleCommand(Client &Conn, const uint8_t *Body, const size_t Length);
+		
+		void SendTo(Client &Conn, const QByteArray &Frame); //Frame is always built plain, it's converted here for compact clients.
+		void Transmit(Client &Conn, const QByteArray &Frame);
+		void Broadcast(const uint32_t Flag, const QByteArray &Frame);
+		void SendFullState(Client &Conn, const uint32_t Flag);
+		void StartTimer(const double Hz, std::function<void(void)> Tick);
+		
+		static QByteArray Frame(const msgpack::sbuffer &Buffer);
+		static QByteArray EventFrame(const char *EventName, const msgpack::object &Data);
+		static QByteArray CompactFrame(const QByteArray &PlainFrame, const uint16_t KeyLimit);
+		QByteArray PresetsFrame(void) const;
+		QByteArray PresetStatesFrame(void) const;
+		QByteArray AssetSyncFrame(void) const;
+		QByteArray HWStateFrame(void) const;
+		void BroadcastPlaybackEvent(const Coyote::PlaybackEventType EType, const int32_t PK, const int32_t NewTime = 0);
+		
+		void TickTimeCode(void);
+		void TickPresetChurn(void);
+		void TickAssetChurn(void);
+		void TickMiniviews(void);
+		void ScheduleDisconnect(void);
+		
+		Coyote::PresetState *FindState(const int32_t PK);
+		void BuildState(void);
+		
+		//Command handlers
+		Coyote::StatusCode GetUnitType(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode SetWireEncoding(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetHostOS(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetSupportedSinks(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetUnitID(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetServerVersion(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetKonaHardwareState(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode GetDisks(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode IsMirror(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode Subscribe(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode SubscribeMiniview(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode UnsubscribeMiniview(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode Playback(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+		Coyote::StatusCode SelectPreset(Client &Conn, const std::string &Command, const msgpack::object &Args, msgpack::zone &TempZone, msgpack::object &DataOut);
+	public:
+		bool Start(void); //False if the address couldn't be bound
+		void Stop(void);
+		Stats GetStats(void) const;
+		inline const UnitConfig &GetConfig(void) const { return this->Config; }
+		void SendTimeCode(const Coyote::TimeCode &TC); //Right now, to every client subscribed to timecodes. For latency probes.
+		
+		Unit(const UnitConfig &Config);
+		~Unit(void);
+		
+		Unit(const Unit &) = delete;
+		Unit &operator=(const Unit &) = delete;
+	};
+	
+	struct FarmConfig
+	{
+		UnitConfig Template; //Address, UnitID, Nickname and Seed get filled in per unit
+		uint32_t NumUnits = 1;
+		std::string FirstAddress = "127.0.0.1"; //Units take consecutive IPv4 addresses from here
+		uint32_t NumThreads = 4;
+	};
+	
+	class Farm
+	{ //Owns the units and their threads. Start() and Stop() may be called from any thread that isn't one of ours.
+	private:
+		const FarmConfig Config;
+		std::vector<std::unique_ptr<QThread> > Threads;
+		std::vector<std::unique_ptr<Unit> > Units;
+	public:
+		size_t Start(void); //Returns how many units are listening
+		void Stop(void);
+		Stats GetStats(void) const; //Summed over every unit
+		inline size_t NumUnits(void) const { return this->Units.size(); }
+		inline const Unit &GetUnit(const size_t Index) const { return *this->Units[Index]; }
+		inline Unit &GetUnit(const size_t Index) { return *this->Units[Index]; }
+		
+		static std::string NthAddress(const std::string &First, const uint32_t N);
+		
+		Farm(const FarmConfig &Config) : Config(Config) {}
+		~Farm(void);
+		
+		Farm(const Farm &) = delete;
+		Farm &operator=(const Farm &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_COYOTESIM_H__
@@ -0,0 +1,304 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "include/assetcatalog.h"
+#include "decodeworker.h"
+#include <algorithm>
+
+constexpr size_t Coyote::AssetCatalog::NumShards;
+
+static inline size_t StatusBucket(const Coyote::AssetState Status)
+{
+	const size_t Value = static_cast<size_t>(Status);
+	
+	return Value < Coyote::COYOTE_ASSETSTATE_MAX ? Value : Coyote::COYOTE_ASSETSTATE_MAX;
+}
+
+static inline std::string NormalizeDirectory(const std::string &Directory)
+{
+	if (Directory.empty() || Directory.back() == '/') return Directory;
+	
+	return Directory + '/';
+}
+
+static inline void EraseFrom(std::vector<const Coyote::Asset*> &Bucket, const Coyote::Asset *const Item)
+{ //Order within a bucket doesn't matter, so swap with the back instead of shifting.
+	const auto Iter = std::find(Bucket.begin(), Bucket.end(), Item);
+	
+	if (Iter == Bucket.end()) return;
+	
+	*Iter = Bucket.back();
+	Bucket.pop_back();
+}
+
+static inline bool StartsWith(const std::string &Text, const std::string &Prefix)
+{
+	return Text.size() >= Prefix.size() && !Text.compare(0u, Prefix.size(), Prefix);
+}
+
+void Coyote::AssetShard::Reindex(void)
+{
+	this->ByDirectory.clear();
+	this->ByChecksum.clear();
+	this->ByChecksum.reserve(this->Assets.size());
+	
+	for (std::vector<const Asset*> &Bucket : this->ByStatus) Bucket.clear();
+	
+	for (const auto &Pair : this->Assets) this->Index(Pair.second.get());
+}
+
+void Coyote::AssetShard::Index(const Asset *const Item)
+{
+	this->ByDirectory[AssetCatalog::ParentDirectory(Item->FullPath)].push_back(Item);
+	this->ByStatus[StatusBucket(Item->Status)].push_back(Item);
+	
+	if (!Item->Checksum.empty()) this->ByChecksum.emplace(Item->Checksum, Item);
+}
+
+void Coyote::AssetShard::Unindex(const Asset *const Item)
+{
+	const auto DirIter = this->ByDirectory.find(AssetCatalog::ParentDirectory(Item->FullPath));
+	
+	if (DirIter != this->ByDirectory.end())
+	{
+		EraseFrom(DirIter->second, Item);
+		
+		if (DirIter->second.empty()) this->ByDirectory.erase(DirIter);
+	}
+	
+	EraseFrom(this->ByStatus[StatusBucket(Item->Status)], Item);
+	
+	if (Item->Checksum.empty()) return;
+	
+	const auto Range = this->ByChecksum.equal_range(Item->Checksum);
+	
+	for (auto Iter = Range.first; Iter != Range.second; ++Iter)
+	{
+		if (Iter->second != Item) continue;
+		
+		this->ByChecksum.erase(Iter);
+		break;
+	}
+}
+
+std::shared_ptr<Coyote::AssetShard> Coyote::AssetShard::Clone(void) const
+{ //Shallow, the assets are shared and so is everything the indexes point at.
+	std::shared_ptr<AssetShard> RetVal { std::make_shared<AssetShard>() };
+	
+	RetVal->Assets = this->Assets;
+	RetVal->ByDirectory = this->ByDirectory;
+	RetVal->ByStatus = this->ByStatus;
+	RetVal->ByChecksum = this->ByChecksum;
+	
+	return RetVal;
+}
+
+Coyote::AssetCatalog::AssetCatalog(void) : Count()
+{
+	const std::shared_ptr<const AssetShard> Empty { std::make_shared<AssetShard>() };
+	
+	this->Shards.fill(Empty);
+}
+
+size_t Coyote::AssetCatalog::ShardFor(const std::string &FullPath)
+{
+	return std::hash<std::string>{}(FullPath) % NumShards;
+}
+
+std::string Coyote::AssetCatalog::ParentDirectory(const std::string &FullPath)
+{
+	const size_t Slash = FullPath.rfind('/');
+	
+	if (Slash == std::string::npos) return {};
+	
+	return FullPath.substr(0u, Slash + 1u);
+}
+
+const Coyote::Asset *Coyote::AssetCatalog::Find(const std::string &FullPath) const
+{
+	const AssetShard &Target { *this->Shards[ShardFor(FullPath)] };
+	
+	const auto Iter = Target.Assets.find(FullPath);
+	
+	return Iter == Target.Assets.end() ? nullptr : Iter->second.get();
+}
+
+Coyote::AssetView Coyote::AssetCatalog::Query(const AssetQuery &Query) const
+{
+	AssetView RetVal;
+	
+	RetVal.Owner = this->shared_from_this();
+	
+	const std::string Directory { NormalizeDirectory(Query.Directory) };
+	const bool HasStatus = Query.Status >= 0;
+	
+	//Whatever isn't answered by the index we pick gets checked item by item.
+	auto Matches = [&Query, &Directory, HasStatus] (const Asset &Item)
+	{
+		if (HasStatus && static_cast<int32_t>(Item.Status) != Query.Status) return false;
+		if (!Query.Checksum.empty() && Item.Checksum != Query.Checksum) return false;
+		
+		if (!Directory.empty())
+		{
+			if (!StartsWith(Item.FullPath, Directory)) return false;
+			if (!Query.Recursive && Item.FullPath.find('/', Directory.size()) != std::string::npos) return false;
+		}
+		
+		return true;
+	};
+	
+	for (const std::shared_ptr<const AssetShard> &ShardPtr : this->Shards)
+	{
+		const AssetShard &Target { *ShardPtr };
+		
+		if (!Query.Checksum.empty())
+		{ //Most selective by far, usually a single hit.
+			const auto Range = Target.ByChecksum.equal_range(Query.Checksum);
+			
+			for (auto Iter = Range.first; Iter != Range.second; ++Iter)
+			{
+				if (Matches(*Iter->second)) RetVal.Items.push_back(Iter->second);
+			}
+		}
+		else if (!Directory.empty())
+		{
+			for (auto Iter = Target.ByDirectory.lower_bound(Directory); Iter != Target.ByDirectory.end() && StartsWith(Iter->first, Directory); ++Iter)
+			{
+				if (!Query.Recursive && Iter->first.size() != Directory.size()) break; //Subdirectories sort after the directory itself
+				
+				for (const Asset *const Item : Iter->second)
+				{
+					if (!HasStatus || static_cast<int32_t>(Item->Status) == Query.Status) RetVal.Items.push_back(Item);
+				}
+			}
+		}
+		else if (HasStatus)
+		{
+			const std::vector<const Asset*> &Bucket { Target.ByStatus[StatusBucket(static_cast<AssetState>(Query.Status))] };
+			
+			for (const Asset *const Item : Bucket)
+			{
+				if (Matches(*Item)) RetVal.Items.push_back(Item);
+			}
+		}
+		else
+		{
+			for (const auto &Pair : Target.Assets) RetVal.Items.push_back(Pair.second.get());
+		}
+	}
+	
+	return RetVal;
+}
+
+Coyote::AssetsSnapshot Coyote::AssetCatalog::Flatten(void) const
+{
+	std::call_once(this->FlattenOnce, [this]
+		{
+			std::shared_ptr<std::unordered_map<std::string, Asset> > Map { std::make_shared<std::unordered_map<std::string, Asset> >() };
+			
+			Map->reserve(this->Count);
+			
+			for (const std::shared_ptr<const AssetShard> &ShardPtr : this->Shards)
+			{
+				for (const auto &Pair : ShardPtr->Assets) Map->emplace(Pair.first, *Pair.second);
+			}
+			
+			this->Flattened = std::move(Map);
+		});
+	
+	return this->Flattened;
+}
+
+Coyote::AssetCatalogSnapshot Coyote::AssetCatalog::Build(std::vector<Asset> &&Items)
+{
+	std::array<std::shared_ptr<AssetShard>, NumShards> NewShards;
+	
+	for (std::shared_ptr<AssetShard> &ShardPtr : NewShards) ShardPtr = std::make_shared<AssetShard>();
+	
+	std::shared_ptr<AssetCatalog> RetVal { std::make_shared<AssetCatalog>() };
+	
+	for (Asset &Item : Items)
+	{
+		std::unordered_map<std::string, std::shared_ptr<const Asset> > &Target { NewShards[ShardFor(Item.FullPath)]->Assets };
+		
+		std::string Key { Item.FullPath };
+		
+		Target[std::move(Key)] = std::make_shared<const Asset>(std::move(Item));
+	}
+	
+	//Shards are independent, so indexing a big sync spreads across cores.
+	DecodeWork::ParallelFor(NumShards, 4u, [&NewShards] (const size_t Begin, const size_t End)
+		{
+			for (size_t Inc = Begin; Inc < End; ++Inc) NewShards[Inc]->Reindex();
+		});
+	
+	size_t Count = 0u;
+	
+	for (size_t Inc = 0u; Inc < NumShards; ++Inc)
+	{
+		Count += NewShards[Inc]->Assets.size();
+		RetVal->Shards[Inc] = std::move(NewShards[Inc]);
+	}
+	
+	RetVal->Count = Count;
+	
+	return RetVal;
+}
+
+Coyote::AssetCatalogSnapshot Coyote::AssetCatalog::WithAsset(const Asset &Item) const
+{
+	const size_t Index = ShardFor(Item.FullPath);
+	
+	std::shared_ptr<AssetShard> NewShard { this->Shards[Index]->Clone() };
+	
+	std::shared_ptr<const Asset> &Slot { NewShard->Assets[Item.FullPath] };
+	const bool Existed = Slot != nullptr;
+	
+	if (Existed) NewShard->Unindex(Slot.get());
+	
+	Slot = std::make_shared<const Asset>(Item);
+	NewShard->Index(Slot.get());
+	
+	std::shared_ptr<AssetCatalog> RetVal { std::make_shared<AssetCatalog>() };
+	
+	RetVal->Shards = this->Shards;
+	RetVal->Shards[Index] = std::move(NewShard);
+	RetVal->Count = this->Count + !Existed;
+	
+	return RetVal;
+}
+
+Coyote::AssetCatalogSnapshot Coyote::AssetCatalog::WithoutAsset(const std::string &FullPath) const
+{
+	const size_t Index = ShardFor(FullPath);
+	
+	if (!this->Shards[Index]->Assets.count(FullPath)) return this->shared_from_this();
+	
+	std::shared_ptr<AssetShard> NewShard { this->Shards[Index]->Clone() };
+	
+	const auto Iter = NewShard->Assets.find(FullPath);
+	
+	NewShard->Unindex(Iter->second.get());
+	NewShard->Assets.erase(Iter);
+	
+	std::shared_ptr<AssetCatalog> RetVal { std::make_shared<AssetCatalog>() };
+	
+	RetVal->Shards = this->Shards;
+	RetVal->Shards[Index] = std::move(NewShard);
+	RetVal->Count = this->Count - 1u;
+	
+	return RetVal;
+}
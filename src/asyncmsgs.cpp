@@ -26,10 +26,92 @@
 
 bool AsyncMsgs::AsynchronousSession::OnMessageReady(const std::unordered_map<std::string, msgpack::object> &Values, WS::WSConnection *Conn, WSMessage *Msg_)
 {
-	const std::unique_ptr<WSMessage> Msg { Msg_ };
+	std::shared_ptr<WSMessage> Msg { Msg_ };
+	
+	const std::lock_guard<std::mutex> G { this->DispatchLock };
+	
+	if (this->Decoder.Busy())
+	{ //Values points into the caller's zone, so the strand decodes its own copy.
+		this->PostLocked(Msg);
+		return true;
+	}
 	
 	this->SubSession.ProcessSubscriptionEvent(Values);
 	
 	return true;
 }
 
+void AsyncMsgs::AsynchronousSession::PostLocked(const std::shared_ptr<WSMessage> &Msg)
+{
+	this->Decoder.Post([this, Msg] { this->DecodeAndApply(*Msg); });
+}
+
+void AsyncMsgs::AsynchronousSession::DecodeAndApply(WSMessage &Msg)
+{
+	POOLED_ZONE(TempZone);
+	
+	const std::unordered_map<std::string, msgpack::object> Values { MsgpackProc::InitIncomingMsg(Msg.GetBody(), Msg.GetBodySize(), TempZone) };
+	
+	this->SubSession.ProcessSubscriptionEvent(Values);
+}
+
+bool AsyncMsgs::AsynchronousSession::OnSubscriptionMessage(WSMessage *Msg_, const MsgpackProc::MessageHeaders &Headers)
+{ //Takes ownership of Msg_. Small events are applied right here unless something is still queued ahead of them, so order always holds.
+	std::shared_ptr<WSMessage> Msg { Msg_ };
+	
+	if (Headers.EventName && !this->SubSession.WantsEvent(Headers.EventName, Headers.EventNameLength))
+	{ //A feed we've stopped caring about, but the server is still sending until we reconnect.
+		return true;
+	}
+	
+	static const char PresetsUpdate[] = "PresetsUpdate";
+	
+	const std::lock_guard<std::mutex> G { this->DispatchLock };
+	
+	if (this->PresetHolds && Headers.EventName && Headers.EventNameLength == sizeof PresetsUpdate - 1 && !memcmp(Headers.EventName, PresetsUpdate, sizeof PresetsUpdate - 1))
+	{
+		this->HeldPresets = std::move(Msg);
+		return true;
+	}
+	
+	if (Msg->GetBodySize() < OffloadThreshold && !this->Decoder.Busy())
+	{
+		try
+		{
+			this->DecodeAndApply(*Msg);
+		}
+		catch (const std::exception &Err)
+		{
+			LDEBUG_MSG("Failed to decode subscription event, exception was " << Err.what());
+			return false;
+		}
+		
+		return true;
+	}
+	
+	LDEBUG_MSG("Handing subscription event of size " << Msg->GetBodySize() << " to the decode strand");
+	
+	this->PostLocked(Msg);
+	
+	return true;
+}
+
+void AsyncMsgs::AsynchronousSession::HoldPresets(void)
+{
+	const std::lock_guard<std::mutex> G { this->DispatchLock };
+	
+	++this->PresetHolds;
+}
+
+void AsyncMsgs::AsynchronousSession::ReleasePresets(void)
+{
+	const std::lock_guard<std::mutex> G { this->DispatchLock };
+	
+	assert(this->PresetHolds);
+	
+	if (--this->PresetHolds || !this->HeldPresets) return;
+	
+	//We're not the network thread, so this always goes through the strand. Anything that arrives after it queues up behind it.
+	this->PostLocked(this->HeldPresets);
+	this->HeldPresets.reset();
+}
@@ -21,19 +21,35 @@
 #include "native_ws.h"
 #include "msgpackproc.h"
 #include "subscriptions.h"
+#include "decodeworker.h"
 
 namespace AsyncMsgs
 {
 	class AsynchronousSession
 	{
 	private:
+		static constexpr size_t OffloadThreshold = 16 * 1024; //Bodies past this are decoded on the strand, not the network thread.
 		
+		//Held from checking Decoder.Busy() through applying an event inline, and around every Post(). Events are only ever applied
+		//by one thread at a time, which the timecode mailbox and the VU meters rely on, and never out of order.
+		std::mutex DispatchLock;
+		
+		//While batch preset edits are in flight, every PresetsUpdate but the newest is dropped undecoded. Each carries the whole list.
+		uint32_t PresetHolds; //Protected by DispatchLock
+		std::shared_ptr<WSMessage> HeldPresets; //Protected by DispatchLock
+		
+		void DecodeAndApply(WSMessage &Msg);
+		void PostLocked(const std::shared_ptr<WSMessage> &Msg);
 	public:
 		bool OnMessageReady(const std::unordered_map<std::string, msgpack::object> &Values, WS::WSConnection *Conn, WSMessage *Msg);
+		bool OnSubscriptionMessage(WSMessage *Msg, const MsgpackProc::MessageHeaders &Headers);
+		void HoldPresets(void);
+		void ReleasePresets(void); //Applies whatever arrived while held, once the last hold is released
 		
 		Subs::SubscriptionSession SubSession;
+		DecodeWork::Strand Decoder; //After SubSession, so it's stopped before the state it writes to goes away.
 		
-		AsynchronousSession(void) {}
+		AsynchronousSession(void) : PresetHolds() {}
 		
 		inline void SetStateEventCallback(const Coyote::StateEventType EType, const Coyote::StateEventCallback CB, void *const UserData)
 		{
@@ -49,8 +65,18 @@ namespace AsyncMsgs
 		{
 			SubSession.SetMiniviewCallback(CB, UserData);
 		}
-
 		
+		inline void SetPresetChangeCallback(const Coyote::PresetChangeCallback CB, void *const UserData)
+		{
+			SubSession.SetPresetChangeCallback(CB, UserData);
+		}
+		
+		inline void SetChangeSetCallback(const Coyote::ChangeSetCallback CB, void *const UserData)
+		{
+			SubSession.SetChangeSetCallback(CB, UserData);
+		}
+		
+	
 	};
 }
 #endif //__LIBCOYOTE_ASYNCMSGS_H__
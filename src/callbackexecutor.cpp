@@ -0,0 +1,263 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "callbackexecutor.h"
+
+static thread_local const CallbackExec::Executor *CurrentExecutor; //Set on worker threads, so we never try to join ourselves.
+static thread_local bool WorkerOrphaned; //Our executor was destroyed by the callback we were running, don't touch it again.
+static thread_local uint32_t InlineDepth; //Nonzero while this thread is running an inline callback
+
+CallbackExec::Executor::Executor(const uint32_t NumThreads, const uint32_t QueueLimit)
+	: HeadSeq(), QueueLimit(QueueLimit ? QueueLimit : 1u), Inline(true), Stopping(), Posted(), Dropped(), Coalesced(), HighWater(), Executed()
+{
+	this->Configure(NumThreads, QueueLimit);
+}
+
+CallbackExec::Executor::~Executor(void)
+{ //Whatever is still pending is discarded, the subscribers it was meant for are going away with us.
+	this->StopWorkers();
+}
+
+void CallbackExec::Executor::Run(const std::function<void(void)> &Func)
+{
+	try
+	{
+		Func();
+	}
+	catch (const std::exception &Err)
+	{ //An exception escaping a user callback would otherwise take the whole worker down with it.
+		LDEBUG_MSG("Callback threw exception: " << Err.what());
+	}
+	catch (...)
+	{
+		LDEBUG_MSG("Callback threw unknown exception");
+	}
+	
+	if (!WorkerOrphaned) ++this->Executed;
+}
+
+bool CallbackExec::Executor::PopFront(std::unique_lock<std::mutex> &Guard, std::function<void(void)> &Out)
+{ //Caller holds Lock.
+	(void)Guard;
+	
+	if (this->Queue.empty()) return false;
+	
+	Task &Front { this->Queue.front() };
+	
+	if (Front.Key)
+	{
+		const auto Iter = this->PendingKeys.find(Front.Key);
+		
+		if (Iter != this->PendingKeys.end() && Iter->second == this->HeadSeq) this->PendingKeys.erase(Iter);
+	}
+	
+	Out = std::move(Front.Func);
+	
+	this->Queue.pop_front();
+	++this->HeadSeq;
+	
+	return true;
+}
+
+bool CallbackExec::Executor::EvictOldest(std::unique_lock<std::mutex> &Guard)
+{ //Caller holds Lock. Returns false if everything queued has to stay.
+	size_t Index = 0u;
+	
+	while (Index < this->Queue.size() && !this->Queue[Index].Evictable) ++Index;
+	
+	if (Index == this->Queue.size()) return false;
+	
+	if (!Index)
+	{
+		std::function<void(void)> Discarded;
+		
+		return this->PopFront(Guard, Discarded);
+	}
+	
+	const uint64_t Seq = this->HeadSeq + Index;
+	
+	//Everything behind it moves up a spot.
+	for (auto Iter = this->PendingKeys.begin(); Iter != this->PendingKeys.end();)
+	{
+		if (Iter->second == Seq) Iter = this->PendingKeys.erase(Iter);
+		else
+		{
+			if (Iter->second > Seq) --Iter->second;
+			++Iter;
+		}
+	}
+	
+	this->Queue.erase(this->Queue.begin() + Index);
+	
+	return true;
+}
+
+void CallbackExec::Executor::Post(std::function<void(void)> Func, const uint64_t Key, const bool Evictable)
+{
+	std::unique_lock<std::mutex> Guard { this->Lock };
+	
+	++this->Posted;
+	
+	if (this->Inline)
+	{
+		Guard.unlock();
+		
+		++InlineDepth;
+		this->Run(Func);
+		--InlineDepth;
+		
+		return;
+	}
+	
+	if (Key)
+	{
+		const auto Iter = this->PendingKeys.find(Key);
+		
+		if (Iter != this->PendingKeys.end())
+		{ //Newer data for something still waiting, swap it in and keep its place.
+			this->Queue[Iter->second - this->HeadSeq].Func = std::move(Func);
+			++this->Coalesced;
+			return;
+		}
+	}
+	
+	if (this->Queue.size() >= this->QueueLimit)
+	{
+		if (this->EvictOldest(Guard)) ++this->Dropped;
+		else if (Evictable)
+		{ //Only tasks that must not be lost are waiting, so this one gives way.
+			++this->Dropped;
+			return;
+		}
+	}
+	
+	if (Key) this->PendingKeys[Key] = this->HeadSeq + this->Queue.size();
+	
+	this->Queue.push_back({ Key, std::move(Func), Evictable });
+	
+	if (this->Queue.size() > this->HighWater) this->HighWater = static_cast<uint32_t>(this->Queue.size());
+	
+	Guard.unlock();
+	
+	this->Wake.notify_one();
+}
+
+void CallbackExec::Executor::WorkerLoop(void)
+{
+	CurrentExecutor = this;
+	
+	std::unique_lock<std::mutex> Guard { this->Lock };
+	
+	while (true)
+	{
+		this->Wake.wait(Guard, [this] { return this->Stopping || !this->Queue.empty(); });
+		
+		if (this->Stopping) break;
+		
+		std::function<void(void)> Func;
+		
+		if (!this->PopFront(Guard, Func)) continue;
+		
+		Guard.unlock();
+		this->Run(Func);
+		
+		if (WorkerOrphaned) return;
+		
+		Guard.lock();
+	}
+	
+	CurrentExecutor = nullptr;
+}
+
+void CallbackExec::Executor::StopWorkers(void)
+{ //Caller holds ConfigLock, or is the destructor.
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		this->Stopping = true;
+	}
+	
+	this->Wake.notify_all();
+	
+	for (std::thread &Worker : this->Workers)
+	{
+		if (Worker.get_id() == std::this_thread::get_id())
+		{ //Session torn down from inside its own callback.
+			WorkerOrphaned = true;
+			Worker.detach();
+		}
+		else Worker.join();
+	}
+	
+	this->Workers.clear();
+	
+	const std::lock_guard<std::mutex> G { this->Lock };
+	this->Stopping = false;
+}
+
+bool CallbackExec::Executor::Configure(const uint32_t NumThreads, const uint32_t QueueLimit)
+{
+	if (!QueueLimit || CurrentExecutor == this) return false; //Reconfiguring from a callback would have a worker joining itself.
+	
+	const std::lock_guard<std::mutex> ConfigGuard { this->ConfigLock };
+	
+	this->StopWorkers();
+	
+	std::deque<Task> Leftover;
+	
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		this->QueueLimit = QueueLimit;
+		this->Inline = !NumThreads;
+		
+		if (this->Inline)
+		{ //Nobody would ever run these otherwise.
+			Leftover.swap(this->Queue);
+			this->HeadSeq += Leftover.size();
+			this->PendingKeys.clear();
+		}
+	}
+	
+	for (const Task &Item : Leftover) this->Run(Item.Func);
+	
+	for (uint32_t Inc = 0u; Inc < NumThreads; ++Inc)
+	{
+		this->Workers.emplace_back(&Executor::WorkerLoop, this);
+	}
+	
+	return true;
+}
+
+Coyote::CallbackExecutorStats CallbackExec::Executor::GetStats(void) const
+{
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	Coyote::CallbackExecutorStats RetVal{};
+	
+	RetVal.Posted = this->Posted;
+	RetVal.Executed = this->Executed;
+	RetVal.Dropped = this->Dropped;
+	RetVal.Coalesced = this->Coalesced;
+	RetVal.Pending = static_cast<uint32_t>(this->Queue.size());
+	RetVal.HighWater = this->HighWater;
+	
+	return RetVal;
+}
+
+bool CallbackExec::InInlineCallback(void)
+{
+	return InlineDepth != 0u;
+}
@@ -0,0 +1,86 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_CALLBACKEXECUTOR_H__
+#define __LIBCOYOTE_CALLBACKEXECUTOR_H__
+
+#include "include/common.h"
+#include "include/datastructures.h"
+
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+
+/**Runs user callbacks off the network thread, so a slow callback can't stall socket I/O, pings or synchronous replies.
+ * Tasks run in the order they were posted when there's one worker thread.
+ * A task posted with a nonzero key replaces a still-pending task with the same key in place, keeping its spot in line.
+ * Past QueueLimit the oldest evictable task is dropped. Tasks posted as not evictable are never dropped, the queue grows for them instead.**/
+
+namespace CallbackExec
+{
+	class Executor
+	{
+	private:
+		struct Task
+		{
+			uint64_t Key; //0 means never coalesced
+			std::function<void(void)> Func;
+			bool Evictable;
+		};
+		
+		std::mutex ConfigLock; //Serializes Configure() calls, never held by workers.
+		mutable std::mutex Lock;
+		std::condition_variable Wake;
+		std::deque<Task> Queue;
+		std::unordered_map<uint64_t, uint64_t> PendingKeys; //Key -> absolute sequence number of its task in Queue
+		uint64_t HeadSeq;
+		std::vector<std::thread> Workers;
+		uint32_t QueueLimit;
+		bool Inline;
+		bool Stopping;
+		
+		uint64_t Posted;
+		uint64_t Dropped;
+		uint64_t Coalesced;
+		uint32_t HighWater;
+		std::atomic<uint64_t> Executed;
+		
+		void WorkerLoop(void);
+		void StopWorkers(void);
+		bool PopFront(std::unique_lock<std::mutex> &Guard, std::function<void(void)> &Out);
+		bool EvictOldest(std::unique_lock<std::mutex> &Guard);
+		void Run(const std::function<void(void)> &Func);
+	public:
+		void Post(std::function<void(void)> Func, const uint64_t Key = 0u, const bool Evictable = true);
+		bool Configure(const uint32_t NumThreads, const uint32_t QueueLimit);
+		Coyote::CallbackExecutorStats GetStats(void) const;
+		
+		Executor(const uint32_t NumThreads = 1u, const uint32_t QueueLimit = 4096u);
+		~Executor(void);
+		
+		Executor(const Executor &) = delete;
+		Executor &operator=(const Executor &) = delete;
+	};
+	
+	//True while the calling thread is inside a callback run inline, i.e. on whatever thread is applying subscription events.
+	bool InInlineCallback(void);
+	
+	static inline uint64_t MakeKey(const uint8_t Kind, const uint64_t Value)
+	{ //Kind in the top byte so different events can never coalesce into each other.
+		return (static_cast<uint64_t>(Kind) << 56) | (Value & 0x00FFFFFFFFFFFFFFull);
+	}
+}
+
+#endif //__LIBCOYOTE_CALLBACKEXECUTOR_H__
@@ -0,0 +1,123 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "compactwire.h"
+
+static inline bool IsInternedKey(const msgpack::object &Key)
+{
+	return Key.type == msgpack::type::EXT && Key.via.ext.size == 1 && Key.via.ext.type() == CompactWire::KeyExtType;
+}
+
+bool CompactWire::IsCompact(const msgpack::object &Object)
+{ //Every compact message starts with an interned header key, so the first key is all we need to look at.
+	return Object.type == msgpack::type::MAP && Object.via.map.size > 0 && IsInternedKey(Object.via.map.ptr[0].key);
+}
+
+void CompactWire::ExpandKeys(msgpack::object &Object)
+{ //Rewrites interned keys into plain string objects pointing at our static key text, in place.
+  //After this, everything downstream (MSGPACK_DEFINE_MAP, convert() into maps) can't tell the difference.
+	switch (Object.type)
+	{
+		case msgpack::type::MAP:
+		{
+			msgpack::object_kv *const End = Object.via.map.ptr + Object.via.map.size;
+			
+			for (msgpack::object_kv *Iter = Object.via.map.ptr; Iter != End; ++Iter)
+			{
+				if (IsInternedKey(Iter->key))
+				{
+					const char *const Text = WireSchema::KeyText(static_cast<uint8_t>(Iter->key.via.ext.data()[0]));
+					
+					if (Text)
+					{
+						Iter->key.type = msgpack::type::STR;
+						Iter->key.via.str.ptr = Text;
+						Iter->key.via.str.size = strlen(Text);
+					}
+				}
+				
+				ExpandKeys(Iter->val);
+			}
+			break;
+		}
+		case msgpack::type::ARRAY:
+		{
+			msgpack::object *const End = Object.via.array.ptr + Object.via.array.size;
+			
+			for (msgpack::object *Iter = Object.via.array.ptr; Iter != End; ++Iter)
+			{
+				ExpandKeys(*Iter);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void CompactWire::PackKey(msgpack::packer<msgpack::sbuffer> &Pack, const WireSchema::WireKey Key)
+{
+	const char ID = static_cast<char>(static_cast<uint8_t>(Key));
+	
+	Pack.pack_ext(1, KeyExtType);
+	Pack.pack_ext_body(&ID, 1);
+}
+
+void CompactWire::PackObject(msgpack::packer<msgpack::sbuffer> &Pack, const msgpack::object &Object, const uint16_t KeyLimit)
+{
+	switch (Object.type)
+	{
+		case msgpack::type::MAP:
+		{
+			Pack.pack_map(Object.via.map.size);
+			
+			const msgpack::object_kv *const End = Object.via.map.ptr + Object.via.map.size;
+			
+			for (const msgpack::object_kv *Iter = Object.via.map.ptr; Iter != End; ++Iter)
+			{
+				WireSchema::WireKey Key = WireSchema::WireKey::Invalid;
+				
+				if (Iter->key.type == msgpack::type::STR &&
+					WireSchema::KeyTable.Lookup(Iter->key.via.str.ptr, Iter->key.via.str.size, Key) &&
+					static_cast<uint16_t>(Key) <= KeyLimit) //Don't send IDs the other end never heard of
+				{
+					PackKey(Pack, Key);
+				}
+				else
+				{
+					Pack.pack(Iter->key);
+				}
+				
+				PackObject(Pack, Iter->val, KeyLimit);
+			}
+			break;
+		}
+		case msgpack::type::ARRAY:
+		{
+			Pack.pack_array(Object.via.array.size);
+			
+			const msgpack::object *const End = Object.via.array.ptr + Object.via.array.size;
+			
+			for (const msgpack::object *Iter = Object.via.array.ptr; Iter != End; ++Iter)
+			{
+				PackObject(Pack, *Iter, KeyLimit);
+			}
+			break;
+		}
+		default:
+			Pack.pack(Object);
+			break;
+	}
+}
@@ -0,0 +1,44 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_COMPACTWIRE_H__
+#define __LIBCOYOTE_COMPACTWIRE_H__
+
+#define MSGPACK_DEFAULT_API_VERSION 2
+#include "msgpack.hpp"
+
+#include "include/common.h"
+#include "wireschema.h"
+
+/**Compact wire encoding, "compact-v1".
+ * Same msgpack maps as always, but any key listed in COYOTE_WIRE_KEY_SCHEMA goes out as a 3 byte fixext
+ * holding its ID instead of the full string. Keys that aren't in the table still go out as strings, so the table never has to be complete.
+ * An ext is used rather than a bare integer because some maps (Gotos, Countdowns) really are keyed by integers.
+ * 
+ * Both ends have to agree to it during the handshake, see InternalSession::NegotiateWireEncoding().
+ * Pings and anything sent before negotiation finishes stay in the plain map format, so a peer has to accept both.**/
+
+namespace CompactWire
+{
+	static constexpr int8_t KeyExtType = 0x4B; //'K'
+	static constexpr const char *EncodingName = "compact-v1";
+	
+	bool IsCompact(const msgpack::object &Object);
+	void ExpandKeys(msgpack::object &Object);
+	void PackKey(msgpack::packer<msgpack::sbuffer> &Pack, const WireSchema::WireKey Key);
+	void PackObject(msgpack::packer<msgpack::sbuffer> &Pack, const msgpack::object &Object, const uint16_t KeyLimit);
+}
+
+#endif //__LIBCOYOTE_COMPACTWIRE_H__
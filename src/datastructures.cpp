@@ -14,8 +14,10 @@
    limitations under the License.
 */
 
+#include "msgpack.hpp"
 #include "include/common.h"
 #include "include/datastructures.h"
+#include "wireschema.h"
 
 
 Coyote::Player Coyote::Preset::GetPlayersForCanvas(const uint32_t Index) const
@@ -48,6 +50,35 @@ Coyote::Player Coyote::Preset::GetPlayersForCanvas(const uint32_t Index) const
 	return TotalPlayers;
 }
 
+uint32_t Coyote::Preset::Diff(const Coyote::Preset &Other) const
+{
+	uint32_t Mask = Coyote::COYOTE_PFIELD_NONE;
+	
+#define PFIELD_CMP(Field, Flag) if (this->Field != Other.Field) Mask |= Coyote::Flag
+	PFIELD_CMP(Name, COYOTE_PFIELD_NAME);
+	PFIELD_CMP(Notes, COYOTE_PFIELD_NOTES);
+	PFIELD_CMP(Color, COYOTE_PFIELD_COLOR);
+	PFIELD_CMP(Canvases, COYOTE_PFIELD_CANVASES);
+	PFIELD_CMP(Gotos, COYOTE_PFIELD_GOTOS);
+	PFIELD_CMP(Countdowns, COYOTE_PFIELD_COUNTDOWNS);
+	PFIELD_CMP(Volume, COYOTE_PFIELD_VOLUME);
+	PFIELD_CMP(TabDisplayOrder, COYOTE_PFIELD_TABDISPLAYORDER);
+	PFIELD_CMP(SinkOptions, COYOTE_PFIELD_SINKOPTIONS);
+	PFIELD_CMP(Loop, COYOTE_PFIELD_LOOP);
+	PFIELD_CMP(Link, COYOTE_PFIELD_LINK);
+	PFIELD_CMP(DissolveInMS, COYOTE_PFIELD_DISSOLVEINMS);
+	PFIELD_CMP(DissolveOutMS, COYOTE_PFIELD_DISSOLVEOUTMS);
+	PFIELD_CMP(FadeInMS, COYOTE_PFIELD_FADEINMS);
+	PFIELD_CMP(FadeOutMS, COYOTE_PFIELD_FADEOUTMS);
+	PFIELD_CMP(InPosition, COYOTE_PFIELD_INPOSITION);
+	PFIELD_CMP(OutPosition, COYOTE_PFIELD_OUTPOSITION);
+	PFIELD_CMP(Dissolve, COYOTE_PFIELD_DISSOLVE);
+	PFIELD_CMP(FreezeAtEnd, COYOTE_PFIELD_FREEZEATEND);
+#undef PFIELD_CMP
+
+	return Mask;
+}
+
 Coyote::Player Coyote::Preset::GetActivePlayerForCanvas(const uint32_t Index) const
 {
 	const Coyote::Player Players = this->GetPlayersForCanvas(Index);
@@ -133,3 +164,25 @@ std::vector<uint32_t> Coyote::PlayersToIntegers(const Coyote::Player Players)
 	return RetVal;
 }
 
+//msgpack members for every wire struct, generated from the field lists in wireschema.h.
+COYOTE_WIRE_DEFINE(Size2D, COYOTE_SIZE2D_FIELDS)
+COYOTE_WIRE_DEFINE(Coords2D, COYOTE_COORDS2D_FIELDS)
+COYOTE_WIRE_DEFINE(Rect, COYOTE_RECT_FIELDS)
+COYOTE_WIRE_DEFINE(Cube, COYOTE_CUBE_FIELDS)
+COYOTE_WIRE_DEFINE(PinnedAsset, COYOTE_PINNEDASSET_FIELDS)
+COYOTE_WIRE_DEFINE(ProjectorCanvasConfig, COYOTE_PROJECTORCANVASCONFIG_FIELDS)
+COYOTE_WIRE_DEFINE(CanvasInfo, COYOTE_CANVASINFO_FIELDS)
+COYOTE_WIRE_DEFINE(PresetMark, COYOTE_PRESETMARK_FIELDS)
+COYOTE_WIRE_DEFINE(LANCoyote, COYOTE_LANCOYOTE_FIELDS)
+COYOTE_WIRE_DEFINE(TimeCode, COYOTE_TIMECODE_FIELDS)
+COYOTE_WIRE_DEFINE(Drive, COYOTE_DRIVE_FIELDS)
+COYOTE_WIRE_DEFINE(Asset, COYOTE_ASSET_FIELDS)
+COYOTE_WIRE_DEFINE(AssetMetadata, COYOTE_ASSETMETADATA_FIELDS)
+COYOTE_WIRE_DEFINE(ExternalAsset, COYOTE_EXTERNALASSET_FIELDS)
+COYOTE_WIRE_DEFINE(PresetState, COYOTE_PRESETSTATE_FIELDS)
+COYOTE_WIRE_DEFINE(Preset, COYOTE_PRESET_FIELDS)
+COYOTE_WIRE_DEFINE(KonaHardwareState, COYOTE_KONAHARDWARESTATE_FIELDS)
+COYOTE_WIRE_DEFINE(NetworkInfo, COYOTE_NETWORKINFO_FIELDS)
+COYOTE_WIRE_DEFINE(Mirror, COYOTE_MIRROR_FIELDS)
+COYOTE_WIRE_DEFINE(GenlockSettings, COYOTE_GENLOCKSETTINGS_FIELDS)
+COYOTE_WIRE_DEFINE(LicensingStatus, COYOTE_LICENSINGSTATUS_FIELDS)
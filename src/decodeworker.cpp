@@ -0,0 +1,221 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "decodeworker.h"
+#include <algorithm>
+#include <exception>
+
+namespace
+{
+	static constexpr size_t MaxPoolThreads = 7u; //Plus the caller. Past that, allocation in UnpackCoyoteObject() is the bottleneck anyway.
+	
+	static thread_local bool OnPoolThread;
+	
+	class Pool
+	{ //Process-wide and never torn down, so nothing has to care about static destruction order.
+	private:
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::deque<std::function<void(void)> > Queue;
+		size_t NumThreads;
+		
+		void WorkerLoop(void)
+		{
+			OnPoolThread = true;
+			
+			std::unique_lock<std::mutex> Guard { this->Lock };
+			
+			while (true)
+			{
+				this->Wake.wait(Guard, [this] { return !this->Queue.empty(); });
+				
+				std::function<void(void)> Func { std::move(this->Queue.front()) };
+				this->Queue.pop_front();
+				
+				Guard.unlock();
+				Func();
+				Guard.lock();
+			}
+		}
+	public:
+		Pool(void) : NumThreads(std::min<size_t>(MaxPoolThreads, std::max(std::thread::hardware_concurrency(), 2u) - 1u))
+		{
+			for (size_t Inc = 0u; Inc < this->NumThreads; ++Inc)
+			{
+				std::thread(&Pool::WorkerLoop, this).detach();
+			}
+		}
+		
+		inline size_t Size(void) const { return this->NumThreads; }
+		
+		void Post(std::function<void(void)> Func)
+		{
+			{
+				const std::lock_guard<std::mutex> G { this->Lock };
+				this->Queue.push_back(std::move(Func));
+			}
+			
+			this->Wake.notify_one();
+		}
+		
+		static Pool &GetInstance(void)
+		{
+			static Pool *const Instance = new Pool;
+			
+			return *Instance;
+		}
+	};
+	
+	struct ParallelJob
+	{ //Shared with the helpers, since a helper can get scheduled after the caller already finished every piece itself.
+		const std::function<void(const size_t, const size_t)> *Body;
+		size_t Count;
+		size_t PieceSize;
+		size_t NumPieces;
+		std::atomic<size_t> NextPiece;
+		std::atomic<size_t> PiecesDone;
+		std::mutex Lock;
+		std::condition_variable Finished;
+		std::exception_ptr Error;
+		
+		void RunPieces(void)
+		{
+			size_t Piece;
+			
+			while ((Piece = this->NextPiece++) < this->NumPieces)
+			{
+				const size_t Begin = Piece * this->PieceSize;
+				const size_t End = std::min(this->Count, Begin + this->PieceSize);
+				
+				try
+				{
+					(*this->Body)(Begin, End);
+				}
+				catch (...)
+				{
+					const std::lock_guard<std::mutex> G { this->Lock };
+					
+					if (!this->Error) this->Error = std::current_exception();
+				}
+				
+				if (++this->PiecesDone == this->NumPieces)
+				{
+					const std::lock_guard<std::mutex> G { this->Lock };
+					this->Finished.notify_all();
+				}
+			}
+		}
+	};
+}
+
+void DecodeWork::Strand::WorkerLoop(void)
+{
+	std::unique_lock<std::mutex> Guard { this->Lock };
+	
+	while (true)
+	{
+		this->Wake.wait(Guard, [this] { return this->Stopping || !this->Queue.empty(); });
+		
+		if (this->Stopping) break;
+		
+		std::function<void(void)> Func { std::move(this->Queue.front()) };
+		this->Queue.pop_front();
+		
+		Guard.unlock();
+		
+		try
+		{
+			Func();
+		}
+		catch (const std::exception &Err)
+		{
+			LDEBUG_MSG("Exception applying subscription event: " << Err.what());
+		}
+		catch (...)
+		{
+			LDEBUG_MSG("Unknown exception applying subscription event");
+		}
+		
+		--this->Pending;
+		
+		Guard.lock();
+	}
+}
+
+void DecodeWork::Strand::Post(std::function<void(void)> Func)
+{
+	++this->Pending;
+	
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		if (!this->Worker.joinable()) this->Worker = std::thread(&Strand::WorkerLoop, this);
+		
+		this->Queue.push_back(std::move(Func));
+	}
+	
+	this->Wake.notify_one();
+}
+
+DecodeWork::Strand::~Strand(void)
+{ //Pending events are dropped, the state they would have updated is going away too.
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		this->Stopping = true;
+	}
+	
+	this->Wake.notify_all();
+	
+	if (this->Worker.joinable()) this->Worker.join();
+}
+
+void DecodeWork::ParallelFor(const size_t Count, const size_t MinChunk, const std::function<void(const size_t Begin, const size_t End)> &Body)
+{
+	Pool &Workers { Pool::GetInstance() };
+	
+	const size_t MaxPieces = (Workers.Size() + 1u) * 4u; //A few pieces per thread evens out uneven items.
+	const size_t NumPieces = std::min(MaxPieces, Count / std::max<size_t>(MinChunk, 1u));
+	
+	if (NumPieces <= 1u || OnPoolThread)
+	{ //Too small to be worth it, or we're already a helper and waiting here could starve the pool.
+		if (Count) Body(0u, Count);
+		return;
+	}
+	
+	const std::shared_ptr<ParallelJob> Job { std::make_shared<ParallelJob>() };
+	
+	Job->Body = &Body;
+	Job->Count = Count;
+	Job->PieceSize = (Count + NumPieces - 1u) / NumPieces;
+	Job->NumPieces = (Count + Job->PieceSize - 1u) / Job->PieceSize;
+	Job->NextPiece = 0u;
+	Job->PiecesDone = 0u;
+	
+	const size_t NumHelpers = std::min(Workers.Size(), Job->NumPieces - 1u);
+	
+	for (size_t Inc = 0u; Inc < NumHelpers; ++Inc)
+	{
+		Workers.Post([Job] { Job->RunPieces(); });
+	}
+	
+	Job->RunPieces();
+	
+	std::unique_lock<std::mutex> Guard { Job->Lock };
+	
+	Job->Finished.wait(Guard, [&Job] { return Job->PiecesDone.load() == Job->NumPieces; });
+	
+	if (Job->Error) std::rethrow_exception(Job->Error);
+}
@@ -0,0 +1,58 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_DECODEWORKER_H__
+#define __LIBCOYOTE_DECODEWORKER_H__
+
+#include "include/common.h"
+
+#include <deque>
+#include <atomic>
+#include <condition_variable>
+
+/**Keeps bulk subscription decoding off the WSCore thread, which also has to deliver synchronous replies and answer pings.
+ * Each session gets a Strand: one lazily started thread that applies that session's subscription events strictly in arrival order.
+ * ParallelFor() splits big array decodes across a small process-wide pool.**/
+
+namespace DecodeWork
+{
+	class Strand
+	{
+	private:
+		std::mutex Lock;
+		std::condition_variable Wake;
+		std::deque<std::function<void(void)> > Queue;
+		std::thread Worker;
+		std::atomic<size_t> Pending; //Queued plus running
+		bool Stopping;
+		
+		void WorkerLoop(void);
+	public:
+		void Post(std::function<void(void)> Func);
+		inline bool Busy(void) const { return this->Pending.load() != 0u; }
+		
+		Strand(void) : Pending(), Stopping() {}
+		~Strand(void);
+		
+		Strand(const Strand &) = delete;
+		Strand &operator=(const Strand &) = delete;
+	};
+	
+	//Calls Body over [0, Count) in chunks of at least MinChunk items, using the calling thread plus the pool.
+	//Chunks may run concurrently and in any order. The first exception thrown by Body is rethrown here once every chunk has finished.
+	void ParallelFor(const size_t Count, const size_t MinChunk, const std::function<void(const size_t Begin, const size_t End)> &Body);
+}
+
+#endif //__LIBCOYOTE_DECODEWORKER_H__
@@ -0,0 +1,109 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_ASSETCATALOG_H__
+#define __LIBCOYOTE_ASSETCATALOG_H__
+
+#include "common.h"
+#include "macros.h"
+#include "statuscodes.h"
+#include "datastructures.h"
+
+/**The subscribed asset catalog, as an immutable snapshot with secondary indexes.
+ * Assets are split into shards by path hash. Each shard carries its own indexes by parent directory, status and checksum.
+ * Assets themselves are reference counted and never copied. An AssetPost or AssetDelete copies one shard's pointers,
+ * then patches that shard's indexes for the one asset that changed. Every other shard is shared with the previous snapshot.
+ * Query results are pointers into the snapshot they came from, and keep that snapshot alive for as long as they exist.**/
+
+namespace Coyote
+{
+	struct AssetQuery
+	{
+		std::string Directory; //Empty for any. Matched on whole path components, a trailing slash is optional.
+		bool Recursive = true; //Include subdirectories of Directory
+		int32_t Status = -1; //An AssetState, or -1 for any
+		std::string Checksum; //Empty for any
+	};
+	
+	struct AssetShard
+	{ //Not copyable by accident, use Clone(). The indexes point at the shared assets, so a clone can keep them as they are.
+		std::unordered_map<std::string, std::shared_ptr<const Asset> > Assets;
+		std::map<std::string, std::vector<const Asset*> > ByDirectory; //Keyed by parent directory, with its trailing slash
+		std::array<std::vector<const Asset*>, COYOTE_ASSETSTATE_MAX + 1> ByStatus; //Last bucket catches anything out of range
+		std::unordered_multimap<std::string, const Asset*> ByChecksum;
+		
+		void Reindex(void);
+		void Index(const Asset *Item);
+		void Unindex(const Asset *Item);
+		std::shared_ptr<AssetShard> Clone(void) const;
+		
+		AssetShard(void) = default;
+		AssetShard(const AssetShard &) = delete;
+		AssetShard &operator=(const AssetShard &) = delete;
+	};
+	
+	class AssetCatalog;
+	
+	typedef std::shared_ptr<const AssetCatalog> AssetCatalogSnapshot;
+	
+	class AssetView
+	{ //The results of one query. Cheap to move, the assets themselves are never copied.
+	private:
+		AssetCatalogSnapshot Owner;
+		std::vector<const Asset*> Items;
+		
+		friend class AssetCatalog;
+	public:
+		typedef std::vector<const Asset*>::const_iterator const_iterator;
+		
+		inline const_iterator begin(void) const { return this->Items.begin(); }
+		inline const_iterator end(void) const { return this->Items.end(); }
+		inline size_t size(void) const { return this->Items.size(); }
+		inline bool empty(void) const { return this->Items.empty(); }
+		inline const Asset &operator[](const size_t Index) const { return *this->Items[Index]; }
+	};
+	
+	class EXPFUNC AssetCatalog : public std::enable_shared_from_this<AssetCatalog>
+	{
+	public:
+		static constexpr size_t NumShards = 64;
+	private:
+		std::array<std::shared_ptr<const AssetShard>, NumShards> Shards;
+		size_t Count;
+		
+		mutable std::once_flag FlattenOnce;
+		mutable AssetsSnapshot Flattened;
+	public:
+		static size_t ShardFor(const std::string &FullPath);
+		static std::string ParentDirectory(const std::string &FullPath);
+		
+		inline size_t Size(void) const { return this->Count; }
+		inline const AssetShard &Shard(const size_t Index) const { return *this->Shards[Index]; }
+		
+		const Asset *Find(const std::string &FullPath) const;
+		AssetView Query(const AssetQuery &Query) const;
+		AssetsSnapshot Flatten(void) const; //FullPath keyed map, built on first use and kept with the snapshot.
+		
+		//Building new versions. Only the subscription code does this, each returns a new snapshot and leaves this one alone.
+		static AssetCatalogSnapshot Build(std::vector<Asset> &&Items);
+		AssetCatalogSnapshot WithAsset(const Asset &Item) const;
+		AssetCatalogSnapshot WithoutAsset(const std::string &FullPath) const;
+		
+		AssetCatalog(void);
+	};
+}
+
+#endif //__LIBCOYOTE_ASSETCATALOG_H__
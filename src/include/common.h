@@ -45,6 +45,7 @@
 #define MSGPACK_DEFINE_MAP(...)
 #define MSGPACK_DEFINE_ARRAY(...)
 #define MSGPACK_ADD_ENUM(...)
+#define COYOTE_WIRE_MEMBERS
 #endif //MSGPACK_DEFINE_MAP
 
 
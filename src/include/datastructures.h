@@ -14,7 +14,7 @@
    limitations under the License.
 */
 
-/**It's important that you use MSGPACK_DEFINE_MAP, not MSGPACK_DEFINE or MSGPACK_DEFINE_ARRAY.
+/**Wire structs declare their msgpack members with COYOTE_WIRE_MEMBERS, defined in datastructures.cpp from the library's field lists. Don't use MSGPACK_DEFINE or MSGPACK_DEFINE_ARRAY,
  *Communicator won't understand the data structure otherwise. It looks at items by named text field.**/
 
 #ifndef __LIBCOYOTE_DATASTRUCTURES_H__
@@ -24,11 +24,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <time.h>
 #include "common.h"
 
 #include "macros.h"
 #include "statuscodes.h"
 
+#ifndef COYOTE_WIRE_MEMBERS //common.h leaves this empty when msgpack isn't included
+#define COYOTE_WIRE_MEMBERS \
+	void msgpack_pack(msgpack::packer<msgpack::sbuffer> &Pack) const; \
+	void msgpack_unpack(const msgpack::object &Obj); \
+	void msgpack_object(msgpack::object *Out, msgpack::zone &Zone) const;
+#endif //COYOTE_WIRE_MEMBERS
+
 
 typedef Coyote::ResolutionMode ResolutionMode;
 typedef Coyote::RefreshMode RefreshMode;
@@ -44,6 +52,22 @@ namespace Coyote
 	typedef void (*MiniviewCallback)(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Size2D &Dimensions, std::vector<uint8_t> FrameData, void *UserData);
 	typedef void (*PBEventCallback)(const PlaybackEventType EType, const int32_t PK, const int32_t Time, void *UserData);
 	typedef void (*StateEventCallback)(const StateEventType EventType, void *UserData);
+	
+	struct ChangeSet;
+	
+	//EventType is COYOTE_STATE_PRESETS or COYOTE_STATE_PRESETSTATES. ChangedFields is a PresetField or PresetStateField mask, zero for adds and removes.
+	typedef void (*PresetChangeCallback)(const StateEventType EventType, const int32_t PK, const ChangeKind Kind, const uint32_t ChangedFields, void *UserData);
+	typedef void (*ChangeSetCallback)(const StateEventType EventType, const ChangeSet &Changes, void *UserData);
+	
+	//Log downloads. The sink gets the bytes in order, a piece at a time, and can return false to abort the download.
+	//Total is zero until the unit has said how big the whole thing is.
+	typedef std::function<bool(const uint8_t *Data, const size_t Length)> LogSink;
+	typedef std::function<void(const uint64_t Done, const uint64_t Total)> LogProgressCallback;
+	
+	struct ExternalAsset;
+	
+	//Drive crawls. Subpath is the directory Entry was listed in, relative to the drive. Return false to stop the crawl.
+	typedef std::function<bool(const std::string &Subpath, const ExternalAsset &Entry)> DiskAssetCallback;
 
 
 	
@@ -54,7 +78,7 @@ namespace Coyote
 		inline bool operator==(const Size2D &Other) const { return this->Width == Other.Width && this->Height == Other.Height; }
 		inline bool operator!=(const Size2D &Other) const { return !(*this == Other); }
 		
-		MSGPACK_DEFINE_MAP(Width, Height)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct Coords2D
@@ -64,7 +88,7 @@ namespace Coyote
 		inline bool operator==(const Coords2D &Other) const { return this->X == Other.X && this->Y == Other.Y; }
 		inline bool operator!=(const Coords2D &Other) const { return !(*this == Other); }
 
-		MSGPACK_DEFINE_MAP(X, Y)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct Rect : public Size2D, public Coords2D
@@ -76,7 +100,7 @@ namespace Coyote
 		}
 		
 		inline bool operator!=(const Rect &Other) const { return !(*this == Other); }
-		MSGPACK_DEFINE_MAP(Width, Height, X, Y)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct Cube : public Rect
@@ -91,7 +115,7 @@ namespace Coyote
 		
 		inline bool operator!=(const Cube &Other) const { return !(*this == Other); }
 		
-		MSGPACK_DEFINE_MAP(Width, Height, X, Y, Z, Depth)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct Object
@@ -141,7 +165,16 @@ namespace Coyote
 		std::string FullPath;
 		Cube PinnedCoords;
 		float Hue, Saturation, Brightness, Contrast;
-		MSGPACK_DEFINE_MAP(FullPath, PinnedCoords, Hue, Saturation, Brightness, Contrast)
+		inline bool operator==(const PinnedAsset &Other) const
+		{
+			return	this->FullPath == Other.FullPath && this->PinnedCoords == Other.PinnedCoords &&
+					this->Hue == Other.Hue && this->Saturation == Other.Saturation &&
+					this->Brightness == Other.Brightness && this->Contrast == Other.Contrast;
+		}
+		
+		inline bool operator!=(const PinnedAsset &Other) const { return !(*this == Other); }
+		
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct ProjectorCanvasConfig : public Object
@@ -160,7 +193,7 @@ namespace Coyote
 		inline bool operator==(const ProjectorCanvasConfig &Other) const { return this->Orientation == Other.Orientation && this->Dimensions == Other.Dimensions && this->NumOutputs == Other.NumOutputs; }
 		inline bool operator!=(const ProjectorCanvasConfig &Other) const { return !(*this == Other); }
 		
-		MSGPACK_DEFINE_MAP(Dimensions, NumOutputs)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct CanvasInfo : public Object
@@ -170,7 +203,15 @@ namespace Coyote
 		SinkType SinkTypes;
 		uint32_t Index;
 		
-		MSGPACK_DEFINE_MAP(Assets, SinkTypes, Index)
+		inline bool operator==(const CanvasInfo &Other) const
+		{
+			return	this->CanvasCfg == Other.CanvasCfg && this->Assets == Other.Assets &&
+					this->SinkTypes == Other.SinkTypes && this->Index == Other.Index;
+		}
+		
+		inline bool operator!=(const CanvasInfo &Other) const { return !(*this == Other); }
+		
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct PresetMark : public Object
@@ -179,7 +220,10 @@ namespace Coyote
 		int32_t TimeMS;
 		std::string Name;
 		
-		MSGPACK_DEFINE_MAP(ID, TimeMS, Name)
+		inline bool operator==(const PresetMark &Other) const { return this->ID == Other.ID && this->TimeMS == Other.TimeMS && this->Name == Other.Name; }
+		inline bool operator!=(const PresetMark &Other) const { return !(*this == Other); }
+		
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct LANCoyote : public Object
@@ -191,7 +235,7 @@ namespace Coyote
 		std::string IP;
 		UnitRole CurrentRole;
 		UnitType Type;
-		MSGPACK_DEFINE_MAP(APIVersion, CommunicatorVersion, GUID, Nickname, CurrentRole, Type)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct TimeCode : public Object
@@ -200,7 +244,35 @@ namespace Coyote
 		int32_t Time;
 		std::vector<int32_t> VUData;
 		
-		MSGPACK_DEFINE_MAP(PK, Time, VUData)
+		COYOTE_WIRE_MEMBERS
+	};
+	
+	struct TimeCodeSample
+	{ //One received timecode, as the server sent it and when we got it.
+		int32_t Time;
+		std::chrono::steady_clock::time_point ReceivedAt;
+	};
+	
+	struct VUMeterConfig
+	{ //Levels are in whatever units the server sends VUData in, only magnitudes are looked at.
+		float PeakHoldSeconds = 1.5f; //How long a new peak is held before it falls with the decaying level
+		float DecayHalfLifeSeconds = 0.3f; //Falling ballistics. Exponential, so a steady fall on a dB scale.
+		uint32_t RMSWindow = 16; //In timecode events, 1 to 64
+		int32_t ClipThreshold = INT32_MAX; //Levels at or above this count as clipping
+	};
+	
+	struct VUMeterReading
+	{
+		static constexpr size_t MaxChannels = 64;
+		
+		int32_t PK;
+		uint32_t NumChannels;
+		std::chrono::steady_clock::time_point UpdatedAt;
+		std::array<float, MaxChannels> Level; //Latest sample, as received
+		std::array<float, MaxChannels> Ballistic; //Instant attack, decaying release
+		std::array<float, MaxChannels> PeakHold;
+		std::array<float, MaxChannels> RMS;
+		std::array<uint32_t, MaxChannels> ClipCount; //Times each channel went into clipping since the last reset
 	};
 	
 	struct Drive : public Object
@@ -209,7 +281,7 @@ namespace Coyote
 		int64_t Total, Used, Free;
 		bool IsExternal;
 		
-		MSGPACK_DEFINE_MAP(Mountpoint, Total, Used, Free, IsExternal)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct Asset : public Object
@@ -221,7 +293,7 @@ namespace Coyote
 		int64_t CurrentSize;
 		AssetState Status;
 		
-		MSGPACK_DEFINE_MAP(FullPath, Checksum, LastModified, TotalSize, CurrentSize, Status)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct AssetMetadata : public Object
@@ -239,20 +311,7 @@ namespace Coyote
 		uint32_t FPS;
 		int32_t Duration;
 		
-		MSGPACK_DEFINE_MAP(
-			FilePath,
-			FPS,
-			VideoFormat,
-			AudioFormat,
-			ContainerFormat,
-			Resolution,
-			TotalSize,
-			VBitrate,
-			ABitrate,
-			ASampleRate,
-			AChannels,
-			Duration
-		)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 
@@ -262,6 +321,9 @@ namespace Coyote
 		int32_t Index;
 		
 		inline TabOrdering(const std::string TabID = "", const int32_t Index = 0) : TabID(TabID), Index(Index) {}
+		
+		inline bool operator==(const TabOrdering &Other) const { return this->TabID == Other.TabID && this->Index == Other.Index; }
+		inline bool operator!=(const TabOrdering &Other) const { return !(*this == Other); }
 	}; //Processed by msgpack manually
 	
 	struct ExternalAsset : public Object
@@ -271,7 +333,7 @@ namespace Coyote
 		int64_t FileSize;
 		bool IsDirectory;
 		
-		MSGPACK_DEFINE_MAP(Filename, FullPath, FileSize, IsDirectory)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct PresetState : public Object
@@ -283,7 +345,19 @@ namespace Coyote
 		bool IsPaused;
 		bool IsSelected;
 		
-		MSGPACK_DEFINE_MAP(PK, TRT, CurrentLoop, IsPlaying, IsPaused, IsSelected)
+		inline uint32_t Diff(const PresetState &Other) const
+		{ //Returns a PresetStateField mask, PK isn't compared.
+			return	(this->TRT != Other.TRT ? COYOTE_PSFIELD_TRT : 0) |
+					(this->CurrentLoop != Other.CurrentLoop ? COYOTE_PSFIELD_CURRENTLOOP : 0) |
+					(this->IsPlaying != Other.IsPlaying ? COYOTE_PSFIELD_ISPLAYING : 0) |
+					(this->IsPaused != Other.IsPaused ? COYOTE_PSFIELD_ISPAUSED : 0) |
+					(this->IsSelected != Other.IsSelected ? COYOTE_PSFIELD_ISSELECTED : 0);
+		}
+		
+		inline bool operator==(const PresetState &Other) const { return this->PK == Other.PK && !this->Diff(Other); }
+		inline bool operator!=(const PresetState &Other) const { return !(*this == Other); }
+		
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct EXPFUNC Preset : public Object
@@ -310,26 +384,7 @@ namespace Coyote
 		int32_t Dissolve;
 		bool FreezeAtEnd;
 		
-		MSGPACK_DEFINE_MAP(
-			Name,
-			Notes,
-			Color,
-			Gotos,
-			Countdowns,
-			PK,
-			Loop,
-			Link,
-			DissolveInMS,
-			DissolveOutMS,
-			FadeInMS,
-			FadeOutMS,
-			InPosition,
-			OutPosition,
-			Dissolve,
-			FreezeAtEnd,
-			Volume,
-			SinkOptions
-		)
+		COYOTE_WIRE_MEMBERS
 		
 		
 		//Methods
@@ -338,6 +393,134 @@ namespace Coyote
 		const CanvasInfo *LookupCanvasByPlayer(const Coyote::Player PlayerNum) const;
 		std::array<uint32_t, 2> *GetPlayerRangeForCanvas(const uint32_t Index) const;
 		bool HasValidSinks(void) const;
+		uint32_t Diff(const Preset &Other) const; //Returns a PresetField mask, PK isn't compared.
+		
+		inline bool operator==(const Preset &Other) const { return this->PK == Other.PK && !this->Diff(Other); }
+		inline bool operator!=(const Preset &Other) const { return !(*this == Other); }
+	};
+	
+	struct PKChange
+	{
+		int32_t PK;
+		uint32_t ChangedFields; //PresetField or PresetStateField mask
+	};
+	
+	struct ChangeSet
+	{ //What one PresetsUpdate or PresetStatesUpdate actually changed, relative to what we had cached.
+		std::vector<int32_t> Added;
+		std::vector<int32_t> Removed;
+		std::vector<PKChange> Modified;
+		
+		inline bool Empty(void) const { return this->Added.empty() && this->Removed.empty() && this->Modified.empty(); }
+	};
+	
+	struct SessionOptions
+	{
+		uint32_t Subscriptions = COYOTE_SUB_ALL; //SubscriptionFlags, can be changed later with Session::SetSubscriptions()
+		bool MonitorOnly = false; //Skip the GetHostOS and GetSupportedSinks handshake queries. Kona sink support is still checked if COYOTE_SUB_HWSTATE is set.
+		int NumAttempts = -1; //Connection attempts, -1 for infinite
+		std::string StateCacheDir; //Last known presets, preset states, assets and HW state are kept here per unit, and loaded before connecting. Empty for none.
+		std::string UnitGUID; //Picks the cached unit, as reported by discovery or GetUnitID(). If empty, whichever unit was last saved for this host.
+	};
+	
+	struct TrafficReplayOptions
+	{
+		bool OriginalPacing = false; //Reproduce the gaps between messages as recorded. Otherwise as fast as they can be decoded.
+		double Speed = 1.0; //With OriginalPacing, 2.0 plays back twice as fast
+	};
+	
+	struct TrafficReplayStats
+	{
+		uint64_t Messages; //Fed through the session
+		uint64_t Bytes;
+		uint64_t Skipped; //Outgoing messages and command replies
+		uint64_t Failed; //Couldn't be decoded
+		std::chrono::nanoseconds Elapsed; //Until the last message was applied, including on the decode strand
+	};
+	
+	struct DiskAssetsPage
+	{
+		std::vector<ExternalAsset> Items;
+		std::string ContinuationToken; //Pass back in for the next page. Empty once the directory is finished.
+	};
+	
+	struct DiskCrawlOptions
+	{
+		uint32_t MaxConcurrent = 8; //Listing requests waiting on the unit at once
+		uint32_t MaxDepth = 0; //Directories below the starting one to descend into, zero for no limit
+		uint32_t PageSize = 500; //Entries per request, on units that page
+	};
+	
+	struct DiskCrawlStats
+	{
+		uint64_t Directories; //Listed, fully or not
+		uint64_t Entries; //Handed to the callback
+		uint64_t Requests;
+		uint64_t Failed; //Directories that couldn't be listed
+	};
+	
+	struct MarkEdit
+	{ //One goto or countdown change for Session::ApplyMarkEdits(). Marks are identified by PK and TimeMS, as with the single edit methods.
+		int32_t PK = 0;
+		MarkType Type = COYOTE_MARK_GOTO;
+		MarkEditAction Action = COYOTE_MARKEDIT_CREATE;
+		int32_t TimeMS = 0;
+		std::string Name; //The new name for creates and renames, ignored for deletes
+	};
+	
+	struct LogStreamOptions
+	{
+		uint32_t ChunkSize = 1u << 20; //Asked for per request from units that can send logs in pieces, and the most handed to the sink at once
+		time_t ChunkTimeoutSecs = 0; //Per request, zero for the session's command timeout
+		LogProgressCallback Progress; //Optional, called on the calling thread after every piece
+	};
+	
+	struct LogDay
+	{
+		std::string SpokeName;
+		int Year;
+		int Month;
+		int Day;
+	};
+	
+	struct LogDayResult
+	{
+		StatusCode Status;
+		std::string LogText;
+	};
+	
+	struct CallbackExecutorConfig
+	{ //NumThreads of 0 runs callbacks inline on the network thread, the way older versions did.
+		uint32_t NumThreads = 1; //More than one means callbacks can run concurrently and out of order.
+		uint32_t QueueLimit = 4096; //Past this many pending callbacks, the oldest get dropped. Preset and asset deltas are never dropped.
+		uint32_t Coalesce = COYOTE_COALESCE_ALL; //CoalesceFlags
+	};
+	
+	struct CallbackExecutorStats
+	{
+		uint64_t Posted;
+		uint64_t Executed;
+		uint64_t Dropped; //Lost to QueueLimit
+		uint64_t Coalesced; //Replaced by a newer event of the same kind before they ran
+		uint32_t Pending;
+		uint32_t HighWater;
+	};
+	
+	struct ResponseCacheStats
+	{
+		uint64_t Hits;
+		uint64_t Misses; //Including expired replies
+		uint64_t Invalidations; //Cached replies dropped early, by setters, reconnects or InvalidateResponseCache()
+		uint64_t Entries; //Held right now
+	};
+	
+	struct MiniviewStats
+	{
+		uint64_t Received; //Frames decoded off the wire
+		uint64_t Delivered; //Frames handed to miniview handlers
+		uint64_t Dropped; //Frames replaced by a newer one before a handler got to them
+		uint64_t BuffersAllocated;
+		uint64_t BuffersReused;
 	};
 	
 	struct KonaHardwareState : public Object
@@ -349,14 +532,7 @@ namespace Coyote
 		KonaAudioConfig AudioConfig;
 		bool ConstLumin;
 		
-		MSGPACK_DEFINE_MAP(
-			//Resolution, !! Handled custom !!
-			//RefreshRate, !! Handled custom !!
-			HDRMode,
-			EOTFSetting,
-			ConstLumin
-			//AudioConfig, !! Handled custom !!
-		)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct NetworkInfo : public Object
@@ -366,7 +542,7 @@ namespace Coyote
 		int32_t AdapterID;
 		bool CableConnected;
 		
-		MSGPACK_DEFINE_MAP(IP, Subnet, AdapterID, CableConnected)
+		COYOTE_WIRE_MEMBERS
 	};
 
 	struct Mirror : public Object
@@ -377,7 +553,7 @@ namespace Coyote
 		bool Busy;
 		bool IsAlive;
 		
-		MSGPACK_DEFINE_MAP(UnitID, IP, Type, Busy, IsAlive)
+		COYOTE_WIRE_MEMBERS
 	};
 	
 	struct GenlockSettings : public Object
@@ -387,7 +563,7 @@ namespace Coyote
 		int32_t VertValue;
 		bool Genlocked;
 		
-		MSGPACK_DEFINE_MAP(FormatString, HorzValue, VertValue, Genlocked)
+		COYOTE_WIRE_MEMBERS
 	};
 
 	struct LicensingStatus : public Object
@@ -401,9 +577,18 @@ namespace Coyote
 		uint32_t TotalSeats;
 		bool ValidLicense;
 
-		MSGPACK_DEFINE_MAP(LicenseKey, ProductName, UserName, LicenseMachineUUID, LicenseCaps, UsedSeats, TotalSeats, ValidLicense)
+		COYOTE_WIRE_MEMBERS
 	};
 
+	
+	//Immutable, reference counted views of subscription state. Holding one never blocks the network thread,
+	//and it never changes under you, a newer version just gets published next to it.
+	//Presets and preset states that didn't change are the very same object in both versions, so comparing pointers is enough to skip them.
+	typedef std::shared_ptr<const std::unordered_map<std::string, Asset> > AssetsSnapshot;
+	typedef std::shared_ptr<const std::unordered_map<int32_t, std::shared_ptr<const Preset> > > PresetsSnapshot;
+	typedef std::shared_ptr<const std::unordered_map<int32_t, std::shared_ptr<const PresetState> > > PresetStatesSnapshot;
+	typedef std::shared_ptr<const std::unordered_map<int32_t, TimeCode> > TimeCodesSnapshot;
+	typedef std::shared_ptr<const KonaHardwareState> HWStateSnapshot;
 }
 
 MSGPACK_ADD_ENUM(Coyote::CanvasOrientationEnum)
@@ -0,0 +1,82 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_EVENTSUBSCRIPTION_H__
+#define __LIBCOYOTE_EVENTSUBSCRIPTION_H__
+
+#include "common.h"
+#include "statuscodes.h"
+#include "datastructures.h"
+#include "miniviewframe.h"
+
+namespace Coyote
+{
+	//Typed handlers for Session::On*(). Any number of them can be registered per event.
+	typedef std::function<void(const TimeCode &TC)> TimeCodeHandler;
+	typedef std::function<void(const Asset &Posted)> AssetPostHandler;
+	typedef std::function<void(const std::string &FullPath)> AssetDeleteHandler;
+	typedef std::function<void(const AssetsSnapshot &Assets)> AssetSyncHandler;
+	typedef std::function<void(const PresetsSnapshot &Presets, const ChangeSet &Changes)> PresetsHandler;
+	typedef std::function<void(const PresetStatesSnapshot &PresetStates, const ChangeSet &Changes)> PresetStatesHandler;
+	typedef std::function<void(const StateEventType EventType, const int32_t PK, const ChangeKind Kind, const uint32_t ChangedFields)> PresetChangeHandler;
+	typedef std::function<void(const HWStateSnapshot &HWState)> HWStateHandler;
+	typedef std::function<void(const PlaybackEventType EType, const int32_t PK, const int32_t Time)> PlaybackEventHandler;
+	typedef std::function<void(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Size2D &Dimensions, const std::vector<uint8_t> &FrameData)> MiniviewHandler;
+	typedef std::function<void(const MiniviewFrame &Frame)> MiniviewFrameHandler; //Hang onto Frame as long as you like, nothing is copied.
+	typedef std::function<void(const StateEventType EventType)> StateEventHandler;
+
+	class Subscription
+	{ //Keeps a handler registered for as long as it lives. Safe to outlive the session it came from.
+	private:
+		std::function<void(void)> Cancel;
+	public:
+		Subscription(void) = default;
+		explicit Subscription(std::function<void(void)> Cancel) : Cancel(std::move(Cancel)) {}
+
+		Subscription(Subscription &&In) : Cancel(std::move(In.Cancel)) { In.Cancel = nullptr; }
+
+		Subscription &operator=(Subscription &&In)
+		{
+			if (this == &In) return *this;
+
+			this->Reset();
+			this->Cancel = std::move(In.Cancel);
+			In.Cancel = nullptr;
+
+			return *this;
+		}
+
+		Subscription(const Subscription &) = delete;
+		Subscription &operator=(const Subscription &) = delete;
+
+		~Subscription(void) { this->Reset(); }
+
+		inline void Reset(void)
+		{ //Unsubscribes now. Once this returns, the handler won't be started again, but a call already running on the callback executor may still finish.
+			if (!this->Cancel) return;
+
+			std::function<void(void)> Func { std::move(this->Cancel) };
+			this->Cancel = nullptr;
+
+			Func();
+		}
+
+		inline bool Active(void) const { return static_cast<bool>(this->Cancel); }
+		inline explicit operator bool(void) const { return this->Active(); }
+	};
+}
+
+#endif //__LIBCOYOTE_EVENTSUBSCRIPTION_H__
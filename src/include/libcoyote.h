@@ -25,6 +25,8 @@
 #include "easycanvasalign.h"
 #include "macros.h"
 #include "session.h"
+#include "eventsubscription.h"
+#include "assetcatalog.h"
 
 namespace Coyote
 { //Empty cuz everything else is in different headers
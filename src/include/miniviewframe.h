@@ -0,0 +1,85 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_MINIVIEWFRAME_H__
+#define __LIBCOYOTE_MINIVIEWFRAME_H__
+
+#include "common.h"
+#include "macros.h"
+#include "datastructures.h"
+
+namespace Coyote
+{
+	struct MiniviewImages;
+	
+	class MiniviewFrame
+	{ //One decoded miniview frame. Copies share the pixels, which go back to the session's buffer pool once the last copy is gone.
+	private:
+		std::shared_ptr<const std::vector<uint8_t> > Pixels;
+	public:
+		int32_t PK;
+		uint32_t CanvasIndex;
+		uint32_t OutputNum;
+		Size2D Dimensions;
+		uint64_t Sequence; //Counts frames received for this PK, canvas and output. Gaps between delivered frames were dropped as stale.
+		std::shared_ptr<const MiniviewImages> Images; //Only set on delivered frames while miniview processing is configured
+		
+		inline bool Valid(void) const { return this->Pixels != nullptr; }
+		inline const uint8_t *Data(void) const { return this->Pixels ? this->Pixels->data() : nullptr; }
+		inline size_t Size(void) const { return this->Pixels ? this->Pixels->size() : 0u; }
+		
+		inline const std::vector<uint8_t> &Bytes(void) const
+		{
+			static const std::vector<uint8_t> Empty;
+			
+			return this->Pixels ? *this->Pixels : Empty;
+		}
+		
+		MiniviewFrame(void) : PK(), CanvasIndex(), OutputNum(), Dimensions(), Sequence() {}
+		
+		MiniviewFrame(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Size2D &Dimensions, std::shared_ptr<const std::vector<uint8_t> > Pixels)
+			: Pixels(std::move(Pixels)), PK(PK), CanvasIndex(CanvasIndex), OutputNum(OutputNum), Dimensions(Dimensions), Sequence() {}
+	};
+	
+	struct MiniviewProcessingConfig
+	{
+		MiniviewPixelFormat SourceFormat = COYOTE_PIXFMT_AUTO;
+		MiniviewPixelFormat OutputFormat = COYOTE_PIXFMT_RGBA; //RGBA or BGRA
+		uint32_t MipLevels = 0; //Halved copies wanted beyond full size. More get made anyway if the tiles need them.
+		std::vector<Size2D> TileSizes; //Each one scaled from the smallest level that's still at least that big
+	};
+	
+	struct MiniviewImage
+	{ //Borrowed, valid for as long as the MiniviewImages it came from.
+		Size2D Dimensions;
+		size_t Stride; //Bytes per row
+		const uint8_t *Data;
+	};
+	
+	struct MiniviewImages
+	{ //Every level and tile lives in one buffer, apart from a full size level that needed no conversion, which is the frame's own pixels.
+		std::shared_ptr<const std::vector<uint8_t> > Storage;
+		MiniviewFrame Source;
+		MiniviewPixelFormat Format;
+		std::vector<MiniviewImage> Levels; //Levels[0] is full size, each one after is half the one before
+		std::vector<MiniviewImage> Tiles; //Same order as TileSizes
+	};
+	
+	//For frames from GetLatestMiniviewFrame() or anywhere else processing wasn't applied on delivery.
+	EXPFUNC StatusCode ProcessMiniview(const MiniviewFrame &Frame, const MiniviewProcessingConfig &Config, MiniviewImages &Out);
+}
+
+#endif //__LIBCOYOTE_MINIVIEWFRAME_H__
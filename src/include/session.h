@@ -26,6 +26,8 @@
 #include "macros.h"
 #include "statuscodes.h"
 #include "datastructures.h"
+#include "eventsubscription.h"
+#include "assetcatalog.h"
 
 namespace Coyote
 {
@@ -37,6 +39,7 @@ namespace Coyote
 		static constexpr size_t DefaultCommandTimeoutSecs = 10;
 		
 		Session(const std::string &Host, const int NumAttempts = -1);
+		Session(const std::string &Host, const SessionOptions &Options);
 		Session(Session &&In);
 		Session &operator=(Session &&In);
 		
@@ -45,13 +48,28 @@ namespace Coyote
 		Session &operator=(const Session &) = delete;
 		
 		StatusCode GetAssets(std::vector<Asset> &Out);
+		StatusCode QueryAssets(AssetView &Out, const AssetQuery &Query); //e.g. everything under a directory that is still copying. Served from indexes, nothing is copied.
 		StatusCode GetPresets(std::vector<Preset> &Out);
 		StatusCode GetPresetsMap(std::unordered_map<int32_t, Preset> &Out);
 		StatusCode GetPresetStates(std::vector<PresetState> &Out);
 		StatusCode GetPresetStatesMap(std::unordered_map<int32_t, PresetState> &Out);
 		StatusCode GetTimeCode(TimeCode &Out, const int32_t PK = 0);
+		StatusCode GetTimeCodeHistory(std::vector<TimeCodeSample> &Out, const int32_t PK = 0); //Last few received timecodes, oldest first.
+		StatusCode GetExtrapolatedTime(int32_t &TimeOut, const int32_t PK = 0, const std::chrono::steady_clock::time_point At = std::chrono::steady_clock::now()); //Estimated playhead at At, for smooth clocks between updates.
+		StatusCode EnableVUMeters(const VUMeterConfig &Config = VUMeterConfig{}); //Meters every PK's VUData as it arrives. Calling again starts over with the new settings.
+		void DisableVUMeters(void);
+		StatusCode GetVUMeters(VUMeterReading &Out, const int32_t PK = 0); //FAILED if meters are off or nothing arrived for PK yet
+		StatusCode ResetVUMeters(const int32_t PK = 0); //Clears held peaks and clip counts
 		StatusCode GetTimeCodesMap(std::unordered_map<int32_t, Coyote::TimeCode> &Out);
 		
+		//Zero copy versions of the above. Cheap enough to call every frame, hold on to them as long as you like.
+		AssetsSnapshot GetAssetsSnapshot(void) const;
+		AssetCatalogSnapshot GetAssetCatalog(void) const;
+		PresetsSnapshot GetPresetsSnapshot(void) const;
+		PresetStatesSnapshot GetPresetStatesSnapshot(void) const;
+		TimeCodesSnapshot GetTimeCodesSnapshot(void) const;
+		HWStateSnapshot GetKonaHardwareStateSnapshot(void) const;
+		
 		//Input parameter names must match the expected JSON names
 		StatusCode Take(const int32_t PK = 0);
 		StatusCode Pause(const int32_t PK = 0);
@@ -64,11 +82,20 @@ namespace Coyote
 		StatusCode DeletePreset(const int32_t PK);
 		StatusCode CreatePreset(const Preset &Ref);
 		StatusCode UpdatePreset(const Preset &Ref);
+		//Many presets in one message, or a pipelined burst of single commands on units without the batch commands.
+		//The PresetsUpdate the unit sends back after each one is collapsed, so subscribers see a single refresh. StatusesOut lines up with Presets.
+		StatusCode CreatePresets(const std::vector<Preset> &Presets, std::vector<StatusCode> *StatusesOut = nullptr);
+		StatusCode UpdatePresets(const std::vector<Preset> &Presets, std::vector<StatusCode> *StatusesOut = nullptr);
 		StatusCode ReadAssetMetadata(const std::string &FullPath, AssetMetadata &Out);
 		StatusCode BeginUpdate(void);
 		StatusCode GetDisks(std::vector<Drive> &Out);
 		inline StatusCode GetDrives(std::vector<Drive> &Out) { return this->GetDisks(Out); }
 		StatusCode GetDiskAssets(std::vector<ExternalAsset> &Out, const std::string &DriveName, const std::string &Subpath = "");
+		//One page of a directory. Pass Out.ContinuationToken back in until it comes back empty. Units that don't page send the whole directory as one page.
+		StatusCode GetDiskAssetsPage(DiskAssetsPage &Out, const std::string &DriveName, const std::string &Subpath = "", const std::string &ContinuationToken = "", const uint32_t PageSize = 500);
+		//Walks the tree under Subpath with several listings in flight at once, handing each entry to Callback on this thread as its page arrives.
+		//A directory that can't be listed doesn't stop the crawl, the first such error is what gets returned.
+		StatusCode CrawlDiskAssets(const std::string &DriveName, const std::string &Subpath, const DiskAssetCallback &Callback, const DiskCrawlOptions &Options = DiskCrawlOptions{}, DiskCrawlStats *StatsOut = nullptr);
 		StatusCode EjectDisk(const std::string &Mountpoint);
 		StatusCode GetUnitID(std::string &UnitIDOut, std::string &NicknameOut);
 		StatusCode GetKonaHardwareState(KonaHardwareState &Out);
@@ -108,9 +135,18 @@ namespace Coyote
 		StatusCode DeleteCountdown(const int32_t PK, const int32_t Time);
 		StatusCode CreateGoto(const int32_t PK, const int32_t Time, const std::string &Name);
 		StatusCode CreateCountdown(const int32_t PK, const int32_t Time, const std::string &Name);
+		StatusCode ApplyMarkEdits(const std::vector<MarkEdit> &Edits, std::vector<StatusCode> *StatusesOut = nullptr); //Applied in order, as one batch. MISUSED before sending anything if an edit has a bad Type or Action.
 		StatusCode GetLogsZip(std::vector<uint8_t> &OutBuffer);
 		StatusCode ReadLog(const std::string &SpokeName, const int Year, const int Month, const int Day, std::string &LogOut);
 		StatusCode ExportLogsZip(const std::string &Mountpoint);
+		
+		//Streaming versions of the above, memory use is bounded by ChunkSize rather than by how much the unit has logged.
+		//Units that don't support chunked transfers still send everything in one reply, but it isn't copied again on the way to the sink.
+		StatusCode StreamLogsZip(const LogSink &Sink, const LogStreamOptions &Options = LogStreamOptions{});
+		StatusCode StreamLogsZipToFD(const int FD, const LogStreamOptions &Options = LogStreamOptions{});
+		StatusCode StreamLog(const std::string &SpokeName, const int Year, const int Month, const int Day, const LogSink &Sink, const LogStreamOptions &Options = LogStreamOptions{});
+		StatusCode StreamLogToFD(const std::string &SpokeName, const int Year, const int Month, const int Day, const int FD, const LogStreamOptions &Options = LogStreamOptions{});
+		StatusCode ReadLogs(const std::vector<LogDay> &Days, std::vector<LogDayResult> &Out, const uint32_t MaxConcurrent = 4); //OK only if every day was read, Out has each one's status.
 		StatusCode SetPausedState(const int32_t PK, const bool Value);
 		StatusCode SetPause(const int32_t PK);
 		StatusCode UnsetPause(const int32_t PK);
@@ -143,6 +179,10 @@ namespace Coyote
 		StatusCode GetLicensingStatus(LicensingStatus &LicStats);
 		StatusCode SubscribeMiniview(const int32_t PK);
 		StatusCode UnsubscribeMiniview(const int32_t PK);
+		StatusCode GetLatestMiniviewFrame(MiniviewFrame &Out, const int32_t PK, const uint32_t CanvasIndex = 0, const uint32_t OutputNum = 0); //FAILED if none arrived yet
+		MiniviewStats GetMiniviewStats(void) const;
+		StatusCode SetMiniviewProcessing(const MiniviewProcessingConfig &Config); //Applied to frames given to OnMiniviewFrame() handlers, see MiniviewFrame::Images
+		void DisableMiniviewProcessing(void);
 		StatusCode HostSinkEarlyFireup(void);
 		StatusCode ExitSupervisor(void);
 		
@@ -150,18 +190,68 @@ namespace Coyote
 		
 		void SetCommandTimeoutSecs(const time_t TimeoutSecs = DefaultCommandTimeoutSecs);
 		time_t GetCommandTimeoutSecs(void) const;
+		
+		//GetServerVersion(), GetSupportsS12G(), GetLicensingStatus(), GetWatchPaths(), GetHostSinkResolution(), GetBMDResolution(),
+		//GetGenlockSettings() and GetMirrors() reuse replies for a few seconds to a few minutes each. The matching setters and Reconnect() drop them early.
+		//Commands are named as on the wire, e.g. "GetMirrors". A TTL of zero turns caching off for that command.
+		void SetResponseCacheTTL(const std::string &CommandName, const std::chrono::milliseconds TTL);
+		void InvalidateResponseCache(const std::string &CommandName = {}); //Empty for everything
+		ResponseCacheStats GetResponseCacheStats(void) const;
 		bool HasConnectionError(void) const;
 		
 		bool Connected(void) const;
 		bool Reconnect(const std::string &Host = {});
 		std::string GetHost(void) const;
-		std::string GetHostOS(void) const;
+		std::string GetHostOS(void) const; //Empty for MonitorOnly sessions
+		
+		//SubscriptionFlags. Added feeds are subscribed right away. The server can't unsubscribe, so removed ones are dropped
+		//on arrival without being decoded, their cached state is released, and they stop being sent after the next Reconnect().
+		StatusCode SetSubscriptions(const uint32_t Flags);
+		uint32_t GetSubscriptions(void) const;
 		
 		///WARNING: All callbacks will execute in a different thread than the thread calling the setter method!
+		///By default they run on one dedicated callback thread, in order, never on the network thread.
+		
+		StatusCode ConfigureCallbackExecutor(const CallbackExecutorConfig &Config); //MISUSED if called from inside a callback.
+		CallbackExecutorStats GetCallbackExecutorStats(void) const;
 		
 		void SetMiniviewCallback(const MiniviewCallback CB, void *const UserData = nullptr); 
 		void SetPlaybackEventCallback(const PBEventCallback CB, void *const UserData = nullptr); 
 		void SetStateEventCallback(const StateEventType EType, const StateEventCallback CB, void *const UserData = nullptr);
+		void SetPresetChangeCallback(const PresetChangeCallback CB, void *const UserData = nullptr); //Once per added, removed or modified PK.
+		void SetChangeSetCallback(const ChangeSetCallback CB, void *const UserData = nullptr); //Once per update that changed anything.
+		StatusCode GetLastChangeSet(const StateEventType EType, ChangeSet &Out); //Presets and preset states only.
+		
+		//Every state category has a version that goes up each time a change to it is published. COYOTE_STATE_INVALID covers all of them.
+		//WaitForStateChange() blocks until the version differs from LastSeenVersion, then returns OK, or FAILED on timeout.
+		//Either way VersionOut gets the current version, so it can be fed straight back in. Miniviews aren't versioned.
+		uint64_t GetStateVersion(const StateEventType EType) const;
+		StatusCode WaitForStateChange(uint64_t &VersionOut, const StateEventType EType, const uint64_t LastSeenVersion, const std::chrono::milliseconds Timeout);
+		
+		//With SessionOptions::StateCacheDir set, state can start out as loaded from disk. It stays flagged until the unit sends its own.
+		bool IsStateFromCache(const StateEventType EType) const;
+		StatusCode FlushStateCache(void); //Saves now instead of a couple of seconds after the last change. MISUSED without a cache directory.
+		
+		//Captures are raw, timestamped copies of every message to and from the unit, meant for bug reports and offline benchmarks.
+		//ReplayTraffic() feeds one back through the decode and subscription code with no network, so it needs a session that never
+		//connected (NumAttempts of 0). Callbacks, typed subscriptions and snapshots all see the replayed state as if it were live.
+		StatusCode StartTrafficCapture(const std::string &Path); //Replaces any capture already running. Kept across reconnects.
+		void StopTrafficCapture(void);
+		StatusCode ReplayTraffic(const std::string &Path, const TrafficReplayOptions &Options = TrafficReplayOptions{}, TrafficReplayStats *StatsOut = nullptr);
+		
+		//Typed subscriptions. Any number per event, each one stays registered until its Subscription is reset or destroyed.
+		Subscription OnTimeCode(TimeCodeHandler Handler);
+		Subscription OnAssetPost(AssetPostHandler Handler);
+		Subscription OnAssetDelete(AssetDeleteHandler Handler);
+		Subscription OnAssetSync(AssetSyncHandler Handler);
+		Subscription OnPresets(PresetsHandler Handler);
+		Subscription OnPresetStates(PresetStatesHandler Handler);
+		Subscription OnPresetChange(PresetChangeHandler Handler);
+		Subscription OnKonaHardwareState(HWStateHandler Handler);
+		Subscription OnPlaybackEvent(PlaybackEventHandler Handler);
+		Subscription OnMiniview(MiniviewHandler Handler);
+		Subscription OnMiniviewFrame(MiniviewFrameHandler Handler); //Zero copy, only the newest frame per canvas and output waits for a slow handler.
+		Subscription OnStateEvent(const StateEventType EType, StateEventHandler Handler); //COYOTE_STATE_INVALID for all of them.
 		
 		//Only useful for Sonoran internal code.
 		StatusCode _SVS_WriteCytLog_(const std::string &Param1, const std::string &Param2); //Users: DO NOT use this method.
@@ -176,8 +266,10 @@ namespace Coyote
 	
 	extern EXPFUNC const std::unordered_map<ResolutionMode, std::string> ResolutionMap;
 	EXPFUNC ResolutionMode ReverseResolutionMap(const std::string &Lookup);
+	EXPFUNC ResolutionMode ReverseResolutionMap(const char *Lookup, const size_t Length);
 	
 	extern EXPFUNC const std::unordered_map<RefreshMode, std::string> RefreshMap;
 	EXPFUNC RefreshMode ReverseRefreshMap(const std::string &Lookup);
+	EXPFUNC RefreshMode ReverseRefreshMap(const char *Lookup, const size_t Length);
 }
 #endif //__LIBCOYOTE_SESSION_H__
@@ -215,6 +215,95 @@ namespace Coyote
 		COYOTE_LICCAP_MAXVALUE = COYOTE_LICCAP_4PLAYERS,
 	};
 	
+	enum PresetField : uint32_t
+	{ //Bitmask of what changed between two versions of a preset, see Preset::Diff()
+		COYOTE_PFIELD_NONE				= 0,
+		COYOTE_PFIELD_NAME				= 1 << 0,
+		COYOTE_PFIELD_NOTES				= 1 << 1,
+		COYOTE_PFIELD_COLOR				= 1 << 2,
+		COYOTE_PFIELD_CANVASES			= 1 << 3,
+		COYOTE_PFIELD_GOTOS				= 1 << 4,
+		COYOTE_PFIELD_COUNTDOWNS		= 1 << 5,
+		COYOTE_PFIELD_VOLUME			= 1 << 6,
+		COYOTE_PFIELD_TABDISPLAYORDER	= 1 << 7,
+		COYOTE_PFIELD_SINKOPTIONS		= 1 << 8,
+		COYOTE_PFIELD_LOOP				= 1 << 9,
+		COYOTE_PFIELD_LINK				= 1 << 10,
+		COYOTE_PFIELD_DISSOLVEINMS		= 1 << 11,
+		COYOTE_PFIELD_DISSOLVEOUTMS		= 1 << 12,
+		COYOTE_PFIELD_FADEINMS			= 1 << 13,
+		COYOTE_PFIELD_FADEOUTMS			= 1 << 14,
+		COYOTE_PFIELD_INPOSITION		= 1 << 15,
+		COYOTE_PFIELD_OUTPOSITION		= 1 << 16,
+		COYOTE_PFIELD_DISSOLVE			= 1 << 17,
+		COYOTE_PFIELD_FREEZEATEND		= 1 << 18,
+		COYOTE_PFIELD_ALL				= (1 << 19) - 1,
+	};
+	
+	enum PresetStateField : uint32_t
+	{ //Same idea for PresetState::Diff()
+		COYOTE_PSFIELD_NONE			= 0,
+		COYOTE_PSFIELD_TRT			= 1 << 0,
+		COYOTE_PSFIELD_CURRENTLOOP	= 1 << 1,
+		COYOTE_PSFIELD_ISPLAYING	= 1 << 2,
+		COYOTE_PSFIELD_ISPAUSED		= 1 << 3,
+		COYOTE_PSFIELD_ISSELECTED	= 1 << 4,
+		COYOTE_PSFIELD_ALL			= (1 << 5) - 1,
+	};
+	
+	enum ChangeKind
+	{
+		COYOTE_CHANGE_ADDED		= 1,
+		COYOTE_CHANGE_REMOVED	= 2,
+		COYOTE_CHANGE_MODIFIED	= 3,
+	};
+	
+	enum MarkType
+	{
+		COYOTE_MARK_GOTO		= 1,
+		COYOTE_MARK_COUNTDOWN	= 2,
+	};
+	
+	enum MarkEditAction
+	{
+		COYOTE_MARKEDIT_CREATE	= 1,
+		COYOTE_MARKEDIT_RENAME	= 2,
+		COYOTE_MARKEDIT_DELETE	= 3,
+	};
+	
+	enum CoalesceFlags : uint32_t
+	{ //Events that may be collapsed to only the newest pending one when callbacks fall behind.
+		COYOTE_COALESCE_NONE		= 0,
+		COYOTE_COALESCE_TIMECODE	= 1 << 0, //Per PK
+		COYOTE_COALESCE_MINIVIEW	= 1 << 1, //Per PK, canvas and output
+		COYOTE_COALESCE_STATEEVENTS	= 1 << 2, //Per StateEventType
+		COYOTE_COALESCE_HWSTATE		= 1 << 3,
+		COYOTE_COALESCE_ASSETSYNC	= 1 << 4,
+		COYOTE_COALESCE_ALL			= (1 << 5) - 1,
+	};
+	
+	enum SubscriptionFlags : uint32_t
+	{ //Which subscription feeds a session asks the server for.
+		COYOTE_SUB_NONE				= 0,
+		COYOTE_SUB_TIMECODE			= 1 << 0,
+		COYOTE_SUB_ASSETS			= 1 << 1, //AssetSync, AssetPost and AssetDelete
+		COYOTE_SUB_PRESETSTATES		= 1 << 2,
+		COYOTE_SUB_PRESETS			= 1 << 3,
+		COYOTE_SUB_HWSTATE			= 1 << 4, //Only sent to units with a Kona sink
+		COYOTE_SUB_PLAYBACKEVENTS	= 1 << 5,
+		COYOTE_SUB_ALL				= (1 << 6) - 1,
+	};
+	
+	enum MiniviewPixelFormat
+	{
+		COYOTE_PIXFMT_AUTO		= 0, //Source only. Taken from the frame's size, 3 bytes per pixel is RGB24 and 4 is RGBA.
+		COYOTE_PIXFMT_RGB24		= 1,
+		COYOTE_PIXFMT_BGR24		= 2,
+		COYOTE_PIXFMT_RGBA		= 3,
+		COYOTE_PIXFMT_BGRA		= 4,
+		COYOTE_PIXFMT_MAX
+	};
+	
 	EXPFUNC std::array<uint32_t, 2> *GetPlayerRange(const Coyote::Player Players);
 	EXPFUNC std::vector<uint32_t> PlayersToIntegers(const Coyote::Player Players);
 
@@ -0,0 +1,351 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "miniviewpipeline.h"
+#include "pixelkernels.h"
+#include <algorithm>
+
+void MiniviewPipe::Pipeline::Recycle(std::vector<uint8_t> *Buffer)
+{
+	std::unique_ptr<std::vector<uint8_t> > Owned { Buffer };
+	
+	if (Owned->capacity() > MaxRetainedBufferBytes) return;
+	
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	if (this->FreeBuffers.size() < MaxFreeBuffers) this->FreeBuffers.push_back(std::move(Owned));
+}
+
+std::shared_ptr<std::vector<uint8_t> > MiniviewPipe::Pipeline::Acquire(const size_t Size)
+{
+	std::unique_ptr<std::vector<uint8_t> > Buffer;
+	
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		if (!this->FreeBuffers.empty())
+		{
+			Buffer = std::move(this->FreeBuffers.back());
+			this->FreeBuffers.pop_back();
+		}
+	}
+	
+	if (Buffer) ++this->BuffersReused;
+	else
+	{
+		Buffer.reset(new std::vector<uint8_t>);
+		++this->BuffersAllocated;
+	}
+	
+	Buffer->resize(Size);
+	
+	//Frames can outlive the session, so the way back to the pool has to notice when it's gone.
+	const std::weak_ptr<Pipeline> Weak { this->shared_from_this() };
+	
+	return std::shared_ptr<std::vector<uint8_t> >(Buffer.release(), [Weak] (std::vector<uint8_t> *const Ptr)
+		{
+			if (const std::shared_ptr<Pipeline> Strong = Weak.lock()) Strong->Recycle(Ptr);
+			else delete Ptr;
+		});
+}
+
+uint32_t MiniviewPipe::Pipeline::Store(Coyote::MiniviewFrame &Frame)
+{
+	++this->Received;
+	
+	Coyote::MiniviewFrame Previous; //Released after unlocking, its buffer comes back through Recycle().
+	
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	Slot &Target { this->Slots[SlotKey(Frame.PK, Frame.CanvasIndex, Frame.OutputNum)] }; //Value initialized, so new slots start out zeroed
+	
+	if (!Target.ID) Target.ID = this->NextSlotID++;
+	
+	Frame.Sequence = ++Target.Received;
+	
+	Previous = std::move(Target.Latest);
+	Target.Latest = Frame;
+	
+	return Target.ID;
+}
+
+void MiniviewPipe::Pipeline::NoteDelivered(const Coyote::MiniviewFrame &Frame)
+{ //Whatever was received in between never made it to a handler, either replaced while queued or lost to the executor's queue limit.
+	++this->Delivered;
+	
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	const auto Iter = this->Slots.find(SlotKey(Frame.PK, Frame.CanvasIndex, Frame.OutputNum));
+	
+	if (Iter == this->Slots.end() || Frame.Sequence <= Iter->second.LastDelivered) return;
+	
+	this->Dropped += Frame.Sequence - Iter->second.LastDelivered - 1u;
+	Iter->second.LastDelivered = Frame.Sequence;
+}
+
+bool MiniviewPipe::Pipeline::GetLatest(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, Coyote::MiniviewFrame &Out) const
+{ //Whatever Out held before may be the last reference to a pooled frame, so it has to be let go of after unlocking, same as in Store().
+	Coyote::MiniviewFrame Latest;
+	
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		const auto Iter = this->Slots.find(SlotKey(PK, CanvasIndex, OutputNum));
+		
+		if (Iter == this->Slots.end()) return false;
+		
+		Latest = Iter->second.Latest;
+	}
+	
+	std::swap(Out, Latest);
+	
+	return true;
+}
+
+void MiniviewPipe::Pipeline::Forget(const int32_t PK)
+{ //Lets go of the latest frames for a PK that's no longer subscribed.
+	std::vector<Coyote::MiniviewFrame> Released; //Same as in Store()
+	
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	for (auto Iter = this->Slots.begin(); Iter != this->Slots.end();)
+	{
+		if (Iter->second.Latest.PK != PK)
+		{
+			++Iter;
+			continue;
+		}
+		
+		Released.push_back(std::move(Iter->second.Latest));
+		Iter = this->Slots.erase(Iter);
+	}
+}
+
+Coyote::MiniviewStats MiniviewPipe::Pipeline::GetStats(void) const
+{
+	Coyote::MiniviewStats RetVal{};
+	
+	RetVal.Received = this->Received.load();
+	RetVal.Delivered = this->Delivered.load();
+	RetVal.Dropped = this->Dropped.load();
+	RetVal.BuffersAllocated = this->BuffersAllocated.load();
+	RetVal.BuffersReused = this->BuffersReused.load();
+	
+	return RetVal;
+}
+
+void MiniviewPipe::Pipeline::SetProcessing(std::shared_ptr<const Coyote::MiniviewProcessingConfig> Config)
+{
+	std::atomic_store(&this->Processing, std::move(Config));
+}
+
+void MiniviewPipe::Pipeline::ApplyProcessing(Coyote::MiniviewFrame &Frame)
+{
+	const std::shared_ptr<const Coyote::MiniviewProcessingConfig> Config { std::atomic_load(&this->Processing) };
+	
+	if (!Config) return;
+	
+	std::shared_ptr<Coyote::MiniviewImages> Images { std::make_shared<Coyote::MiniviewImages>() };
+	
+	const Coyote::StatusCode Status = Process(Frame, *Config, *Images, [this] (const size_t Size) { return this->Acquire(Size); });
+	
+	if (Status != Coyote::COYOTE_STATUS_OK)
+	{
+		LDEBUG_MSG("Miniview processing failed for PK " << Frame.PK << " with status " << Status);
+		return;
+	}
+	
+	Frame.Images = std::move(Images);
+}
+
+static bool LayoutFor(const Coyote::MiniviewPixelFormat Format, PixelKernels::Layout &Out)
+{
+	switch (Format)
+	{
+		case Coyote::COYOTE_PIXFMT_RGB24: Out = PixelKernels::Layout::RGB24; return true;
+		case Coyote::COYOTE_PIXFMT_BGR24: Out = PixelKernels::Layout::BGR24; return true;
+		case Coyote::COYOTE_PIXFMT_RGBA: Out = PixelKernels::Layout::RGBA; return true;
+		case Coyote::COYOTE_PIXFMT_BGRA: Out = PixelKernels::Layout::BGRA; return true;
+		default: return false;
+	}
+}
+
+Coyote::StatusCode MiniviewPipe::CheckConfig(const Coyote::MiniviewProcessingConfig &Config)
+{
+	PixelKernels::Layout Unused;
+	
+	if (Config.SourceFormat != Coyote::COYOTE_PIXFMT_AUTO && !LayoutFor(Config.SourceFormat, Unused)) return Coyote::COYOTE_STATUS_MISUSED;
+	if (Config.OutputFormat != Coyote::COYOTE_PIXFMT_RGBA && Config.OutputFormat != Coyote::COYOTE_PIXFMT_BGRA) return Coyote::COYOTE_STATUS_MISUSED;
+	if (Config.MipLevels > 31u) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	for (const Coyote::Size2D &Tile : Config.TileSizes)
+	{
+		if (Tile.Width <= 0 || Tile.Height <= 0) return Coyote::COYOTE_STATUS_MISUSED;
+	}
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode MiniviewPipe::Process(const Coyote::MiniviewFrame &Frame, const Coyote::MiniviewProcessingConfig &Config, Coyote::MiniviewImages &Out, const BufferSource &Allocate)
+{
+	const Coyote::StatusCode ConfigStatus = CheckConfig(Config);
+	
+	if (ConfigStatus != Coyote::COYOTE_STATUS_OK) return ConfigStatus;
+	
+	const int32_t Width = Frame.Dimensions.Width, Height = Frame.Dimensions.Height;
+	
+	if (!Frame.Valid() || Width <= 0 || Height <= 0) return Coyote::COYOTE_STATUS_FAILED;
+	
+	const size_t NumPixels = static_cast<size_t>(Width) * Height;
+	
+	if (Frame.Size() % NumPixels) return Coyote::COYOTE_STATUS_FAILED;
+	
+	const size_t BPP = Frame.Size() / NumPixels;
+	
+	PixelKernels::Layout SrcLayout;
+	
+	if (Config.SourceFormat == Coyote::COYOTE_PIXFMT_AUTO)
+	{ //The server doesn't say, so go by size.
+		if (BPP == 3u) SrcLayout = PixelKernels::Layout::RGB24;
+		else if (BPP == 4u) SrcLayout = PixelKernels::Layout::RGBA;
+		else return Coyote::COYOTE_STATUS_FAILED;
+	}
+	else if (!LayoutFor(Config.SourceFormat, SrcLayout) || PixelKernels::BytesPerPixel(SrcLayout) != BPP) return Coyote::COYOTE_STATUS_FAILED;
+	
+	const bool DstBGRA = Config.OutputFormat == Coyote::COYOTE_PIXFMT_BGRA;
+	const bool ConvertNeeded = SrcLayout != (DstBGRA ? PixelKernels::Layout::BGRA : PixelKernels::Layout::RGBA);
+	
+	//Work out every level we need first, so it all fits in a single buffer.
+	std::vector<Coyote::Size2D> LevelSizes { Frame.Dimensions };
+	
+	auto NextLevel = [] (const Coyote::Size2D &Size) { return Coyote::Size2D { std::max(1, Size.Width / 2), std::max(1, Size.Height / 2) }; };
+	auto CanHalve = [] (const Coyote::Size2D &Size) { return Size.Width > 1 || Size.Height > 1; };
+	
+	while (LevelSizes.size() <= Config.MipLevels && CanHalve(LevelSizes.back())) LevelSizes.push_back(NextLevel(LevelSizes.back()));
+	
+	std::vector<size_t> TileLevels;
+	TileLevels.reserve(Config.TileSizes.size());
+	
+	for (const Coyote::Size2D &Tile : Config.TileSizes)
+	{ //Box filtering down the levels keeps the bilinear step at less than 2:1, where it doesn't alias.
+		size_t Level = 0u;
+		
+		while (true)
+		{
+			if (Level + 1u >= LevelSizes.size())
+			{
+				if (!CanHalve(LevelSizes.back())) break;
+				
+				const Coyote::Size2D Next { NextLevel(LevelSizes.back()) };
+				
+				if (Next.Width < Tile.Width || Next.Height < Tile.Height) break;
+				
+				LevelSizes.push_back(Next);
+			}
+			
+			const Coyote::Size2D &Next { LevelSizes[Level + 1u] };
+			
+			if (Next.Width < Tile.Width || Next.Height < Tile.Height) break;
+			
+			++Level;
+		}
+		
+		TileLevels.push_back(Level);
+	}
+	
+	auto ImageBytes = [] (const Coyote::Size2D &Size) { return static_cast<size_t>(Size.Width) * Size.Height * 4u; };
+	
+	size_t Total = ConvertNeeded ? ImageBytes(LevelSizes[0]) : 0u;
+	
+	for (size_t Inc = 1u; Inc < LevelSizes.size(); ++Inc) Total += ImageBytes(LevelSizes[Inc]);
+	
+	for (size_t Inc = 0u; Inc < Config.TileSizes.size(); ++Inc)
+	{
+		if (Config.TileSizes[Inc] != LevelSizes[TileLevels[Inc]]) Total += ImageBytes(Config.TileSizes[Inc]);
+	}
+	
+	std::shared_ptr<std::vector<uint8_t> > Storage { Allocate(Total) };
+	uint8_t *Cursor = Storage->data();
+	
+	auto Place = [&Cursor, &ImageBytes] (const Coyote::Size2D &Size)
+	{
+		uint8_t *const RetVal = Cursor;
+		
+		Cursor += ImageBytes(Size);
+		
+		return RetVal;
+	};
+	
+	Out.Levels.clear();
+	Out.Tiles.clear();
+	Out.Levels.reserve(LevelSizes.size());
+	Out.Tiles.reserve(Config.TileSizes.size());
+	
+	if (ConvertNeeded)
+	{
+		uint8_t *const Dst = Place(LevelSizes[0]);
+		
+		for (int32_t Y = 0; Y < Height; ++Y)
+		{
+			PixelKernels::ConvertRow(Frame.Data() + Y * Width * BPP, SrcLayout, Dst + Y * Width * 4u, DstBGRA, Width);
+		}
+		
+		Out.Levels.push_back({ LevelSizes[0], static_cast<size_t>(Width) * 4u, Dst });
+	}
+	else Out.Levels.push_back({ LevelSizes[0], static_cast<size_t>(Width) * 4u, Frame.Data() }); //Already what was asked for, no copy.
+	
+	for (size_t Inc = 1u; Inc < LevelSizes.size(); ++Inc)
+	{
+		const Coyote::MiniviewImage Prev { Out.Levels[Inc - 1u] };
+		const size_t Stride = static_cast<size_t>(LevelSizes[Inc].Width) * 4u;
+		uint8_t *const Dst = Place(LevelSizes[Inc]);
+		
+		PixelKernels::Halve(Prev.Data, Prev.Dimensions.Width, Prev.Dimensions.Height, Prev.Stride, Dst, Stride);
+		
+		Out.Levels.push_back({ LevelSizes[Inc], Stride, Dst });
+	}
+	
+	for (size_t Inc = 0u; Inc < Config.TileSizes.size(); ++Inc)
+	{
+		const Coyote::MiniviewImage &From { Out.Levels[TileLevels[Inc]] };
+		const Coyote::Size2D &Tile { Config.TileSizes[Inc] };
+		
+		if (Tile == From.Dimensions)
+		{
+			Out.Tiles.push_back(From);
+			continue;
+		}
+		
+		const size_t Stride = static_cast<size_t>(Tile.Width) * 4u;
+		uint8_t *const Dst = Place(Tile);
+		
+		PixelKernels::Resize(From.Data, From.Dimensions.Width, From.Dimensions.Height, From.Stride, Dst, Tile.Width, Tile.Height, Stride);
+		
+		Out.Tiles.push_back({ Tile, Stride, Dst });
+	}
+	
+	Out.Storage = std::move(Storage);
+	Out.Source = Frame;
+	Out.Source.Images.reset();
+	Out.Format = Config.OutputFormat;
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode Coyote::ProcessMiniview(const MiniviewFrame &Frame, const MiniviewProcessingConfig &Config, MiniviewImages &Out)
+{
+	return MiniviewPipe::Process(Frame, Config, Out, [] (const size_t Size) { return std::make_shared<std::vector<uint8_t> >(Size); });
+}
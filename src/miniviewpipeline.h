@@ -0,0 +1,89 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_MINIVIEWPIPELINE_H__
+#define __LIBCOYOTE_MINIVIEWPIPELINE_H__
+
+#include "include/common.h"
+#include "include/datastructures.h"
+#include "include/miniviewframe.h"
+
+#include <atomic>
+
+/**Where miniview frames live between the network thread and whoever consumes them.
+ * Pixels are decoded into buffers recycled through a small pool, so a steady stream of frames stops allocating once warm.
+ * Every (PK, CanvasIndex, OutputNum) has a slot holding its latest frame, for polling and for counting what got skipped.
+ * Pushing frames to handlers goes through the callback executor, keyed per slot, so a slow consumer only ever has the newest one waiting.
+ * Optional processing (format conversion, halved levels, fixed size tiles) runs on delivery, after stale frames have already been skipped.**/
+
+namespace MiniviewPipe
+{
+	static constexpr size_t MaxFreeBuffers = 16;
+	static constexpr size_t MaxRetainedBufferBytes = 4 * 1024 * 1024; //Anything bigger is freed rather than pooled.
+	
+	typedef std::function<std::shared_ptr<std::vector<uint8_t> >(const size_t Size)> BufferSource;
+	
+	Coyote::StatusCode CheckConfig(const Coyote::MiniviewProcessingConfig &Config);
+	Coyote::StatusCode Process(const Coyote::MiniviewFrame &Frame, const Coyote::MiniviewProcessingConfig &Config, Coyote::MiniviewImages &Out, const BufferSource &Allocate);
+	
+	class Pipeline : public std::enable_shared_from_this<Pipeline>
+	{
+	private:
+		struct Slot
+		{
+			uint32_t ID; //Executor key, unique per slot
+			uint64_t Received;
+			uint64_t LastDelivered;
+			Coyote::MiniviewFrame Latest;
+		};
+		
+		mutable std::mutex Lock;
+		std::unordered_map<uint64_t, Slot> Slots;
+		std::vector<std::unique_ptr<std::vector<uint8_t> > > FreeBuffers; //Protected by Lock
+		uint32_t NextSlotID; //Protected by Lock
+		std::shared_ptr<const Coyote::MiniviewProcessingConfig> Processing; //Atomic access only, null when off
+		
+		std::atomic<uint64_t> Received;
+		std::atomic<uint64_t> Delivered;
+		std::atomic<uint64_t> Dropped;
+		std::atomic<uint64_t> BuffersAllocated;
+		std::atomic<uint64_t> BuffersReused;
+		
+		void Recycle(std::vector<uint8_t> *Buffer);
+		
+		static inline uint64_t SlotKey(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum)
+		{
+			return (static_cast<uint64_t>(static_cast<uint32_t>(PK)) << 32) | ((CanvasIndex & 0xFFFFu) << 16) | (OutputNum & 0xFFFFu);
+		}
+	public:
+		std::shared_ptr<std::vector<uint8_t> > Acquire(const size_t Size); //Contents are unspecified, overwrite all of it.
+		uint32_t Store(Coyote::MiniviewFrame &Frame); //Fills in Frame.Sequence, returns the slot's executor key.
+		void NoteDelivered(const Coyote::MiniviewFrame &Frame);
+		bool GetLatest(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, Coyote::MiniviewFrame &Out) const;
+		void Forget(const int32_t PK);
+		Coyote::MiniviewStats GetStats(void) const;
+		
+		void SetProcessing(std::shared_ptr<const Coyote::MiniviewProcessingConfig> Config);
+		void ApplyProcessing(Coyote::MiniviewFrame &Frame); //Fills in Frame.Images if processing is on. Failures just leave it empty.
+		
+		Pipeline(void) : NextSlotID(1u), Received(), Delivered(), Dropped(), BuffersAllocated(), BuffersReused() {}
+		
+		Pipeline(const Pipeline &) = delete;
+		Pipeline &operator=(const Pipeline &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_MINIVIEWPIPELINE_H__
@@ -15,6 +15,8 @@
 */
 #include "msgpackproc.h"
 #include "include/libcoyote.h"
+#include "wireschema.h"
+#include "compactwire.h"
 
 
 #include <typeinfo>
@@ -111,14 +113,14 @@ static Coyote::Object *CoyoteCanvasOrientationUnpack(const msgpack::object &Obj)
 		}
 		
 		std::unordered_map<std::string, msgpack::object> CoordsMap;
-
+		
 		Mappy["Custom"].convert(CoordsMap);
 		
 		const Coyote::Coords2D Coords { CoordsMap["X"].as<int32_t>(), CoordsMap["Y"].as<int32_t>() };
 		
 		return new CanvasOrientation(CanvasOrientationEnum::Custom, &Coords);
 	}
-
+	
 	static const std::unordered_map<std::string, CanvasOrientationEnum> EnumMap
 	{
 		{ "Invalid", CanvasOrientationEnum::Invalid },
@@ -168,7 +170,7 @@ static Coyote::Object *CoyoteProjectorCanvasConfigUnpack(const msgpack::object &
 static Coyote::Object *CoyoteCanvasInfoUnpack(const msgpack::object &Obj)
 {
 	Coyote::CanvasInfo *Info = static_cast<Coyote::CanvasInfo*>(CoyoteGenericUnpack<Coyote::CanvasInfo>(Obj));
-
+	
 	std::unordered_map<std::string, msgpack::object> Mappy;
 	
 	Obj.convert(Mappy);
@@ -205,11 +207,11 @@ static Coyote::Object *CoyotePresetUnpack(const msgpack::object &Obj)
 	Coyote::Preset *const PObj = static_cast<Coyote::Preset*>(CoyoteGenericUnpack<Coyote::Preset>(Obj));
 	
 	if (!PObj) return nullptr;
-
+	
 	std::unordered_map<std::string, msgpack::object> Mappy;
 	
 	Obj.convert(Mappy);
-
+	
 	std::vector<msgpack::object> RawCanvases;
 	
 	Mappy["Canvases"].convert(RawCanvases);
@@ -244,7 +246,7 @@ static void CoyotePresetPack(const Coyote::Object *const Obj, msgpack::object *c
 	std::unordered_map<std::string, msgpack::object> Mappy;
 	
 	ConvObj.convert(Mappy);
-		
+	
 	std::vector<msgpack::object> OutCanvases;
 	OutCanvases.reserve(PObj->Canvases.size());
 	
@@ -258,7 +260,7 @@ static void CoyotePresetPack(const Coyote::Object *const Obj, msgpack::object *c
 	}
 	
 	std::unordered_map<std::string, int32_t> Tabs;
-
+	
 	for (const auto &Pair : PObj->TabDisplayOrder)
 	{
 		Tabs.emplace(Pair.second.TabID, Pair.second.Index);
@@ -266,7 +268,7 @@ static void CoyotePresetPack(const Coyote::Object *const Obj, msgpack::object *c
 	
 	Mappy["Canvases"] = msgpack::object { std::move(OutCanvases), TempZone };
 	Mappy["TabDisplayOrder"] = msgpack::object { std::move(Tabs), TempZone };
-
+	
 	*Out = msgpack::object{ std::move(Mappy), TempZone };
 }
 
@@ -275,22 +277,30 @@ static void CoyoteHWStatePack(const Coyote::Object *const Obj, msgpack::object *
 	const Coyote::KonaHardwareState *const HWObj = static_cast<const Coyote::KonaHardwareState*>(Obj);
 	
 	msgpack::object ConvObj { *HWObj, TempZone };
-
+	
 	std::unordered_map<std::string, msgpack::object> Mappy;
 	
 	ConvObj.convert(Mappy);
-
+	
 	std::vector<msgpack::object> ResolutionStrings;
 	
 	ResolutionStrings.reserve(NUM_KONA_OUTS);
 	
 	for (size_t Inc = 0u; Inc < NUM_KONA_OUTS; ++Inc)
 	{
-		ResolutionStrings.emplace_back(msgpack::object { ResolutionMap.at(HWObj->Resolutions[Inc]).c_str() });
+		const char *const Text = WireSchema::ResolutionText(HWObj->Resolutions[Inc]);
+		
+		assert(Text != nullptr);
+		
+		ResolutionStrings.emplace_back(msgpack::object { Text ? Text : "" });
 	}
 	
+	const char *const RefreshText = WireSchema::RefreshText(HWObj->RefreshRate);
+	
+	assert(RefreshText != nullptr);
+	
 	Mappy.emplace("Resolutions", msgpack::object{ MsgpackProc::STLArrayToMsgpackArray(ResolutionStrings, TempZone), TempZone });
-	Mappy.emplace("RefreshRate", msgpack::object{ RefreshMap.at(HWObj->RefreshRate), TempZone });
+	Mappy.emplace("RefreshRate", msgpack::object{ RefreshText ? RefreshText : "", TempZone });
 	Mappy.emplace("AudioConfig", msgpack::object{ (int)HWObj->AudioConfig, TempZone });
 	
 	*Out = msgpack::object { std::move(Mappy), TempZone };
@@ -301,42 +311,67 @@ static Coyote::Object *CoyoteHWStateUnpack(const msgpack::object &Obj)
 	Coyote::KonaHardwareState *const HWObj = static_cast<Coyote::KonaHardwareState*>(CoyoteGenericUnpack<Coyote::KonaHardwareState>(Obj));
 	
 	if (!HWObj) return nullptr;
-
+	
 	std::unordered_map<std::string, msgpack::object> Mappy;
 	
 	Obj.convert(Mappy);
 	
-	const auto ResStrings = Mappy.at("Resolutions").as<std::vector<std::string>>();
+	const msgpack::object &ResArray = Mappy.at("Resolutions");
+	
+	if (ResArray.type != msgpack::type::ARRAY) throw std::bad_cast{};
 	
-	const size_t NumOuts = std::min(ResStrings.size(), (size_t)NUM_KONA_OUTS);
+	const size_t NumOuts = std::min((size_t)ResArray.via.array.size, (size_t)NUM_KONA_OUTS);
 	
 	for (size_t Inc = 0; Inc < NumOuts; ++Inc)
-	{
-		HWObj->Resolutions.at(Inc) = ReverseResolutionMap(ResStrings.at(Inc));
+	{ //Straight from the message buffer into the perfect hash, no std::string in between.
+		HWObj->Resolutions.at(Inc) = MsgpackProc::UnpackResolution(ResArray.via.array.ptr[Inc]);
 	}
 	
-	HWObj->RefreshRate = ReverseRefreshMap(Mappy.at("RefreshRate").as<std::string>());
+	HWObj->RefreshRate = MsgpackProc::UnpackRefreshRate(Mappy.at("RefreshRate"));
 	HWObj->AudioConfig = (Coyote::KonaAudioConfig)Mappy.at("AudioConfig").as<int>();
 	
 	return HWObj;
 }
 	
 //Definitions
-void MsgpackProc::InitOutgoingMsg(msgpack::packer<msgpack::sbuffer> &Pack, const std::string &CommandName, const uint64_t MsgID, const msgpack::object *Values)
+static inline void PackString(msgpack::packer<msgpack::sbuffer> &Pack, const char *const String, const size_t Length)
 {
-	msgpack::zone TempZone;
+	Pack.pack_str(Length);
+	Pack.pack_str_body(String, Length);
+}
+
+void MsgpackProc::InitOutgoingMsg(msgpack::packer<msgpack::sbuffer> &Pack, const std::string &CommandName, const uint64_t MsgID, const msgpack::object *Values, const uint16_t CompactKeyLimit)
+{ //Packed field by field. Building a map of msgpack objects just to serialize it again cost a zone and a hash table per command.
+  //CompactKeyLimit is nonzero once the server agreed to the compact encoding, see compactwire.h
+	static const char APIVersion[] = COYOTE_API_VERSION;
 	
-	std::unordered_map<std::string, msgpack::object> TotalValues
+	const auto PackHeaderKey = [&Pack, CompactKeyLimit] (const WireSchema::WireKey Key, const char *const Text, const size_t Length)
 	{
-		{ "CommandName", msgpack::object{ CommandName.c_str(), TempZone} },
-		{ "CoyoteAPIVersion", msgpack::object{ COYOTE_API_VERSION, TempZone } },
+		if (CompactKeyLimit >= static_cast<uint16_t>(Key)) CompactWire::PackKey(Pack, Key);
+		else PackString(Pack, Text, Length);
 	};
 	
-	if (MsgID) TotalValues.emplace("MsgID", msgpack::object{ MsgID });
+	Pack.pack_map(2 + (MsgID != 0) + (Values != nullptr));
 	
-	if (Values != nullptr) TotalValues["Data"] = *Values;
-
-	Pack.pack(TotalValues);
+	PackHeaderKey(WireSchema::WireKey::CommandName, "CommandName", sizeof "CommandName" - 1);
+	PackString(Pack, CommandName.data(), CommandName.size());
+	
+	PackHeaderKey(WireSchema::WireKey::CoyoteAPIVersion, "CoyoteAPIVersion", sizeof "CoyoteAPIVersion" - 1);
+	PackString(Pack, APIVersion, sizeof APIVersion - 1);
+	
+	if (MsgID)
+	{
+		PackHeaderKey(WireSchema::WireKey::MsgID, "MsgID", sizeof "MsgID" - 1);
+		Pack.pack(MsgID);
+	}
+	
+	if (Values != nullptr)
+	{
+		PackHeaderKey(WireSchema::WireKey::Data, "Data", sizeof "Data" - 1);
+		
+		if (CompactKeyLimit) CompactWire::PackObject(Pack, *Values, CompactKeyLimit);
+		else Pack.pack(*Values);
+	}
 }
 
 static bool HasValidIncomingHeaders(const std::unordered_map<std::string, msgpack::object> &Values)
@@ -357,12 +392,151 @@ static bool IsSubscriptionEvent(const std::unordered_map<std::string, msgpack::o
 	return Values.count("SubscriptionEvent");
 }
 
+static inline uint32_t ReadBE(const uint8_t *Ptr, const size_t Bytes)
+{
+	uint32_t Value = 0u;
+	
+	for (size_t Inc = 0u; Inc < Bytes; ++Inc) Value = (Value << 8) | Ptr[Inc];
+	
+	return Value;
+}
+
+static bool SkipObjects(const uint8_t *&Ptr, const uint8_t *const End, size_t Remaining)
+{ //Steps over whole msgpack objects without building anything. Nested containers just add to the count, so no recursion.
+	while (Remaining--)
+	{
+		if (Ptr >= End) return false;
+		
+		const uint8_t Tag = *Ptr++;
+		size_t Skip = 0u;
+		size_t LenBytes = 0u;
+		
+		if 		(Tag <= 0x7f || Tag >= 0xe0 || Tag == 0xc0 || Tag == 0xc2 || Tag == 0xc3) continue;
+		else if (Tag <= 0x8f) { Remaining += (Tag & 0x0f) * 2u; continue; }
+		else if (Tag <= 0x9f) { Remaining += Tag & 0x0f; continue; }
+		else if (Tag <= 0xbf) Skip = Tag & 0x1f;
+		else switch (Tag)
+		{
+			case 0xc4: case 0xd9: LenBytes = 1u; break; //bin8, str8
+			case 0xc5: case 0xda: LenBytes = 2u; break;
+			case 0xc6: case 0xdb: LenBytes = 4u; break;
+			case 0xc7: LenBytes = 1u; Skip = 1u; break; //ext8, plus the type byte
+			case 0xc8: LenBytes = 2u; Skip = 1u; break;
+			case 0xc9: LenBytes = 4u; Skip = 1u; break;
+			case 0xcc: case 0xd0: Skip = 1u; break;
+			case 0xcd: case 0xd1: Skip = 2u; break;
+			case 0xca: case 0xce: case 0xd2: Skip = 4u; break;
+			case 0xcb: case 0xcf: case 0xd3: Skip = 8u; break;
+			case 0xd4: Skip = 2u; break; //fixext, plus the type byte
+			case 0xd5: Skip = 3u; break;
+			case 0xd6: Skip = 5u; break;
+			case 0xd7: Skip = 9u; break;
+			case 0xd8: Skip = 17u; break;
+			case 0xdc: case 0xdd: case 0xde: case 0xdf:
+			{
+				const size_t CountBytes = (Tag & 1) ? 4u : 2u;
+				
+				if (static_cast<size_t>(End - Ptr) < CountBytes) return false;
+				
+				const size_t Count = ReadBE(Ptr, CountBytes);
+				Ptr += CountBytes;
+				
+				if (Count > static_cast<size_t>(End - Ptr)) return false; //Every element takes at least a byte.
+				
+				Remaining += Tag >= 0xde ? Count * 2u : Count;
+				continue;
+			}
+			default:
+				return false;
+		}
+		
+		if (LenBytes)
+		{
+			if (static_cast<size_t>(End - Ptr) < LenBytes) return false;
+			
+			Skip += ReadBE(Ptr, LenBytes);
+			Ptr += LenBytes;
+		}
+		
+		if (static_cast<size_t>(End - Ptr) < Skip) return false;
+		
+		Ptr += Skip;
+	}
+	
+	return true;
+}
+
+static bool MatchKey(const uint8_t *Ptr, const uint8_t *const End, const WireSchema::WireKey Key)
+{ //Plain string or an interned compact-v1 key, see compactwire.h
+	if (End - Ptr >= 3 && Ptr[0] == 0xd4 && static_cast<int8_t>(Ptr[1]) == CompactWire::KeyExtType) return Ptr[2] == static_cast<uint8_t>(Key);
+	
+	const char *const Text = WireSchema::KeyText(static_cast<uint16_t>(Key));
+	const size_t Len = strlen(Text);
+	
+	if (Len > 31 || End - Ptr < static_cast<ptrdiff_t>(Len + 1) || Ptr[0] != (0xa0 | Len)) return false;
+	
+	return !memcmp(Ptr + 1, Text, Len);
+}
+
+static void ReadString(const uint8_t *Ptr, const uint8_t *const End, const char *&Text, size_t &Length)
+{ //Leaves Text alone if Ptr isn't at a complete string.
+	if (Ptr >= End) return;
+	
+	size_t Len = 0u;
+	
+	if 		((*Ptr & 0xe0) == 0xa0) Len = *Ptr++ & 0x1f;
+	else if (*Ptr == 0xd9 && End - Ptr >= 2) { Len = Ptr[1]; Ptr += 2; }
+	else if (*Ptr == 0xda && End - Ptr >= 3) { Len = ReadBE(Ptr + 1, 2); Ptr += 3; }
+	else return;
+	
+	if (static_cast<size_t>(End - Ptr) < Len) return;
+	
+	Text = reinterpret_cast<const char*>(Ptr);
+	Length = Len;
+}
+
+bool MsgpackProc::ScanHeaders(const void *Data, const size_t DataLength, MessageHeaders &Out)
+{ //Just enough to route a message, without decoding a possibly huge body on the network thread.
+	const uint8_t *Ptr = static_cast<const uint8_t*>(Data);
+	const uint8_t *const End = Ptr + DataLength;
+	
+	Out = MessageHeaders{};
+	
+	if (Ptr >= End) return false;
+	
+	size_t Count = 0u;
+	
+	if 		((*Ptr & 0xf0) == 0x80) Count = *Ptr++ & 0x0f;
+	else if (*Ptr == 0xde && End - Ptr >= 3) { Count = ReadBE(Ptr + 1, 2); Ptr += 3; }
+	else if (*Ptr == 0xdf && End - Ptr >= 5) { Count = ReadBE(Ptr + 1, 4); Ptr += 5; }
+	else return false;
+	
+	for (size_t Inc = 0u; Inc < Count; ++Inc)
+	{
+		bool IsEventKey = false;
+		
+		if 		(MatchKey(Ptr, End, WireSchema::WireKey::MsgID)) Out.HasMsgID = true;
+		else if (MatchKey(Ptr, End, WireSchema::WireKey::SubscriptionEvent)) Out.IsSubscription = IsEventKey = true;
+		
+		if (!SkipObjects(Ptr, End, 1u)) return false; //Key
+		
+		if (IsEventKey) ReadString(Ptr, End, Out.EventName, Out.EventNameLength);
+		
+		if (!SkipObjects(Ptr, End, 1u)) return false; //Value
+	}
+	
+	return true;
+}
+
 std::unordered_map<std::string, msgpack::object> MsgpackProc::InitIncomingMsg(const void *Data, const size_t DataLength, msgpack::zone &TempZone, uint64_t *MsgIDOut)
 {
 	//Unpack binary data.
 	msgpack::unpacked Result;
-
-	const msgpack::object &Object { msgpack::unpack(TempZone, (const char*)Data, DataLength) };
+	
+	msgpack::object Object { msgpack::unpack(TempZone, (const char*)Data, DataLength) };
+	
+	//Compact messages get their keys turned back into strings first, it's a cheap walk and nothing below has to care.
+	if (CompactWire::IsCompact(Object)) CompactWire::ExpandKeys(Object);
 	
 	//Convert into a map of smaller msgpack objects
 	std::unordered_map<std::string, msgpack::object> Values;
@@ -388,11 +562,25 @@ std::unordered_map<std::string, msgpack::object> MsgpackProc::InitIncomingMsg(co
 	return Values;
 }
 
+Coyote::ResolutionMode MsgpackProc::UnpackResolution(const msgpack::object &Object)
+{
+	if (Object.type != msgpack::type::STR) return Coyote::COYOTE_RES_INVALID;
+	
+	return ReverseResolutionMap(Object.via.str.ptr, Object.via.str.size);
+}
+
+Coyote::RefreshMode MsgpackProc::UnpackRefreshRate(const msgpack::object &Object)
+{
+	if (Object.type != msgpack::type::STR) return Coyote::COYOTE_REFRESH_INVALID;
+	
+	return ReverseRefreshMap(Object.via.str.ptr, Object.via.str.size);
+}
+
 msgpack::object MsgpackProc::PackCoyoteObject(const Coyote::Object *Object, msgpack::zone &TempZone, msgpack::packer<msgpack::sbuffer> *Pack)
 { //I haven't used typeid/RTTI since 2014. I figured 'why not', it's here anyways.
 	
 	const std::type_index OurType { typeid(*Object) };
-
+	
 	const static std::unordered_map<std::type_index, void (*)(const Coyote::Object *Obj, msgpack::object *Out, msgpack::zone &TempZone)> Lookup
 	{
 		{ std::type_index(typeid(Coyote::Asset)), &CoyoteGenericPack<Coyote::Asset> },
@@ -413,7 +601,7 @@ msgpack::object MsgpackProc::PackCoyoteObject(const Coyote::Object *Object, msgp
 		{ std::type_index(typeid(Coyote::CanvasInfo)), &CoyoteCanvasInfoPack },
 		{ std::type_index(typeid(Coyote::ProjectorCanvasConfig)), &CoyoteProjectorCanvasConfigPack },
 	};
-
+	
 	assert(Lookup.count(OurType));
 	
 	msgpack::object Obj;
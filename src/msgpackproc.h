@@ -22,19 +22,31 @@
 
 #include "include/common.h"
 #include "include/datastructures.h"
+#include "pools.h"
 
 namespace MsgpackProc
 {
+	struct MessageHeaders
+	{
+		bool HasMsgID;
+		bool IsSubscription;
+		const char *EventName; //Points into the scanned buffer. Null unless SubscriptionEvent was a plain string.
+		size_t EventNameLength;
+	};
+	
 	msgpack::object PackCoyoteObject(const Coyote::Object *Object, msgpack::zone &TempZone, msgpack::packer<msgpack::sbuffer> *Pack = nullptr);
 	Coyote::Object *UnpackCoyoteObject(const msgpack::object &Object, const std::type_info &Expected);
-	void InitOutgoingMsg(msgpack::packer<msgpack::sbuffer> &Pack, const std::string &CommandName, const uint64_t MsgID = 0u, const msgpack::object *Values = nullptr);
+	void InitOutgoingMsg(msgpack::packer<msgpack::sbuffer> &Pack, const std::string &CommandName, const uint64_t MsgID = 0u, const msgpack::object *Values = nullptr, const uint16_t CompactKeyLimit = 0u);
+	bool ScanHeaders(const void *Data, const size_t DataLength, MessageHeaders &Out);
 	std::unordered_map<std::string, msgpack::object> InitIncomingMsg(const void *Data, const size_t DataLength, msgpack::zone &TempZone, uint64_t *MsgIDOut = nullptr);
+	Coyote::ResolutionMode UnpackResolution(const msgpack::object &Object);
+	Coyote::RefreshMode UnpackRefreshRate(const msgpack::object &Object);
 
 	
 	template<typename T>
 	msgpack::object STLArrayToMsgpackArray(const T &Vector, msgpack::zone &InZone)
 	{ //Works on std::array, std::vector, and probably std::list
-		msgpack::sbuffer Buffer;
+		POOLED_SBUFFER(Buffer);
 		msgpack::packer<msgpack::sbuffer> Pack { Buffer };
 		
 		Pack.pack_array(Vector.size());
@@ -50,7 +62,7 @@ namespace MsgpackProc
 	template<typename T>
 	msgpack::object STLMapToMsgpackMap(const T &Map, msgpack::zone &InZone)
 	{
-		msgpack::sbuffer Buffer;
+		POOLED_SBUFFER(Buffer);
 		msgpack::packer<msgpack::sbuffer> Pack { Buffer };
 		
 		Pack.pack_map(Map.size());
@@ -25,6 +25,7 @@
 
 #include "include/common.h"
 #include "msgpackproc.h"
+#include "pools.h"
 #include "native_ws.h"
 
 /**
@@ -57,7 +58,7 @@ WS::WSCore::WSCore(bool (*const OnReceiveCallback)(WSConnection*, WSMessage*))
 
 void WS::WSConnection::SendPing(void)
 {
-	msgpack::sbuffer Buffer;
+	POOLED_SBUFFER(Buffer);
 	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
 	
 	MsgpackProc::InitOutgoingMsg(Pack, "Ping");
@@ -262,6 +263,11 @@ void WS::WSConnection::OnRecv(const QByteArray &Data)
 	
 	if (!Msg) return;
 	
+	if (const std::shared_ptr<WireTrace::Recorder> Capture { std::atomic_load(&this->Recorder) })
+	{
+		Capture->Write(WireTrace::Incoming, Msg->GetBody(), Msg->GetBodySize());
+	}
+	
 	this->OnReceiveCallback(this, Msg);
 }
 
@@ -383,6 +389,11 @@ void WS::WSConnection::Shutdown(void)
 
 void WS::WSConnection::Send(WSMessage *Msg)
 {
+	if (const std::shared_ptr<WireTrace::Recorder> Capture { std::atomic_load(&this->Recorder) })
+	{
+		Capture->Write(WireTrace::Outgoing, Msg->GetBody(), Msg->GetBodySize());
+	}
+	
 	std::unique_lock<std::mutex> OGuard { this->OMutex };
 	
 	this->Outgoing.push(Msg);
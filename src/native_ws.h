@@ -21,6 +21,7 @@
 
 #include "include/common.h"
 #include "mtevent.h"
+#include "wiretrace.h"
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -55,6 +56,7 @@ namespace WS
 		std::unique_ptr<QWebSocket> WebSocket;		
 		std::atomic_uint64_t LastPingMS;
 		std::atomic_bool ErrorDetectedFlag;
+		std::shared_ptr<WireTrace::Recorder> Recorder; //Null unless capturing. Always accessed with std::atomic_load()/std::atomic_store().
 		
 		//Private methods
 		WSMessage *AddFragment(const void *Data, const size_t DataSize);
@@ -73,6 +75,7 @@ namespace WS
 		bool NeedsPing(void) const;
 		void SendPing(void);
 		inline bool HasError(void) const { return this->ErrorDetectedFlag; }
+		inline void SetRecorder(const std::shared_ptr<WireTrace::Recorder> &NewRecorder) { std::atomic_store(&this->Recorder, NewRecorder); }
 
 		//No copying or moving
 		WSConnection(const WSConnection &) = delete;
@@ -0,0 +1,395 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "pixelkernels.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXELKERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//Lets the SIMD paths live in this file without building the whole library for a newer CPU.
+#if defined(PIXELKERNELS_X86) && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+using PixelKernels::Layout;
+
+namespace
+{
+	struct ChannelMap
+	{
+		uint8_t R, G, B;
+		bool HasAlpha; //Always at offset 3
+	};
+	
+	struct KernelSet
+	{
+		void (*ConvertRow)(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width);
+		void (*HalveRow)(const uint8_t *Row0, const uint8_t *Row1, uint8_t *Dst, const size_t DstWidth, const size_t SrcWidth, const size_t X);
+		void (*ResizeRow)(const uint8_t *Row0, const uint8_t *Row1, const uint32_t FY, const uint32_t *Offsets0, const uint32_t *Offsets1, const uint16_t *FX, uint8_t *Dst, const size_t DstWidth);
+		const char *Name;
+	};
+}
+
+static inline ChannelMap MapFor(const Layout In)
+{
+	switch (In)
+	{
+		case Layout::RGB24: return { 0, 1, 2, false };
+		case Layout::BGR24: return { 2, 1, 0, false };
+		case Layout::RGBA: return { 0, 1, 2, true };
+		case Layout::BGRA: return { 2, 1, 0, true };
+	}
+	
+	return { 0, 1, 2, false };
+}
+
+static inline uint32_t Load32(const uint8_t *Ptr)
+{
+	uint32_t Value;
+	memcpy(&Value, Ptr, sizeof Value);
+	return Value;
+}
+
+static void ConvertRowScalar(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width)
+{
+	const ChannelMap Map = MapFor(SrcLayout);
+	const size_t BPP = PixelKernels::BytesPerPixel(SrcLayout);
+	
+	for (size_t Inc = 0u; Inc < Width; ++Inc, Src += BPP, Dst += 4)
+	{
+		const uint8_t R = Src[Map.R], G = Src[Map.G], B = Src[Map.B];
+		
+		Dst[0] = DstBGRA ? B : R;
+		Dst[1] = G;
+		Dst[2] = DstBGRA ? R : B;
+		Dst[3] = Map.HasAlpha ? Src[3] : 0xFF;
+	}
+}
+
+static void HalveRowScalar(const uint8_t *Row0, const uint8_t *Row1, uint8_t *Dst, const size_t DstWidth, const size_t SrcWidth, size_t X)
+{
+	const size_t Next = SrcWidth > 1u ? 4u : 0u; //A one pixel wide source only gets averaged vertically
+	
+	for (; X < DstWidth; ++X)
+	{
+		const uint8_t *const A = Row0 + X * 8u;
+		const uint8_t *const B = Row1 + X * 8u;
+		
+		for (size_t C = 0u; C < 4u; ++C) Dst[X * 4u + C] = static_cast<uint8_t>((A[C] + A[Next + C] + B[C] + B[Next + C] + 2u) >> 2);
+	}
+}
+
+static void ResizeRowScalar(const uint8_t *Row0, const uint8_t *Row1, const uint32_t FY, const uint32_t *Offsets0, const uint32_t *Offsets1, const uint16_t *FX, uint8_t *Dst, const size_t DstWidth)
+{
+	for (size_t X = 0u; X < DstWidth; ++X, Dst += 4)
+	{
+		for (size_t C = 0u; C < 4u; ++C)
+		{
+			//Vertical then horizontal, rounding after each, so this matches the SIMD version bit for bit.
+			const uint32_t Left = (Row0[Offsets0[X] + C] * (256u - FY) + Row1[Offsets0[X] + C] * FY + 128u) >> 8;
+			const uint32_t Right = (Row0[Offsets1[X] + C] * (256u - FY) + Row1[Offsets1[X] + C] * FY + 128u) >> 8;
+			
+			Dst[C] = static_cast<uint8_t>((Left * (256u - FX[X]) + Right * FX[X] + 128u) >> 8);
+		}
+	}
+}
+
+#ifdef PIXELKERNELS_X86
+static void BuildShuffle(const Layout SrcLayout, const bool DstBGRA, uint8_t (&Mask)[16], uint8_t (&AlphaFill)[16])
+{ //pshufb control for four pixels. 0x80 zeroes the byte, AlphaFill then ORs in an opaque alpha where the source has none.
+	const ChannelMap Map = MapFor(SrcLayout);
+	const size_t BPP = PixelKernels::BytesPerPixel(SrcLayout);
+	
+	for (size_t Px = 0u; Px < 4u; ++Px)
+	{
+		const uint8_t Base = static_cast<uint8_t>(Px * BPP);
+		
+		Mask[Px * 4u + 0u] = Base + (DstBGRA ? Map.B : Map.R);
+		Mask[Px * 4u + 1u] = Base + Map.G;
+		Mask[Px * 4u + 2u] = Base + (DstBGRA ? Map.R : Map.B);
+		Mask[Px * 4u + 3u] = Map.HasAlpha ? Base + 3u : 0x80;
+		
+		AlphaFill[Px * 4u + 0u] = AlphaFill[Px * 4u + 1u] = AlphaFill[Px * 4u + 2u] = 0u;
+		AlphaFill[Px * 4u + 3u] = Map.HasAlpha ? 0u : 0xFF;
+	}
+}
+
+TARGET_SSSE3 static void ConvertRowSSSE3(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width)
+{
+	uint8_t MaskBytes[16], FillBytes[16];
+	
+	BuildShuffle(SrcLayout, DstBGRA, MaskBytes, FillBytes);
+	
+	const __m128i Mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(MaskBytes));
+	const __m128i Fill = _mm_loadu_si128(reinterpret_cast<const __m128i*>(FillBytes));
+	const size_t BPP = PixelKernels::BytesPerPixel(SrcLayout);
+	
+	size_t Inc = 0u;
+	
+	//Each step loads 16 bytes but 24 bit sources only use 12 of them, so stop while the load still fits in the row.
+	for (; Inc + 4u <= Width && Inc * BPP + 16u <= Width * BPP; Inc += 4u)
+	{
+		const __m128i In = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + Inc * BPP));
+		
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + Inc * 4u), _mm_or_si128(_mm_shuffle_epi8(In, Mask), Fill));
+	}
+	
+	ConvertRowScalar(Src + Inc * BPP, SrcLayout, Dst + Inc * 4u, DstBGRA, Width - Inc);
+}
+
+TARGET_AVX2 static void ConvertRowAVX2(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width)
+{
+	uint8_t MaskBytes[16], FillBytes[16];
+	
+	BuildShuffle(SrcLayout, DstBGRA, MaskBytes, FillBytes);
+	
+	//vpshufb works per 128 bit lane, so each lane gets its own four pixels and the same control.
+	const __m256i Mask = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(MaskBytes)));
+	const __m256i Fill = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(FillBytes)));
+	const size_t BPP = PixelKernels::BytesPerPixel(SrcLayout);
+	
+	size_t Inc = 0u;
+	
+	for (; Inc + 8u <= Width && (Inc + 4u) * BPP + 16u <= Width * BPP; Inc += 8u)
+	{
+		const __m128i Lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + Inc * BPP));
+		const __m128i Hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src + (Inc + 4u) * BPP));
+		const __m256i In = _mm256_inserti128_si256(_mm256_castsi128_si256(Lo), Hi, 1);
+		
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Dst + Inc * 4u), _mm256_or_si256(_mm256_shuffle_epi8(In, Mask), Fill));
+	}
+	
+	ConvertRowSSSE3(Src + Inc * BPP, SrcLayout, Dst + Inc * 4u, DstBGRA, Width - Inc);
+}
+
+TARGET_SSE2 static void HalveRowSSE2(const uint8_t *Row0, const uint8_t *Row1, uint8_t *Dst, const size_t DstWidth, const size_t SrcWidth, size_t X)
+{
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i Two = _mm_set1_epi16(2);
+	
+	for (; X + 2u <= DstWidth; X += 2u)
+	{
+		const __m128i A = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row0 + X * 8u));
+		const __m128i B = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Row1 + X * 8u));
+		
+		//Widen to 16 bits and add the rows, then add each pixel to its right hand neighbour.
+		const __m128i Lo = _mm_add_epi16(_mm_unpacklo_epi8(A, Zero), _mm_unpacklo_epi8(B, Zero)); //Source pixels 0 and 1
+		const __m128i Hi = _mm_add_epi16(_mm_unpackhi_epi8(A, Zero), _mm_unpackhi_epi8(B, Zero)); //2 and 3
+		const __m128i Sum = _mm_add_epi16(_mm_unpacklo_epi64(Lo, Hi), _mm_unpackhi_epi64(Lo, Hi));
+		const __m128i Avg = _mm_srli_epi16(_mm_add_epi16(Sum, Two), 2);
+		
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(Dst + X * 4u), _mm_packus_epi16(Avg, Avg));
+	}
+	
+	HalveRowScalar(Row0, Row1, Dst, DstWidth, SrcWidth, X);
+}
+
+TARGET_AVX2 static void HalveRowAVX2(const uint8_t *Row0, const uint8_t *Row1, uint8_t *Dst, const size_t DstWidth, const size_t SrcWidth, size_t X)
+{
+	const __m256i Zero = _mm256_setzero_si256();
+	const __m256i Two = _mm256_set1_epi16(2);
+	
+	for (; X + 4u <= DstWidth; X += 4u)
+	{
+		const __m256i A = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Row0 + X * 8u));
+		const __m256i B = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Row1 + X * 8u));
+		
+		//Same as the SSE2 version, once per lane.
+		const __m256i Lo = _mm256_add_epi16(_mm256_unpacklo_epi8(A, Zero), _mm256_unpacklo_epi8(B, Zero));
+		const __m256i Hi = _mm256_add_epi16(_mm256_unpackhi_epi8(A, Zero), _mm256_unpackhi_epi8(B, Zero));
+		const __m256i Sum = _mm256_add_epi16(_mm256_unpacklo_epi64(Lo, Hi), _mm256_unpackhi_epi64(Lo, Hi));
+		const __m256i Avg = _mm256_srli_epi16(_mm256_add_epi16(Sum, Two), 2);
+		
+		//Packing leaves two output pixels at the bottom of each lane, pull them together.
+		const __m256i Packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(Avg, Avg), _MM_SHUFFLE(3, 1, 2, 0));
+		
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dst + X * 4u), _mm256_castsi256_si128(Packed));
+	}
+	
+	HalveRowSSE2(Row0, Row1, Dst, DstWidth, SrcWidth, X);
+}
+
+TARGET_SSE2 static void ResizeRowSSE2(const uint8_t *Row0, const uint8_t *Row1, const uint32_t FY, const uint32_t *Offsets0, const uint32_t *Offsets1, const uint16_t *FX, uint8_t *Dst, const size_t DstWidth)
+{ //One output pixel per step, all four channels at once in 16 bit lanes. Weights add up to 256, so nothing overflows.
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i Round = _mm_set1_epi16(128);
+	const __m128i WeightTop = _mm_set1_epi16(static_cast<int16_t>(256u - FY));
+	const __m128i WeightBottom = _mm_set1_epi16(static_cast<int16_t>(FY));
+	
+	for (size_t X = 0u; X < DstWidth; ++X)
+	{
+		const __m128i Top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(Load32(Row0 + Offsets0[X])), _mm_cvtsi32_si128(Load32(Row0 + Offsets1[X]))), Zero);
+		const __m128i Bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128(Load32(Row1 + Offsets0[X])), _mm_cvtsi32_si128(Load32(Row1 + Offsets1[X]))), Zero);
+		
+		const __m128i Vertical = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(Top, WeightTop), _mm_mullo_epi16(Bottom, WeightBottom)), Round), 8);
+		
+		const int16_t Right = static_cast<int16_t>(FX[X]);
+		const int16_t Left = static_cast<int16_t>(256 - Right);
+		const __m128i Weighted = _mm_mullo_epi16(Vertical, _mm_set_epi16(Right, Right, Right, Right, Left, Left, Left, Left));
+		const __m128i Horizontal = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(Weighted, _mm_srli_si128(Weighted, 8)), Round), 8);
+		
+		const uint32_t Out = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(Horizontal, Horizontal)));
+		
+		memcpy(Dst + X * 4u, &Out, sizeof Out);
+	}
+}
+
+static bool CPUHasSSE2(void);
+static bool CPUHasSSSE3(void);
+static bool CPUHasAVX2(void);
+
+#if defined(__GNUC__)
+static bool CPUHasSSE2(void) { __builtin_cpu_init(); return __builtin_cpu_supports("sse2"); }
+static bool CPUHasSSSE3(void) { __builtin_cpu_init(); return __builtin_cpu_supports("ssse3"); }
+static bool CPUHasAVX2(void) { __builtin_cpu_init(); return __builtin_cpu_supports("avx2"); }
+#elif defined(_MSC_VER)
+static bool CPUHasSSE2(void)
+{
+	int Regs[4];
+	__cpuid(Regs, 1);
+	return Regs[3] & (1 << 26);
+}
+
+static bool CPUHasSSSE3(void)
+{
+	int Regs[4];
+	__cpuid(Regs, 1);
+	return Regs[2] & (1 << 9);
+}
+
+static bool CPUHasAVX2(void)
+{ //The OS has to save the YMM registers too, not just the CPU having them.
+	int Regs[4];
+	__cpuid(Regs, 1);
+	
+	if (!(Regs[2] & (1 << 27)) || (_xgetbv(0) & 6u) != 6u) return false;
+	
+	__cpuidex(Regs, 7, 0);
+	return Regs[1] & (1 << 5);
+}
+#else
+static bool CPUHasSSE2(void) { return false; }
+static bool CPUHasSSSE3(void) { return false; }
+static bool CPUHasAVX2(void) { return false; }
+#endif
+#endif //PIXELKERNELS_X86
+
+static KernelSet PickKernels(void)
+{
+#ifdef PIXELKERNELS_X86
+	if (CPUHasAVX2()) return { ConvertRowAVX2, HalveRowAVX2, ResizeRowSSE2, "avx2" };
+	if (CPUHasSSSE3()) return { ConvertRowSSSE3, HalveRowSSE2, ResizeRowSSE2, "ssse3" };
+	if (CPUHasSSE2()) return { ConvertRowScalar, HalveRowSSE2, ResizeRowSSE2, "sse2" };
+#endif
+	return { ConvertRowScalar, HalveRowScalar, ResizeRowScalar, "scalar" };
+}
+
+static const KernelSet &Kernels(void)
+{
+	static const KernelSet Chosen { PickKernels() };
+	
+	return Chosen;
+}
+
+void PixelKernels::ConvertRow(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width)
+{
+	Kernels().ConvertRow(Src, SrcLayout, Dst, DstBGRA, Width);
+}
+
+void PixelKernels::Halve(const uint8_t *Src, const size_t SrcWidth, const size_t SrcHeight, const size_t SrcStride, uint8_t *Dst, const size_t DstStride)
+{
+	const KernelSet &Impl { Kernels() };
+	const size_t DstWidth = std::max<size_t>(1u, SrcWidth / 2u);
+	const size_t DstHeight = std::max<size_t>(1u, SrcHeight / 2u);
+	
+	for (size_t Y = 0u; Y < DstHeight; ++Y)
+	{
+		const uint8_t *const Row0 = Src + Y * 2u * SrcStride;
+		const uint8_t *const Row1 = SrcHeight > 1u ? Row0 + SrcStride : Row0;
+		
+		//The SIMD versions read pixel pairs, which a one pixel wide source doesn't have.
+		if (SrcWidth > 1u) Impl.HalveRow(Row0, Row1, Dst + Y * DstStride, DstWidth, SrcWidth, 0u);
+		else HalveRowScalar(Row0, Row1, Dst + Y * DstStride, DstWidth, SrcWidth, 0u);
+	}
+}
+
+void PixelKernels::Resize(const uint8_t *Src, const size_t SrcWidth, const size_t SrcHeight, const size_t SrcStride, uint8_t *Dst, const size_t DstWidth, const size_t DstHeight, const size_t DstStride)
+{
+	if (!SrcWidth || !SrcHeight || !DstWidth || !DstHeight) return;
+	
+	const KernelSet &Impl { Kernels() };
+	
+	//Column taps are the same for every row, so work them out once. Reused per thread, tiles come in at display rate.
+	static thread_local std::vector<uint32_t> Offsets0, Offsets1;
+	static thread_local std::vector<uint16_t> FX;
+	
+	Offsets0.resize(DstWidth);
+	Offsets1.resize(DstWidth);
+	FX.resize(DstWidth);
+	
+	//Pixel centers line up, the usual half pixel offset. Fixed point with 8 fractional bits.
+	auto Tap = [] (const size_t Out, const size_t SrcSize, const size_t DstSize, uint32_t &Index, uint32_t &Frac)
+	{
+		const int64_t Pos = (static_cast<int64_t>(2u * Out + 1u) * SrcSize * 256) / (2 * static_cast<int64_t>(DstSize)) - 128;
+		const int64_t Clamped = std::max<int64_t>(0, std::min<int64_t>(Pos, static_cast<int64_t>(SrcSize - 1u) * 256));
+		
+		Index = static_cast<uint32_t>(Clamped >> 8);
+		Frac = static_cast<uint32_t>(Clamped & 0xFF);
+		
+		if (Index + 1u >= SrcSize) Frac = 0u; //Last column or row, nothing to blend with.
+	};
+	
+	for (size_t X = 0u; X < DstWidth; ++X)
+	{
+		uint32_t Index, Frac;
+		
+		Tap(X, SrcWidth, DstWidth, Index, Frac);
+		
+		Offsets0[X] = Index * 4u;
+		Offsets1[X] = (Index + 1u < SrcWidth ? Index + 1u : Index) * 4u;
+		FX[X] = static_cast<uint16_t>(Frac);
+	}
+	
+	for (size_t Y = 0u; Y < DstHeight; ++Y)
+	{
+		uint32_t Index, Frac;
+		
+		Tap(Y, SrcHeight, DstHeight, Index, Frac);
+		
+		const uint8_t *const Row0 = Src + Index * SrcStride;
+		const uint8_t *const Row1 = Index + 1u < SrcHeight ? Row0 + SrcStride : Row0;
+		
+		Impl.ResizeRow(Row0, Row1, Frac, Offsets0.data(), Offsets1.data(), FX.data(), Dst + Y * DstStride, DstWidth);
+	}
+}
+
+const char *PixelKernels::ActiveISA(void)
+{
+	return Kernels().Name;
+}
@@ -0,0 +1,50 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_PIXELKERNELS_H__
+#define __LIBCOYOTE_PIXELKERNELS_H__
+
+#include "include/common.h"
+
+/**Pixel loops for miniview processing. Everything produces 4 byte pixels.
+ * The best implementation the CPU supports (AVX2, SSSE3/SSE2, or plain C++) is picked once at runtime,
+ * so the library itself still builds for the baseline instruction set.**/
+
+namespace PixelKernels
+{
+	enum class Layout : uint8_t
+	{
+		RGB24,
+		BGR24,
+		RGBA,
+		BGRA,
+	};
+	
+	static inline size_t BytesPerPixel(const Layout In) { return In == Layout::RGB24 || In == Layout::BGR24 ? 3u : 4u; }
+	
+	//Width pixels from Src to Dst. Sources without alpha come out opaque.
+	void ConvertRow(const uint8_t *Src, const Layout SrcLayout, uint8_t *Dst, const bool DstBGRA, const size_t Width);
+	
+	//2x2 box filter. Dst is max(1, SrcWidth / 2) by max(1, SrcHeight / 2), an odd last row or column is left out.
+	void Halve(const uint8_t *Src, const size_t SrcWidth, const size_t SrcHeight, const size_t SrcStride, uint8_t *Dst, const size_t DstStride);
+	
+	//Bilinear, any size to any size. For big reductions, Halve() down to the nearest larger size first or it'll alias.
+	void Resize(const uint8_t *Src, const size_t SrcWidth, const size_t SrcHeight, const size_t SrcStride, uint8_t *Dst, const size_t DstWidth, const size_t DstHeight, const size_t DstStride);
+	
+	const char *ActiveISA(void); //"avx2", "ssse3", "sse2" or "scalar"
+}
+
+#endif //__LIBCOYOTE_PIXELKERNELS_H__
@@ -0,0 +1,116 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_POOLS_H__
+#define __LIBCOYOTE_POOLS_H__
+
+#define MSGPACK_DEFAULT_API_VERSION 2
+#include "msgpack.hpp"
+
+#include "include/common.h"
+
+/**Per-thread free lists for the scratch objects every command and every incoming message needs.
+ * Each thread gets its own list, so there's no lock and no allocator traffic once a thread has warmed up.
+ * Leases nest fine, a function holding a zone can call another that takes one too.**/
+
+namespace Pools
+{
+	static constexpr size_t MaxRetainedPerThread = 8;
+	static constexpr size_t MaxRetainedBufferBytes = 1024 * 1024; //Don't hang onto the buffer from a log download forever.
+
+	template <typename T>
+	struct Traits;
+
+	template <>
+	struct Traits<msgpack::zone>
+	{
+		static inline bool Recycle(msgpack::zone &Zone)
+		{ //clear() frees every chunk but the initial one, so what we keep is bounded.
+			Zone.clear();
+			return true;
+		}
+	};
+
+	template <>
+	struct Traits<msgpack::sbuffer>
+	{
+		static inline bool Recycle(msgpack::sbuffer &Buffer)
+		{
+			if (Buffer.size() > MaxRetainedBufferBytes) return false;
+
+			Buffer.clear();
+			return true;
+		}
+	};
+
+	template <typename T>
+	class ThreadPool
+	{
+	private:
+		static inline std::vector<std::unique_ptr<T> > &FreeList(void)
+		{
+			thread_local std::vector<std::unique_ptr<T> > List;
+
+			return List;
+		}
+	public:
+		static inline T *Acquire(void)
+		{
+			std::vector<std::unique_ptr<T> > &List = FreeList();
+
+			if (List.empty()) return new T;
+
+			T *const RetVal = List.back().release();
+			List.pop_back();
+
+			return RetVal;
+		}
+
+		static inline void Release(T *const Obj)
+		{
+			std::unique_ptr<T> Ptr { Obj };
+
+			if (!Ptr || !Traits<T>::Recycle(*Ptr)) return;
+
+			std::vector<std::unique_ptr<T> > &List = FreeList();
+
+			if (List.size() >= MaxRetainedPerThread) return;
+
+			if (List.capacity() < MaxRetainedPerThread) List.reserve(MaxRetainedPerThread);
+
+			List.emplace_back(std::move(Ptr));
+		}
+	};
+
+	template <typename T>
+	struct Returner
+	{
+		inline void operator()(T *const Obj) const { ThreadPool<T>::Release(Obj); }
+	};
+
+	template <typename T>
+	using Lease = std::unique_ptr<T, Returner<T> >;
+
+	template <typename T>
+	inline Lease<T> Acquire(void)
+	{
+		return Lease<T> { ThreadPool<T>::Acquire() };
+	}
+}
+
+#define POOLED_ZONE(Name) const Pools::Lease<msgpack::zone> Name##Lease { Pools::Acquire<msgpack::zone>() }; msgpack::zone &Name = *Name##Lease
+#define POOLED_SBUFFER(Name) const Pools::Lease<msgpack::sbuffer> Name##Lease { Pools::Acquire<msgpack::sbuffer>() }; msgpack::sbuffer &Name = *Name##Lease
+
+#endif //__LIBCOYOTE_POOLS_H__
@@ -0,0 +1,172 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "responsecache.h"
+
+static const struct
+{
+	const char *Command;
+	std::chrono::milliseconds TTL;
+} DefaultTTLs[] =
+{ //Anything a setter on this session changes is invalidated right away, so these only bound how long changes made elsewhere go unseen.
+	{ "GetServerVersion", std::chrono::minutes{ 10 } }, //Only changes with an update, and that means a reconnect anyway.
+	{ "GetSupportsS12G", std::chrono::minutes{ 10 } },
+	{ "GetLicensingStatus", std::chrono::seconds{ 30 } },
+	{ "GetWatchPaths", std::chrono::seconds{ 30 } },
+	{ "GetHostSinkResolution", std::chrono::seconds{ 10 } },
+	{ "GetBMDResolution", std::chrono::seconds{ 10 } },
+	{ "GetGenlockSettings", std::chrono::seconds{ 10 } },
+	{ "GetMirrors", std::chrono::seconds{ 10 } },
+};
+
+RespCache::Cache::Cache(void) : Hits(), Misses(), Invalidations()
+{
+	for (const auto &Default : DefaultTTLs)
+	{
+		Command &Target { this->Commands[Default.Command] };
+		
+		Target.TTL = Default.TTL;
+		Target.Generation = 0u;
+	}
+}
+
+bool RespCache::Cache::Lookup(const std::string &CommandName, const std::string &ArgKey, msgpack::zone &TempZone, std::unordered_map<std::string, msgpack::object> &Out, uint64_t &GenerationOut)
+{
+	std::shared_ptr<const std::string> Packed;
+	
+	{
+		std::lock_guard<std::mutex> G { this->Lock };
+		
+		auto Iter = this->Commands.find(CommandName);
+		
+		if (Iter == this->Commands.end() || Iter->second.TTL.count() <= 0)
+		{ //Not cached, and not counted either.
+			GenerationOut = UINT64_MAX;
+			return false;
+		}
+		
+		Command &Target { Iter->second };
+		
+		GenerationOut = Target.Generation;
+		
+		auto EntryIter = Target.Entries.find(ArgKey);
+		
+		if (EntryIter != Target.Entries.end())
+		{
+			if (std::chrono::steady_clock::now() < EntryIter->second.Expires) Packed = EntryIter->second.Packed;
+			else Target.Entries.erase(EntryIter);
+		}
+	}
+	
+	if (!Packed)
+	{
+		++this->Misses;
+		return false;
+	}
+	
+	//Unpacked outside the lock, the entry can't change under us since it's never modified once stored.
+	const msgpack::object Reply { msgpack::unpack(TempZone, Packed->data(), Packed->size()) };
+	
+	Reply.convert(Out);
+	
+	++this->Hits;
+	
+	return true;
+}
+
+void RespCache::Cache::Store(const std::string &CommandName, const std::string &ArgKey, const uint64_t Generation, const std::unordered_map<std::string, msgpack::object> &Reply)
+{
+	if (Generation == UINT64_MAX) return;
+	
+	msgpack::sbuffer Buffer;
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+	
+	Pack.pack_map(Reply.size());
+	
+	for (const auto &Pair : Reply)
+	{
+		Pack.pack(Pair.first);
+		Pack.pack(Pair.second);
+	}
+	
+	std::shared_ptr<const std::string> Packed { std::make_shared<const std::string>(Buffer.data(), Buffer.size()) };
+	
+	std::lock_guard<std::mutex> G { this->Lock };
+	
+	auto Iter = this->Commands.find(CommandName);
+	
+	//Invalidated while the reply was on its way, so it might already be out of date.
+	if (Iter == this->Commands.end() || Iter->second.Generation != Generation || Iter->second.TTL.count() <= 0) return;
+	
+	Iter->second.Entries[ArgKey] = Entry{ std::move(Packed), std::chrono::steady_clock::now() + Iter->second.TTL };
+}
+
+void RespCache::Cache::Invalidate(const std::string &CommandName)
+{
+	std::lock_guard<std::mutex> G { this->Lock };
+	
+	auto Iter = this->Commands.find(CommandName);
+	
+	if (Iter == this->Commands.end()) return;
+	
+	++Iter->second.Generation;
+	
+	this->Invalidations += Iter->second.Entries.size();
+	
+	Iter->second.Entries.clear();
+}
+
+void RespCache::Cache::InvalidateAll(void)
+{
+	std::lock_guard<std::mutex> G { this->Lock };
+	
+	for (auto &Pair : this->Commands)
+	{
+		++Pair.second.Generation;
+		
+		this->Invalidations += Pair.second.Entries.size();
+		
+		Pair.second.Entries.clear();
+	}
+}
+
+void RespCache::Cache::SetTTL(const std::string &CommandName, const std::chrono::milliseconds TTL)
+{
+	std::lock_guard<std::mutex> G { this->Lock };
+	
+	Command &Target { this->Commands[CommandName] };
+	
+	Target.TTL = TTL;
+	
+	//Whatever's stored was stored under the old TTL.
+	++Target.Generation;
+	Target.Entries.clear();
+}
+
+Coyote::ResponseCacheStats RespCache::Cache::GetStats(void) const
+{
+	Coyote::ResponseCacheStats RetVal{};
+	
+	RetVal.Hits = this->Hits.load();
+	RetVal.Misses = this->Misses.load();
+	RetVal.Invalidations = this->Invalidations.load();
+	
+	std::lock_guard<std::mutex> G { this->Lock };
+	
+	for (const auto &Pair : this->Commands) RetVal.Entries += Pair.second.Entries.size();
+	
+	return RetVal;
+}
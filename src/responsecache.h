@@ -0,0 +1,67 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_RESPONSECACHE_H__
+#define __LIBCOYOTE_RESPONSECACHE_H__
+
+#include "msgpackproc.h"
+
+#include <atomic>
+
+/**Replies to getters whose answers rarely change, kept for a while so opening a panel doesn't cost a round trip every time.
+ * Each command has its own TTL, zero meaning it isn't cached. Replies are kept packed, and unpacked into the caller's zone on a hit.
+ * Commands that take arguments cache one reply per argument key. Setters invalidate the getters they affect, which bumps that
+ * command's generation, so a reply that was already on its way back when the setter went out is never stored.**/
+
+namespace RespCache
+{
+	class Cache
+	{
+	private:
+		struct Entry
+		{
+			std::shared_ptr<const std::string> Packed;
+			std::chrono::steady_clock::time_point Expires;
+		};
+		
+		struct Command
+		{
+			std::chrono::milliseconds TTL;
+			uint64_t Generation;
+			std::unordered_map<std::string, Entry> Entries; //By argument key
+		};
+		
+		mutable std::mutex Lock;
+		std::unordered_map<std::string, Command> Commands; //Protected by Lock
+		std::atomic<uint64_t> Hits;
+		std::atomic<uint64_t> Misses;
+		std::atomic<uint64_t> Invalidations;
+	public:
+		//False on a miss. GenerationOut then goes to Store() with the reply, whatever it turns out to be.
+		bool Lookup(const std::string &CommandName, const std::string &ArgKey, msgpack::zone &TempZone, std::unordered_map<std::string, msgpack::object> &Out, uint64_t &GenerationOut);
+		void Store(const std::string &CommandName, const std::string &ArgKey, const uint64_t Generation, const std::unordered_map<std::string, msgpack::object> &Reply);
+		void Invalidate(const std::string &CommandName);
+		void InvalidateAll(void);
+		void SetTTL(const std::string &CommandName, const std::chrono::milliseconds TTL);
+		Coyote::ResponseCacheStats GetStats(void) const;
+		
+		Cache(void);
+		
+		Cache(const Cache &) = delete;
+		Cache &operator=(const Cache &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_RESPONSECACHE_H__
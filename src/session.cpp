@@ -24,75 +24,75 @@
 #include "asyncmsgs.h"
 #include "msgpackproc.h"
 #include "subscriptions.h"
+#include "pools.h"
+#include "compactwire.h"
 #include "discovery.h"
+#include "wiretrace.h"
+#include "responsecache.h"
 #include "include/statuscodes.h"
 #include "include/datastructures.h"
 #include "include/session.h"
+#include "wireschema.h"
+#include <algorithm>
+#include <deque>
 #include <mutex>
+#include <cerrno>
+
+#ifdef WIN32
+#include <io.h>
+#endif //WIN32
 
 #define DEF_SESS InternalSession &SESS = *static_cast<InternalSession*>(this->Internal)
 #define DEF_CONST_SESS const InternalSession &SESS = *static_cast<const InternalSession*>(this->Internal)
 #define MAPARG(x) { #x, msgpack::object{ x, TempZone } }
 
+#define SCHEMA_TEXT_PAIR(Value, Text, ...) { Coyote::Value, Text },
+#define SCHEMA_SIZE_PAIR(Value, Text, Width, Height) { Coyote::Value, { Width, Height } },
+
 extern EXPFUNC const std::unordered_map<Coyote::RefreshMode, std::string> Coyote::RefreshMap
 {
-	{ Coyote::COYOTE_REFRESH_INVALID, "" },
-	{ Coyote::COYOTE_REFRESH_23_98, "23.98" },
-	{ Coyote::COYOTE_REFRESH_24, "24" },
-	{ Coyote::COYOTE_REFRESH_25, "25" },
-	{ Coyote::COYOTE_REFRESH_29_97, "29.97" },
-	{ Coyote::COYOTE_REFRESH_30, "30" },
-	{ Coyote::COYOTE_REFRESH_50, "50" },
-	{ Coyote::COYOTE_REFRESH_59_94, "59.94" },
-	{ Coyote::COYOTE_REFRESH_60, "60" }
+	COYOTE_REFRESH_SCHEMA(SCHEMA_TEXT_PAIR)
 };
 
 extern EXPFUNC const std::unordered_map<Coyote::ResolutionMode, std::string> Coyote::ResolutionMap
 {
-	{ Coyote::COYOTE_RES_INVALID, "" },
-	{ Coyote::COYOTE_RES_720P, "720p" },
-	{ Coyote::COYOTE_RES_1080I, "1080i" },
-	{ Coyote::COYOTE_RES_1080P, "1080p" },
-	{ Coyote::COYOTE_RES_1080PSF, "1080psf" },
-	{ Coyote::COYOTE_RES_2160P, "2160p" },
-	{ Coyote::COYOTE_RES_2160PSF, "2160psf" },
-	{ Coyote::COYOTE_RES_DCI_2048, "DCI 2048" },
-	{ Coyote::COYOTE_RES_DCI_2048PSF, "DCI 2048psf" },
-	{ Coyote::COYOTE_RES_DCI_4096, "DCI 4096" },
-	{ Coyote::COYOTE_RES_DCI_4096PSF, "DCI 4096psf" },
+	COYOTE_RESOLUTION_SCHEMA(SCHEMA_TEXT_PAIR)
 };
 
 extern EXPFUNC const std::unordered_map<Coyote::ResolutionMode, Coyote::Size2D> Coyote::ResolutionSizeMap
 {
-	{ Coyote::COYOTE_RES_INVALID, {} },
-	{ Coyote::COYOTE_RES_720P, { 1280, 720 } },
-	{ Coyote::COYOTE_RES_1080P, { 1920, 1080 } },
-	{ Coyote::COYOTE_RES_1080PSF, { 1920, 1080 } },
-	{ Coyote::COYOTE_RES_2160P, { 3840, 2160 } },
-	{ Coyote::COYOTE_RES_2160PSF, { 3840, 2160 } },
-	{ Coyote::COYOTE_RES_DCI_4096, { 4096, 2160 } },
-	{ Coyote::COYOTE_RES_DCI_4096PSF, { 4096, 2160 } },
-	{ Coyote::COYOTE_RES_DCI_2048, { 2048, 1080 } },
-	{ Coyote::COYOTE_RES_DCI_2048PSF, { 2048, 1080 } },
-	{ Coyote::COYOTE_RES_1080I, { 1920, 1080 } },
+	COYOTE_RESOLUTION_SCHEMA(SCHEMA_SIZE_PAIR)
 };
 
-static const auto &ReverseRefreshMapObj { RebuildMapBackwards(Coyote::RefreshMap) };
-static const auto &ReverseResolutionMapObj { RebuildMapBackwards(Coyote::ResolutionMap) };
+#undef SCHEMA_SIZE_PAIR
+#undef SCHEMA_TEXT_PAIR
+
+EXPFUNC Coyote::RefreshMode Coyote::ReverseRefreshMap(const char *Lookup, const size_t Length)
+{
+	Coyote::RefreshMode Value = Coyote::COYOTE_REFRESH_INVALID;
+	
+	if (!WireSchema::RefreshTable.Lookup(Lookup, Length, Value)) return Coyote::COYOTE_REFRESH_INVALID;
 
+	return Value;
+}
 
-EXPFUNC Coyote::RefreshMode Coyote::ReverseRefreshMap(const std::string &Lookup)
+EXPFUNC Coyote::ResolutionMode Coyote::ReverseResolutionMap(const char *Lookup, const size_t Length)
 {
-	if (!ReverseRefreshMapObj.count(Lookup)) return Coyote::COYOTE_REFRESH_INVALID;
+	Coyote::ResolutionMode Value = Coyote::COYOTE_RES_INVALID;
+	
+	if (!WireSchema::ResolutionTable.Lookup(Lookup, Length, Value)) return Coyote::COYOTE_RES_INVALID;
 
-	return ReverseRefreshMapObj.at(Lookup);
+	return Value;
+}
+
+EXPFUNC Coyote::RefreshMode Coyote::ReverseRefreshMap(const std::string &Lookup)
+{
+	return Coyote::ReverseRefreshMap(Lookup.data(), Lookup.size());
 }
 
 EXPFUNC Coyote::ResolutionMode Coyote::ReverseResolutionMap(const std::string &Lookup)
 {
-	if (!ReverseResolutionMapObj.count(Lookup)) return Coyote::COYOTE_RES_INVALID;
-	
-	return ReverseResolutionMapObj.at(Lookup);
+	return Coyote::ReverseResolutionMap(Lookup.data(), Lookup.size());
 }
 
 using Coyote::ResolutionMap;
@@ -111,10 +111,43 @@ struct InternalSession
 	time_t TimeoutSecs;
 	int NumAttempts;
 	Coyote::UnitType UType;
+	std::atomic<uint16_t> CompactKeyLimit; //Zero means plain map encoding
+	std::atomic<int8_t> BatchPresets; //Whether the unit takes CreatePresets and UpdatePresets. Zero until we've tried, then 1 or -1.
+	std::atomic<int8_t> BatchMarkEdits; //Same for ApplyMarkEdits
+	std::atomic<int8_t> PagedDiskAssets; //Same for PageSize and ContinuationToken on GetDiskAssets
+	bool MonitorOnly;
+	std::string StateCacheDir;
+	std::string CachedGUID; //The unit our cached state belongs to
+	std::shared_ptr<WireTrace::Recorder> Capture; //Null unless capturing traffic. Always accessed with std::atomic_load()/std::atomic_store().
+	RespCache::Cache Responses;
 	
-	const std::unordered_map<std::string, msgpack::object> PerformSyncedCommand(const std::string &CommandName, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut = nullptr, const msgpack::object *Values = nullptr);
-	Coyote::StatusCode CreatePreset_Multi(const Coyote::Preset &Ref, const std::string &Cmd);
+	const std::unordered_map<std::string, msgpack::object> PerformSyncedCommand(const std::string &CommandName, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut = nullptr, const msgpack::object *Values = nullptr, const time_t TimeoutSecs = 0);
+	
+	//PerformSyncedCommand() in two halves, so several commands can be waiting on the unit at once. Every ticket SendCommand() returns must go to AwaitReply().
+	AsyncToSync::MessageTicket *SendCommand(const std::string &CommandName, const msgpack::object *Values = nullptr);
+	const std::unordered_map<std::string, msgpack::object> AwaitReply(AsyncToSync::MessageTicket *Ticket, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut = nullptr, const time_t TimeoutSecs = 0);
+	
+	//PerformSyncedCommand() through the response cache. ArgKey tells apart replies to the same command with different Values.
+	const std::unordered_map<std::string, msgpack::object> PerformCachedCommand(const std::string &CommandName, const std::string &ArgKey, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut = nullptr, const msgpack::object *Values = nullptr);
 	
+	Coyote::StatusCode CreatePreset_Multi(const Coyote::Preset &Ref, const std::string &Cmd);
+	Coyote::StatusCode BatchPresets_Multi(const std::vector<Coyote::Preset> &Presets, const std::string &BatchCmd, const std::string &SingleCmd, std::vector<Coyote::StatusCode> *StatusesOut);
+	
+	//Sends Count items as one BatchCmd with an ItemsKey array, or as a pipelined burst of single commands if the unit doesn't know BatchCmd.
+	//PackItem() gives an item's entry in the batch. PackSingle() gives the single command that does the same thing, and its arguments.
+	Coyote::StatusCode PerformBatch(const std::string &BatchCmd, const char *ItemsKey, const size_t Count,
+									const std::function<msgpack::object(const size_t Index, msgpack::zone &TempZone)> &PackItem,
+									const std::function<const char*(const size_t Index, msgpack::zone &TempZone, msgpack::object &ArgsOut)> &PackSingle,
+									std::atomic<int8_t> &Supported, std::vector<Coyote::StatusCode> *StatusesOut);
+	Coyote::StatusCode StreamLogCommand(const std::string &CommandName, const char *BytesKey, std::unordered_map<std::string, msgpack::object> Values, const Coyote::LogSink &Sink, const Coyote::LogStreamOptions &Options);
+	
+	//GetDiskAssets pieces shared by the page and crawl methods. A PageSize of zero asks for the whole directory, the old way.
+	AsyncToSync::MessageTicket *SendDiskAssetsRequest(const std::string &DriveName, const std::string &Subpath, const std::string &ContinuationToken, const uint32_t PageSize);
+	bool UnpackDiskAssetsPage(const std::unordered_map<std::string, msgpack::object> &Msg, Coyote::DiskAssetsPage &Out);
+	bool PagingMaybeRefused(const Coyote::StatusCode Status, const std::unordered_map<std::string, msgpack::object> &Msg);
+	void PagingFallbackWorked(void);
+	
+	bool ProcessIncoming(WSMessage *Msg);
 	static bool OnMessageReady(WS::WSConnection *Conn, WSMessage *Msg);
 	static bool CheckWSInit(void);
 	
@@ -128,6 +161,113 @@ struct InternalSession
 		return false;
 	}
 	
+	inline void NegotiateWireEncoding(const std::unordered_map<std::string, msgpack::object> &UnitTypeData, msgpack::zone &TempZone)
+	{ //Servers that can do the compact encoding advertise it in their GetUnitType reply. Everyone else just keeps getting maps.
+		if (!UnitTypeData.count("WireEncodings") || !UnitTypeData.count("WireKeyCount")) return;
+		
+		//Anything malformed in here means maps, never an exception out of the handshake.
+		const msgpack::object &Encodings { UnitTypeData.at("WireEncodings") };
+		const msgpack::object &TheirKeyCount { UnitTypeData.at("WireKeyCount") };
+		
+		if (Encodings.type != msgpack::type::ARRAY || TheirKeyCount.type != msgpack::type::POSITIVE_INTEGER) return;
+		
+		const std::string Wanted { CompactWire::EncodingName };
+		bool Offered = false;
+		
+		for (uint32_t Inc = 0u; Inc < Encodings.via.array.size && !Offered; ++Inc)
+		{
+			const msgpack::object &Item { Encodings.via.array.ptr[Inc] };
+			
+			Offered = Item.type == msgpack::type::STR && Wanted.compare(0u, std::string::npos, Item.via.str.ptr, Item.via.str.size) == 0;
+		}
+		
+		if (!Offered) return;
+		
+		//Both key tables are append only, so the IDs we both know are the first min(theirs, ours).
+		const uint16_t WireKeyCount = static_cast<uint16_t>(std::min<uint64_t>(TheirKeyCount.via.u64, WireSchema::NumWireKeys));
+		
+		if (WireKeyCount < static_cast<uint16_t>(WireSchema::WireKey::Data)) return; //Must at least cover the headers.
+		
+		const std::string Encoding { CompactWire::EncodingName };
+		
+		const std::unordered_map<std::string, msgpack::object> Values { MAPARG(Encoding), MAPARG(WireKeyCount) };
+		
+		const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
+		
+		Coyote::StatusCode S = Coyote::COYOTE_STATUS_INVALID;
+		
+		this->PerformSyncedCommand("SetWireEncoding", TempZone, &S, &Pass);
+		
+		if (S != Coyote::COYOTE_STATUS_OK)
+		{
+			LDEBUG_MSG("Server advertised " << CompactWire::EncodingName << " but refused it, staying with map encoding");
+			return;
+		}
+		
+		this->CompactKeyLimit = WireKeyCount;
+	}
+	
+	inline bool SendSubscriptions(const uint32_t Flags, msgpack::zone &TempZone, const char **FailedCommand = nullptr)
+	{
+		static const struct
+		{
+			uint32_t Flag;
+			const char *Command;
+			bool NeedsKona;
+		} SubCommands[] =
+		{
+			{ Coyote::COYOTE_SUB_TIMECODE, "SubscribeTC", false },
+			{ Coyote::COYOTE_SUB_ASSETS, "SubscribeAssets", false },
+			{ Coyote::COYOTE_SUB_PRESETSTATES, "SubscribePresetStates", false },
+			{ Coyote::COYOTE_SUB_PRESETS, "SubscribePresets", false },
+			{ Coyote::COYOTE_SUB_HWSTATE, "SubscribeHWState", true },
+			{ Coyote::COYOTE_SUB_PLAYBACKEVENTS, "SubscribePlaybackEvents", false },
+		};
+		
+		for (const auto &Cmd : SubCommands)
+		{
+			if (!(Flags & Cmd.Flag)) continue;
+			if (Cmd.NeedsKona && !this->SupportsSink("kona")) continue;
+			
+			Coyote::StatusCode S = Coyote::COYOTE_STATUS_INVALID;
+
+			this->PerformSyncedCommand(Cmd.Command, TempZone, &S);
+			
+			if (S != Coyote::COYOTE_STATUS_OK)
+			{
+				if (FailedCommand) *FailedCommand = Cmd.Command;
+				return false;
+			}
+		}
+		
+		return true;
+	}
+	
+	inline void IdentifyForStateCache(msgpack::zone &TempZone)
+	{ //State is cached per unit, and what answers at this host now isn't necessarily the unit we cached last time.
+		Coyote::StatusCode S = Coyote::COYOTE_STATUS_INVALID;
+		
+		const std::unordered_map<std::string, msgpack::object> Msg { this->PerformSyncedCommand("GetUnitID", TempZone, &S) };
+		
+		if (S != Coyote::COYOTE_STATUS_OK || !Msg.count("Data")) return;
+		
+		std::unordered_map<std::string, msgpack::object> Data;
+		Msg.at("Data").convert(Data);
+		
+		if (!Data.count("UnitID")) return;
+		
+		const std::string GUID { Data.at("UnitID").as<std::string>() };
+		
+		if (!this->CachedGUID.empty() && GUID != this->CachedGUID)
+		{
+			LDEBUG_MSG("Unit at " << this->Host << " is " << GUID << ", not cached unit " << this->CachedGUID << ", dropping cached state");
+			this->ASyncSess.SubSession.DiscardCachedState();
+		}
+		
+		this->CachedGUID = GUID;
+		this->ASyncSess.SubSession.SetCacheIdentity(GUID, this->Host);
+	}
+	
 	inline bool ConfigConnection(bool *SeriousError = nullptr)
 	{
 		this->CheckWSInit();
@@ -141,11 +281,19 @@ struct InternalSession
 		
 		this->SyncSess.DestroyAllTickets();
 		
+		this->CompactKeyLimit = 0u; //A new connection always starts out speaking maps.
+		this->BatchPresets = 0; //Could be a different unit, or the same one after an update.
+		this->BatchMarkEdits = 0;
+		this->PagedDiskAssets = 0;
+		this->Responses.InvalidateAll();
+		
 		this->Connection = Core->NewConnection(this->Host, this);
 
 		if (!this->Connection) return false;
 		
-		msgpack::zone TempZone;
+		this->Connection->SetRecorder(std::atomic_load(&this->Capture));
+		
+		POOLED_ZONE(TempZone);
 		Coyote::StatusCode S = Coyote::COYOTE_STATUS_INVALID;
 		
 		//Get unit type, that helps determine what commands we actually want to send the server.
@@ -158,72 +306,90 @@ struct InternalSession
 		
 		this->UType = static_cast<Coyote::UnitType>(Data.at("UnitType").as<int>());
 		
-		//Get host OS
-		Msg = this->PerformSyncedCommand("GetHostOS", TempZone, &S);
+		this->NegotiateWireEncoding(Data, TempZone);
 		
-		if (S != Coyote::COYOTE_STATUS_OK) return false;
-		
-		Data.clear();
-		Msg.at("Data").convert(Data);
+		if (!this->StateCacheDir.empty()) this->IdentifyForStateCache(TempZone);
 		
-		assert(Data.count("HostOS"));
+		const uint32_t Subscriptions = this->ASyncSess.SubSession.GetSubscriptions();
 		
-		this->HostOS = Data.at("HostOS").as<std::string>();
+		//Monitor sessions skip everything they don't need to follow the unit's state.
+		if (!this->MonitorOnly)
+		{
+			//Get host OS
+			Msg = this->PerformSyncedCommand("GetHostOS", TempZone, &S);
+			
+			if (S != Coyote::COYOTE_STATUS_OK) return false;
+			
+			Data.clear();
+			Msg.at("Data").convert(Data);
+			
+			assert(Data.count("HostOS"));
+			
+			this->HostOS = Data.at("HostOS").as<std::string>();
+		}
 		
 		//Get supported sinks
-		Msg = this->PerformSyncedCommand("GetSupportedSinks", TempZone, &S);
-		
-		if (S != Coyote::COYOTE_STATUS_OK) return false;
-		
-		Data.clear();
-		Msg.at("Data").convert(Data);
-		
-		this->SupportedSinks.clear();
-		
-		Data.at("SupportedSinks").convert(this->SupportedSinks);
+		if (!this->MonitorOnly || (Subscriptions & Coyote::COYOTE_SUB_HWSTATE))
+		{
+			Msg = this->PerformSyncedCommand("GetSupportedSinks", TempZone, &S);
+			
+			if (S != Coyote::COYOTE_STATUS_OK) return false;
+			
+			Data.clear();
+			Msg.at("Data").convert(Data);
+			
+			this->SupportedSinks.clear();
+			
+			Data.at("SupportedSinks").convert(this->SupportedSinks);
+		}
 		
-		static const char *const SubCommands[] = { "SubscribeTC", "SubscribeAssets", "SubscribePresetStates", "SubscribePresets", "!SubscribeHWState", "SubscribePlaybackEvents", nullptr };
+		const char *FailedCommand = nullptr;
 		
-		for (const char *const *Cmd = SubCommands; *Cmd; ++Cmd)
+		if (!this->SendSubscriptions(Subscriptions, TempZone, &FailedCommand))
 		{
-			const char *Text = *Cmd;
+			std::cerr << "libcoyote: Connection registration command \"" << FailedCommand << "\" for host " << this->Host << " has failed." << std::endl;
 			
-			if (*Text == '!')
-			{
-				if (!this->SupportsSink("kona")) continue;
-				++Text;
-			}
+			Core->ForgetConnection(this->Connection);
+			this->Connection = nullptr;
 			
-			S = Coyote::COYOTE_STATUS_INVALID;
-
-			this->PerformSyncedCommand(Text, TempZone, &S);
+			this->SyncSess.DestroyAllTickets();
 			
-			if (S != Coyote::COYOTE_STATUS_OK)
-			{
-				std::cerr << "libcoyote: Connection registration command \"" << Text << "\" for host " << this->Host << " has failed." << std::endl;
-				
-				Core->ForgetConnection(this->Connection);
-				this->Connection = nullptr;
-				
-				this->SyncSess.DestroyAllTickets();
-				
-				if (SeriousError) *SeriousError = true;
-				
-				return false;
-			}
+			if (SeriousError) *SeriousError = true;
+			
+			return false;
 		}
-		
 
 		return true;
 	}
 	
-	inline InternalSession(const std::string &Host = "", const int NumAttempts = -1)
+	inline InternalSession(const std::string &Host = "", const Coyote::SessionOptions &Options = {})
 		: Connection(),
 		Host(Host),
 		TimeoutSecs(Coyote::Session::DefaultCommandTimeoutSecs), //10 second default operation timeout
-		NumAttempts(NumAttempts),
-		UType()
+		NumAttempts(Options.NumAttempts),
+		UType(),
+		CompactKeyLimit(),
+		BatchPresets(),
+		BatchMarkEdits(),
+		PagedDiskAssets(),
+		MonitorOnly(Options.MonitorOnly),
+		StateCacheDir(Options.StateCacheDir)
 	{
+		this->ASyncSess.SubSession.SetSubscriptions(Options.Subscriptions);
+		
+		if (!this->StateCacheDir.empty())
+		{ //Loaded before connecting, so there's something to show while the unit is still sending everything over.
+			StateCache::CachedState Cached;
+			
+			if (StateCache::Load(this->StateCacheDir, Options.UnitGUID, Host, Cached))
+			{
+				this->CachedGUID = Cached.GUID;
+				this->ASyncSess.SubSession.InstallCachedState(std::move(Cached));
+			}
+			
+			this->ASyncSess.SubSession.EnableStateCache(this->StateCacheDir);
+		}
+		
 		for (int TryCount = 0; this->NumAttempts == -1 || TryCount < this->NumAttempts; ++TryCount)
 		{
 			std::cout << "libcoyote: Attempting to connect new session, attempt " << TryCount + 1 << " of " << (this->NumAttempts == -1 ? "infinite" : std::to_string(this->NumAttempts)) << std::endl;
@@ -241,6 +407,8 @@ struct InternalSession
 	}
 	inline ~InternalSession(void)
 	{
+		if (!this->Connection) return; //Never connected, e.g. a session made for ReplayTraffic()
+		
 		WS::WSCore::GetInstance()->ForgetConnection(this->Connection);
 	}
 };
@@ -264,9 +432,21 @@ bool InternalSession::OnMessageReady(WS::WSConnection *Conn, WSMessage *Msg)
 {
 	InternalSession *Sess = static_cast<InternalSession*>(Conn->UserData);
 	
+	return Sess->ProcessIncoming(Msg);
+}
+
+bool InternalSession::ProcessIncoming(WSMessage *Msg)
+{ //Everything the unit sends comes through here, whether off the network or out of a capture being replayed.
+	MsgpackProc::MessageHeaders Headers;
+	
+	//Subscription events can be huge (a full AssetSync), so route them before decoding anything.
+	if (MsgpackProc::ScanHeaders(Msg->GetBody(), Msg->GetBodySize(), Headers) && Headers.IsSubscription && !Headers.HasMsgID)
+	{
+		return this->ASyncSess.OnSubscriptionMessage(Msg, Headers);
+	}
 	
 	std::unordered_map<std::string, msgpack::object> Values;
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone); //Only replies and messages ScanHeaders couldn't read get this far, subscription events were routed above.
 	
 	try
 	{
@@ -278,25 +458,27 @@ bool InternalSession::OnMessageReady(WS::WSConnection *Conn, WSMessage *Msg)
 	catch (const std::bad_cast &Error)
 	{
 		LDEBUG_MSG("Corrupted or malformed message received, exception was " << Error.what());
+		delete Msg;
 		return false;
 	}
 	catch (...)
 	{
 		LDEBUG_MSG("Unknown exception was caught decoding a message.");
+		delete Msg;
 		return false;
 	}
 	
 	const bool IsSynchronousMsg = Values.count("MsgID");
 	
-	const bool Success = IsSynchronousMsg ? Sess->SyncSess.OnMessageReady(Values, Sess->Connection, Msg) : Sess->ASyncSess.OnMessageReady(Values, Sess->Connection, Msg);
+	const bool Success = IsSynchronousMsg ? this->SyncSess.OnMessageReady(Values, this->Connection, Msg) : this->ASyncSess.OnMessageReady(Values, this->Connection, Msg);
 	
 	return Success;
 }
 
 
-const std::unordered_map<std::string, msgpack::object> InternalSession::PerformSyncedCommand(const std::string &CommandName, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut, const msgpack::object *Values)
-{
-	msgpack::sbuffer Buffer;
+AsyncToSync::MessageTicket *InternalSession::SendCommand(const std::string &CommandName, const msgpack::object *Values)
+{ //Null on a network error.
+	POOLED_SBUFFER(Buffer);
 	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
 	
 	//Acquire a new message ID
@@ -310,23 +492,30 @@ const std::unordered_map<std::string, msgpack::object> InternalSession::PerformS
 #endif //LCVERBOSE
 
 	//Pack our values into a msgpack buffer
-	MsgpackProc::InitOutgoingMsg(Pack, CommandName, MsgID, Values);
+	MsgpackProc::InitOutgoingMsg(Pack, CommandName, MsgID, Values, this->CompactKeyLimit);
 	
-	if (!this->Connection || this->Connection->HasError())
-	{	
-		if (StatusOut) *StatusOut = Coyote::COYOTE_STATUS_NETWORKERROR;
-		
-		return {};
-	}
+	if (!this->Connection || this->Connection->HasError()) return nullptr;
 	
 	//Create the ticket BEFORE we send it.
 	AsyncToSync::MessageTicket *Ticket = this->SyncSess.NewTicket(MsgID);
 
 	this->Connection->Send(new WSMessage(Buffer.data(), Buffer.size()));
 	
+	return Ticket;
+}
+
+const std::unordered_map<std::string, msgpack::object> InternalSession::AwaitReply(AsyncToSync::MessageTicket *Ticket, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut, const time_t TimeoutSecs)
+{
+	if (!Ticket)
+	{
+		if (StatusOut) *StatusOut = Coyote::COYOTE_STATUS_NETWORKERROR;
+		
+		return {};
+	}
+	
 	//Wait for the value we want (with the message ID we want) to appear in the WebSockets thread.
 		
-	std::unique_ptr<WSMessage> ResponsePtr { Ticket->WaitForRecv(this->TimeoutSecs) };
+	std::unique_ptr<WSMessage> ResponsePtr { Ticket->WaitForRecv(TimeoutSecs ? TimeoutSecs : this->TimeoutSecs) };
 	this->SyncSess.DestroyTicket(Ticket);
 	
 	if (!ResponsePtr)
@@ -347,7 +536,154 @@ const std::unordered_map<std::string, msgpack::object> InternalSession::PerformS
 	return Results;
 }
 
-Coyote::Session::Session(const std::string &Host, const int NumAttempts) : Internal(new InternalSession{Host, NumAttempts})
+const std::unordered_map<std::string, msgpack::object> InternalSession::PerformSyncedCommand(const std::string &CommandName, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut, const msgpack::object *Values, const time_t TimeoutSecs)
+{
+	return this->AwaitReply(this->SendCommand(CommandName, Values), TempZone, StatusOut, TimeoutSecs);
+}
+
+const std::unordered_map<std::string, msgpack::object> InternalSession::PerformCachedCommand(const std::string &CommandName, const std::string &ArgKey, msgpack::zone &TempZone, Coyote::StatusCode *StatusOut, const msgpack::object *Values)
+{
+	std::unordered_map<std::string, msgpack::object> Cached;
+	uint64_t Generation = 0u;
+	
+	if (this->Responses.Lookup(CommandName, ArgKey, TempZone, Cached, Generation))
+	{
+		if (StatusOut) *StatusOut = Coyote::COYOTE_STATUS_OK;
+		
+		return Cached;
+	}
+	
+	Coyote::StatusCode Status = Coyote::COYOTE_STATUS_INVALID;
+	
+	std::unordered_map<std::string, msgpack::object> Msg { this->PerformSyncedCommand(CommandName, TempZone, &Status, Values) };
+	
+	if (Status == Coyote::COYOTE_STATUS_OK) this->Responses.Store(CommandName, ArgKey, Generation, Msg);
+	
+	if (StatusOut) *StatusOut = Status;
+	
+	return Msg;
+}
+
+static bool RawBytes(const msgpack::object &Object, const char *&PtrOut, size_t &SizeOut)
+{ //Points into the zone the reply was unpacked into, so nothing gets copied on the way out.
+	switch (Object.type)
+	{
+		case msgpack::type::BIN:
+			PtrOut = Object.via.bin.ptr;
+			SizeOut = Object.via.bin.size;
+			return true;
+		case msgpack::type::STR:
+			PtrOut = Object.via.str.ptr;
+			SizeOut = Object.via.str.size;
+			return true;
+		case msgpack::type::NIL:
+			PtrOut = nullptr;
+			SizeOut = 0u;
+			return true;
+		default:
+			return false;
+	}
+}
+
+static Coyote::LogSink FDSink(const int FD)
+{
+	return [FD] (const uint8_t *Data, const size_t Length)
+	{
+		size_t Written = 0u;
+		
+		while (Written < Length)
+		{
+#ifdef WIN32
+			const int Result = _write(FD, Data + Written, static_cast<unsigned>(std::min<size_t>(Length - Written, INT32_MAX)));
+#else
+			const ssize_t Result = write(FD, Data + Written, Length - Written);
+			
+			if (Result < 0 && errno == EINTR) continue;
+#endif //WIN32
+			if (Result <= 0) return false;
+			
+			Written += Result;
+		}
+		
+		return true;
+	};
+}
+
+Coyote::StatusCode InternalSession::StreamLogCommand(const std::string &CommandName, const char *BytesKey, std::unordered_map<std::string, msgpack::object> Values, const Coyote::LogSink &Sink, const Coyote::LogStreamOptions &Options)
+{ //Asks for one piece at a time with Offset and Length. Units that don't know about those send everything at once without a TotalSize.
+	if (!Sink || !Options.ChunkSize) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	uint64_t Offset = 0u;
+	bool Chunked = true;
+	
+	while (true)
+	{
+		POOLED_ZONE(TempZone);
+		Coyote::StatusCode Status{};
+		
+		if (Chunked)
+		{
+			Values["Offset"] = msgpack::object{Offset};
+			Values["Length"] = msgpack::object{Options.ChunkSize};
+		}
+		else
+		{
+			Values.erase("Offset");
+			Values.erase("Length");
+		}
+		
+		const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
+		
+		const std::unordered_map<std::string, msgpack::object> &Msg { this->PerformSyncedCommand(CommandName, TempZone, &Status, Values.empty() ? nullptr : &Pass, Options.ChunkTimeoutSecs) };
+		
+		if (Status != Coyote::COYOTE_STATUS_OK)
+		{ //A unit that predates chunking might refuse arguments it doesn't recognize, so the first request gets another go without them.
+			if (Chunked && !Offset && (Status == Coyote::COYOTE_STATUS_MISUSED || Status == Coyote::COYOTE_STATUS_UNIMPLEMENTED))
+			{
+				Chunked = false;
+				continue;
+			}
+			
+			return Status;
+		}
+		
+		std::unordered_map<std::string, msgpack::object> Data;
+		
+		Msg.at("Data").convert(Data);
+		
+		const char *Ptr = nullptr;
+		size_t Size = 0u;
+		
+		if (!RawBytes(Data.at(BytesKey), Ptr, Size)) return Coyote::COYOTE_STATUS_FAILED;
+		
+		const bool Whole = !Chunked || !Data.count("TotalSize");
+		const uint64_t Total = Whole ? Size : Data.at("TotalSize").as<uint64_t>();
+		
+		//A unit that ignored Length still only gets ChunkSize bytes handed over at a time.
+		for (size_t Done = 0u; Done < Size;)
+		{
+			const size_t Piece = std::min<size_t>(Size - Done, Options.ChunkSize);
+			
+			if (!Sink(reinterpret_cast<const uint8_t*>(Ptr + Done), Piece)) return Coyote::COYOTE_STATUS_FAILED;
+			
+			Done += Piece;
+			
+			if (Options.Progress) Options.Progress(Offset + Done, Total);
+		}
+		
+		Offset += Size;
+		
+		if (Whole || Offset >= Total) return Coyote::COYOTE_STATUS_OK;
+		
+		if (!Size) return Coyote::COYOTE_STATUS_FAILED; //Ran dry short of TotalSize, so the file is truncated. Asking again would just loop.
+	}
+}
+
+Coyote::Session::Session(const std::string &Host, const int NumAttempts) : Session(Host, SessionOptions{ COYOTE_SUB_ALL, false, NumAttempts })
+{
+}
+
+Coyote::Session::Session(const std::string &Host, const SessionOptions &Options) : Internal(new InternalSession{Host, Options})
 {
 	InternalSession &Sess = *static_cast<InternalSession*>(this->Internal);
 	
@@ -381,7 +717,7 @@ Coyote::StatusCode Coyote::Session::Take(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
@@ -397,7 +733,7 @@ Coyote::StatusCode Coyote::Session::GetMaxCPUPercentage(uint8_t &ValueOut)
 {
 	DEF_SESS;
 	
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetMaxCPUPercentage", TempZone, &Status) };
@@ -417,7 +753,7 @@ Coyote::StatusCode Coyote::Session::SetMaxCPUPercentage(const uint8_t MaxCPUPerc
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 
 	Coyote::StatusCode Status{};
 
@@ -434,7 +770,7 @@ Coyote::StatusCode Coyote::Session::SelectNext(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("SelectNext", TempZone, &Status);
@@ -446,7 +782,7 @@ Coyote::StatusCode Coyote::Session::LoadNetSettings(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("LoadNetSettings", TempZone, &Status);
@@ -458,7 +794,7 @@ Coyote::StatusCode Coyote::Session::SelectPrev(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("SelectPrev", TempZone, &Status);
@@ -470,7 +806,7 @@ Coyote::StatusCode Coyote::Session::TakeNext(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("TakeNext", TempZone, &Status);
@@ -482,7 +818,7 @@ Coyote::StatusCode Coyote::Session::TakePrev(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	
 	Coyote::StatusCode Status{};
 	
@@ -495,7 +831,7 @@ Coyote::StatusCode Coyote::Session::Pause(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
@@ -511,7 +847,7 @@ Coyote::StatusCode Coyote::Session::SetPausedState(const int32_t PK, const bool
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
@@ -538,7 +874,7 @@ Coyote::StatusCode Coyote::Session::End(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
@@ -553,7 +889,7 @@ Coyote::StatusCode Coyote::Session::DeleteAsset(const std::string &FullPath)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "FullPath", msgpack::object{FullPath.c_str(), TempZone } } };
@@ -568,7 +904,7 @@ Coyote::StatusCode Coyote::Session::InstallAsset(const std::string &FullPath, co
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	std::unordered_map<std::string, msgpack::object> Values { { "FullPath",  msgpack::object{FullPath.c_str(), TempZone } } };
@@ -589,7 +925,7 @@ Coyote::StatusCode Coyote::Session::SubscribeMiniview(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	std::unordered_map<std::string, msgpack::object> Values { { "PK", msgpack::object{ PK, TempZone } } };
@@ -605,7 +941,7 @@ Coyote::StatusCode Coyote::Session::UnsubscribeMiniview(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	std::unordered_map<std::string, msgpack::object> Values { { "PK", msgpack::object{ PK, TempZone } } };
@@ -614,14 +950,50 @@ Coyote::StatusCode Coyote::Session::UnsubscribeMiniview(const int32_t PK)
 	
 	SESS.PerformSyncedCommand("UnsubscribeMiniview", TempZone, &Status, &Pass);
 	
+	if (Status == Coyote::COYOTE_STATUS_OK) SESS.ASyncSess.SubSession.ForgetMiniviews(PK);
+	
 	return Status;
 }
 
+Coyote::StatusCode Coyote::Session::GetLatestMiniviewFrame(Coyote::MiniviewFrame &Out, const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetLatestMiniviewFrame(PK, CanvasIndex, OutputNum, Out) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
+
+Coyote::MiniviewStats Coyote::Session::GetMiniviewStats(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetMiniviewStats();
+}
+
+Coyote::StatusCode Coyote::Session::SetMiniviewProcessing(const MiniviewProcessingConfig &Config)
+{
+	DEF_SESS;
+	
+	const Coyote::StatusCode Status = MiniviewPipe::CheckConfig(Config);
+	
+	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	
+	SESS.ASyncSess.SubSession.SetMiniviewProcessing(std::make_shared<const Coyote::MiniviewProcessingConfig>(Config));
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+void Coyote::Session::DisableMiniviewProcessing(void)
+{
+	DEF_SESS;
+	
+	SESS.ASyncSess.SubSession.SetMiniviewProcessing(nullptr);
+}
+
 Coyote::StatusCode Coyote::Session::RenameAsset(const std::string &FullPath, const std::string &NewName)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "FullPath", msgpack::object{FullPath.c_str(), TempZone } }, { "NewName", msgpack::object{NewName.c_str(), TempZone} } };
@@ -646,11 +1018,25 @@ Coyote::StatusCode Coyote::Session::UpdatePreset(const Coyote::Preset &Ref)
 	return SESS.CreatePreset_Multi(Ref, "UpdatePreset");
 }
 
+Coyote::StatusCode Coyote::Session::CreatePresets(const std::vector<Preset> &Presets, std::vector<StatusCode> *StatusesOut)
+{
+	DEF_SESS;
+	
+	return SESS.BatchPresets_Multi(Presets, "CreatePresets", "CreatePreset", StatusesOut);
+}
+
+Coyote::StatusCode Coyote::Session::UpdatePresets(const std::vector<Preset> &Presets, std::vector<StatusCode> *StatusesOut)
+{
+	DEF_SESS;
+	
+	return SESS.BatchPresets_Multi(Presets, "UpdatePresets", "UpdatePreset", StatusesOut);
+}
+
 Coyote::StatusCode InternalSession::CreatePreset_Multi(const Coyote::Preset &Ref, const std::string &Cmd)
 {
 	Coyote::StatusCode Status{};
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	
 	const msgpack::object &Data = MsgpackProc::PackCoyoteObject(&Ref, TempZone);
 
@@ -659,32 +1045,155 @@ Coyote::StatusCode InternalSession::CreatePreset_Multi(const Coyote::Preset &Ref
 	return Status;
 }
 
-Coyote::StatusCode Coyote::Session::RenameCountdown(const int32_t PK, const int32_t Time, const std::string &NewName)
+Coyote::StatusCode InternalSession::BatchPresets_Multi(const std::vector<Coyote::Preset> &Presets, const std::string &BatchCmd, const std::string &SingleCmd, std::vector<Coyote::StatusCode> *StatusesOut)
 {
-	DEF_SESS;
-
-	msgpack::zone TempZone;	
-	Coyote::StatusCode Status{};
+	auto Pack = [&Presets] (const size_t Index, msgpack::zone &TempZone) { return MsgpackProc::PackCoyoteObject(&Presets[Index], TempZone); };
 	
-	const std::unordered_map<std::string, msgpack::object> Values
+	auto PackSingle = [&Presets, &SingleCmd] (const size_t Index, msgpack::zone &TempZone, msgpack::object &ArgsOut)
 	{
-		{ "PK", msgpack::object{PK, TempZone} },
-		{ "TimeMS", msgpack::object{Time, TempZone} },
-		{ "NewName", msgpack::object{NewName.c_str(), TempZone} }
+		ArgsOut = MsgpackProc::PackCoyoteObject(&Presets[Index], TempZone);
+		return SingleCmd.c_str();
 	};
 	
-	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
-	
-	SESS.PerformSyncedCommand("RenameCountdown", TempZone, &Status, &Pass);
-	
-	return Status;
+	return this->PerformBatch(BatchCmd, "Presets", Presets.size(), Pack, PackSingle, this->BatchPresets, StatusesOut);
 }
 
-Coyote::StatusCode Coyote::Session::RenameGoto(const int32_t PK, const int32_t Time, const std::string &NewName)
+Coyote::StatusCode InternalSession::PerformBatch(const std::string &BatchCmd, const char *ItemsKey, const size_t Count,
+												const std::function<msgpack::object(const size_t Index, msgpack::zone &TempZone)> &PackItem,
+												const std::function<const char*(const size_t Index, msgpack::zone &TempZone, msgpack::object &ArgsOut)> &PackSingle,
+												std::atomic<int8_t> &Supported, std::vector<Coyote::StatusCode> *StatusesOut)
 {
-	DEF_SESS;
-
-	msgpack::zone TempZone;	
+	static constexpr size_t PipelineDepth = 32; //Single commands in flight at once, when the unit has no batch command
+	
+	std::vector<Coyote::StatusCode> Statuses(Count, Coyote::COYOTE_STATUS_OK);
+	
+	if (StatusesOut) StatusesOut->clear();
+	
+	if (!Count) return Coyote::COYOTE_STATUS_OK;
+	
+	//Every preset or mark edit makes the unit send the whole preset list back. Only the last of those is worth decoding.
+	this->ASyncSess.HoldPresets();
+	
+	const struct Releaser
+	{
+		AsyncMsgs::AsynchronousSession &Target;
+		~Releaser(void) { this->Target.ReleasePresets(); }
+	} Release { this->ASyncSess };
+	
+	bool Done = false;
+	
+	if (Supported.load() >= 0)
+	{
+		POOLED_ZONE(TempZone);
+		Coyote::StatusCode Status{};
+		
+		std::vector<msgpack::object> Packed;
+		Packed.reserve(Count);
+		
+		for (size_t Inc = 0u; Inc < Count; ++Inc) Packed.push_back(PackItem(Inc, TempZone));
+		
+		const std::unordered_map<std::string, msgpack::object> Values { { ItemsKey, msgpack::object{ Packed, TempZone } } };
+		const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
+		
+		const std::unordered_map<std::string, msgpack::object> &Msg { this->PerformSyncedCommand(BatchCmd, TempZone, &Status, &Pass) };
+		
+		if (Status == Coyote::COYOTE_STATUS_UNIMPLEMENTED)
+		{
+			Supported = -1;
+		}
+		else
+		{
+			if (Status != Coyote::COYOTE_STATUS_NETWORKERROR) Supported = 1;
+			
+			std::fill(Statuses.begin(), Statuses.end(), Status);
+			
+			//Per item results, if the unit gave them. Otherwise they all share the overall status.
+			std::unordered_map<std::string, msgpack::object> Data;
+			
+			if (Msg.count("Data") && Msg.at("Data").type == msgpack::type::MAP) Msg.at("Data").convert(Data);
+			
+			if (Data.count("Statuses"))
+			{
+				std::vector<int> Each;
+				
+				Data.at("Statuses").convert(Each);
+				
+				for (size_t Inc = 0u; Inc < Each.size() && Inc < Statuses.size(); ++Inc) Statuses[Inc] = static_cast<Coyote::StatusCode>(Each[Inc]);
+			}
+			
+			Done = true;
+		}
+	}
+	
+	if (!Done)
+	{ //One command per item, but without waiting for each reply before sending the next. The unit still gets them in order.
+		std::deque<std::pair<size_t, AsyncToSync::MessageTicket*> > InFlight;
+		
+		auto Reap = [this, &InFlight, &Statuses] (void)
+		{
+			POOLED_ZONE(TempZone);
+			
+			this->AwaitReply(InFlight.front().second, TempZone, &Statuses[InFlight.front().first]);
+			InFlight.pop_front();
+		};
+		
+		for (size_t Inc = 0u; Inc < Count; ++Inc)
+		{
+			if (InFlight.size() >= PipelineDepth) Reap();
+			
+			POOLED_ZONE(TempZone);
+			msgpack::object Args;
+			
+			const char *const Cmd = PackSingle(Inc, TempZone, Args);
+			
+			InFlight.emplace_back(Inc, this->SendCommand(Cmd, &Args));
+		}
+		
+		while (!InFlight.empty()) Reap();
+	}
+	
+	Coyote::StatusCode RetVal = Coyote::COYOTE_STATUS_OK;
+	
+	for (const Coyote::StatusCode Status : Statuses)
+	{
+		if (Status != Coyote::COYOTE_STATUS_OK)
+		{
+			RetVal = Status;
+			break;
+		}
+	}
+	
+	if (StatusesOut) *StatusesOut = std::move(Statuses);
+	
+	return RetVal;
+}
+
+Coyote::StatusCode Coyote::Session::RenameCountdown(const int32_t PK, const int32_t Time, const std::string &NewName)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
+	Coyote::StatusCode Status{};
+	
+	const std::unordered_map<std::string, msgpack::object> Values
+	{
+		{ "PK", msgpack::object{PK, TempZone} },
+		{ "TimeMS", msgpack::object{Time, TempZone} },
+		{ "NewName", msgpack::object{NewName.c_str(), TempZone} }
+	};
+	
+	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
+	
+	SESS.PerformSyncedCommand("RenameCountdown", TempZone, &Status, &Pass);
+	
+	return Status;
+}
+
+Coyote::StatusCode Coyote::Session::RenameGoto(const int32_t PK, const int32_t Time, const std::string &NewName)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -705,7 +1214,7 @@ Coyote::StatusCode Coyote::Session::DeleteCountdown(const int32_t PK, const int3
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -725,7 +1234,7 @@ Coyote::StatusCode Coyote::Session::DeleteGoto(const int32_t PK, const int32_t T
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -744,7 +1253,7 @@ Coyote::StatusCode Coyote::Session::CreateCountdown(const int32_t PK, const int3
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -765,7 +1274,7 @@ Coyote::StatusCode Coyote::Session::CreateGoto(const int32_t PK, const int32_t T
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -782,14 +1291,68 @@ Coyote::StatusCode Coyote::Session::CreateGoto(const int32_t PK, const int32_t T
 	return Status;
 }
 
+Coyote::StatusCode Coyote::Session::ApplyMarkEdits(const std::vector<MarkEdit> &Edits, std::vector<StatusCode> *StatusesOut)
+{
+	DEF_SESS;
+	
+	static const char *const Commands[2][3] =
+	{ //[Type - 1][Action - 1], the single commands for units without ApplyMarkEdits
+		{ "CreateGoto", "RenameGoto", "DeleteGoto" },
+		{ "CreateCountdown", "RenameCountdown", "DeleteCountdown" },
+	};
+	
+	static const char *const TypeNames[] = { "Goto", "Countdown" };
+	static const char *const ActionNames[] = { "Create", "Rename", "Delete" };
+	
+	for (const MarkEdit &Edit : Edits)
+	{
+		if (Edit.Type < COYOTE_MARK_GOTO || Edit.Type > COYOTE_MARK_COUNTDOWN) return Coyote::COYOTE_STATUS_MISUSED;
+		if (Edit.Action < COYOTE_MARKEDIT_CREATE || Edit.Action > COYOTE_MARKEDIT_DELETE) return Coyote::COYOTE_STATUS_MISUSED;
+	}
+	
+	//Same argument names as the single commands, so the unit can hand each entry straight to its existing handler.
+	auto PackArgs = [&Edits] (const size_t Index, msgpack::zone &TempZone, const bool Batch)
+	{
+		const MarkEdit &Edit { Edits[Index] };
+		
+		std::unordered_map<std::string, msgpack::object> Values
+		{
+			{ "PK", msgpack::object{Edit.PK, TempZone} },
+			{ "TimeMS", msgpack::object{Edit.TimeMS, TempZone} },
+		};
+		
+		if (Edit.Action == COYOTE_MARKEDIT_CREATE) Values.emplace("Name", msgpack::object{Edit.Name.c_str(), TempZone});
+		else if (Edit.Action == COYOTE_MARKEDIT_RENAME) Values.emplace("NewName", msgpack::object{Edit.Name.c_str(), TempZone});
+		
+		if (Batch)
+		{
+			Values.emplace("Type", msgpack::object{TypeNames[Edit.Type - 1], TempZone});
+			Values.emplace("Action", msgpack::object{ActionNames[Edit.Action - 1], TempZone});
+		}
+		
+		return MsgpackProc::STLMapToMsgpackMap(Values, TempZone);
+	};
+	
+	auto PackItem = [&PackArgs] (const size_t Index, msgpack::zone &TempZone) { return PackArgs(Index, TempZone, true); };
+	
+	auto PackSingle = [&PackArgs, &Edits] (const size_t Index, msgpack::zone &TempZone, msgpack::object &ArgsOut)
+	{
+		ArgsOut = PackArgs(Index, TempZone, false);
+		return Commands[Edits[Index].Type - 1][Edits[Index].Action - 1];
+	};
+	
+	return SESS.PerformBatch("ApplyMarkEdits", "Edits", Edits.size(), PackItem, PackSingle, SESS.BatchMarkEdits, StatusesOut);
+}
+
 Coyote::StatusCode Coyote::Session::BeginUpdate(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("BeginUpdate", TempZone, &Status);
+	SESS.Responses.Invalidate("GetServerVersion");
 	
 	return Status;
 }
@@ -799,7 +1362,7 @@ Coyote::StatusCode Coyote::Session::RebootCoyote(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("RebootCoyote", TempZone, &Status);
@@ -811,7 +1374,7 @@ Coyote::StatusCode Coyote::Session::SoftRebootCoyote(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("SoftRebootCoyote", TempZone, &Status);
@@ -823,7 +1386,7 @@ Coyote::StatusCode Coyote::Session::ShutdownCoyote(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("ShutdownCoyote", TempZone, &Status);
@@ -836,7 +1399,7 @@ Coyote::StatusCode Coyote::Session::IsMirror(bool &ValueOut)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const char *CmdName = "IsMirror";
 	
 	Coyote::StatusCode Status{};
@@ -872,12 +1435,12 @@ Coyote::StatusCode Coyote::Session::GetSupportsS12G(bool &ValueOut)
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 	
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const char *CmdName = "GetSupportsS12G";
 	
 	Coyote::StatusCode Status{};
 
-	const std::unordered_map<std::string, msgpack::object> &Response { SESS.PerformSyncedCommand(CmdName, TempZone, &Status) };
+	const std::unordered_map<std::string, msgpack::object> &Response { SESS.PerformCachedCommand(CmdName, {}, TempZone, &Status) };
 	
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;	
 	
@@ -894,7 +1457,7 @@ Coyote::StatusCode Coyote::Session::SynchronizerBusy(bool &ValueOut)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const char *CmdName = "SynchronizerBusy";
 	
 	Coyote::StatusCode Status{};
@@ -916,10 +1479,11 @@ Coyote::StatusCode Coyote::Session::DeconfigureSync(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("DeconfigureSync", TempZone, &Status);
+	SESS.Responses.Invalidate("GetMirrors");
 	
 	return Status;
 }
@@ -928,13 +1492,14 @@ Coyote::StatusCode Coyote::Session::AddMirror(const std::string &MirrorIP)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "IP",  msgpack::object{MirrorIP.c_str(), TempZone } } };
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("AddMirror", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetMirrors");
 	
 	return Status;
 }
@@ -943,7 +1508,7 @@ Coyote::StatusCode Coyote::Session::StartSpoke(const std::string &SpokeName)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "SpokeName",  msgpack::object{SpokeName.c_str(), TempZone } } };
@@ -958,7 +1523,7 @@ Coyote::StatusCode Coyote::Session::KillSpoke(const std::string &SpokeName)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "SpokeName",  msgpack::object{SpokeName.c_str(), TempZone } } };
@@ -973,7 +1538,7 @@ Coyote::StatusCode Coyote::Session::RestartSpoke(const std::string &SpokeName)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "SpokeName",  msgpack::object{SpokeName.c_str(), TempZone } } };
@@ -997,7 +1562,7 @@ Coyote::StatusCode Coyote::Session::GetDisks(std::vector<Coyote::Drive> &Out)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const char *CmdName = "GetDisks";
 	
 	Coyote::StatusCode Status{};
@@ -1032,7 +1597,7 @@ Coyote::StatusCode Coyote::Session::EjectDisk(const std::string &Mountpoint)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { { "Mountpoint", msgpack::object{Mountpoint.c_str()} } };
@@ -1047,7 +1612,7 @@ Coyote::StatusCode Coyote::Session::ReorderPresets(const int32_t PK1, const int3
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK1), MAPARG(PK2) };
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
@@ -1062,7 +1627,7 @@ Coyote::StatusCode Coyote::Session::MovePreset(const int32_t PK, const std::stri
 
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK), MAPARG(TabID), MAPARG(NewIndex) };
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
@@ -1076,7 +1641,7 @@ Coyote::StatusCode Coyote::Session::DeletePreset(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	Coyote::StatusCode Status{};
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
@@ -1090,7 +1655,7 @@ Coyote::StatusCode Coyote::Session::SeekTo(const int32_t PK, const uint32_t Time
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK), MAPARG(TimeIndex) };
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 
@@ -1105,30 +1670,67 @@ Coyote::StatusCode Coyote::Session::GetTimeCode(Coyote::TimeCode &Out, const int
 {
 	DEF_SESS;
 
-	if (Coyote::TimeCode *const TC = SESS.ASyncSess.SubSession.GetTimeCode(PK))
-	{
-		Out = *TC;
-		delete TC;
-		return Coyote::COYOTE_STATUS_OK;
-	}
+	return SESS.ASyncSess.SubSession.LoadTimeCode(PK, Out) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
+
+Coyote::StatusCode Coyote::Session::GetTimeCodeHistory(std::vector<TimeCodeSample> &Out, const int32_t PK)
+{
+	DEF_SESS;
 	
-	return Coyote::COYOTE_STATUS_FAILED;
+	return SESS.ASyncSess.SubSession.LoadTimeCodeHistory(PK, Out) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
 }
+
+Coyote::StatusCode Coyote::Session::GetExtrapolatedTime(int32_t &TimeOut, const int32_t PK, const std::chrono::steady_clock::time_point At)
+{
+	DEF_SESS;
 	
-Coyote::StatusCode Coyote::Session::GetPresetStates(std::vector<Coyote::PresetState> &Out)
+	return SESS.ASyncSess.SubSession.ExtrapolateTimeCode(PK, At, TimeOut) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
+
+Coyote::StatusCode Coyote::Session::EnableVUMeters(const VUMeterConfig &Config)
+{
+	DEF_SESS;
+	
+	if (!VUMeter::Engine::CheckConfig(Config)) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	SESS.ASyncSess.SubSession.SetVUMeters(std::make_shared<VUMeter::Engine>(Config));
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+void Coyote::Session::DisableVUMeters(void)
+{
+	DEF_SESS;
+	
+	SESS.ASyncSess.SubSession.SetVUMeters(nullptr);
+}
+
+Coyote::StatusCode Coyote::Session::GetVUMeters(VUMeterReading &Out, const int32_t PK)
 {
 	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.LoadVUMeters(PK, Out) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
 
-	std::unique_ptr<std::unordered_map<int32_t, Coyote::PresetState> > Ptr { SESS.ASyncSess.SubSession.GetPresetStates() };
+Coyote::StatusCode Coyote::Session::ResetVUMeters(const int32_t PK)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.ResetVUMeters(PK) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
 	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
+Coyote::StatusCode Coyote::Session::GetPresetStates(std::vector<Coyote::PresetState> &Out)
+{
+	DEF_SESS;
+
+	const Coyote::PresetStatesSnapshot Snapshot { SESS.ASyncSess.SubSession.GetPresetStatesSnapshot() };
 	
 	Out.clear();
-	Out.reserve(Ptr->size());
+	Out.reserve(Snapshot->size());
 	
-	for (auto Pair : *Ptr)
+	for (const auto &Pair : *Snapshot)
 	{
-		Out.push_back(std::move(Pair.second));
+		Out.push_back(*Pair.second);
 	}
 
 	return Coyote::COYOTE_STATUS_OK;
@@ -1138,11 +1740,9 @@ Coyote::StatusCode Coyote::Session::GetPresetStatesMap(std::unordered_map<int32_
 {
 	DEF_SESS;
 
-	std::unique_ptr<std::unordered_map<int32_t, Coyote::PresetState> > Ptr { SESS.ASyncSess.SubSession.GetPresetStates() };
+	std::unique_ptr<std::unordered_map<int32_t, Coyote::PresetState> > Map { SESS.ASyncSess.SubSession.GetPresetStates() };
 	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
-
-	Out = std::move(*Ptr);
+	Out = std::move(*Map);
 
 	return Coyote::COYOTE_STATUS_OK;
 }
@@ -1151,11 +1751,9 @@ Coyote::StatusCode Coyote::Session::GetPresetsMap(std::unordered_map<int32_t, Co
 {
 	DEF_SESS;
 
-	std::unique_ptr<std::unordered_map<int32_t, Coyote::Preset> > Ptr { SESS.ASyncSess.SubSession.GetPresets() };
+	std::unique_ptr<std::unordered_map<int32_t, Coyote::Preset> > Map { SESS.ASyncSess.SubSession.GetPresets() };
 	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
-	
-	Out = std::move(*Ptr);
+	Out = std::move(*Map);
 	
 	return Coyote::COYOTE_STATUS_OK;
 }
@@ -1164,11 +1762,9 @@ Coyote::StatusCode Coyote::Session::GetTimeCodesMap(std::unordered_map<int32_t,
 {
 	DEF_SESS;
 
-	std::unique_ptr<std::unordered_map<int32_t, Coyote::TimeCode> > Ptr { SESS.ASyncSess.SubSession.GetTimeCodesMap() };
+	std::unique_ptr<std::unordered_map<int32_t, Coyote::TimeCode> > Map { SESS.ASyncSess.SubSession.GetTimeCodesMap() };
 	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
-	
-	Out = std::move(*Ptr);
+	Out = std::move(*Map);
 	
 	return Coyote::COYOTE_STATUS_OK;
 }
@@ -1177,16 +1773,14 @@ Coyote::StatusCode Coyote::Session::GetPresets(std::vector<Coyote::Preset> &Out)
 {
 	DEF_SESS;
 
-	std::unique_ptr<std::unordered_map<int32_t, Coyote::Preset> > Ptr { SESS.ASyncSess.SubSession.GetPresets() };
-	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
+	const Coyote::PresetsSnapshot Snapshot { SESS.ASyncSess.SubSession.GetPresetsSnapshot() };
 	
 	Out.clear();
-	Out.reserve(Ptr->size());
+	Out.reserve(Snapshot->size());
 	
-	for (auto Pair : *Ptr)
+	for (const auto &Pair : *Snapshot)
 	{
-		Out.push_back(std::move(Pair.second));
+		Out.push_back(*Pair.second);
 	}
 
 	return Coyote::COYOTE_STATUS_OK;
@@ -1196,21 +1790,73 @@ Coyote::StatusCode Coyote::Session::GetAssets(std::vector<Coyote::Asset> &Out)
 {
 	DEF_SESS;
 
-	std::unique_ptr<std::unordered_map<std::string, Coyote::Asset> > Ptr { SESS.ASyncSess.SubSession.GetAssets() };
-	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
+	const Coyote::AssetCatalogSnapshot Catalog { SESS.ASyncSess.SubSession.GetAssetCatalog() };
 	
 	Out.clear();
-	Out.reserve(Ptr->size());
+	Out.reserve(Catalog->Size());
 	
-	for (auto Pair : *Ptr)
+	for (size_t Inc = 0u; Inc < Coyote::AssetCatalog::NumShards; ++Inc)
 	{
-		Out.push_back(std::move(Pair.second));
+		for (const auto &Pair : Catalog->Shard(Inc).Assets)
+		{
+			Out.push_back(*Pair.second);
+		}
 	}
 
 	return Coyote::COYOTE_STATUS_OK;
 }
 
+Coyote::StatusCode Coyote::Session::QueryAssets(Coyote::AssetView &Out, const Coyote::AssetQuery &Query)
+{
+	DEF_SESS;
+	
+	Out = SESS.ASyncSess.SubSession.GetAssetCatalog()->Query(Query);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::AssetsSnapshot Coyote::Session::GetAssetsSnapshot(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetAssetsSnapshot();
+}
+
+Coyote::AssetCatalogSnapshot Coyote::Session::GetAssetCatalog(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetAssetCatalog();
+}
+
+Coyote::PresetsSnapshot Coyote::Session::GetPresetsSnapshot(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetPresetsSnapshot();
+}
+
+Coyote::PresetStatesSnapshot Coyote::Session::GetPresetStatesSnapshot(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetPresetStatesSnapshot();
+}
+
+Coyote::TimeCodesSnapshot Coyote::Session::GetTimeCodesSnapshot(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetTimeCodesSnapshot();
+}
+
+Coyote::HWStateSnapshot Coyote::Session::GetKonaHardwareStateSnapshot(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetKonaHardwareStateSnapshot();
+}
+
 Coyote::StatusCode Coyote::Session::GetKonaHardwareState(Coyote::KonaHardwareState &Out)
 {
 	DEF_SESS;
@@ -1220,19 +1866,7 @@ Coyote::StatusCode Coyote::Session::GetKonaHardwareState(Coyote::KonaHardwareSta
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 	
-	std::unique_ptr<Coyote::KonaHardwareState> Ptr;
-	try
-	{
-		Ptr.reset(SESS.ASyncSess.SubSession.GetKonaHardwareState());
-	}
-	catch (...)
-	{
-		return Coyote::COYOTE_STATUS_FAILED;
-	}
-	
-	if (!Ptr) return Coyote::COYOTE_STATUS_FAILED;
-	
-	Out = std::move(*Ptr);
+	Out = *SESS.ASyncSess.SubSession.GetKonaHardwareStateSnapshot();
 	
 	return Coyote::COYOTE_STATUS_OK;
 }
@@ -1297,7 +1931,7 @@ Coyote::StatusCode Coyote::Session::GetIP(const int32_t AdapterID, Coyote::Netwo
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(AdapterID) };
 	
 	Coyote::StatusCode Status{};
@@ -1317,7 +1951,7 @@ Coyote::StatusCode Coyote::Session::ReadAssetMetadata(const std::string &FullPat
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(FullPath) };
 	
 	Coyote::StatusCode Status{};
@@ -1338,7 +1972,7 @@ Coyote::StatusCode Coyote::Session::SetIP(const Coyote::NetworkInfo &Input)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	const std::unordered_map<std::string, msgpack::object> Values { { "AdapterID", msgpack::object{Input.AdapterID} }, { "Subnet", msgpack::object{Input.Subnet.c_str()} }, { "IP", msgpack::object{Input.IP.c_str()} } };
 	
 	Coyote::StatusCode Status{};
@@ -1353,7 +1987,7 @@ Coyote::StatusCode Coyote::Session::SelectPreset(const int32_t PK)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(PK) };
@@ -1374,10 +2008,10 @@ Coyote::StatusCode Coyote::Session::GetGenlockSettings(Coyote::GenlockSettings &
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 	
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetGenlockSettings", TempZone, &Status) };
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetGenlockSettings", {}, TempZone, &Status) };
 	
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
 	
@@ -1398,7 +2032,7 @@ Coyote::StatusCode Coyote::Session::SetVertGenlock(int32_t VertValue)
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 	
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	
 	StatusCode Status = COYOTE_STATUS_INVALID;
 	
@@ -1407,6 +2041,7 @@ Coyote::StatusCode Coyote::Session::SetVertGenlock(int32_t VertValue)
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("SetVertGenlock", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetGenlockSettings");
 	
 	return Status;
 }
@@ -1420,7 +2055,7 @@ Coyote::StatusCode Coyote::Session::SetHorzGenlock(int32_t HorzValue)
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 		
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	
 	StatusCode Status = COYOTE_STATUS_INVALID;
 	
@@ -1429,6 +2064,7 @@ Coyote::StatusCode Coyote::Session::SetHorzGenlock(int32_t HorzValue)
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("SetHorzGenlock", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetGenlockSettings");
 	
 	return Status;
 }
@@ -1447,7 +2083,7 @@ Coyote::StatusCode Coyote::Session::SetKonaHardwareMode(const std::array<Resolut
 		return COYOTE_STATUS_UNSUPPORTED;
 	}
 	
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	assert(RefreshMap.count(RefreshRate));
 	
 	StatusCode Status{};
@@ -1474,6 +2110,7 @@ Coyote::StatusCode Coyote::Session::SetKonaHardwareMode(const std::array<Resolut
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 
 	SESS.PerformSyncedCommand("SetKonaHardwareMode", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetGenlockSettings"); //Genlock offsets follow the refresh rate
 	
 	return Status;
 }
@@ -1482,7 +2119,7 @@ Coyote::StatusCode Coyote::Session::UploadState(const std::string &PresetsJson,
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1501,7 +2138,7 @@ Coyote::StatusCode Coyote::Session::DeleteWatchPath(const std::string &Path)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1512,6 +2149,7 @@ Coyote::StatusCode Coyote::Session::DeleteWatchPath(const std::string &Path)
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("DeleteWatchPath", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetWatchPaths");
 	
 	return Status;
 }
@@ -1519,7 +2157,7 @@ Coyote::StatusCode Coyote::Session::ManualForgetAsset(const std::string &Path)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1537,7 +2175,7 @@ Coyote::StatusCode Coyote::Session::ManualAddAsset(const std::string &Path)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1556,7 +2194,7 @@ Coyote::StatusCode Coyote::Session::ExitSupervisor(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	SESS.PerformSyncedCommand("ExitSupervisor", TempZone, &Status);
@@ -1568,7 +2206,7 @@ Coyote::StatusCode Coyote::Session::AddWatchPath(const std::string &Path)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1579,6 +2217,7 @@ Coyote::StatusCode Coyote::Session::AddWatchPath(const std::string &Path)
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("AddWatchPath", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetWatchPaths");
 	
 	return Status;
 }
@@ -1587,7 +2226,7 @@ Coyote::StatusCode Coyote::Session::DownloadState(std::string &PresetsJsonOut, s
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("DownloadState", TempZone, &Status) };
@@ -1609,7 +2248,7 @@ Coyote::StatusCode Coyote::Session::GetCurrentRole(Coyote::UnitRole &CurrentRole
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetCurrentRole", TempZone, &Status) };
@@ -1630,7 +2269,7 @@ Coyote::StatusCode Coyote::Session::ActivateMachine(const std::string &LicenseKe
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1641,6 +2280,7 @@ Coyote::StatusCode Coyote::Session::ActivateMachine(const std::string &LicenseKe
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("ActivateMachine", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetLicensingStatus");
 	
 	return Status;
 }
@@ -1649,7 +2289,7 @@ Coyote::StatusCode Coyote::Session::DeactivateMachine(const std::string &License
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1661,6 +2301,7 @@ Coyote::StatusCode Coyote::Session::DeactivateMachine(const std::string &License
 	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("DeactivateMachine", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetLicensingStatus");
 	
 	return Status;
 }
@@ -1669,10 +2310,10 @@ Coyote::StatusCode Coyote::Session::GetLicensingStatus(LicensingStatus &LicStats
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetLicensingStatus", TempZone, &Status) };
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetLicensingStatus", {}, TempZone, &Status) };
 
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
 
@@ -1687,7 +2328,7 @@ Coyote::StatusCode Coyote::Session::HostSinkEarlyFireup(void)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 
 	SESS.PerformSyncedCommand("HostSinkEarlyFireup", TempZone, &Status);
@@ -1699,7 +2340,7 @@ Coyote::StatusCode Coyote::Session::GetLicenseType(const std::string &LicenseKey
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 
 	const std::unordered_map<std::string, msgpack::object> Values
@@ -1726,7 +2367,7 @@ Coyote::StatusCode Coyote::Session::GetUnitID(std::string &UnitIDOut, std::strin
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetUnitID", TempZone, &Status) };
@@ -1748,10 +2389,10 @@ Coyote::StatusCode Coyote::Session::GetServerVersion(std::string &Out)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetServerVersion", TempZone, &Status) };
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetServerVersion", {}, TempZone, &Status) };
 	
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
 	
@@ -1769,14 +2410,14 @@ Coyote::StatusCode Coyote::Session::GetHostSinkResolution(const uint32_t HDMINum
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(HDMINum) };
 	
 	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetHostSinkResolution", TempZone, &Status, &Pass) };
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetHostSinkResolution", std::to_string(HDMINum), TempZone, &Status, &Pass) };
 	
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
 	
@@ -1785,8 +2426,8 @@ Coyote::StatusCode Coyote::Session::GetHostSinkResolution(const uint32_t HDMINum
 	
 	assert(Data.count("Res") && Data.count("FPS"));
 	
-	ResOut = ReverseResolutionMap(Data.at("Res").as<std::string>());
-	FPSOut = ReverseRefreshMap(Data.at("FPS").as<std::string>());
+	ResOut = MsgpackProc::UnpackResolution(Data.at("Res"));
+	FPSOut = MsgpackProc::UnpackRefreshRate(Data.at("FPS"));
 	
 	return Status;
 }
@@ -1795,7 +2436,7 @@ Coyote::StatusCode Coyote::Session::SetHostSinkResolution(const uint32_t HDMINum
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(HDMINum), { "Res", msgpack::object{ ResolutionMap.at(Res), TempZone } }, { "FPS", msgpack::object { RefreshMap.at(FPS), TempZone } } };
@@ -1803,6 +2444,7 @@ Coyote::StatusCode Coyote::Session::SetHostSinkResolution(const uint32_t HDMINum
 	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("SetHostSinkResolution", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetHostSinkResolution");
 	
 	return Status;
 }
@@ -1811,14 +2453,14 @@ Coyote::StatusCode Coyote::Session::GetBMDResolution(const uint32_t SDIIndex, Co
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(SDIIndex) };
 	
 	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetBMDResolution", TempZone, &Status, &Pass) };
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetBMDResolution", std::to_string(SDIIndex), TempZone, &Status, &Pass) };
 	
 	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
 	
@@ -1827,8 +2469,8 @@ Coyote::StatusCode Coyote::Session::GetBMDResolution(const uint32_t SDIIndex, Co
 	
 	assert(Data.count("Res") && Data.count("FPS"));
 	
-	ResOut = ReverseResolutionMap(Data.at("Res").as<std::string>());
-	FPSOut = ReverseRefreshMap(Data.at("FPS").as<std::string>());
+	ResOut = MsgpackProc::UnpackResolution(Data.at("Res"));
+	FPSOut = MsgpackProc::UnpackRefreshRate(Data.at("FPS"));
 	
 	return Status;
 }
@@ -1836,7 +2478,7 @@ Coyote::StatusCode Coyote::Session::SetBMDResolution(const uint32_t SDIIndex, co
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(SDIIndex), { "Res", msgpack::object{ ResolutionMap.at(Res), TempZone } }, { "FPS", msgpack::object { RefreshMap.at(FPS), TempZone } } };
@@ -1844,6 +2486,7 @@ Coyote::StatusCode Coyote::Session::SetBMDResolution(const uint32_t SDIIndex, co
 	const msgpack::object &Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
 	SESS.PerformSyncedCommand("SetBMDResolution", TempZone, &Status, &Pass);
+	SESS.Responses.Invalidate("GetBMDResolution");
 	
 	return Status;
 }
@@ -1852,7 +2495,7 @@ Coyote::StatusCode Coyote::Session::GetDiskAssets(std::vector<ExternalAsset> &Ou
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> Values { MAPARG(DriveName), MAPARG(Subpath) };
@@ -1877,79 +2520,339 @@ Coyote::StatusCode Coyote::Session::GetDiskAssets(std::vector<ExternalAsset> &Ou
 	return Coyote::COYOTE_STATUS_OK;
 }
 
-Coyote::StatusCode Coyote::Session::GetWatchPaths(std::vector<std::string> &Out)
+AsyncToSync::MessageTicket *InternalSession::SendDiskAssetsRequest(const std::string &DriveName, const std::string &Subpath, const std::string &ContinuationToken, const uint32_t PageSize)
 {
-	DEF_SESS;
-
-	msgpack::zone TempZone;
-	StatusCode Status{};
+	POOLED_ZONE(TempZone);
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetWatchPaths", TempZone, &Status) };
+	std::unordered_map<std::string, msgpack::object> Values { MAPARG(DriveName), MAPARG(Subpath) };
 	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	if (PageSize)
+	{
+		Values["PageSize"] = msgpack::object{PageSize};
+		
+		if (!ContinuationToken.empty()) Values["ContinuationToken"] = msgpack::object{ContinuationToken, TempZone};
+	}
 	
-	Msg.at("Data").convert(Out);
+	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
 	
-	return Coyote::COYOTE_STATUS_OK;
+	return this->SendCommand("GetDiskAssets", &Pass);
 }
 
-Coyote::StatusCode Coyote::Session::GetMirrors(std::vector<Coyote::Mirror> &Out)
-{
-	DEF_SESS;
-
-	msgpack::zone TempZone;
-	StatusCode Status{};
+bool InternalSession::UnpackDiskAssetsPage(const std::unordered_map<std::string, msgpack::object> &Msg, Coyote::DiskAssetsPage &Out)
+{ //Paging units send Assets and ContinuationToken in a map. Everyone else sends the whole directory as a plain array.
+	if (!Msg.count("Data")) return false;
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetMirrors", TempZone, &Status) };
+	const msgpack::object &Data { Msg.at("Data") };
 	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	std::vector<msgpack::object> Items;
 	
+	Out.ContinuationToken.clear();
 	
-	std::vector<msgpack::object> Data;
-
-	Msg.at("Data").convert(Data);
+	if (Data.type == msgpack::type::MAP)
+	{
+		std::unordered_map<std::string, msgpack::object> Fields;
+		
+		Data.convert(Fields);
+		
+		if (!Fields.count("Assets")) return false;
+		
+		Fields.at("Assets").convert(Items);
+		
+		if (Fields.count("ContinuationToken") && Fields.at("ContinuationToken").type == msgpack::type::STR)
+		{
+			Fields.at("ContinuationToken").convert(Out.ContinuationToken);
+		}
+		
+		this->PagedDiskAssets = 1;
+	}
+	else if (Data.type == msgpack::type::ARRAY)
+	{
+		Data.convert(Items);
+	}
+	else return false;
 	
-	for (msgpack::object &Object : Data)
+	Out.Items.reserve(Out.Items.size() + Items.size());
+	
+	for (const msgpack::object &Obj : Items)
 	{
-		LDEBUG_MSG("Found mirror data");
-		std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Object, typeid(Coyote::Mirror))) };
+		std::unique_ptr<Coyote::ExternalAsset> DAStruct { static_cast<Coyote::ExternalAsset*>(MsgpackProc::UnpackCoyoteObject(Obj, typeid(Coyote::ExternalAsset))) };
 		
-		Out.emplace_back(std::move(*MirrorStruct));
+		Out.Items.emplace_back(std::move(*DAStruct));
 	}
-
-	return Coyote::COYOTE_STATUS_OK;
+	
+	return true;
 }
 
-Coyote::StatusCode Coyote::Session::GetDesignatedPrimary(Coyote::Mirror &Out)
-{
-	DEF_SESS;
-
-	msgpack::zone TempZone;
-	StatusCode Status{};
+bool InternalSession::PagingMaybeRefused(const Coyote::StatusCode Status, const std::unordered_map<std::string, msgpack::object> &Msg)
+{ //A unit that predates paging might refuse arguments it doesn't recognize, so the caller should retry without them once.
+	if (Status != Coyote::COYOTE_STATUS_MISUSED && Status != Coyote::COYOTE_STATUS_UNIMPLEMENTED) return false;
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetDesignatedPrimary", TempZone, &Status) };
+	if (this->PagedDiskAssets.load() > 0) return false; //Once a unit has paged for us, errors are just errors.
 	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	const auto Iter = Msg.find("StatusText");
 	
-	std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Msg.at("Data"), typeid(Coyote::Mirror))) };
+	if (Iter == Msg.end() || Iter->second.type != msgpack::type::STR) return true;
+	
+	//Only settled for good when the unit says which argument it choked on. Otherwise it could just be a bad path.
+	const std::string Text { Iter->second.via.str.ptr, Iter->second.via.str.size };
+	
+	if (Text.find("PageSize") != std::string::npos || Text.find("ContinuationToken") != std::string::npos) this->PagedDiskAssets = -1;
+	
+	return true;
+}
 
-	Out = *MirrorStruct;
+void InternalSession::PagingFallbackWorked(void)
+{ //The same listing went through without paging arguments, so it was them. Unless a paged reply beat us to it.
+	int8_t Expected = 0;
 	
-	return Coyote::COYOTE_STATUS_OK;
+	this->PagedDiskAssets.compare_exchange_strong(Expected, -1);
 }
 
-Coyote::StatusCode Coyote::Session::GetEffectivePrimary(Coyote::Mirror &Out)
+static std::string JoinSubpath(const std::string &Subpath, const std::string &Filename)
 {
-	DEF_SESS;
-
-	msgpack::zone TempZone;
-	StatusCode Status{};
+	if (Subpath.empty()) return Filename;
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetEffectivePrimary", TempZone, &Status) };
-	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	if (Subpath.back() == '/') return Subpath + Filename;
 	
-	std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Msg.at("Data"), typeid(Coyote::Mirror))) };
+	return Subpath + '/' + Filename;
+}
+
+Coyote::StatusCode Coyote::Session::GetDiskAssetsPage(DiskAssetsPage &Out, const std::string &DriveName, const std::string &Subpath, const std::string &ContinuationToken, const uint32_t PageSize)
+{
+	DEF_SESS;
+	
+	Out.Items.clear();
+	Out.ContinuationToken.clear();
+	
+	bool Paged = PageSize && (!ContinuationToken.empty() || SESS.PagedDiskAssets.load() >= 0);
+	bool Fallback = false;
+	
+	while (true)
+	{
+		POOLED_ZONE(TempZone);
+		StatusCode Status{};
+		
+		const std::unordered_map<std::string, msgpack::object> &Msg { SESS.AwaitReply(SESS.SendDiskAssetsRequest(DriveName, Subpath, ContinuationToken, Paged ? PageSize : 0u), TempZone, &Status) };
+		
+		if (Status != Coyote::COYOTE_STATUS_OK)
+		{
+			if (Paged && ContinuationToken.empty() && SESS.PagingMaybeRefused(Status, Msg))
+			{
+				Paged = false;
+				Fallback = true;
+				continue;
+			}
+			
+			return Status;
+		}
+		
+		if (!SESS.UnpackDiskAssetsPage(Msg, Out)) return Coyote::COYOTE_STATUS_FAILED;
+		
+		if (Fallback) SESS.PagingFallbackWorked();
+		
+		return Coyote::COYOTE_STATUS_OK;
+	}
+}
+
+Coyote::StatusCode Coyote::Session::CrawlDiskAssets(const std::string &DriveName, const std::string &Subpath, const DiskAssetCallback &Callback, const DiskCrawlOptions &Options, DiskCrawlStats *StatsOut)
+{ //Keeps up to MaxConcurrent listings waiting on the unit. Replies are handled in the order they were sent, all on this thread.
+	DEF_SESS;
+	
+	if (!Callback || !Options.MaxConcurrent) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	struct Listing
+	{
+		std::string Subpath;
+		std::string ContinuationToken;
+		uint32_t Depth;
+		bool Paged;
+		bool Fallback; //Retrying unpaged after the unit refused the paged request
+	};
+	
+	std::deque<Listing> Pending { { Subpath, {}, 0u, Options.PageSize != 0u } };
+	std::deque<std::pair<Listing, AsyncToSync::MessageTicket*> > InFlight;
+	
+	struct TicketDrain
+	{ //A malformed page or a throwing callback still has to collect whatever is out, every ticket goes to AwaitReply().
+		InternalSession &Sess;
+		std::deque<std::pair<Listing, AsyncToSync::MessageTicket*> > &InFlight;
+		
+		~TicketDrain(void)
+		{
+			for (const auto &Pair : this->InFlight)
+			{
+				try
+				{
+					POOLED_ZONE(TempZone);
+					
+					this->Sess.AwaitReply(Pair.second, TempZone, nullptr);
+				}
+				catch (...)
+				{ //Already unwinding, the reply itself doesn't matter.
+				}
+			}
+		}
+	} Drain { SESS, InFlight };
+	
+	DiskCrawlStats Stats{};
+	StatusCode RetVal = Coyote::COYOTE_STATUS_OK;
+	bool Stopped = false;
+	
+	while (!InFlight.empty() || (!Stopped && !Pending.empty()))
+	{
+		while (!Stopped && !Pending.empty() && InFlight.size() < Options.MaxConcurrent)
+		{
+			Listing Next { std::move(Pending.front()) };
+			Pending.pop_front();
+			
+			if (Next.ContinuationToken.empty() && SESS.PagedDiskAssets.load() < 0) Next.Paged = false;
+			
+			AsyncToSync::MessageTicket *const Ticket = SESS.SendDiskAssetsRequest(DriveName, Next.Subpath, Next.ContinuationToken, Next.Paged ? Options.PageSize : 0u);
+			
+			++Stats.Requests;
+			
+			InFlight.emplace_back(std::move(Next), Ticket);
+		}
+		
+		Listing Current { std::move(InFlight.front().first) };
+		AsyncToSync::MessageTicket *const Ticket = InFlight.front().second;
+		
+		InFlight.pop_front();
+		
+		POOLED_ZONE(TempZone);
+		StatusCode Status{};
+		
+		const std::unordered_map<std::string, msgpack::object> &Msg { SESS.AwaitReply(Ticket, TempZone, &Status) };
+		
+		if (Stopped) continue; //Only collecting the tickets that were already out
+		
+		DiskAssetsPage Page;
+		
+		if (Status == Coyote::COYOTE_STATUS_OK && !SESS.UnpackDiskAssetsPage(Msg, Page)) Status = Coyote::COYOTE_STATUS_FAILED;
+		
+		if (Status != Coyote::COYOTE_STATUS_OK)
+		{
+			if (Current.Paged && Current.ContinuationToken.empty() && SESS.PagingMaybeRefused(Status, Msg))
+			{
+				Current.Paged = false;
+				Current.Fallback = true;
+				Pending.push_front(std::move(Current));
+				continue;
+			}
+			
+			++Stats.Failed;
+			
+			if (RetVal == Coyote::COYOTE_STATUS_OK) RetVal = Status;
+			
+			//Everything else is going to fail the same way.
+			if (Status == Coyote::COYOTE_STATUS_NETWORKERROR) Stopped = true;
+			
+			continue;
+		}
+		
+		if (Current.Fallback) SESS.PagingFallbackWorked();
+		
+		if (Current.ContinuationToken.empty()) ++Stats.Directories;
+		
+		//The rest of this directory goes ahead of the ones we haven't started yet.
+		if (!Page.ContinuationToken.empty()) Pending.push_front({ Current.Subpath, std::move(Page.ContinuationToken), Current.Depth, true });
+		
+		for (const ExternalAsset &Entry : Page.Items)
+		{
+			++Stats.Entries;
+			
+			if (!Callback(Current.Subpath, Entry))
+			{
+				Stopped = true;
+				break;
+			}
+			
+			if (!Entry.IsDirectory || Entry.Filename.empty() || Entry.Filename == "." || Entry.Filename == "..") continue;
+			
+			if (Options.MaxDepth && Current.Depth >= Options.MaxDepth) continue;
+			
+			Pending.push_back({ JoinSubpath(Current.Subpath, Entry.Filename), {}, Current.Depth + 1u, Options.PageSize != 0u });
+		}
+	}
+	
+	if (StatsOut) *StatsOut = Stats;
+	
+	return RetVal;
+}
+
+Coyote::StatusCode Coyote::Session::GetWatchPaths(std::vector<std::string> &Out)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
+	StatusCode Status{};
+	
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetWatchPaths", {}, TempZone, &Status) };
+	
+	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	
+	Msg.at("Data").convert(Out);
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode Coyote::Session::GetMirrors(std::vector<Coyote::Mirror> &Out)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
+	StatusCode Status{};
+	
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformCachedCommand("GetMirrors", {}, TempZone, &Status) };
+	
+	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	
+	
+	std::vector<msgpack::object> Data;
+
+	Msg.at("Data").convert(Data);
+	
+	for (msgpack::object &Object : Data)
+	{
+		LDEBUG_MSG("Found mirror data");
+		std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Object, typeid(Coyote::Mirror))) };
+		
+		Out.emplace_back(std::move(*MirrorStruct));
+	}
+
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode Coyote::Session::GetDesignatedPrimary(Coyote::Mirror &Out)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
+	StatusCode Status{};
+	
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetDesignatedPrimary", TempZone, &Status) };
+	
+	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	
+	std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Msg.at("Data"), typeid(Coyote::Mirror))) };
+
+	Out = *MirrorStruct;
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode Coyote::Session::GetEffectivePrimary(Coyote::Mirror &Out)
+{
+	DEF_SESS;
+
+	POOLED_ZONE(TempZone);
+	StatusCode Status{};
+	
+	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetEffectivePrimary", TempZone, &Status) };
+	
+	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	
+	std::unique_ptr<Coyote::Mirror> MirrorStruct { static_cast<Coyote::Mirror*>(MsgpackProc::UnpackCoyoteObject(Msg.at("Data"), typeid(Coyote::Mirror))) };
 
 	Out = *MirrorStruct;
 	
@@ -1970,7 +2873,7 @@ Coyote::StatusCode Coyote::Session::DetectUpdate(bool &DetectedOut, std::string
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("DetectUpdate", TempZone, &Status) };
@@ -1989,28 +2892,34 @@ Coyote::StatusCode Coyote::Session::DetectUpdate(bool &DetectedOut, std::string
 
 Coyote::StatusCode Coyote::Session::GetLogsZip(std::vector<uint8_t> &OutBuffer)
 {
-	DEF_SESS;
-
-	msgpack::zone TempZone;	
-	StatusCode Status{};
+	LogStreamOptions Options;
 	
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetLogsZip", TempZone, &Status) };
+	Options.Progress = [&OutBuffer] (const uint64_t, const uint64_t Total) { if (Total > OutBuffer.capacity()) OutBuffer.reserve(Total); };
 	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	OutBuffer.clear();
 	
-	std::unordered_map<std::string, msgpack::object> Data;
+	return this->StreamLogsZip([&OutBuffer] (const uint8_t *Data, const size_t Length) { OutBuffer.insert(OutBuffer.end(), Data, Data + Length); return true; }, Options);
+}
 
-	Msg.at("Data").convert(Data);
+Coyote::StatusCode Coyote::Session::StreamLogsZip(const LogSink &Sink, const LogStreamOptions &Options)
+{
+	DEF_SESS;
 	
-	Data.at("ZipBytes").convert(OutBuffer);
+	return SESS.StreamLogCommand("GetLogsZip", "ZipBytes", {}, Sink, Options);
+}
+
+Coyote::StatusCode Coyote::Session::StreamLogsZipToFD(const int FD, const LogStreamOptions &Options)
+{
+	if (FD < 0) return Coyote::COYOTE_STATUS_MISUSED;
 	
-	return Status;
+	return this->StreamLogsZip(FDSink(FD), Options);
 }
+
 Coyote::StatusCode Coyote::Session::GetKonaAVBufferLevels(std::vector<std::tuple<uint32_t, uint32_t, int64_t>> &OutLevels)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 	StatusCode Status{};
 	
 	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetKonaAVBufferLevels", TempZone, &Status) };
@@ -2049,43 +2958,364 @@ void Coyote::Session::SetStateEventCallback(const StateEventType EType, const St
 	
 	SESS.ASyncSess.SetStateEventCallback(EType, CB, UserData);
 }
+
+void Coyote::Session::SetPresetChangeCallback(const PresetChangeCallback CB, void *const UserData)
+{
+	DEF_SESS;
 	
-Coyote::StatusCode Coyote::Session::ReadLog(const std::string &SpokeName, const int Year, const int Month, const int Day, std::string &LogOut)
+	SESS.ASyncSess.SetPresetChangeCallback(CB, UserData);
+}
+
+void Coyote::Session::SetChangeSetCallback(const ChangeSetCallback CB, void *const UserData)
 {
 	DEF_SESS;
+	
+	SESS.ASyncSess.SetChangeSetCallback(CB, UserData);
+}
 
-	msgpack::zone TempZone;	
-	StatusCode Status{};
+Coyote::StatusCode Coyote::Session::GetLastChangeSet(const StateEventType EType, ChangeSet &Out)
+{
+	DEF_SESS;
 	
+	return SESS.ASyncSess.SubSession.GetLastChangeSet(EType, Out) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_MISUSED;
+}
 
-	LDEBUG_MSG("Building values");
-	const std::unordered_map<std::string, msgpack::object> Values { {"SpokeName", msgpack::object{SpokeName.c_str()} }, { "Year", msgpack::object{Year} }, { "Month", msgpack::object{Month} }, { "Day", msgpack::object{Day} } };
+Coyote::StatusCode Coyote::Session::ConfigureCallbackExecutor(const CallbackExecutorConfig &Config)
+{
+	DEF_SESS;
 	
-	LDEBUG_MSG("Performing conversions");
-	const msgpack::object Pass { MsgpackProc::STLMapToMsgpackMap(Values, TempZone) };
+	return SESS.ASyncSess.SubSession.ConfigureCallbackExecutor(Config) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_MISUSED;
+}
+
+Coyote::CallbackExecutorStats Coyote::Session::GetCallbackExecutorStats(void) const
+{
+	DEF_CONST_SESS;
 	
-	LDEBUG_MSG("Executing method");
-	const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("ReadLog", TempZone, &Status, &Pass) };
+	return SESS.ASyncSess.SubSession.GetCallbackExecutorStats();
+}
+
+uint64_t Coyote::Session::GetStateVersion(const StateEventType EType) const
+{
+	DEF_CONST_SESS;
 	
-	if (Status != Coyote::COYOTE_STATUS_OK) return Status;
+	if (EType < Coyote::COYOTE_STATE_INVALID || EType >= Coyote::COYOTE_STATE_MAX) return 0u;
 	
-	std::unordered_map<std::string, msgpack::object> Data;
+	return SESS.ASyncSess.SubSession.GetStateVersion(EType);
+}
 
-	LDEBUG_MSG("Converting Data");
-	Msg.at("Data").convert(Data);
+Coyote::StatusCode Coyote::Session::WaitForStateChange(uint64_t &VersionOut, const StateEventType EType, const uint64_t LastSeenVersion, const std::chrono::milliseconds Timeout)
+{
+	DEF_SESS;
 	
-	LDEBUG_MSG("Converting LogText");
-	Data.at("LogText").convert(LogOut);
+	if (EType < Coyote::COYOTE_STATE_INVALID || EType >= Coyote::COYOTE_STATE_MAX || EType == Coyote::COYOTE_STATE_MINIVIEW) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	//An inline callback runs on the thread that applies updates, so waiting there could only ever time out.
+	if (CallbackExec::InInlineCallback()) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	return SESS.ASyncSess.SubSession.WaitForStateChange(EType, LastSeenVersion, Timeout, VersionOut) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
 
-	LDEBUG_MSG("Success");
-	return Status;
+bool Coyote::Session::IsStateFromCache(const StateEventType EType) const
+{
+	DEF_CONST_SESS;
+	
+	if (EType <= Coyote::COYOTE_STATE_INVALID || EType >= Coyote::COYOTE_STATE_MAX) return false;
+	
+	return SESS.ASyncSess.SubSession.IsStateFromCache(EType);
+}
+
+Coyote::StatusCode Coyote::Session::FlushStateCache(void)
+{
+	DEF_SESS;
+	
+	if (SESS.StateCacheDir.empty()) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	return SESS.ASyncSess.SubSession.FlushStateCache() ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
+
+Coyote::StatusCode Coyote::Session::StartTrafficCapture(const std::string &Path)
+{
+	DEF_SESS;
+	
+	std::shared_ptr<WireTrace::Recorder> NewCapture { std::make_shared<WireTrace::Recorder>() };
+	
+	if (!NewCapture->Open(Path)) return Coyote::COYOTE_STATUS_FAILED;
+	
+	const std::shared_ptr<WireTrace::Recorder> Previous { std::atomic_exchange(&SESS.Capture, NewCapture) };
+	
+	if (SESS.Connection) SESS.Connection->SetRecorder(NewCapture);
+	
+	if (Previous) Previous->Close();
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+void Coyote::Session::StopTrafficCapture(void)
+{
+	DEF_SESS;
+	
+	const std::shared_ptr<WireTrace::Recorder> Previous { std::atomic_exchange(&SESS.Capture, std::shared_ptr<WireTrace::Recorder>{}) };
+	
+	if (SESS.Connection) SESS.Connection->SetRecorder(nullptr);
+	
+	//The network thread may still be holding on to it for one last message, closing makes that a no-op.
+	if (Previous) Previous->Close();
+}
+
+Coyote::StatusCode Coyote::Session::ReplayTraffic(const std::string &Path, const TrafficReplayOptions &Options, TrafficReplayStats *StatsOut)
+{
+	DEF_SESS;
+	
+	//Live traffic would interleave with the capture.
+	if (SESS.Connection || !(Options.Speed > 0.0)) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	WireTrace::Reader Capture;
+	
+	if (!Capture.Open(Path)) return Coyote::COYOTE_STATUS_FAILED;
+	
+	TrafficReplayStats Stats{};
+	WireTrace::Record Item;
+	bool HaveBase = false;
+	uint64_t BaseUs = 0u;
+	
+	const std::chrono::steady_clock::time_point Started { std::chrono::steady_clock::now() };
+	
+	while (Capture.Next(Item))
+	{
+		MsgpackProc::MessageHeaders Headers;
+		
+		//Command replies have no ticket waiting for them offline, and what we sent is only in there for reading.
+		if (Item.Direction != WireTrace::Incoming || (MsgpackProc::ScanHeaders(Item.Body.data(), Item.Body.size(), Headers) && Headers.HasMsgID))
+		{
+			++Stats.Skipped;
+			continue;
+		}
+		
+		if (Options.OriginalPacing)
+		{ //Paced from the first message we replay, so a capture started well before any traffic doesn't open with a long sleep.
+			if (!HaveBase)
+			{
+				BaseUs = Item.OffsetUs;
+				HaveBase = true;
+			}
+			
+			const std::chrono::microseconds Due { static_cast<int64_t>((Item.OffsetUs - BaseUs) / Options.Speed) };
+			
+			std::this_thread::sleep_until(Started + Due);
+		}
+		
+		Stats.Bytes += Item.Body.size();
+		
+		if (SESS.ProcessIncoming(new WSMessage(Item.Body.data(), Item.Body.size()))) ++Stats.Messages;
+		else ++Stats.Failed;
+	}
+	
+	//Big events are still being applied on the decode strand, and they count.
+	while (SESS.ASyncSess.Decoder.Busy()) std::this_thread::sleep_for(std::chrono::microseconds(50));
+	
+	Stats.Elapsed = std::chrono::steady_clock::now() - Started;
+	
+	if (StatsOut) *StatsOut = Stats;
+	
+	return Coyote::COYOTE_STATUS_OK;
+}
+
+Coyote::StatusCode Coyote::Session::SetSubscriptions(const uint32_t Flags)
+{
+	DEF_SESS;
+	
+	if (Flags & ~Coyote::COYOTE_SUB_ALL) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	const uint32_t Previous = SESS.ASyncSess.SubSession.SetSubscriptions(Flags);
+	const uint32_t Added = Flags & ~Previous;
+	
+	if (!Added || !SESS.Connection) return Coyote::COYOTE_STATUS_OK; //A reconnect subscribes to everything in Flags anyways.
+	
+	POOLED_ZONE(TempZone);
+	
+	if ((Added & Coyote::COYOTE_SUB_HWSTATE) && SESS.MonitorOnly && SESS.SupportedSinks.empty())
+	{ //Monitor sessions only ask for sinks when they need them.
+		Coyote::StatusCode S = Coyote::COYOTE_STATUS_INVALID;
+		
+		const std::unordered_map<std::string, msgpack::object> &Msg { SESS.PerformSyncedCommand("GetSupportedSinks", TempZone, &S) };
+		
+		if (S != Coyote::COYOTE_STATUS_OK) return S;
+		
+		std::unordered_map<std::string, msgpack::object> Data;
+		Msg.at("Data").convert(Data);
+		
+		Data.at("SupportedSinks").convert(SESS.SupportedSinks);
+	}
+	
+	return SESS.SendSubscriptions(Added, TempZone) ? Coyote::COYOTE_STATUS_OK : Coyote::COYOTE_STATUS_FAILED;
+}
+
+uint32_t Coyote::Session::GetSubscriptions(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.ASyncSess.SubSession.GetSubscriptions();
+}
+
+Coyote::Subscription Coyote::Session::OnTimeCode(TimeCodeHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnTimeCode(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnAssetPost(AssetPostHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnAssetPost(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnAssetDelete(AssetDeleteHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnAssetDelete(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnAssetSync(AssetSyncHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnAssetSync(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnPresets(PresetsHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnPresets(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnPresetStates(PresetStatesHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnPresetStates(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnPresetChange(PresetChangeHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnPresetChange(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnKonaHardwareState(HWStateHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnKonaHardwareState(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnPlaybackEvent(PlaybackEventHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnPlaybackEvent(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnMiniview(MiniviewHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnMiniview(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnMiniviewFrame(MiniviewFrameHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnMiniviewFrame(std::move(Handler));
+}
+
+Coyote::Subscription Coyote::Session::OnStateEvent(const StateEventType EType, StateEventHandler Handler)
+{
+	DEF_SESS;
+	
+	return SESS.ASyncSess.SubSession.OnStateEvent(EType, std::move(Handler));
+}
+	
+Coyote::StatusCode Coyote::Session::ReadLog(const std::string &SpokeName, const int Year, const int Month, const int Day, std::string &LogOut)
+{
+	LogStreamOptions Options;
+	
+	Options.Progress = [&LogOut] (const uint64_t, const uint64_t Total) { if (Total > LogOut.capacity()) LogOut.reserve(Total); };
+	
+	LogOut.clear();
+	
+	return this->StreamLog(SpokeName, Year, Month, Day, [&LogOut] (const uint8_t *Data, const size_t Length) { LogOut.append(reinterpret_cast<const char*>(Data), Length); return true; }, Options);
+}
+
+Coyote::StatusCode Coyote::Session::StreamLog(const std::string &SpokeName, const int Year, const int Month, const int Day, const LogSink &Sink, const LogStreamOptions &Options)
+{
+	DEF_SESS;
+	
+	std::unordered_map<std::string, msgpack::object> Values { {"SpokeName", msgpack::object{SpokeName.c_str()} }, { "Year", msgpack::object{Year} }, { "Month", msgpack::object{Month} }, { "Day", msgpack::object{Day} } };
+	
+	return SESS.StreamLogCommand("ReadLog", "LogText", std::move(Values), Sink, Options);
+}
+
+Coyote::StatusCode Coyote::Session::StreamLogToFD(const std::string &SpokeName, const int Year, const int Month, const int Day, const int FD, const LogStreamOptions &Options)
+{
+	if (FD < 0) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	return this->StreamLog(SpokeName, Year, Month, Day, FDSink(FD), Options);
+}
+
+Coyote::StatusCode Coyote::Session::ReadLogs(const std::vector<LogDay> &Days, std::vector<LogDayResult> &Out, const uint32_t MaxConcurrent)
+{ //Replies are matched to their requests by MsgID, so several days can be in flight at once.
+	if (!MaxConcurrent) return Coyote::COYOTE_STATUS_MISUSED;
+	
+	Out.assign(Days.size(), LogDayResult{ Coyote::COYOTE_STATUS_FAILED, {} });
+	
+	if (Days.empty()) return Coyote::COYOTE_STATUS_OK;
+	
+	std::atomic<size_t> Next { 0u };
+	
+	auto Worker = [this, &Days, &Out, &Next]
+	{
+		for (size_t Index = Next++; Index < Days.size(); Index = Next++)
+		{
+			const LogDay &Item { Days[Index] };
+			
+			try
+			{
+				Out[Index].Status = this->ReadLog(Item.SpokeName, Item.Year, Item.Month, Item.Day, Out[Index].LogText);
+			}
+			catch (const std::exception &)
+			{ //Malformed reply. Nothing would catch it on a helper thread.
+				Out[Index].Status = Coyote::COYOTE_STATUS_FAILED;
+			}
+		}
+	};
+	
+	std::vector<std::thread> Helpers;
+	
+	for (size_t Inc = 1u; Inc < std::min<size_t>(MaxConcurrent, Days.size()); ++Inc) Helpers.emplace_back(Worker);
+	
+	Worker();
+	
+	for (std::thread &Helper : Helpers) Helper.join();
+	
+	for (const LogDayResult &Result : Out)
+	{
+		if (Result.Status != Coyote::COYOTE_STATUS_OK) return Result.Status;
+	}
+	
+	return Coyote::COYOTE_STATUS_OK;
 }
 
 Coyote::StatusCode Coyote::Session::SetUnitNickname(const std::string &Nickname)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2102,7 +3332,7 @@ Coyote::StatusCode Coyote::Session::ExportLogsZip(const std::string &Mountpoint)
 {
 	DEF_SESS;
 
-	msgpack::zone TempZone;
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2119,7 +3349,7 @@ Coyote::StatusCode Coyote::Session::_SVS_WriteCytLog_(const std::string &Param1,
 { //This function is intended for Sonoran Video Systems use only. Use by users will either not work or just confuse unit logs.
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2135,7 +3365,7 @@ Coyote::StatusCode Coyote::Session::_SVS_RegisterPing_(const std::string &Param1
 { //This function is intended for Sonoran Video Systems use only. Use by users will either not work or just confuse unit logs.
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2151,7 +3381,7 @@ Coyote::StatusCode Coyote::Session::_SVS_RegisterReady_(const std::string &Param
 { //This function is intended for Sonoran Video Systems use only. Use by users will either not work or just confuse unit logs.
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2166,7 +3396,7 @@ Coyote::StatusCode Coyote::Session::_SVS_APID_(const std::string &Param1, const
 { //This function is intended for Sonoran Video Systems use only. Use by users will either not work or just confuse unit logs.
 	DEF_SESS;
 
-	msgpack::zone TempZone;	
+	POOLED_ZONE(TempZone);
 
 	StatusCode Status{};
 	
@@ -2193,6 +3423,28 @@ void Coyote::Session::SetCommandTimeoutSecs(const time_t TimeoutSecs)
 	SESS.TimeoutSecs = TimeoutSecs;
 }
 
+void Coyote::Session::SetResponseCacheTTL(const std::string &CommandName, const std::chrono::milliseconds TTL)
+{
+	DEF_SESS;
+	
+	SESS.Responses.SetTTL(CommandName, TTL);
+}
+
+void Coyote::Session::InvalidateResponseCache(const std::string &CommandName)
+{
+	DEF_SESS;
+	
+	if (CommandName.empty()) SESS.Responses.InvalidateAll();
+	else SESS.Responses.Invalidate(CommandName);
+}
+
+Coyote::ResponseCacheStats Coyote::Session::GetResponseCacheStats(void) const
+{
+	DEF_CONST_SESS;
+	
+	return SESS.Responses.GetStats();
+}
+
 void SessionSneak_DeactivateConnection(void *Ptr)
 {
 	InternalSession &SESS = *static_cast<InternalSession*>(Ptr);
@@ -0,0 +1,416 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "msgpack.hpp"
+#include "statecache.h"
+
+#include <cstdio>
+#include <ctime>
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#endif //WIN32
+
+static constexpr const char *Magic = "coyotestate";
+
+namespace
+{
+	class MappedFile
+	{ //Read only view of a whole file.
+	private:
+		const char *Data;
+		size_t Size;
+	public:
+		inline const char *GetData(void) const { return this->Data; }
+		inline size_t GetSize(void) const { return this->Size; }
+		
+		bool Open(const std::string &Path);
+		
+		MappedFile(void) : Data(), Size() {}
+		~MappedFile(void);
+		
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+	};
+}
+
+#ifdef WIN32
+bool MappedFile::Open(const std::string &Path)
+{
+	const HANDLE File = CreateFileA(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	
+	if (File == INVALID_HANDLE_VALUE) return false;
+	
+	LARGE_INTEGER FileSize{};
+	
+	if (!GetFileSizeEx(File, &FileSize) || !FileSize.QuadPart)
+	{
+		CloseHandle(File);
+		return false;
+	}
+	
+	const HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	
+	CloseHandle(File);
+	
+	if (!Mapping) return false;
+	
+	//The view keeps the mapping alive on its own.
+	this->Data = static_cast<const char*>(MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+	
+	CloseHandle(Mapping);
+	
+	if (!this->Data) return false;
+	
+	this->Size = static_cast<size_t>(FileSize.QuadPart);
+	
+	return true;
+}
+
+MappedFile::~MappedFile(void)
+{
+	if (this->Data) UnmapViewOfFile(this->Data);
+}
+#else
+bool MappedFile::Open(const std::string &Path)
+{
+	const int FD = open(Path.c_str(), O_RDONLY);
+	
+	if (FD < 0) return false;
+	
+	struct stat Info{};
+	
+	if (fstat(FD, &Info) != 0 || Info.st_size <= 0)
+	{
+		close(FD);
+		return false;
+	}
+	
+	void *const Mapped = mmap(nullptr, static_cast<size_t>(Info.st_size), PROT_READ, MAP_PRIVATE, FD, 0);
+	
+	close(FD); //The mapping stays valid without it.
+	
+	if (Mapped == MAP_FAILED) return false;
+	
+	this->Data = static_cast<const char*>(Mapped);
+	this->Size = static_cast<size_t>(Info.st_size);
+	
+	return true;
+}
+
+MappedFile::~MappedFile(void)
+{
+	if (this->Data) munmap(const_cast<char*>(this->Data), this->Size);
+}
+#endif //WIN32
+
+static std::string FileFor(const std::string &Directory, const std::string &GUID)
+{ //GUIDs come off the network, so nothing in one gets to reach the filesystem as anything but a plain name.
+	std::string Name;
+	Name.reserve(GUID.size());
+	
+	for (const char Char : GUID)
+	{
+		const bool Safe = (Char >= 'a' && Char <= 'z') || (Char >= 'A' && Char <= 'Z') || (Char >= '0' && Char <= '9') || Char == '-' || Char == '_';
+		
+		Name += Safe ? Char : '_';
+	}
+	
+	return Directory + '/' + Name + StateCache::Extension;
+}
+
+static std::vector<std::string> ListCacheFiles(const std::string &Directory)
+{
+	std::vector<std::string> RetVal;
+	const std::string Suffix { StateCache::Extension };
+
+#ifdef WIN32
+	WIN32_FIND_DATAA Found{};
+	const HANDLE Search = FindFirstFileA((Directory + "\\*" + Suffix).c_str(), &Found);
+	
+	if (Search == INVALID_HANDLE_VALUE) return RetVal;
+	
+	do
+	{
+		RetVal.push_back(Directory + '/' + Found.cFileName);
+	} while (FindNextFileA(Search, &Found));
+	
+	FindClose(Search);
+#else
+	DIR *const Dir = opendir(Directory.c_str());
+	
+	if (!Dir) return RetVal;
+	
+	while (const struct dirent *const Entry = readdir(Dir))
+	{
+		const std::string Name { Entry->d_name };
+		
+		if (Name.size() > Suffix.size() && !Name.compare(Name.size() - Suffix.size(), Suffix.size(), Suffix)) RetVal.push_back(Directory + '/' + Name);
+	}
+	
+	closedir(Dir);
+#endif //WIN32
+	
+	return RetVal;
+}
+
+static bool ReadHeader(const MappedFile &File, size_t &Offset, StateCache::CachedState &Out)
+{
+	try
+	{
+		msgpack::zone TempZone;
+		const msgpack::object Header { msgpack::unpack(TempZone, File.GetData(), File.GetSize(), Offset) };
+		
+		if (Header.type != msgpack::type::ARRAY || Header.via.array.size < 6u) return false;
+		
+		const msgpack::object *const Fields = Header.via.array.ptr;
+		
+		if (Fields[0].as<std::string>() != Magic || Fields[1].as<uint32_t>() != StateCache::FormatVersion) return false;
+		
+		Fields[2].convert(Out.GUID);
+		Fields[3].convert(Out.Host);
+		Fields[4].convert(Out.SavedAt);
+		Fields[5].convert(Out.Contents);
+	}
+	catch (const std::exception &Err)
+	{
+		LDEBUG_MSG("Bad state cache header: " << Err.what());
+		return false;
+	}
+	
+	return true;
+}
+
+static bool ReadBody(const MappedFile &File, size_t &Offset, StateCache::CachedState &Out)
+{
+	try
+	{
+		msgpack::zone TempZone;
+		const msgpack::object Body { msgpack::unpack(TempZone, File.GetData(), File.GetSize(), Offset) };
+		
+		if (Body.type != msgpack::type::ARRAY || Body.via.array.size < 4u) return false;
+		
+		const msgpack::object *const Fields = Body.via.array.ptr;
+		
+		Fields[0].convert(Out.Presets);
+		Fields[1].convert(Out.PresetStates);
+		Fields[2].convert(Out.Assets);
+		Fields[3].convert(Out.HWState);
+	}
+	catch (const std::exception &Err)
+	{
+		LDEBUG_MSG("Bad state cache body: " << Err.what());
+		return false;
+	}
+	
+	return true;
+}
+
+bool StateCache::Load(const std::string &Directory, const std::string &GUID, const std::string &Host, CachedState &Out)
+{
+	std::string Path;
+	
+	if (!GUID.empty()) Path = FileFor(Directory, GUID);
+	else
+	{ //Only headers get decoded here, the maps just page in the first few hundred bytes of each.
+		int64_t Newest = INT64_MIN;
+		
+		for (const std::string &Candidate : ListCacheFiles(Directory))
+		{
+			MappedFile File;
+			size_t Offset = 0u;
+			CachedState Header;
+			
+			if (!File.Open(Candidate) || !ReadHeader(File, Offset, Header) || Header.Host != Host || Header.SavedAt <= Newest) continue;
+			
+			Newest = Header.SavedAt;
+			Path = Candidate;
+		}
+		
+		if (Path.empty()) return false;
+	}
+	
+	MappedFile File;
+	size_t Offset = 0u;
+	CachedState Loaded;
+	
+	if (!File.Open(Path) || !ReadHeader(File, Offset, Loaded)) return false;
+	if (!GUID.empty() && Loaded.GUID != GUID) return false;
+	if (!ReadBody(File, Offset, Loaded)) return false;
+	
+	Out = std::move(Loaded);
+	
+	return true;
+}
+
+bool StateCache::Save(const std::string &Directory, const CachedState &State)
+{
+	if (State.GUID.empty()) return false;
+	
+	msgpack::sbuffer Buffer;
+	msgpack::packer<msgpack::sbuffer> Pack { Buffer };
+	
+	Pack.pack_array(6);
+	Pack.pack(std::string{ Magic });
+	Pack.pack(FormatVersion);
+	Pack.pack(State.GUID);
+	Pack.pack(State.Host);
+	Pack.pack(State.SavedAt);
+	Pack.pack(State.Contents);
+	
+	Pack.pack_array(4);
+	Pack.pack(State.Presets);
+	Pack.pack(State.PresetStates);
+	Pack.pack(State.Assets);
+	Pack.pack(State.HWState);
+
+#ifdef WIN32
+	CreateDirectoryA(Directory.c_str(), nullptr);
+#else
+	mkdir(Directory.c_str(), 0755);
+#endif //WIN32
+	
+	const std::string Path { FileFor(Directory, State.GUID) };
+	const std::string TempPath { Path + ".tmp" };
+	
+	FILE *const Desc = fopen(TempPath.c_str(), "wb");
+	
+	if (!Desc) return false;
+	
+	const bool Written = fwrite(Buffer.data(), 1u, Buffer.size(), Desc) == Buffer.size();
+	
+	if (fclose(Desc) != 0 || !Written)
+	{
+		remove(TempPath.c_str());
+		return false;
+	}
+
+#ifdef WIN32
+	const bool Renamed = MoveFileExA(TempPath.c_str(), Path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+	const bool Renamed = rename(TempPath.c_str(), Path.c_str()) == 0;
+#endif //WIN32
+	
+	if (!Renamed) remove(TempPath.c_str());
+	
+	return Renamed;
+}
+
+StateCache::Writer::Writer(const std::string &Directory, std::function<void(CachedState &Out)> Capture)
+	: Directory(Directory), Capture(std::move(Capture)), Dirty(), Stopping()
+{
+	this->Worker = std::thread { &Writer::WorkerLoop, this };
+}
+
+StateCache::Writer::~Writer(void)
+{
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		this->Stopping = true;
+	}
+	
+	this->Wake.notify_all();
+	
+	if (this->Worker.joinable()) this->Worker.join();
+}
+
+void StateCache::Writer::NoteChanged(void)
+{
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		if (this->Dirty) return;
+		
+		this->Dirty = true;
+	}
+	
+	this->Wake.notify_all();
+}
+
+void StateCache::Writer::SetIdentity(const std::string &GUID, const std::string &Host)
+{
+	{
+		const std::lock_guard<std::mutex> G { this->Lock };
+		
+		this->GUID = GUID;
+		this->Host = Host;
+	}
+	
+	this->Wake.notify_all();
+}
+
+bool StateCache::Writer::Flush(void)
+{
+	std::unique_lock<std::mutex> G { this->Lock };
+	
+	return this->SaveLocked(G);
+}
+
+bool StateCache::Writer::SaveLocked(std::unique_lock<std::mutex> &G)
+{ //Unlocks around the capture and the write, so NoteChanged() never waits on the disk.
+	if (this->GUID.empty()) return false;
+	
+	CachedState State;
+	
+	State.GUID = this->GUID;
+	State.Host = this->Host;
+	this->Dirty = false;
+	
+	G.unlock();
+	
+	bool RetVal;
+	
+	{
+		const std::lock_guard<std::mutex> WG { this->WriteLock };
+		
+		this->Capture(State);
+		State.SavedAt = static_cast<int64_t>(time(nullptr));
+		
+		RetVal = Save(this->Directory, State);
+	}
+	
+	if (!RetVal) std::cerr << "libcoyote: Failed to write state cache for unit " << State.GUID << " to " << this->Directory << std::endl;
+	
+	G.lock();
+	
+	return RetVal;
+}
+
+void StateCache::Writer::WorkerLoop(void)
+{
+	std::unique_lock<std::mutex> G { this->Lock };
+	
+	while (true)
+	{
+		this->Wake.wait(G, [this] { return this->Stopping || (this->Dirty && !this->GUID.empty()); });
+		
+		if (this->Stopping) break;
+		
+		//Give a burst of asset posts time to finish, so it all goes out in one write.
+		this->Wake.wait_for(G, SaveDelay, [this] { return this->Stopping; });
+		
+		this->SaveLocked(G);
+	}
+	
+	//Whatever changed in the last few seconds still gets saved on the way out.
+	if (this->Dirty) this->SaveLocked(G);
+}
@@ -0,0 +1,83 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_STATECACHE_H__
+#define __LIBCOYOTE_STATECACHE_H__
+
+#include "include/common.h"
+#include "include/datastructures.h"
+
+#include <condition_variable>
+
+/**Last known subscription state, kept on disk per unit so a new session has something to show before the unit resyncs.
+ * One file per unit GUID in the cache directory. Each file is two msgpack objects back to back: a small header naming the unit
+ * and the host it was reached at, then the state itself. Reading maps the file, so picking the right one out of a directory
+ * only ever touches headers. Writes go to a temporary file that's renamed over the old one, so a crash never leaves half a cache.**/
+
+namespace StateCache
+{
+	static constexpr uint32_t FormatVersion = 1;
+	static constexpr const char *Extension = ".coyotestate";
+	static constexpr std::chrono::milliseconds SaveDelay { 2000 }; //Changes are batched up for this long before writing
+	
+	struct CachedState
+	{
+		std::string GUID;
+		std::string Host;
+		int64_t SavedAt; //Unix time
+		uint32_t Contents; //1 << StateEventType, for each kind of state that was subscribed when saved
+		std::vector<Coyote::Preset> Presets;
+		std::vector<Coyote::PresetState> PresetStates;
+		std::vector<Coyote::Asset> Assets;
+		Coyote::KonaHardwareState HWState;
+		
+		CachedState(void) : SavedAt(), Contents(), HWState() {}
+	};
+	
+	//With an empty GUID, takes the newest file last saved for Host.
+	bool Load(const std::string &Directory, const std::string &GUID, const std::string &Host, CachedState &Out);
+	bool Save(const std::string &Directory, const CachedState &State);
+	
+	class Writer
+	{ //Saves on its own thread, so bursts of changes cost one write and the subscription thread never waits on the disk.
+	private:
+		std::mutex Lock;
+		std::mutex WriteLock; //Flush() and the worker both write the same file. Never taken while holding Lock.
+		std::condition_variable Wake;
+		std::thread Worker;
+		const std::string Directory;
+		const std::function<void(CachedState &Out)> Capture; //Fills in everything but the identity
+		std::string GUID; //Protected by Lock. Nothing gets written until this is known.
+		std::string Host; //Protected by Lock
+		bool Dirty; //Protected by Lock
+		bool Stopping; //Protected by Lock
+		
+		void WorkerLoop(void);
+		bool SaveLocked(std::unique_lock<std::mutex> &G);
+	public:
+		void NoteChanged(void);
+		void SetIdentity(const std::string &GUID, const std::string &Host);
+		bool Flush(void);
+		
+		Writer(const std::string &Directory, std::function<void(CachedState &Out)> Capture);
+		~Writer(void);
+		
+		Writer(const Writer &) = delete;
+		Writer &operator=(const Writer &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_STATECACHE_H__
@@ -16,249 +16,877 @@
 
 #include "subscriptions.h"
 #include "msgpackproc.h"
+#include "wireschema.h"
+#include "decodeworker.h"
 #include <mutex>
 
-static const std::unordered_map<std::string, Coyote::StateEventType> CBMap
+namespace
 {
-	{ "PresetsUpdate", Coyote::COYOTE_STATE_PRESETS },
-	{ "PresetStatesUpdate", Coyote::COYOTE_STATE_PRESETSTATES },
-	{ "TimeCode", Coyote::COYOTE_STATE_TIMECODE },
-	{ "AssetSync", Coyote::COYOTE_STATE_ASSETS },
-	{ "AssetPost", Coyote::COYOTE_STATE_ASSETS },
-	{ "AssetDelete", Coyote::COYOTE_STATE_ASSETS },
-	{ "KonaHardwareStateUpdate", Coyote::COYOTE_STATE_HWSTATE },
-};
+	//Indexed by Subs::EventID, so every name is hashed once at compile time and dispatch is a table lookup.
+	constexpr const char *const EventNames[] =
+	{
+		"TimeCode",
+		"MiniviewPost",
+		"PresetsUpdate",
+		"PresetStatesUpdate",
+		"AssetSync",
+		"AssetDelete",
+		"AssetPost",
+		"KonaHardwareStateUpdate",
+		"PlaybackEvent",
+	};
 	
-bool Subs::SubscriptionSession::ProcessSubscriptionEvent(const std::unordered_map<std::string, msgpack::object> &Values)
-{
-	if (!Values.count("SubscriptionEvent") || !Values.count("Data")) return false; //Not a subscription event
+	constexpr Subs::EventID EventValues[] =
+	{
+		Subs::EventID::TimeCode,
+		Subs::EventID::MiniviewPost,
+		Subs::EventID::PresetsUpdate,
+		Subs::EventID::PresetStatesUpdate,
+		Subs::EventID::AssetSync,
+		Subs::EventID::AssetDelete,
+		Subs::EventID::AssetPost,
+		Subs::EventID::KonaHardwareStateUpdate,
+		Subs::EventID::PlaybackEvent,
+	};
+	
+	constexpr Coyote::StateEventType EventStateTypes[] =
+	{ //Which coarse state callback an event feeds, if any.
+		Coyote::COYOTE_STATE_TIMECODE,
+		Coyote::COYOTE_STATE_INVALID,
+		Coyote::COYOTE_STATE_PRESETS,
+		Coyote::COYOTE_STATE_PRESETSTATES,
+		Coyote::COYOTE_STATE_ASSETS,
+		Coyote::COYOTE_STATE_ASSETS,
+		Coyote::COYOTE_STATE_ASSETS,
+		Coyote::COYOTE_STATE_HWSTATE,
+		Coyote::COYOTE_STATE_INVALID,
+	};
+	
+	constexpr uint32_t EventSubscriptionFlags[] =
+	{ //Which SubscriptionFlags feed an event comes from. Miniviews are subscribed per PK instead, so they always get through.
+		Coyote::COYOTE_SUB_TIMECODE,
+		Coyote::COYOTE_SUB_NONE,
+		Coyote::COYOTE_SUB_PRESETS,
+		Coyote::COYOTE_SUB_PRESETSTATES,
+		Coyote::COYOTE_SUB_ASSETS,
+		Coyote::COYOTE_SUB_ASSETS,
+		Coyote::COYOTE_SUB_ASSETS,
+		Coyote::COYOTE_SUB_HWSTATE,
+		Coyote::COYOTE_SUB_PLAYBACKEVENTS,
+	};
+	
+	constexpr bool EventReplacesState[] =
+	{ //Events carrying the whole of their state, not just a change to it. Once one arrives, cached state of that type is gone.
+		false,
+		false,
+		true,
+		true,
+		true,
+		false,
+		false,
+		true,
+		false,
+	};
+	
+	constexpr size_t NumEvents = static_cast<size_t>(Subs::EventID::Max);
+	
+	static_assert(sizeof EventNames / sizeof *EventNames == NumEvents, "EventNames out of sync with Subs::EventID");
+	static_assert(sizeof EventValues / sizeof *EventValues == NumEvents, "EventValues out of sync with Subs::EventID");
+	static_assert(sizeof EventStateTypes / sizeof *EventStateTypes == NumEvents, "EventStateTypes out of sync with Subs::EventID");
+	static_assert(sizeof EventSubscriptionFlags / sizeof *EventSubscriptionFlags == NumEvents, "EventSubscriptionFlags out of sync with Subs::EventID");
+	static_assert(sizeof EventReplacesState / sizeof *EventReplacesState == NumEvents, "EventReplacesState out of sync with Subs::EventID");
+	
+	constexpr struct
+	{
+		Coyote::StateEventType EType;
+		uint32_t Flag;
+	} PersistedStates[] =
+	{ //What the state cache keeps, and which feed each comes from.
+		{ Coyote::COYOTE_STATE_PRESETS, Coyote::COYOTE_SUB_PRESETS },
+		{ Coyote::COYOTE_STATE_PRESETSTATES, Coyote::COYOTE_SUB_PRESETSTATES },
+		{ Coyote::COYOTE_STATE_ASSETS, Coyote::COYOTE_SUB_ASSETS },
+		{ Coyote::COYOTE_STATE_HWSTATE, Coyote::COYOTE_SUB_HWSTATE },
+	};
+	
+	constexpr size_t ParallelDecodeChunk = 512; //Below this many items per chunk, handing work to other threads costs more than it saves.
+	
+	constexpr auto EventTable = WireSchema::BuildPerfectTable<Subs::EventID, NumEvents, 32>(EventNames, EventValues);
+}
 
-	const std::string &EventName = Values.at("SubscriptionEvent").as<std::string>();
+template <typename T>
+static Coyote::ChangeSet DiffByPK(const std::unordered_map<int32_t, std::shared_ptr<const T> > &Current, std::unordered_map<int32_t, T> &&Incoming,
+									std::unordered_map<int32_t, std::shared_ptr<const T> > &Next)
+{ //Next ends up with the incoming state, but anything that didn't change is the entry from Current, shared rather than replaced.
+	Coyote::ChangeSet Changes;
+	
+	for (const auto &Pair : Current)
+	{
+		if (!Incoming.count(Pair.first)) Changes.Removed.push_back(Pair.first);
+	}
 	
-	bool RetVal = false;
+	Next.reserve(Incoming.size());
 	
-	if 		(EventName == "TimeCode")
+	for (auto &Pair : Incoming)
 	{
-		std::unique_ptr<Coyote::TimeCode> TC { static_cast<Coyote::TimeCode*>(MsgpackProc::UnpackCoyoteObject(Values.at("Data"), typeid(Coyote::TimeCode))) };
+		const auto Existing = Current.find(Pair.first);
 		
-		if (!TC)
+		if (Existing == Current.end())
 		{
-			RetVal = true;
-			goto End;
+			Changes.Added.push_back(Pair.first);
+			Next.emplace(Pair.first, std::make_shared<const T>(std::move(Pair.second)));
+			continue;
 		}
 		
-		std::lock_guard<std::mutex> G { this->TimeCodesLock };
+		const uint32_t Fields = Existing->second->Diff(Pair.second);
 		
-		this->TimeCodes[TC->PK] = *TC;
+		if (!Fields)
+		{
+			Next.emplace(Pair.first, Existing->second);
+			continue;
+		}
 		
-		RetVal = true;
+		Changes.Modified.push_back({ Pair.first, Fields });
+		Next.emplace(Pair.first, std::make_shared<const T>(std::move(Pair.second)));
 	}
-	else if (EventName == "MiniviewPost")
-	{
-		if (this->MiniviewCB)
+	
+	return Changes;
+}
+
+template <typename T>
+static std::unordered_map<int32_t, T> *Unshare(const std::unordered_map<int32_t, std::shared_ptr<const T> > &Shared)
+{
+	std::unordered_map<int32_t, T> *const RetVal = new std::unordered_map<int32_t, T>;
+	
+	RetVal->reserve(Shared.size());
+	
+	for (const auto &Pair : Shared) RetVal->emplace(Pair.first, *Pair.second);
+	
+	return RetVal;
+}
+
+template <typename T>
+static std::vector<T> DecodeArray(const msgpack::object &Data)
+{ //Items are independent, so big arrays get decoded on several cores. Each slot is only ever touched by one chunk.
+	std::vector<msgpack::object> Objects;
+	
+	Data.convert(Objects);
+	
+	std::vector<T> RetVal(Objects.size());
+	
+	DecodeWork::ParallelFor(Objects.size(), ParallelDecodeChunk, [&Objects, &RetVal] (const size_t Begin, const size_t End)
 		{
-			std::unordered_map<std::string, msgpack::object> Map;
+			for (size_t Inc = Begin; Inc < End; ++Inc)
+			{
+				std::unique_ptr<T> Item { static_cast<T*>(MsgpackProc::UnpackCoyoteObject(Objects[Inc], typeid(T))) };
+				
+				RetVal[Inc] = std::move(*Item);
+			}
+		});
+	
+	return RetVal;
+}
 
-			Values.at("Data").convert(Map);
-			
-			const int32_t PK = Map.at("PK").as<int32_t>();
-			const uint32_t CanvasIndex = Map.at("CanvasIndex").as<uint32_t>();
-			const uint32_t OutputNum = Map.at("OutputNum").as<uint32_t>();
-			const int32_t Width = Map.at("Width").as<int32_t>();
-			const int32_t Height = Map.at("Height").as<int32_t>();
-			std::vector<uint8_t> Bytes;
-
-			Map.at("Bytes").convert(Bytes);
-			
-			this->MiniviewCB(PK, CanvasIndex, OutputNum, Coyote::Size2D { Width, Height }, std::move(Bytes), this->MiniviewCBData);
-		}
+template <typename T>
+static std::unordered_map<int32_t, T> DecodeByPK(const msgpack::object &Data)
+{
+	std::vector<T> Items { DecodeArray<T>(Data) };
+	
+	std::unordered_map<int32_t, T> RetVal;
+	RetVal.reserve(Items.size());
+	
+	for (T &Item : Items)
+	{
+		const int32_t PK = Item.PK;
+		
+		RetVal.emplace(PK, std::move(Item));
+	}
+	
+	return RetVal;
+}
+
+void Subs::SubscriptionSession::Post(const Subs::EventID ID, const uint64_t SubKey, const uint32_t CoalesceFlag, std::function<void(void)> Func)
+{
+	const bool Coalesce = CoalesceFlag && (this->CoalesceMask.load() & CoalesceFlag);
+	
+	//These are relative to the delivery before them, losing one would quietly corrupt everything a client builds from the rest.
+	const bool Delta = ID == Subs::EventID::PresetsUpdate || ID == Subs::EventID::PresetStatesUpdate ||
+						ID == Subs::EventID::AssetPost || ID == Subs::EventID::AssetDelete;
+	
+	this->Executor.Post(std::move(Func), Coalesce ? CallbackExec::MakeKey(static_cast<uint8_t>(ID) + 1, SubKey) : 0u, !Delta);
+}
 
-		RetVal = true;
+bool Subs::SubscriptionSession::ConfigureCallbackExecutor(const Coyote::CallbackExecutorConfig &Config)
+{
+	if (!this->Executor.Configure(Config.NumThreads, Config.QueueLimit)) return false;
+	
+	this->CoalesceMask = Config.Coalesce;
+	
+	return true;
+}
+
+static void DispatchChanges(const Subs::EventDispatcher &Dispatcher, const Coyote::StateEventType EType, const Coyote::ChangeSet &Changes)
+{ //Runs on the callback executor, handlers are free to call back into the session.
+	const Subs::SubscriberList<Coyote::PresetChangeHandler> &List { Dispatcher.PresetChange };
+	
+	if (List.Empty()) return;
+	
+	for (const int32_t PK : Changes.Added) List.Invoke(EType, PK, Coyote::COYOTE_CHANGE_ADDED, 0u);
+	for (const int32_t PK : Changes.Removed) List.Invoke(EType, PK, Coyote::COYOTE_CHANGE_REMOVED, 0u);
+	for (const Coyote::PKChange &Change : Changes.Modified) List.Invoke(EType, Change.PK, Coyote::COYOTE_CHANGE_MODIFIED, Change.ChangedFields);
+}
+
+bool Subs::SubscriptionSession::ProcessSubscriptionEvent(const std::unordered_map<std::string, msgpack::object> &Values)
+{
+	typedef bool (SubscriptionSession::*EventHandlerFunc)(const msgpack::object &Data, bool &Changed);
+	
+	static const EventHandlerFunc Handlers[] =
+	{ //Indexed by Subs::EventID
+		&SubscriptionSession::HandleTimeCode,
+		&SubscriptionSession::HandleMiniviewPost,
+		&SubscriptionSession::HandlePresetsUpdate,
+		&SubscriptionSession::HandlePresetStatesUpdate,
+		&SubscriptionSession::HandleAssetSync,
+		&SubscriptionSession::HandleAssetDelete,
+		&SubscriptionSession::HandleAssetPost,
+		&SubscriptionSession::HandleKonaHardwareStateUpdate,
+		&SubscriptionSession::HandlePlaybackEvent,
+	};
+	
+	static_assert(sizeof Handlers / sizeof *Handlers == NumEvents, "Handlers out of sync with Subs::EventID");
+	
+	const auto EventIter = Values.find("SubscriptionEvent");
+	const auto DataIter = Values.find("Data");
+	
+	if (EventIter == Values.end() || DataIter == Values.end()) return false; //Not a subscription event
+	
+	const msgpack::object &EventName { EventIter->second };
+	
+	if (EventName.type != msgpack::type::STR) return false;
+	
+	Subs::EventID ID = Subs::EventID::Max;
+	
+	if (!EventTable.Lookup(EventName.via.str.ptr, EventName.via.str.size, ID))
+	{
+		LDEBUG_MSG("Invalid EventName " << std::string(EventName.via.str.ptr, EventName.via.str.size));
+		return false;
 	}
-	else if (EventName == "PresetsUpdate")
+	
+	const size_t Index = static_cast<size_t>(ID);
+	
+	if (EventSubscriptionFlags[Index] && !(this->Subscriptions.load() & EventSubscriptionFlags[Index])) return true; //Unsubscribed, see SetSubscriptions()
+	
+	bool Changed = false; //Stays false when an update turned out to be identical to what we had, so nobody gets woken up for nothing.
+	
+	const bool RetVal = (this->*Handlers[Index])(DataIter->second, Changed);
+	
+	const Coyote::StateEventType EType = EventStateTypes[Index];
+	
+	if (EType == Coyote::COYOTE_STATE_INVALID) return RetVal;
+	
+	//Live now, even when it matched the cache exactly and nothing changed.
+	if (EventReplacesState[Index]) this->FromCache.fetch_and(~(1u << EType));
+	
+	if (!Changed)
 	{
-		std::vector<msgpack::object> PresetObjects;
+		LDEBUG_MSG("No changes from " << EventNames[Index] << ", not invoking state callbacks");
+		return RetVal;
+	}
+	
+	this->BumpVersion(EType);
+	
+	if (this->CacheWriter && EType != Coyote::COYOTE_STATE_TIMECODE) this->CacheWriter->NoteChanged();
+	
+	LDEBUG_MSG("Invoking state callbacks for EType " << EventNames[Index]);
+	if (!this->Dispatcher->StateEvent.Empty())
+	{
+		this->Post(Subs::EventID::Max, EType, Coyote::COYOTE_COALESCE_STATEEVENTS, [Dispatcher = this->Dispatcher, EType] { Dispatcher->StateEvent.Invoke(EType); });
+	}
+	
+	return RetVal;
+}
 
-		Values.at("Data").convert(PresetObjects);
+bool Subs::SubscriptionSession::HandleTimeCode(const msgpack::object &Data, bool &Changed)
+{
+	const std::chrono::steady_clock::time_point ReceivedAt { std::chrono::steady_clock::now() };
 	
-		const std::lock_guard<std::mutex> G { this->PresetsLock };
+	//The most frequent event by far. Decoding into a reused object keeps VUData's capacity, so this allocates nothing once warm.
+	static thread_local Coyote::TimeCode Scratch;
+	
+	//Unpacking only touches the keys that are present, so nothing from the last event may carry over into this one.
+	Scratch.PK = 0;
+	Scratch.Time = 0;
+	Scratch.VUData.clear();
+	
+	Data.convert(Scratch);
+	
+	this->TimeCodes.Store(Scratch, ReceivedAt);
+	
+	if (const std::shared_ptr<VUMeter::Engine> Meters = std::atomic_load(&this->VUMeters)) Meters->Feed(Scratch, ReceivedAt);
+	
+	Changed = true;
+	
+	if (!this->Dispatcher->TimeCode.Empty())
+	{
+		this->Post(Subs::EventID::TimeCode, static_cast<uint32_t>(Scratch.PK), Coyote::COYOTE_COALESCE_TIMECODE, [Dispatcher = this->Dispatcher, Value = Scratch] { Dispatcher->TimeCode.Invoke(Value); });
+	}
+	
+	return true;
+}
 
-		this->Presets.clear();
+bool Subs::SubscriptionSession::HandleMiniviewPost(const msgpack::object &Data, bool &Changed)
+{
+	std::unordered_map<std::string, msgpack::object> Map;
+	
+	Data.convert(Map);
+	
+	const int32_t PK = Map.at("PK").as<int32_t>();
+	const uint32_t CanvasIndex = Map.at("CanvasIndex").as<uint32_t>();
+	const uint32_t OutputNum = Map.at("OutputNum").as<uint32_t>();
+	const int32_t Width = Map.at("Width").as<int32_t>();
+	const int32_t Height = Map.at("Height").as<int32_t>();
+	const msgpack::object &BytesObj { Map.at("Bytes") };
+	
+	std::shared_ptr<std::vector<uint8_t> > Pixels;
+	
+	//Straight from the message into a recycled buffer. The msgpack zone dies with the message, so one copy is as low as it goes.
+	if (BytesObj.type == msgpack::type::BIN)
+	{
+		Pixels = this->Miniviews->Acquire(BytesObj.via.bin.size);
+		
+		if (BytesObj.via.bin.size) memcpy(Pixels->data(), BytesObj.via.bin.ptr, BytesObj.via.bin.size);
+	}
+	else
+	{ //Old servers sent an array of integers.
+		Pixels = this->Miniviews->Acquire(0u);
 		
-		for (auto Iter = PresetObjects.begin(); Iter != PresetObjects.end(); ++Iter)
+		BytesObj.convert(*Pixels);
+	}
+	
+	Coyote::MiniviewFrame Frame { PK, CanvasIndex, OutputNum, Coyote::Size2D { Width, Height }, std::move(Pixels) };
+	
+	const uint32_t SlotID = this->Miniviews->Store(Frame);
+	
+	Changed = true;
+	
+	if (this->Dispatcher->Miniview.Empty() && this->Dispatcher->MiniviewFrame.Empty()) return true; //Still kept for GetLatestMiniviewFrame()
+	
+	//Keyed per slot, so while one is still waiting it just gets swapped for this newer frame and the stale one goes back to the pool.
+	this->Post(Subs::EventID::MiniviewPost, SlotID, Coyote::COYOTE_COALESCE_MINIVIEW,
+		[Dispatcher = this->Dispatcher, Pipe = this->Miniviews, Frame = std::move(Frame)] () mutable
 		{
-			std::unique_ptr<Coyote::Preset> Item { static_cast<Coyote::Preset*>(MsgpackProc::UnpackCoyoteObject(*Iter, typeid(Coyote::Preset))) };
+			Pipe->NoteDelivered(Frame);
 			
-			this->Presets.emplace(Item->PK, std::move(*Item));
-		}
+			//Done here rather than on receipt, so frames that got replaced while queued never cost anything.
+			if (!Dispatcher->MiniviewFrame.Empty()) Pipe->ApplyProcessing(Frame);
+			
+			Dispatcher->MiniviewFrame.Invoke(Frame);
+			Dispatcher->Miniview.Invoke(Frame.PK, Frame.CanvasIndex, Frame.OutputNum, Frame.Dimensions, Frame.Bytes());
+		});
+	
+	return true;
+}
+
+bool Subs::SubscriptionSession::HandlePresetsUpdate(const msgpack::object &Data, bool &Changed)
+{
+	std::unordered_map<int32_t, Coyote::Preset> Incoming { DecodeByPK<Coyote::Preset>(Data) };
+	Coyote::ChangeSet Changes;
+	Coyote::PresetsSnapshot Published;
+	
+	{
+		const std::lock_guard<std::mutex> G { this->PresetsLock };
+		
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_PRESETS)) return true; //Dropped while we were decoding, ClearState() has already run or is waiting on us.
+		
+		std::shared_ptr<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > > Next { std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > >() };
+		
+		Changes = DiffByPK(*this->Presets, std::move(Incoming), *Next);
 		
-		RetVal = true;
+		//A repeat of the same list publishes nothing, and GetLastChangeSet() keeps reporting the last real change.
+		if (!Changes.Empty())
+		{
+			Published = std::move(Next);
+			std::atomic_store(&this->Presets, Published);
+			this->LastPresetChanges = Changes;
+		}
 	}
-	else if (EventName == "PresetStatesUpdate")
+	
+	Changed = !Changes.Empty();
+	
+	if (Changed && !(this->Dispatcher->Presets.Empty() && this->Dispatcher->PresetChange.Empty()))
 	{
-		std::vector<msgpack::object> PStateObjects;
+		//Never coalesced, each ChangeSet is relative to the one before it.
+		this->Post(Subs::EventID::PresetsUpdate, 0u, Coyote::COYOTE_COALESCE_NONE, [Dispatcher = this->Dispatcher, Published, Changes]
+			{
+				Dispatcher->Presets.Invoke(Published, Changes);
+				DispatchChanges(*Dispatcher, Coyote::COYOTE_STATE_PRESETS, Changes);
+			});
+	}
+	
+	return true;
+}
 
-		Values.at("Data").convert(PStateObjects);
+bool Subs::SubscriptionSession::HandlePresetStatesUpdate(const msgpack::object &Data, bool &Changed)
+{
+	std::unordered_map<int32_t, Coyote::PresetState> Incoming { DecodeByPK<Coyote::PresetState>(Data) };
+	Coyote::ChangeSet Changes;
+	Coyote::PresetStatesSnapshot Published;
 	
+	{
 		const std::lock_guard<std::mutex> G { this->PresetStatesLock };
-
-		this->PresetStates.clear();
 		
-		for (auto Iter = PStateObjects.begin(); Iter != PStateObjects.end(); ++Iter)
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_PRESETSTATES)) return true;
+		
+		std::shared_ptr<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > > Next { std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > >() };
+		
+		Changes = DiffByPK(*this->PresetStates, std::move(Incoming), *Next);
+		
+		if (!Changes.Empty())
 		{
-			std::unique_ptr<Coyote::PresetState> Item { static_cast<Coyote::PresetState*>(MsgpackProc::UnpackCoyoteObject(*Iter, typeid(Coyote::PresetState))) };
-			
-			this->PresetStates.emplace(Item->PK, std::move(*Item));
+			Published = std::move(Next);
+			std::atomic_store(&this->PresetStates, Published);
+			this->LastPresetStateChanges = Changes;
 		}
-		
-		RetVal = true;
 	}
-	else if (EventName == "AssetSync")
+	
+	Changed = !Changes.Empty();
+	
+	if (Changed && !(this->Dispatcher->PresetStates.Empty() && this->Dispatcher->PresetChange.Empty()))
 	{
-		LDEBUG_MSG("Decoding assets");
-		std::vector<msgpack::object> AssetObjects;
+		//Never coalesced, each ChangeSet is relative to the one before it.
+		this->Post(Subs::EventID::PresetStatesUpdate, 0u, Coyote::COYOTE_COALESCE_NONE, [Dispatcher = this->Dispatcher, Published, Changes]
+			{
+				Dispatcher->PresetStates.Invoke(Published, Changes);
+				DispatchChanges(*Dispatcher, Coyote::COYOTE_STATE_PRESETSTATES, Changes);
+			});
+	}
+	
+	return true;
+}
 
-		Values.at("Data").convert(AssetObjects);
+bool Subs::SubscriptionSession::HandleAssetSync(const msgpack::object &Data, bool &Changed)
+{
+	LDEBUG_MSG("Decoding assets");
+	std::vector<Coyote::Asset> Items { DecodeArray<Coyote::Asset>(Data) };
+	
+	const Coyote::AssetCatalogSnapshot Published { Coyote::AssetCatalog::Build(std::move(Items)) };
 	
+	{
 		const std::lock_guard<std::mutex> G { this->AssetsLock };
-
-		this->Assets.clear();
 		
-		for (auto Iter = AssetObjects.begin(); Iter != AssetObjects.end(); ++Iter)
-		{
-			std::unique_ptr<Coyote::Asset> Item { static_cast<Coyote::Asset*>(MsgpackProc::UnpackCoyoteObject(*Iter, typeid(Coyote::Asset))) };
-			
-			this->Assets.emplace(Item->FullPath, std::move(*Item));
-		}
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_ASSETS)) return true;
 		
-		RetVal = true;
+		std::atomic_store(&this->Assets, Published);
 	}
-	else if (EventName == "AssetDelete")
+	
+	Changed = true;
+	
+	if (!this->Dispatcher->AssetSync.Empty())
 	{
-		LDEBUG_MSG("Decoding asset deletion request");
-		std::string FullPath;
+		this->Post(Subs::EventID::AssetSync, 0u, Coyote::COYOTE_COALESCE_ASSETSYNC, [Dispatcher = this->Dispatcher, Published] { Dispatcher->AssetSync.Invoke(Published->Flatten()); });
+	}
+	
+	return true;
+}
 
-		Values.at("Data").convert(FullPath);
+bool Subs::SubscriptionSession::HandleAssetDelete(const msgpack::object &Data, bool &Changed)
+{
+	LDEBUG_MSG("Decoding asset deletion request");
+	std::string FullPath;
+	
+	Data.convert(FullPath);
 	
+	{
 		const std::lock_guard<std::mutex> G { this->AssetsLock };
 		
-		if (this->Assets.count(FullPath))
-		{
-			LDEBUG_MSG("Found asset " << FullPath << " to delete, deleting.");
-			this->Assets.erase(FullPath);
-		}
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_ASSETS) || !this->Assets->Find(FullPath)) return true;
 		
-		RetVal = true;
+		LDEBUG_MSG("Found asset " << FullPath << " to delete, deleting.");
+		
+		std::atomic_store(&this->Assets, this->Assets->WithoutAsset(FullPath));
 	}
-	else if (EventName == "AssetPost")
+	
+	Changed = true;
+	
+	if (!this->Dispatcher->AssetDelete.Empty())
 	{
-		LDEBUG_MSG("Decoding asset post request");
-		
-		std::unique_ptr<Coyote::Asset> Ptr { static_cast<Coyote::Asset*>(MsgpackProc::UnpackCoyoteObject(Values.at("Data"), typeid(Coyote::Asset))) };
+		this->Post(Subs::EventID::AssetDelete, 0u, Coyote::COYOTE_COALESCE_NONE, [Dispatcher = this->Dispatcher, FullPath] { Dispatcher->AssetDelete.Invoke(FullPath); });
+	}
+	
+	return true;
+}
+
+bool Subs::SubscriptionSession::HandleAssetPost(const msgpack::object &Data, bool &Changed)
+{
+	LDEBUG_MSG("Decoding asset post request");
 	
+	std::unique_ptr<Coyote::Asset> Ptr { static_cast<Coyote::Asset*>(MsgpackProc::UnpackCoyoteObject(Data, typeid(Coyote::Asset))) };
+	
+	LDEBUG_MSG("Found asset " << Ptr->FullPath << " to add/update.");
+	
+	{
 		const std::lock_guard<std::mutex> G { this->AssetsLock };
 		
-		this->Assets[Ptr->FullPath] = std::move(*Ptr);
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_ASSETS)) return true;
 		
-		LDEBUG_MSG("Found asset " << Ptr->FullPath << " to add/update.");
-		
-		RetVal = true;
+		std::atomic_store(&this->Assets, this->Assets->WithAsset(*Ptr));
 	}
-	else if (EventName == "KonaHardwareStateUpdate")
+	
+	Changed = true;
+	
+	if (!this->Dispatcher->AssetPost.Empty())
+	{
+		this->Post(Subs::EventID::AssetPost, 0u, Coyote::COYOTE_COALESCE_NONE, [Dispatcher = this->Dispatcher, Value = std::move(*Ptr)] { Dispatcher->AssetPost.Invoke(Value); });
+	}
+	
+	return true;
+}
+
+bool Subs::SubscriptionSession::HandleKonaHardwareStateUpdate(const msgpack::object &Data, bool &Changed)
+{
+	std::unique_ptr<Coyote::KonaHardwareState> Ptr { static_cast<Coyote::KonaHardwareState*>(MsgpackProc::UnpackCoyoteObject(Data, typeid(Coyote::KonaHardwareState))) };
+	
+	const Coyote::HWStateSnapshot Published { std::make_shared<Coyote::KonaHardwareState>(std::move(*Ptr)) };
+	
 	{
 		const std::lock_guard<std::mutex> G { this->HWStateLock };
 		
-		std::unique_ptr<Coyote::KonaHardwareState> Ptr { static_cast<Coyote::KonaHardwareState*>(MsgpackProc::UnpackCoyoteObject(Values.at("Data"), typeid(Coyote::KonaHardwareState))) };
+		if (!this->StillSubscribed(Coyote::COYOTE_SUB_HWSTATE)) return true;
 		
-		this->HWState = std::move(*Ptr);
+		std::atomic_store(&this->HWState, Published);
+	}
+	
+	Changed = true;
+	
+	if (!this->Dispatcher->HWState.Empty())
+	{
+		this->Post(Subs::EventID::KonaHardwareStateUpdate, 0u, Coyote::COYOTE_COALESCE_HWSTATE, [Dispatcher = this->Dispatcher, Published] { Dispatcher->HWState.Invoke(Published); });
+	}
+	
+	return true;
+}
+
+bool Subs::SubscriptionSession::HandlePlaybackEvent(const msgpack::object &Data, bool &Changed)
+{
+	std::unordered_map<std::string, msgpack::object> DataObjs;
+	
+	Data.convert(DataObjs);
+	
+	const Coyote::PlaybackEventType EType = static_cast<Coyote::PlaybackEventType>(DataObjs.at("EType").as<int>());
+	const int32_t PK = DataObjs.at("PK").as<int32_t>();
+	const int32_t NewTime = DataObjs.count("NewTime") ? DataObjs.at("NewTime").as<int32_t>() : 0;
+	
+	if (!this->Dispatcher->PlaybackEvent.Empty())
+	{
+		this->Post(Subs::EventID::PlaybackEvent, 0u, Coyote::COYOTE_COALESCE_NONE, [Dispatcher = this->Dispatcher, EType, PK, NewTime] { Dispatcher->PlaybackEvent.Invoke(EType, PK, NewTime); });
+	}
+	
+	Changed = true;
+	
+	return true;
+}
+
+//These all hand out private copies for the older API. New code should use the Get*Snapshot() methods and skip the copy.
+Coyote::TimeCode *Subs::SubscriptionSession::GetTimeCode(const int32_t PK)
+{
+	std::unique_ptr<Coyote::TimeCode> RetVal { new Coyote::TimeCode{} };
+	
+	if (!this->TimeCodes.Load(PK, *RetVal)) return nullptr;
+	
+	return RetVal.release();
+}
+
+std::unordered_map<int32_t, Coyote::TimeCode> *Subs::SubscriptionSession::GetTimeCodesMap(void)
+{
+	return new std::unordered_map<int32_t, Coyote::TimeCode> { this->TimeCodes.LoadAll() };
+}
+
+bool Subs::SubscriptionSession::WantsEvent(const char *const EventName, const size_t Length) const
+{ //Unknown names get through, ProcessSubscriptionEvent() is where those are reported.
+	Subs::EventID ID = Subs::EventID::Max;
+	
+	if (!EventTable.Lookup(EventName, Length, ID)) return true;
+	
+	const uint32_t Flag = EventSubscriptionFlags[static_cast<size_t>(ID)];
+	
+	return !Flag || (this->Subscriptions.load() & Flag);
+}
+
+uint32_t Subs::SubscriptionSession::SetSubscriptions(const uint32_t Flags)
+{
+	const uint32_t Previous = this->Subscriptions.exchange(Flags);
+	const uint32_t Removed = Previous & ~Flags;
+	
+	//Nothing will keep these current anymore, so let their memory go rather than serving stale state.
+	if (Removed & Coyote::COYOTE_SUB_ASSETS) this->ClearState(Coyote::COYOTE_STATE_ASSETS);
+	if (Removed & Coyote::COYOTE_SUB_PRESETS) this->ClearState(Coyote::COYOTE_STATE_PRESETS);
+	if (Removed & Coyote::COYOTE_SUB_PRESETSTATES) this->ClearState(Coyote::COYOTE_STATE_PRESETSTATES);
+	if (Removed & Coyote::COYOTE_SUB_HWSTATE) this->ClearState(Coyote::COYOTE_STATE_HWSTATE);
+	
+	return Previous;
+}
+
+void Subs::SubscriptionSession::ClearState(const Coyote::StateEventType EType)
+{
+	switch (EType)
+	{
+		case Coyote::COYOTE_STATE_ASSETS:
+		{
+			const std::lock_guard<std::mutex> G { this->AssetsLock };
+			
+			std::atomic_store(&this->Assets, Coyote::AssetCatalogSnapshot{ std::make_shared<Coyote::AssetCatalog>() });
+			break;
+		}
+		case Coyote::COYOTE_STATE_PRESETS:
+		{
+			const std::lock_guard<std::mutex> G { this->PresetsLock };
+			
+			std::atomic_store(&this->Presets, Coyote::PresetsSnapshot{ std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > >() });
+			this->LastPresetChanges = {};
+			break;
+		}
+		case Coyote::COYOTE_STATE_PRESETSTATES:
+		{
+			const std::lock_guard<std::mutex> G { this->PresetStatesLock };
+			
+			std::atomic_store(&this->PresetStates, Coyote::PresetStatesSnapshot{ std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > >() });
+			this->LastPresetStateChanges = {};
+			break;
+		}
+		case Coyote::COYOTE_STATE_HWSTATE:
+		{
+			const std::lock_guard<std::mutex> G { this->HWStateLock };
+			
+			std::atomic_store(&this->HWState, Coyote::HWStateSnapshot{ std::make_shared<Coyote::KonaHardwareState>() });
+			break;
+		}
+		default:
+			return;
+	}
+	
+	this->FromCache.fetch_and(~(1u << EType));
+	this->BumpVersion(EType);
+}
+
+void Subs::SubscriptionSession::EnableStateCache(const std::string &Directory)
+{
+	this->CacheWriter.reset(new StateCache::Writer { Directory, [this] (StateCache::CachedState &Out) { this->CaptureState(Out); } });
+}
+
+void Subs::SubscriptionSession::SetCacheIdentity(const std::string &GUID, const std::string &Host)
+{
+	if (this->CacheWriter) this->CacheWriter->SetIdentity(GUID, Host);
+}
+
+void Subs::SubscriptionSession::CaptureState(StateCache::CachedState &Out) const
+{ //Only what's subscribed, anything else is empty and would just wipe good state on the next load.
+	const uint32_t Flags = this->Subscriptions.load();
+	
+	for (const auto &Persisted : PersistedStates)
+	{
+		if (Flags & Persisted.Flag) Out.Contents |= 1u << Persisted.EType;
+	}
+	
+	if (Flags & Coyote::COYOTE_SUB_PRESETS)
+	{
+		const Coyote::PresetsSnapshot Snapshot { std::atomic_load(&this->Presets) };
 		
-		RetVal = true;
+		Out.Presets.reserve(Snapshot->size());
+		
+		for (const auto &Pair : *Snapshot) Out.Presets.push_back(*Pair.second);
 	}
-	else if (EventName == "PlaybackEvent")
+	
+	if (Flags & Coyote::COYOTE_SUB_PRESETSTATES)
 	{
-		std::unordered_map<std::string, msgpack::object> DataObjs;
+		const Coyote::PresetStatesSnapshot Snapshot { std::atomic_load(&this->PresetStates) };
+		
+		Out.PresetStates.reserve(Snapshot->size());
 		
-		Values.at("Data").convert(DataObjs);
+		for (const auto &Pair : *Snapshot) Out.PresetStates.push_back(*Pair.second);
+	}
+	
+	if (Flags & Coyote::COYOTE_SUB_ASSETS)
+	{
+		const Coyote::AssetCatalogSnapshot Catalog { std::atomic_load(&this->Assets) };
 		
-		const Coyote::PlaybackEventType EType = static_cast<Coyote::PlaybackEventType>(DataObjs.at("EType").as<int>());
-		const int32_t PK = DataObjs.at("PK").as<int32_t>();
-		const int32_t NewTime = DataObjs.count("NewTime") ? DataObjs.at("NewTime").as<int32_t>() : 0;
+		Out.Assets.reserve(Catalog->Size());
 		
-		if (this->UserPBEventCallback)
+		for (size_t Inc = 0u; Inc < Coyote::AssetCatalog::NumShards; ++Inc)
 		{
-			this->UserPBEventCallback(EType, PK, NewTime, this->UserPBEventData);
+			for (const auto &Pair : Catalog->Shard(Inc).Assets) Out.Assets.push_back(*Pair.second);
 		}
-		
-		RetVal = true;
 	}
-End:
+	
+	if (Flags & Coyote::COYOTE_SUB_HWSTATE) Out.HWState = *std::atomic_load(&this->HWState);
+}
 
-	if (CBMap.count(EventName))
+void Subs::SubscriptionSession::InstallCachedState(StateCache::CachedState &&State)
+{ //Runs before the first connection, so nothing live can be overwritten here.
+	const uint32_t Flags = this->Subscriptions.load();
+	
+	auto Wanted = [&State, Flags] (const Coyote::StateEventType EType, const uint32_t Flag) { return (State.Contents & (1u << EType)) && (Flags & Flag); };
+	
+	if (Wanted(Coyote::COYOTE_STATE_PRESETS, Coyote::COYOTE_SUB_PRESETS))
 	{
-		const auto &Struct { this->StateCallbacks[CBMap.at(EventName) - 1] };
+		std::shared_ptr<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > > Map { std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > >() };
 		
-		if (Struct.CB != nullptr)
+		for (Coyote::Preset &Item : State.Presets)
 		{
-			LDEBUG_MSG("Invoking callback for EType " << EventName);
-			Struct.CB(CBMap.at(EventName), Struct.UserData);
+			const int32_t PK = Item.PK;
+			
+			Map->emplace(PK, std::make_shared<const Coyote::Preset>(std::move(Item)));
 		}
+		
+		{
+			const std::lock_guard<std::mutex> G { this->PresetsLock };
+			
+			std::atomic_store(&this->Presets, Coyote::PresetsSnapshot{ std::move(Map) });
+		}
+		
+		this->FromCache.fetch_or(1u << Coyote::COYOTE_STATE_PRESETS);
+		this->BumpVersion(Coyote::COYOTE_STATE_PRESETS);
 	}
-	else
+	
+	if (Wanted(Coyote::COYOTE_STATE_PRESETSTATES, Coyote::COYOTE_SUB_PRESETSTATES))
 	{
-		LDEBUG_MSG("Invalid EventName " << EventName);
+		std::shared_ptr<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > > Map { std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > >() };
+		
+		for (Coyote::PresetState &Item : State.PresetStates)
+		{
+			const int32_t PK = Item.PK;
+			
+			Map->emplace(PK, std::make_shared<const Coyote::PresetState>(std::move(Item)));
+		}
+		
+		{
+			const std::lock_guard<std::mutex> G { this->PresetStatesLock };
+			
+			std::atomic_store(&this->PresetStates, Coyote::PresetStatesSnapshot{ std::move(Map) });
+		}
+		
+		this->FromCache.fetch_or(1u << Coyote::COYOTE_STATE_PRESETSTATES);
+		this->BumpVersion(Coyote::COYOTE_STATE_PRESETSTATES);
 	}
 	
-	return RetVal;
+	if (Wanted(Coyote::COYOTE_STATE_ASSETS, Coyote::COYOTE_SUB_ASSETS))
+	{
+		const Coyote::AssetCatalogSnapshot Catalog { Coyote::AssetCatalog::Build(std::move(State.Assets)) };
+		
+		{
+			const std::lock_guard<std::mutex> G { this->AssetsLock };
+			
+			std::atomic_store(&this->Assets, Catalog);
+		}
+		
+		this->FromCache.fetch_or(1u << Coyote::COYOTE_STATE_ASSETS);
+		this->BumpVersion(Coyote::COYOTE_STATE_ASSETS);
+	}
+	
+	if (Wanted(Coyote::COYOTE_STATE_HWSTATE, Coyote::COYOTE_SUB_HWSTATE))
+	{
+		{
+			const std::lock_guard<std::mutex> G { this->HWStateLock };
+			
+			std::atomic_store(&this->HWState, Coyote::HWStateSnapshot{ std::make_shared<Coyote::KonaHardwareState>(std::move(State.HWState)) });
+		}
+		
+		this->FromCache.fetch_or(1u << Coyote::COYOTE_STATE_HWSTATE);
+		this->BumpVersion(Coyote::COYOTE_STATE_HWSTATE);
+	}
 }
 
-Coyote::TimeCode *Subs::SubscriptionSession::GetTimeCode(const int32_t PK)
+void Subs::SubscriptionSession::DiscardCachedState(void)
 {
-	std::lock_guard<std::mutex> G { this->TimeCodesLock };
+	const uint32_t Cached = this->FromCache.load();
+	
+	for (const auto &Persisted : PersistedStates)
+	{
+		if (Cached & (1u << Persisted.EType)) this->ClearState(Persisted.EType);
+	}
+}
 
-	if (!this->TimeCodes.count(PK)) return nullptr;
+void Subs::SubscriptionSession::BumpVersion(const Coyote::StateEventType EType)
+{
+	this->StateVersions[EType].fetch_add(1u);
+	this->StateVersions[Coyote::COYOTE_STATE_INVALID].fetch_add(1u);
+	
+	//Pairs with the increment in WaitForStateChange(). Either the waiter sees the new version, or we see the waiter.
+	if (!this->VersionWaiters.load()) return;
+	
+	{ //Taking the lock means a waiter is either before its check or already asleep, never in between.
+		const std::lock_guard<std::mutex> G { this->VersionLock };
+	}
 	
-	return new Coyote::TimeCode{ this->TimeCodes[PK] };
+	this->VersionChanged.notify_all();
 }
 
-std::unordered_map<int32_t, Coyote::TimeCode> *Subs::SubscriptionSession::GetTimeCodesMap(void)
+uint64_t Subs::SubscriptionSession::GetStateVersion(const Coyote::StateEventType EType) const
 {
-	std::lock_guard<std::mutex> G { this->TimeCodesLock };
+	return this->StateVersions[EType].load();
+}
 
-	return new std::unordered_map<int32_t, Coyote::TimeCode> { this->TimeCodes }; //Copy, not move.
+bool Subs::SubscriptionSession::WaitForStateChange(const Coyote::StateEventType EType, const uint64_t LastSeenVersion, const std::chrono::milliseconds Timeout, uint64_t &VersionOut)
+{ //True if something newer than LastSeenVersion exists, false on timeout. VersionOut gets the current version either way.
+	const std::atomic<uint64_t> &Version { this->StateVersions[EType] };
+	
+	VersionOut = Version.load();
+	
+	if (VersionOut != LastSeenVersion || Timeout.count() <= 0) return VersionOut != LastSeenVersion;
+	
+	++this->VersionWaiters;
+	
+	{
+		std::unique_lock<std::mutex> Guard { this->VersionLock };
+		
+		this->VersionChanged.wait_for(Guard, Timeout, [&Version, LastSeenVersion] { return Version.load() != LastSeenVersion; });
+	}
+	
+	--this->VersionWaiters;
+	
+	VersionOut = Version.load();
+	
+	return VersionOut != LastSeenVersion;
+}
+
+Coyote::TimeCodesSnapshot Subs::SubscriptionSession::GetTimeCodesSnapshot(void) const
+{ //Timecodes live in the mailbox rather than a published map, so this one is built on demand.
+	return std::make_shared<std::unordered_map<int32_t, Coyote::TimeCode> >(this->TimeCodes.LoadAll());
 }
 
 std::unordered_map<std::string, Coyote::Asset> *Subs::SubscriptionSession::GetAssets(void)
 {
-	const std::lock_guard<std::mutex> G { this->AssetsLock };
-	
-	return new decltype(this->Assets) { this->Assets }; //Copy, not move.
+	return new std::unordered_map<std::string, Coyote::Asset> { *this->GetAssetsSnapshot() };
 }
 
 std::unordered_map<int32_t, Coyote::Preset> *Subs::SubscriptionSession::GetPresets(void)
 {
-	const std::lock_guard<std::mutex> G { this->PresetsLock };
-	
-	return new decltype(this->Presets) { this->Presets }; //Copy, not move.
+	return Unshare(*this->GetPresetsSnapshot());
 }
 
 std::unordered_map<int32_t, Coyote::PresetState> *Subs::SubscriptionSession::GetPresetStates(void)
 {
-	const std::lock_guard<std::mutex> G { this->PresetStatesLock };
-	
-	return new decltype(this->PresetStates) { this->PresetStates }; //Copy, not move.
+	return Unshare(*this->GetPresetStatesSnapshot());
 }
 
 Coyote::KonaHardwareState *Subs::SubscriptionSession::GetKonaHardwareState(void)
 {
-	const std::lock_guard<std::mutex> G { this->HWStateLock };
-	
-	return new Coyote::KonaHardwareState { this->HWState }; //Call copy constructor
+	return new Coyote::KonaHardwareState { *this->GetKonaHardwareStateSnapshot() }; //Call copy constructor
 }
 
 
+Coyote::Subscription Subs::SubscriptionSession::OnStateEvent(const Coyote::StateEventType EType, Coyote::StateEventHandler Handler)
+{ //COYOTE_STATE_INVALID subscribes to every state event type.
+	if (EType == Coyote::COYOTE_STATE_INVALID) return this->Subscribe(&EventDispatcher::StateEvent, std::move(Handler));
+	
+	return this->Subscribe(&EventDispatcher::StateEvent, Coyote::StateEventHandler { [EType, Handler] (const Coyote::StateEventType Fired)
+		{
+			if (Fired == EType) Handler(Fired);
+		} });
+}
+
+//The single-slot setters below keep their old replace-on-set semantics. Passing a null callback unregisters.
 void Subs::SubscriptionSession::SetStateEventCallback(const Coyote::StateEventType EType, const Coyote::StateEventCallback CB, void *const UserData)
 {
-	if (EType > Coyote::COYOTE_STATE_MAX || !EType)
+	if (EType >= Coyote::COYOTE_STATE_MAX || !EType)
 	{
 		LDEBUG_MSG("ERROR, state event type value " << (int)EType << " is greater than max value " << Coyote::COYOTE_STATE_MAX - 1);
 		return;
@@ -266,18 +894,96 @@ void Subs::SubscriptionSession::SetStateEventCallback(const Coyote::StateEventTy
 	
 	LDEBUG_MSG("Setting state event callback for EType " << EType);
 	
-	this->StateCallbacks[EType - 1] = { CB, UserData };
+	Coyote::Subscription &Slot { this->LegacyStateSubs[EType - 1] };
+	
+	if (!CB)
+	{
+		Slot.Reset();
+		return;
+	}
+	
+	Slot = this->OnStateEvent(EType, [CB, UserData] (const Coyote::StateEventType Fired) { CB(Fired, UserData); });
 }
 
 void Subs::SubscriptionSession::SetPlaybackEventCallback(const Coyote::PBEventCallback CB, void *const UserData)
 {
-	this->UserPBEventCallback = CB;
-	this->UserPBEventData = UserData;
+	if (!CB)
+	{
+		this->LegacyPBEventSub.Reset();
+		return;
+	}
+	
+	this->LegacyPBEventSub = this->OnPlaybackEvent([CB, UserData] (const Coyote::PlaybackEventType EType, const int32_t PK, const int32_t Time)
+		{
+			CB(EType, PK, Time, UserData);
+		});
 }
 
 void Subs::SubscriptionSession::SetMiniviewCallback(const Coyote::MiniviewCallback CB, void *const UserData)
 {
-	this->MiniviewCB = CB;
-	this->MiniviewCBData = UserData;
+	if (!CB)
+	{
+		this->LegacyMiniviewSub.Reset();
+		return;
+	}
+	
+	this->LegacyMiniviewSub = this->OnMiniview([CB, UserData] (const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, const Coyote::Size2D &Dimensions, const std::vector<uint8_t> &FrameData)
+		{
+			CB(PK, CanvasIndex, OutputNum, Dimensions, FrameData, UserData);
+		});
+}
+
+void Subs::SubscriptionSession::SetPresetChangeCallback(const Coyote::PresetChangeCallback CB, void *const UserData)
+{
+	if (!CB)
+	{
+		this->LegacyPresetChangeSub.Reset();
+		return;
+	}
+	
+	this->LegacyPresetChangeSub = this->OnPresetChange([CB, UserData] (const Coyote::StateEventType EType, const int32_t PK, const Coyote::ChangeKind Kind, const uint32_t ChangedFields)
+		{
+			CB(EType, PK, Kind, ChangedFields, UserData);
+		});
 }
 
+void Subs::SubscriptionSession::SetChangeSetCallback(const Coyote::ChangeSetCallback CB, void *const UserData)
+{
+	if (!CB)
+	{
+		this->LegacyChangeSetSubs[0].Reset();
+		this->LegacyChangeSetSubs[1].Reset();
+		return;
+	}
+	
+	this->LegacyChangeSetSubs[0] = this->OnPresets([CB, UserData] (const Coyote::PresetsSnapshot &, const Coyote::ChangeSet &Changes)
+		{
+			CB(Coyote::COYOTE_STATE_PRESETS, Changes, UserData);
+		});
+	
+	this->LegacyChangeSetSubs[1] = this->OnPresetStates([CB, UserData] (const Coyote::PresetStatesSnapshot &, const Coyote::ChangeSet &Changes)
+		{
+			CB(Coyote::COYOTE_STATE_PRESETSTATES, Changes, UserData);
+		});
+}
+
+bool Subs::SubscriptionSession::GetLastChangeSet(const Coyote::StateEventType EType, Coyote::ChangeSet &Out)
+{
+	switch (EType)
+	{
+		case Coyote::COYOTE_STATE_PRESETS:
+		{
+			const std::lock_guard<std::mutex> G { this->PresetsLock };
+			Out = this->LastPresetChanges;
+			return true;
+		}
+		case Coyote::COYOTE_STATE_PRESETSTATES:
+		{
+			const std::lock_guard<std::mutex> G { this->PresetStatesLock };
+			Out = this->LastPresetStateChanges;
+			return true;
+		}
+		default:
+			return false;
+	}
+}
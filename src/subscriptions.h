@@ -19,41 +19,196 @@
 #define MSGPACK_DEFAULT_API_VERSION 2
 #include "msgpack.hpp"
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include "include/common.h"
 #include "include/datastructures.h"
 #include "include/statuscodes.h"
+#include "include/eventsubscription.h"
+#include "include/assetcatalog.h"
+#include "callbackexecutor.h"
+#include "timecodemailbox.h"
+#include "miniviewpipeline.h"
+#include "vumeters.h"
+#include "statecache.h"
 
 namespace Subs
 {
-	struct StateEventCBSettings
-	{
-		Coyote::StateEventCallback CB;
-		void *UserData;
+	enum class EventID : uint8_t
+	{ //Order must match the handler table in ProcessSubscriptionEvent()
+		TimeCode = 0,
+		MiniviewPost,
+		PresetsUpdate,
+		PresetStatesUpdate,
+		AssetSync,
+		AssetDelete,
+		AssetPost,
+		KonaHardwareStateUpdate,
+		PlaybackEvent,
+		Max
+	};
+	
+	template <typename Func>
+	class SubscriberList
+	{ //Copy-on-write list, so a handler can subscribe or unsubscribe from inside a callback without deadlocking.
+	private:
+		struct Entry
+		{
+			uint64_t ID;
+			Func Handler;
+		};
+		
+		std::mutex WriteLock;
+		std::shared_ptr<const std::vector<Entry> > Entries;
+	public:
+		SubscriberList(void) : Entries(std::make_shared<std::vector<Entry> >()) {}
+		
+		void Add(const uint64_t ID, Func Handler)
+		{
+			const std::lock_guard<std::mutex> G { this->WriteLock };
+			
+			std::shared_ptr<std::vector<Entry> > New { std::make_shared<std::vector<Entry> >(*this->Entries) };
+			
+			New->push_back({ ID, std::move(Handler) });
+			
+			std::atomic_store(&this->Entries, std::shared_ptr<const std::vector<Entry> >{ std::move(New) });
+		}
+		
+		void Remove(const uint64_t ID)
+		{
+			const std::lock_guard<std::mutex> G { this->WriteLock };
+			
+			std::shared_ptr<std::vector<Entry> > New { std::make_shared<std::vector<Entry> >() };
+			New->reserve(this->Entries->size());
+			
+			for (const Entry &Item : *this->Entries)
+			{
+				if (Item.ID != ID) New->push_back(Item);
+			}
+			
+			std::atomic_store(&this->Entries, std::shared_ptr<const std::vector<Entry> >{ std::move(New) });
+		}
+		
+		inline bool Empty(void) const { return std::atomic_load(&this->Entries)->empty(); }
+		
+		template <typename... Args>
+		void Invoke(const Args&... Values) const
+		{
+			const std::shared_ptr<const std::vector<Entry> > Snapshot { std::atomic_load(&this->Entries) };
+			
+			for (const Entry &Item : *Snapshot)
+			{
+				Item.Handler(Values...);
+			}
+		}
+	};
+	
+	struct EventDispatcher
+	{ //Owned through a shared_ptr so Subscription handles can tell if the session is already gone.
+		std::atomic<uint64_t> NextID;
+		
+		SubscriberList<Coyote::TimeCodeHandler> TimeCode;
+		SubscriberList<Coyote::AssetPostHandler> AssetPost;
+		SubscriberList<Coyote::AssetDeleteHandler> AssetDelete;
+		SubscriberList<Coyote::AssetSyncHandler> AssetSync;
+		SubscriberList<Coyote::PresetsHandler> Presets;
+		SubscriberList<Coyote::PresetStatesHandler> PresetStates;
+		SubscriberList<Coyote::PresetChangeHandler> PresetChange;
+		SubscriberList<Coyote::HWStateHandler> HWState;
+		SubscriberList<Coyote::PlaybackEventHandler> PlaybackEvent;
+		SubscriberList<Coyote::MiniviewHandler> Miniview;
+		SubscriberList<Coyote::MiniviewFrameHandler> MiniviewFrame;
+		SubscriberList<Coyote::StateEventHandler> StateEvent;
+		
+		EventDispatcher(void) : NextID(1u) {}
 	};
 	
 	class SubscriptionSession
 	{
 	private:
-		std::mutex TimeCodesLock;
+		//State is published as immutable snapshots, swapped with std::atomic_store() and read with std::atomic_load().
+		//Readers never take these locks, they only keep two writers from losing each other's read-modify-publish.
 		std::mutex PresetsLock;
 		std::mutex PresetStatesLock;
 		std::mutex AssetsLock;
 		std::mutex HWStateLock;
-		std::unordered_map<int32_t, Coyote::TimeCode> TimeCodes;
-		std::unordered_map<int32_t, Coyote::Preset> Presets;
-		std::unordered_map<int32_t, Coyote::PresetState> PresetStates;
-		std::unordered_map<std::string, Coyote::Asset> Assets;
-		Coyote::KonaHardwareState HWState;
-		Coyote::PBEventCallback UserPBEventCallback;
-		void *UserPBEventData;
-		Coyote::MiniviewCallback MiniviewCB;
-		void *MiniviewCBData;
-		
-		StateEventCBSettings StateCallbacks[Coyote::COYOTE_STATE_MAX - 1];
+		Coyote::PresetsSnapshot Presets;
+		Coyote::PresetStatesSnapshot PresetStates;
+		Coyote::AssetCatalogSnapshot Assets; //Indexed, see assetcatalog.h
+		Coyote::HWStateSnapshot HWState;
+		TCMailbox::Mailbox TimeCodes; //Lock free, see timecodemailbox.h
+		std::shared_ptr<MiniviewPipe::Pipeline> Miniviews; //Shared with queued deliveries and the frames themselves
+		std::shared_ptr<VUMeter::Engine> VUMeters; //Atomic access only, null until enabled
+		Coyote::ChangeSet LastPresetChanges; //Protected by PresetsLock
+		Coyote::ChangeSet LastPresetStateChanges; //Protected by PresetStatesLock
+		
+		std::shared_ptr<EventDispatcher> Dispatcher;
 		
+		//The older single-slot callback setters are just subscriptions we hold on the user's behalf.
+		Coyote::Subscription LegacyStateSubs[Coyote::COYOTE_STATE_MAX - 1];
+		Coyote::Subscription LegacyPBEventSub;
+		Coyote::Subscription LegacyMiniviewSub;
+		Coyote::Subscription LegacyPresetChangeSub;
+		Coyote::Subscription LegacyChangeSetSubs[2];
+		
+		std::atomic<uint32_t> Subscriptions; //SubscriptionFlags. Events for feeds not in here are thrown away undecoded.
+		
+		//Bumped after every change has been published, indexed by StateEventType. COYOTE_STATE_INVALID counts changes of any kind.
+		std::atomic<uint64_t> StateVersions[Coyote::COYOTE_STATE_MAX];
+		std::atomic<uint32_t> VersionWaiters; //Lets BumpVersion() skip the lock when nobody is waiting.
+		std::mutex VersionLock;
+		std::condition_variable VersionChanged;
+		
+		void BumpVersion(const Coyote::StateEventType EType);
+		
+		std::atomic<uint32_t> FromCache; //1 << StateEventType for state still as loaded from disk, until the unit sends its own.
+		std::unique_ptr<StateCache::Writer> CacheWriter; //Set up before connecting, if at all. Destroyed before the state it saves.
+		
+		void CaptureState(StateCache::CachedState &Out) const;
+		void ClearState(const Coyote::StateEventType EType);
+
+		//Checked again under the publish lock, since SetSubscriptions() clears under that same lock after the flags change.
+		inline bool StillSubscribed(const uint32_t Flag) const { return this->Subscriptions.load() & Flag; }
+
+		//Subscriber lists are only ever invoked from here, never from the network thread directly.
+		std::atomic<uint32_t> CoalesceMask;
+		CallbackExec::Executor Executor; //Last member, so its workers are joined before anything they use is destroyed.
+		
+		void Post(const EventID ID, const uint64_t SubKey, const uint32_t CoalesceFlag, std::function<void(void)> Func);
+		
+		bool HandleTimeCode(const msgpack::object &Data, bool &Changed);
+		bool HandleMiniviewPost(const msgpack::object &Data, bool &Changed);
+		bool HandlePresetsUpdate(const msgpack::object &Data, bool &Changed);
+		bool HandlePresetStatesUpdate(const msgpack::object &Data, bool &Changed);
+		bool HandleAssetSync(const msgpack::object &Data, bool &Changed);
+		bool HandleAssetDelete(const msgpack::object &Data, bool &Changed);
+		bool HandleAssetPost(const msgpack::object &Data, bool &Changed);
+		bool HandleKonaHardwareStateUpdate(const msgpack::object &Data, bool &Changed);
+		bool HandlePlaybackEvent(const msgpack::object &Data, bool &Changed);
+		
+		template <typename Func>
+		Coyote::Subscription Subscribe(SubscriberList<Func> EventDispatcher::*List, typename std::common_type<Func>::type Handler)
+		{
+			const uint64_t ID = this->Dispatcher->NextID++;
+			
+			((*this->Dispatcher).*List).Add(ID, std::move(Handler));
+			
+			const std::weak_ptr<EventDispatcher> Weak { this->Dispatcher };
+			
+			return Coyote::Subscription { [Weak, List, ID] (void)
+				{
+					if (const std::shared_ptr<EventDispatcher> Strong = Weak.lock()) ((*Strong).*List).Remove(ID);
+				} };
+		}
+	
 	public:
 		bool ProcessSubscriptionEvent(const std::unordered_map<std::string, msgpack::object> &Values);
+		bool WantsEvent(const char *const EventName, const size_t Length) const;
+		uint32_t SetSubscriptions(const uint32_t Flags); //Returns the previous flags
+		inline uint32_t GetSubscriptions(void) const { return this->Subscriptions.load(); }
+		uint64_t GetStateVersion(const Coyote::StateEventType EType) const;
+		bool WaitForStateChange(const Coyote::StateEventType EType, const uint64_t LastSeenVersion, const std::chrono::milliseconds Timeout, uint64_t &VersionOut);
 		Coyote::TimeCode *GetTimeCode(const int32_t PK);
 		std::unordered_map<int32_t, Coyote::TimeCode> *GetTimeCodesMap(void);
 		std::unordered_map<int32_t, Coyote::Preset> *GetPresets(void);
@@ -63,8 +218,74 @@ namespace Subs
 		void SetPlaybackEventCallback(const Coyote::PBEventCallback, void *const UserData = nullptr);
 		void SetMiniviewCallback(const Coyote::MiniviewCallback, void *const UserData = nullptr);
 		void SetStateEventCallback(const Coyote::StateEventType EType, const Coyote::StateEventCallback CB, void *const UserData);
+		void SetPresetChangeCallback(const Coyote::PresetChangeCallback CB, void *const UserData = nullptr);
+		void SetChangeSetCallback(const Coyote::ChangeSetCallback CB, void *const UserData = nullptr);
+		bool GetLastChangeSet(const Coyote::StateEventType EType, Coyote::ChangeSet &Out);
+		bool ConfigureCallbackExecutor(const Coyote::CallbackExecutorConfig &Config);
+		void EnableStateCache(const std::string &Directory);
+		void InstallCachedState(StateCache::CachedState &&State);
+		void SetCacheIdentity(const std::string &GUID, const std::string &Host);
+		void DiscardCachedState(void); //Anything not yet replaced by live state
+		inline bool IsStateFromCache(const Coyote::StateEventType EType) const { return this->FromCache.load() & (1u << EType); }
+		inline bool FlushStateCache(void) { return this->CacheWriter && this->CacheWriter->Flush(); }
+		inline Coyote::CallbackExecutorStats GetCallbackExecutorStats(void) const { return this->Executor.GetStats(); }
+		
+		Coyote::TimeCodesSnapshot GetTimeCodesSnapshot(void) const;
+		inline bool LoadTimeCode(const int32_t PK, Coyote::TimeCode &Out) const { return this->TimeCodes.Load(PK, Out); }
+		inline bool LoadTimeCodeHistory(const int32_t PK, std::vector<Coyote::TimeCodeSample> &Out) const { return this->TimeCodes.LoadHistory(PK, Out); }
+		inline bool ExtrapolateTimeCode(const int32_t PK, const std::chrono::steady_clock::time_point At, int32_t &TimeOut) const { return this->TimeCodes.Extrapolate(PK, At, TimeOut); }
+		inline void SetVUMeters(std::shared_ptr<VUMeter::Engine> Engine) { std::atomic_store(&this->VUMeters, std::move(Engine)); }
+		
+		inline bool LoadVUMeters(const int32_t PK, Coyote::VUMeterReading &Out) const
+		{
+			const std::shared_ptr<VUMeter::Engine> Engine { std::atomic_load(&this->VUMeters) };
+			
+			return Engine && Engine->Load(PK, Out);
+		}
+		
+		inline bool ResetVUMeters(const int32_t PK)
+		{
+			const std::shared_ptr<VUMeter::Engine> Engine { std::atomic_load(&this->VUMeters) };
+			
+			return Engine && Engine->RequestReset(PK);
+		}
+		inline Coyote::PresetsSnapshot GetPresetsSnapshot(void) const { return std::atomic_load(&this->Presets); }
+		inline Coyote::PresetStatesSnapshot GetPresetStatesSnapshot(void) const { return std::atomic_load(&this->PresetStates); }
+		inline Coyote::AssetCatalogSnapshot GetAssetCatalog(void) const { return std::atomic_load(&this->Assets); }
+		inline Coyote::AssetsSnapshot GetAssetsSnapshot(void) const { return this->GetAssetCatalog()->Flatten(); }
+		inline Coyote::HWStateSnapshot GetKonaHardwareStateSnapshot(void) const { return std::atomic_load(&this->HWState); }
+		
+		inline Coyote::Subscription OnTimeCode(Coyote::TimeCodeHandler Handler) { return this->Subscribe(&EventDispatcher::TimeCode, std::move(Handler)); }
+		inline Coyote::Subscription OnAssetPost(Coyote::AssetPostHandler Handler) { return this->Subscribe(&EventDispatcher::AssetPost, std::move(Handler)); }
+		inline Coyote::Subscription OnAssetDelete(Coyote::AssetDeleteHandler Handler) { return this->Subscribe(&EventDispatcher::AssetDelete, std::move(Handler)); }
+		inline Coyote::Subscription OnAssetSync(Coyote::AssetSyncHandler Handler) { return this->Subscribe(&EventDispatcher::AssetSync, std::move(Handler)); }
+		inline Coyote::Subscription OnPresets(Coyote::PresetsHandler Handler) { return this->Subscribe(&EventDispatcher::Presets, std::move(Handler)); }
+		inline Coyote::Subscription OnPresetStates(Coyote::PresetStatesHandler Handler) { return this->Subscribe(&EventDispatcher::PresetStates, std::move(Handler)); }
+		inline Coyote::Subscription OnPresetChange(Coyote::PresetChangeHandler Handler) { return this->Subscribe(&EventDispatcher::PresetChange, std::move(Handler)); }
+		inline Coyote::Subscription OnKonaHardwareState(Coyote::HWStateHandler Handler) { return this->Subscribe(&EventDispatcher::HWState, std::move(Handler)); }
+		inline Coyote::Subscription OnPlaybackEvent(Coyote::PlaybackEventHandler Handler) { return this->Subscribe(&EventDispatcher::PlaybackEvent, std::move(Handler)); }
+		inline Coyote::Subscription OnMiniview(Coyote::MiniviewHandler Handler) { return this->Subscribe(&EventDispatcher::Miniview, std::move(Handler)); }
+		inline Coyote::Subscription OnMiniviewFrame(Coyote::MiniviewFrameHandler Handler) { return this->Subscribe(&EventDispatcher::MiniviewFrame, std::move(Handler)); }
+		inline bool GetLatestMiniviewFrame(const int32_t PK, const uint32_t CanvasIndex, const uint32_t OutputNum, Coyote::MiniviewFrame &Out) const { return this->Miniviews->GetLatest(PK, CanvasIndex, OutputNum, Out); }
+		inline void ForgetMiniviews(const int32_t PK) { this->Miniviews->Forget(PK); }
+		inline Coyote::MiniviewStats GetMiniviewStats(void) const { return this->Miniviews->GetStats(); }
+		inline void SetMiniviewProcessing(std::shared_ptr<const Coyote::MiniviewProcessingConfig> Config) { this->Miniviews->SetProcessing(std::move(Config)); }
+		Coyote::Subscription OnStateEvent(const Coyote::StateEventType EType, Coyote::StateEventHandler Handler);
 		
-		SubscriptionSession() : HWState(), UserPBEventCallback(), UserPBEventData(), MiniviewCB(), MiniviewCBData(), StateCallbacks() { }
+		SubscriptionSession()
+			: Presets(std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::Preset> > >()),
+			PresetStates(std::make_shared<std::unordered_map<int32_t, std::shared_ptr<const Coyote::PresetState> > >()),
+			Assets(std::make_shared<Coyote::AssetCatalog>()),
+			HWState(std::make_shared<Coyote::KonaHardwareState>()),
+			Miniviews(std::make_shared<MiniviewPipe::Pipeline>()),
+			Dispatcher(std::make_shared<EventDispatcher>()),
+			Subscriptions(Coyote::COYOTE_SUB_ALL),
+			VersionWaiters(),
+			FromCache(),
+			CoalesceMask(Coyote::COYOTE_COALESCE_ALL)
+		{
+			for (std::atomic<uint64_t> &Version : this->StateVersions) Version.store(0u, std::memory_order_relaxed);
+		}
 	};
 }
 #endif //__LIBCOYOTE_SUBSCRIPTIONS_H__
@@ -0,0 +1,297 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "timecodemailbox.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr int64_t FitWindowNs = 3000000000ll; //Only samples this recent are used to estimate the playback rate
+static constexpr int64_t MaxExtrapolationNs = 1000000000ll; //If the server goes quiet, stop advancing after this long
+
+static inline size_t HomeSlot(const int32_t PK)
+{
+	return (static_cast<uint32_t>(PK) * 2654435761u) & (TCMailbox::MaxSlots - 1u);
+}
+
+static inline int64_t ToNs(const std::chrono::steady_clock::time_point Point)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Point.time_since_epoch()).count();
+}
+
+TCMailbox::Mailbox::Mailbox(void)
+{
+	for (Slot &Item : this->Slots)
+	{
+		Item.PK.store(EmptyPK, std::memory_order_relaxed);
+		Item.Published.store(false, std::memory_order_relaxed);
+		Item.Seq.store(0u, std::memory_order_relaxed);
+		Item.Time.store(0, std::memory_order_relaxed);
+		Item.NumVU.store(0u, std::memory_order_relaxed);
+		Item.HistoryCount.store(0u, std::memory_order_relaxed);
+	}
+}
+
+const TCMailbox::Mailbox::Slot *TCMailbox::Mailbox::Find(const int32_t PK) const
+{
+	for (size_t Probe = 0u, Index = HomeSlot(PK); Probe < MaxSlots; ++Probe, Index = (Index + 1u) & (MaxSlots - 1u))
+	{
+		const int32_t SlotPK = this->Slots[Index].PK.load(std::memory_order_acquire);
+		
+		if (SlotPK == PK) return this->Slots[Index].Published.load(std::memory_order_acquire) ? &this->Slots[Index] : nullptr;
+		if (SlotPK == EmptyPK) return nullptr;
+	}
+	
+	return nullptr;
+}
+
+TCMailbox::Mailbox::Slot *TCMailbox::Mailbox::Claim(const int32_t PK)
+{
+	for (size_t Probe = 0u, Index = HomeSlot(PK); Probe < MaxSlots; ++Probe, Index = (Index + 1u) & (MaxSlots - 1u))
+	{
+		int32_t Expected = EmptyPK;
+		
+		if (this->Slots[Index].PK.compare_exchange_strong(Expected, PK, std::memory_order_acq_rel) || Expected == PK) return &this->Slots[Index];
+	}
+	
+	return nullptr;
+}
+
+bool TCMailbox::Mailbox::Store(const Coyote::TimeCode &TC, const std::chrono::steady_clock::time_point ReceivedAt)
+{
+	if (TC.PK == EmptyPK) return false;
+	
+	Slot *const Target = this->Claim(TC.PK);
+	
+	if (!Target)
+	{
+		LDEBUG_MSG("Timecode mailbox is full, dropping timecode for PK " << TC.PK);
+		return false;
+	}
+	
+	const uint32_t Seq = Target->Seq.load(std::memory_order_relaxed);
+	
+	Target->Seq.store(Seq + 1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	
+	const uint32_t NumVU = static_cast<uint32_t>(std::min(TC.VUData.size(), MaxVUChannels));
+	
+	Target->Time.store(TC.Time, std::memory_order_relaxed);
+	Target->NumVU.store(NumVU, std::memory_order_relaxed);
+	
+	for (uint32_t Inc = 0u; Inc < NumVU; ++Inc) Target->VU[Inc].store(TC.VUData[Inc], std::memory_order_relaxed);
+	
+	const uint32_t Count = Target->HistoryCount.load(std::memory_order_relaxed);
+	const size_t Index = Count & (HistoryLength - 1u);
+	
+	Target->HistoryTime[Index].store(TC.Time, std::memory_order_relaxed);
+	Target->HistoryLocalNs[Index].store(ToNs(ReceivedAt), std::memory_order_relaxed);
+	Target->HistoryCount.store(Count + 1u, std::memory_order_relaxed);
+	
+	Target->Seq.store(Seq + 2u, std::memory_order_release);
+	Target->Published.store(true, std::memory_order_release);
+	
+	return true;
+}
+
+bool TCMailbox::Mailbox::Load(const int32_t PK, Coyote::TimeCode &Out) const
+{
+	const Slot *const Source = this->Find(PK);
+	
+	if (!Source) return false;
+	
+	Out.PK = PK;
+	Out.VUData.reserve(MaxVUChannels); //Keeps the retry loop below allocation free, and is a no-op when Out gets reused.
+	
+	while (true)
+	{
+		const uint32_t Before = Source->Seq.load(std::memory_order_acquire);
+		
+		if (Before & 1u) continue;
+		
+		Out.Time = Source->Time.load(std::memory_order_relaxed);
+		
+		const uint32_t NumVU = std::min<uint32_t>(Source->NumVU.load(std::memory_order_relaxed), MaxVUChannels);
+		
+		Out.VUData.resize(NumVU);
+		
+		for (uint32_t Inc = 0u; Inc < NumVU; ++Inc) Out.VUData[Inc] = Source->VU[Inc].load(std::memory_order_relaxed);
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		
+		if (Source->Seq.load(std::memory_order_relaxed) == Before) return true;
+	}
+}
+
+size_t TCMailbox::Mailbox::ReadHistory(const Slot &Source, int32_t (&Times)[HistoryLength], int64_t (&LocalNs)[HistoryLength])
+{ //Copies the ring out oldest first, returns how many samples are valid.
+	int32_t RawTimes[HistoryLength];
+	int64_t RawLocalNs[HistoryLength];
+	uint32_t Count;
+	
+	while (true)
+	{
+		const uint32_t Before = Source.Seq.load(std::memory_order_acquire);
+		
+		if (Before & 1u) continue;
+		
+		Count = Source.HistoryCount.load(std::memory_order_relaxed);
+		
+		for (size_t Inc = 0u; Inc < HistoryLength; ++Inc)
+		{
+			RawTimes[Inc] = Source.HistoryTime[Inc].load(std::memory_order_relaxed);
+			RawLocalNs[Inc] = Source.HistoryLocalNs[Inc].load(std::memory_order_relaxed);
+		}
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		
+		if (Source.Seq.load(std::memory_order_relaxed) == Before) break;
+	}
+	
+	const uint32_t Valid = std::min<uint32_t>(Count, HistoryLength);
+	
+	for (uint32_t Inc = 0u; Inc < Valid; ++Inc)
+	{
+		const size_t Index = (Count - Valid + Inc) & (HistoryLength - 1u);
+		
+		Times[Inc] = RawTimes[Index];
+		LocalNs[Inc] = RawLocalNs[Index];
+	}
+	
+	return Valid;
+}
+
+bool TCMailbox::Mailbox::LoadHistory(const int32_t PK, std::vector<Coyote::TimeCodeSample> &Out) const
+{ //Oldest first.
+	const Slot *const Source = this->Find(PK);
+	
+	if (!Source) return false;
+	
+	int32_t Times[HistoryLength];
+	int64_t LocalNs[HistoryLength];
+	
+	const size_t Count = ReadHistory(*Source, Times, LocalNs);
+	
+	Out.clear();
+	Out.reserve(Count);
+	
+	for (size_t Inc = 0u; Inc < Count; ++Inc)
+	{
+		const std::chrono::steady_clock::duration SinceEpoch { std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds{ LocalNs[Inc] }) };
+		
+		Out.push_back({ Times[Inc], std::chrono::steady_clock::time_point{ SinceEpoch } });
+	}
+	
+	return true;
+}
+
+bool TCMailbox::Mailbox::Extrapolate(const int32_t PK, const std::chrono::steady_clock::time_point At, int32_t &TimeOut) const
+{ //Called at display rate by clock overlays, so no allocation in here.
+	const Slot *const Source = this->Find(PK);
+	
+	if (!Source) return false;
+	
+	int32_t Times[HistoryLength];
+	int64_t LocalNs[HistoryLength];
+	
+	const size_t Count = ReadHistory(*Source, Times, LocalNs);
+	
+	if (!Count) return false;
+	
+	const size_t Last = Count - 1u;
+	
+	TimeOut = Times[Last];
+	
+	if (Count < 2u) return true;
+	
+	//Walk back to the start of the current run of steady forward playback.
+	//A pause, a rewind, or a jump that doesn't match the rate we're seeing now all end the run.
+	const int64_t LastLocalDelta = LocalNs[Last] - LocalNs[Last - 1u];
+	const int64_t LastServerDelta = static_cast<int64_t>(Times[Last]) - Times[Last - 1u];
+	
+	if (LastServerDelta <= 0 || LastLocalDelta <= 0) return true; //Paused or just seeked
+	
+	const double LastRate = static_cast<double>(LastServerDelta) / LastLocalDelta;
+	
+	size_t First = Last - 1u;
+	
+	while (First > 0u)
+	{
+		const int64_t LocalDelta = LocalNs[First] - LocalNs[First - 1u];
+		const int64_t ServerDelta = static_cast<int64_t>(Times[First]) - Times[First - 1u];
+		
+		if (LocalNs[Last] - LocalNs[First - 1u] > FitWindowNs || LocalDelta <= 0 || ServerDelta <= 0) break;
+		
+		const double Rate = static_cast<double>(ServerDelta) / LocalDelta;
+		
+		if (Rate < LastRate * 0.5 || Rate > LastRate * 2.0) break;
+		
+		--First;
+	}
+	
+	//Least squares over the run, which irons out network jitter in when each sample arrived.
+	//X is relative to the newest sample so the doubles keep their precision.
+	const size_t N = Count - First;
+	double MeanX = 0.0, MeanY = 0.0;
+	
+	for (size_t Inc = First; Inc < Count; ++Inc)
+	{
+		MeanX += static_cast<double>(LocalNs[Inc] - LocalNs[Last]);
+		MeanY += Times[Inc];
+	}
+	
+	MeanX /= N;
+	MeanY /= N;
+	
+	double Covariance = 0.0, Variance = 0.0;
+	
+	for (size_t Inc = First; Inc < Count; ++Inc)
+	{
+		const double DX = static_cast<double>(LocalNs[Inc] - LocalNs[Last]) - MeanX;
+		
+		Covariance += DX * (Times[Inc] - MeanY);
+		Variance += DX * DX;
+	}
+	
+	const double Slope = Variance > 0.0 ? Covariance / Variance : LastRate;
+	
+	if (Slope <= 0.0) return true;
+	
+	const int64_t AtNs = std::min(ToNs(At) - LocalNs[Last], MaxExtrapolationNs);
+	
+	const double Predicted = MeanY + Slope * (static_cast<double>(AtNs) - MeanX);
+	
+	TimeOut = static_cast<int32_t>(std::max<double>(INT32_MIN, std::min<double>(INT32_MAX, std::round(Predicted))));
+	
+	return true;
+}
+
+std::unordered_map<int32_t, Coyote::TimeCode> TCMailbox::Mailbox::LoadAll(void) const
+{
+	std::unordered_map<int32_t, Coyote::TimeCode> RetVal;
+	
+	for (const Slot &Item : this->Slots)
+	{
+		const int32_t PK = Item.PK.load(std::memory_order_acquire);
+		
+		if (PK == EmptyPK) continue;
+		
+		Coyote::TimeCode TC{};
+		
+		if (this->Load(PK, TC)) RetVal.emplace(PK, std::move(TC));
+	}
+	
+	return RetVal;
+}
@@ -0,0 +1,73 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef __LIBCOYOTE_TIMECODEMAILBOX_H__
+#define __LIBCOYOTE_TIMECODEMAILBOX_H__
+
+#include "include/common.h"
+#include "include/datastructures.h"
+
+#include <atomic>
+
+/**Latest timecode per PK, readable from any thread without locks or allocation.
+ * Each PK gets a fixed slot guarded by a sequence lock. The one writer (whatever thread applies subscription events) never waits,
+ * readers just retry if they raced a write. Slots are claimed on first use and never given back, PKs are few and long lived.
+ * Every slot also keeps a short ring of (server time, local receive time) samples, which is what extrapolation works from.**/
+
+namespace TCMailbox
+{
+	static constexpr size_t MaxSlots = 128; //Power of two
+	static constexpr int32_t EmptyPK = INT32_MIN;
+	static constexpr size_t MaxVUChannels = 64; //Anything past this is dropped
+	static constexpr size_t HistoryLength = 16; //Power of two
+	
+	class Mailbox
+	{
+	private:
+		struct Slot
+		{
+			std::atomic<int32_t> PK; //EmptyPK until claimed
+			std::atomic<bool> Published; //Claimed slots only show up to readers after their first write.
+			std::atomic<uint32_t> Seq; //Odd while a write is in progress
+			
+			//Everything below is only meaningful between two equal, even reads of Seq.
+			std::atomic<int32_t> Time;
+			std::atomic<uint32_t> NumVU;
+			std::atomic<int32_t> VU[MaxVUChannels];
+			std::atomic<uint32_t> HistoryCount;
+			std::atomic<int32_t> HistoryTime[HistoryLength];
+			std::atomic<int64_t> HistoryLocalNs[HistoryLength];
+		};
+		
+		Slot Slots[MaxSlots];
+		
+		const Slot *Find(const int32_t PK) const;
+		Slot *Claim(const int32_t PK);
+		static size_t ReadHistory(const Slot &Source, int32_t (&Times)[HistoryLength], int64_t (&LocalNs)[HistoryLength]);
+	public:
+		bool Store(const Coyote::TimeCode &TC, const std::chrono::steady_clock::time_point ReceivedAt = std::chrono::steady_clock::now());
+		bool Load(const int32_t PK, Coyote::TimeCode &Out) const;
+		bool LoadHistory(const int32_t PK, std::vector<Coyote::TimeCodeSample> &Out) const;
+		bool Extrapolate(const int32_t PK, const std::chrono::steady_clock::time_point At, int32_t &TimeOut) const;
+		std::unordered_map<int32_t, Coyote::TimeCode> LoadAll(void) const;
+		
+		Mailbox(void);
+		
+		Mailbox(const Mailbox &) = delete;
+		Mailbox &operator=(const Mailbox &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_TIMECODEMAILBOX_H__
@@ -0,0 +1,325 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#include "vumeters.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VUMETERS_SSE2
+#include <emmintrin.h>
+#endif
+
+static constexpr float MaxStepSeconds = 10.0f; //A feed that went quiet shouldn't make the next sample decay forever
+
+static inline size_t HomeSlot(const int32_t PK)
+{
+	return (static_cast<uint32_t>(PK) * 2654435761u) & (VUMeter::MaxSlots - 1u);
+}
+
+static inline int64_t ToNs(const std::chrono::steady_clock::time_point Point)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Point.time_since_epoch()).count();
+}
+
+namespace
+{
+	struct StepParams
+	{
+		float Decay; //Multiplier for this step
+		float Seconds; //Since the last sample
+		float Hold;
+		float Threshold;
+		float InvFilled; //1 / samples in the RMS window
+	};
+}
+
+#ifdef VUMETERS_SSE2
+static inline __m128 Select(const __m128 Mask, const __m128 IfSet, const __m128 IfClear)
+{
+	return _mm_or_ps(_mm_and_ps(Mask, IfSet), _mm_andnot_ps(Mask, IfClear));
+}
+#endif
+
+//Runs one sample through every channel, including ones the feed doesn't currently have, which just decay as silence.
+//Squares is the RMS ring row being replaced. Templated only so it can see the engine's private State.
+template <typename StateT>
+static void Step(StateT &Work, const float *Levels, float *Squares, float *RMSOut, const StepParams &Params)
+{
+#ifdef VUMETERS_SSE2
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 Decay = _mm_set1_ps(Params.Decay);
+	const __m128 Seconds = _mm_set1_ps(Params.Seconds);
+	const __m128 Hold = _mm_set1_ps(Params.Hold);
+	const __m128 Threshold = _mm_set1_ps(Params.Threshold);
+	const __m128 InvFilled = _mm_set1_ps(Params.InvFilled);
+	
+	for (size_t Inc = 0u; Inc < VUMeter::MaxChannels; Inc += 4u)
+	{
+		const __m128 Level = _mm_load_ps(Levels + Inc);
+		const __m128 Ballistic = _mm_max_ps(Level, _mm_mul_ps(_mm_load_ps(Work.Ballistic + Inc), Decay));
+		const __m128 Peak = _mm_load_ps(Work.Peak + Inc);
+		const __m128 HoldLeft = _mm_sub_ps(_mm_load_ps(Work.HoldLeft + Inc), Seconds);
+		
+		//A new peak restarts the hold. Once the hold runs out the peak rides down with the ballistic level.
+		const __m128 Hit = _mm_cmpge_ps(Level, Peak);
+		const __m128 Expired = _mm_cmple_ps(HoldLeft, Zero);
+		
+		_mm_store_ps(Work.Ballistic + Inc, Ballistic);
+		_mm_store_ps(Work.HoldLeft + Inc, Select(Hit, Hold, HoldLeft));
+		_mm_store_ps(Work.Peak + Inc, Select(Hit, Level, Select(Expired, Ballistic, Peak)));
+		
+		//Only count going into clipping, not every sample spent there. Subtracting an all-ones mask adds one.
+		const __m128 Clipping = _mm_cmpge_ps(Level, Threshold);
+		const __m128 Rising = _mm_andnot_ps(_mm_load_ps(Work.WasClipping + Inc), Clipping);
+		const __m128i Clips = _mm_load_si128(reinterpret_cast<const __m128i*>(Work.Clips + Inc));
+		
+		_mm_store_si128(reinterpret_cast<__m128i*>(Work.Clips + Inc), _mm_sub_epi32(Clips, _mm_castps_si128(Rising)));
+		_mm_store_ps(Work.WasClipping + Inc, Clipping);
+		
+		const __m128 Square = _mm_mul_ps(Level, Level);
+		const __m128 Sum = _mm_add_ps(_mm_load_ps(Work.SquareSum + Inc), _mm_sub_ps(Square, _mm_load_ps(Squares + Inc)));
+		
+		_mm_store_ps(Squares + Inc, Square);
+		_mm_store_ps(Work.SquareSum + Inc, Sum);
+		_mm_store_ps(RMSOut + Inc, _mm_sqrt_ps(_mm_mul_ps(_mm_max_ps(Sum, Zero), InvFilled)));
+	}
+#else
+	for (size_t Inc = 0u; Inc < VUMeter::MaxChannels; ++Inc)
+	{
+		const float Level = Levels[Inc];
+		const float Ballistic = std::max(Level, Work.Ballistic[Inc] * Params.Decay);
+		const bool Hit = Level >= Work.Peak[Inc];
+		const float HoldLeft = Work.HoldLeft[Inc] - Params.Seconds;
+		const bool Expired = HoldLeft <= 0.0f;
+		
+		Work.Ballistic[Inc] = Ballistic;
+		Work.HoldLeft[Inc] = Hit ? Params.Hold : HoldLeft;
+		Work.Peak[Inc] = Hit ? Level : (Expired ? Ballistic : Work.Peak[Inc]);
+		
+		const bool Clipping = Level >= Params.Threshold;
+		
+		if (Clipping && !Work.WasClipping[Inc]) ++Work.Clips[Inc];
+		
+		Work.WasClipping[Inc] = Clipping ? 1.0f : 0.0f;
+		
+		const float Square = Level * Level;
+		
+		Work.SquareSum[Inc] += Square - Squares[Inc];
+		Squares[Inc] = Square;
+		RMSOut[Inc] = std::sqrt(std::max(Work.SquareSum[Inc], 0.0f) * Params.InvFilled);
+	}
+#endif
+}
+
+static void LoadLevels(const Coyote::TimeCode &TC, const size_t NumChannels, float *Out)
+{ //Magnitudes as floats, zero padded out to MaxChannels.
+	alignas(16) int32_t Raw[VUMeter::MaxChannels] = {};
+	
+	if (NumChannels) memcpy(Raw, TC.VUData.data(), NumChannels * sizeof(int32_t));
+
+#ifdef VUMETERS_SSE2
+	const __m128 SignBit = _mm_set1_ps(-0.0f);
+	
+	for (size_t Inc = 0u; Inc < VUMeter::MaxChannels; Inc += 4u)
+	{
+		const __m128 Values = _mm_cvtepi32_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(Raw + Inc)));
+		
+		_mm_store_ps(Out + Inc, _mm_andnot_ps(SignBit, Values));
+	}
+#else
+	for (size_t Inc = 0u; Inc < VUMeter::MaxChannels; ++Inc) Out[Inc] = std::fabs(static_cast<float>(Raw[Inc]));
+#endif
+}
+
+bool VUMeter::Engine::CheckConfig(const Coyote::VUMeterConfig &Config)
+{
+	return Config.PeakHoldSeconds >= 0.0f && Config.DecayHalfLifeSeconds > 0.0f && Config.RMSWindow >= 1u && Config.RMSWindow <= MaxRMSWindow;
+}
+
+VUMeter::Engine::Engine(const Coyote::VUMeterConfig &Config) : Config(Config)
+{
+	for (Slot &Item : this->Slots)
+	{
+		Item.PK.store(EmptyPK, std::memory_order_relaxed);
+		Item.Published.store(false, std::memory_order_relaxed);
+		Item.ResetRequested.store(false, std::memory_order_relaxed);
+		Item.Seq.store(0u, std::memory_order_relaxed);
+		Item.NumChannels.store(0u, std::memory_order_relaxed);
+		Item.UpdatedNs.store(0, std::memory_order_relaxed);
+	}
+}
+
+const VUMeter::Engine::Slot *VUMeter::Engine::Find(const int32_t PK) const
+{
+	for (size_t Probe = 0u, Index = HomeSlot(PK); Probe < MaxSlots; ++Probe, Index = (Index + 1u) & (MaxSlots - 1u))
+	{
+		const int32_t SlotPK = this->Slots[Index].PK.load(std::memory_order_acquire);
+		
+		if (SlotPK == PK) return &this->Slots[Index];
+		if (SlotPK == EmptyPK) return nullptr;
+	}
+	
+	return nullptr;
+}
+
+VUMeter::Engine::Slot *VUMeter::Engine::Claim(const int32_t PK)
+{ //Only the writer claims, so no compare and swap needed here.
+	for (size_t Probe = 0u, Index = HomeSlot(PK); Probe < MaxSlots; ++Probe, Index = (Index + 1u) & (MaxSlots - 1u))
+	{
+		const int32_t SlotPK = this->Slots[Index].PK.load(std::memory_order_relaxed);
+		
+		if (SlotPK == PK) return &this->Slots[Index];
+		
+		if (SlotPK == EmptyPK)
+		{
+			this->Slots[Index].Work.reset(new State{});
+			this->Slots[Index].PK.store(PK, std::memory_order_release);
+			
+			return &this->Slots[Index];
+		}
+	}
+	
+	return nullptr;
+}
+
+void VUMeter::Engine::Feed(const Coyote::TimeCode &TC, const std::chrono::steady_clock::time_point ReceivedAt)
+{
+	if (TC.PK == EmptyPK) return;
+	
+	Slot *const Target = this->Claim(TC.PK);
+	
+	if (!Target)
+	{
+		LDEBUG_MSG("VU meter engine is full, dropping levels for PK " << TC.PK);
+		return;
+	}
+	
+	State &Work { *Target->Work };
+	
+	if (Target->ResetRequested.exchange(false, std::memory_order_acq_rel))
+	{ //Clipping state stays, a channel that's still clipping shouldn't count again straight away.
+		std::fill(std::begin(Work.Peak), std::end(Work.Peak), 0.0f);
+		std::fill(std::begin(Work.HoldLeft), std::end(Work.HoldLeft), 0.0f);
+		std::fill(std::begin(Work.Clips), std::end(Work.Clips), 0u);
+	}
+	
+	const size_t NumChannels = std::min(TC.VUData.size(), MaxChannels);
+	const int64_t NowNs = ToNs(ReceivedAt);
+	const uint32_t Window = this->Config.RMSWindow;
+	
+	const float Seconds = Work.LastNs ? std::max(0.0f, std::min(MaxStepSeconds, (NowNs - Work.LastNs) / 1e9f)) : 0.0f;
+	
+	Work.LastNs = NowNs;
+	Work.Filled = std::min(Work.Filled + 1u, Window);
+	
+	const StepParams Params { std::exp2(-Seconds / this->Config.DecayHalfLifeSeconds), Seconds, this->Config.PeakHoldSeconds, static_cast<float>(this->Config.ClipThreshold), 1.0f / Work.Filled };
+	
+	alignas(16) float Levels[MaxChannels];
+	alignas(16) float RMS[MaxChannels];
+	
+	LoadLevels(TC, NumChannels, Levels);
+	Step(Work, Levels, Work.Squares[Work.RingPos], RMS, Params);
+	
+	if (++Work.RingPos >= Window)
+	{ //Once per trip round the ring, add it all up again so rounding in the running sums never builds up.
+		Work.RingPos = 0u;
+		
+		std::fill(std::begin(Work.SquareSum), std::end(Work.SquareSum), 0.0f);
+		
+		for (uint32_t Row = 0u; Row < Window; ++Row)
+		{
+			for (size_t Inc = 0u; Inc < MaxChannels; ++Inc) Work.SquareSum[Inc] += Work.Squares[Row][Inc];
+		}
+	}
+	
+	const uint32_t Seq = Target->Seq.load(std::memory_order_relaxed);
+	
+	Target->Seq.store(Seq + 1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	
+	Target->NumChannels.store(static_cast<uint32_t>(NumChannels), std::memory_order_relaxed);
+	Target->UpdatedNs.store(NowNs, std::memory_order_relaxed);
+	
+	for (size_t Inc = 0u; Inc < NumChannels; ++Inc)
+	{
+		Target->Level[Inc].store(Levels[Inc], std::memory_order_relaxed);
+		Target->Ballistic[Inc].store(Work.Ballistic[Inc], std::memory_order_relaxed);
+		Target->Peak[Inc].store(Work.Peak[Inc], std::memory_order_relaxed);
+		Target->RMS[Inc].store(RMS[Inc], std::memory_order_relaxed);
+		Target->Clips[Inc].store(Work.Clips[Inc], std::memory_order_relaxed);
+	}
+	
+	Target->Seq.store(Seq + 2u, std::memory_order_release);
+	Target->Published.store(true, std::memory_order_release);
+}
+
+bool VUMeter::Engine::Load(const int32_t PK, Coyote::VUMeterReading &Out) const
+{
+	const Slot *const Source = this->Find(PK);
+	
+	if (!Source || !Source->Published.load(std::memory_order_acquire)) return false;
+	
+	Out.PK = PK;
+	
+	uint32_t NumChannels;
+	int64_t UpdatedNs;
+	
+	while (true)
+	{
+		const uint32_t Before = Source->Seq.load(std::memory_order_acquire);
+		
+		if (Before & 1u) continue;
+		
+		NumChannels = std::min<uint32_t>(Source->NumChannels.load(std::memory_order_relaxed), MaxChannels);
+		UpdatedNs = Source->UpdatedNs.load(std::memory_order_relaxed);
+		
+		for (uint32_t Inc = 0u; Inc < NumChannels; ++Inc)
+		{
+			Out.Level[Inc] = Source->Level[Inc].load(std::memory_order_relaxed);
+			Out.Ballistic[Inc] = Source->Ballistic[Inc].load(std::memory_order_relaxed);
+			Out.PeakHold[Inc] = Source->Peak[Inc].load(std::memory_order_relaxed);
+			Out.RMS[Inc] = Source->RMS[Inc].load(std::memory_order_relaxed);
+			Out.ClipCount[Inc] = Source->Clips[Inc].load(std::memory_order_relaxed);
+		}
+		
+		std::atomic_thread_fence(std::memory_order_acquire);
+		
+		if (Source->Seq.load(std::memory_order_relaxed) == Before) break;
+	}
+	
+	Out.NumChannels = NumChannels;
+	Out.UpdatedAt = std::chrono::steady_clock::time_point { std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds{ UpdatedNs }) };
+	
+	std::fill(Out.Level.begin() + NumChannels, Out.Level.end(), 0.0f);
+	std::fill(Out.Ballistic.begin() + NumChannels, Out.Ballistic.end(), 0.0f);
+	std::fill(Out.PeakHold.begin() + NumChannels, Out.PeakHold.end(), 0.0f);
+	std::fill(Out.RMS.begin() + NumChannels, Out.RMS.end(), 0.0f);
+	std::fill(Out.ClipCount.begin() + NumChannels, Out.ClipCount.end(), 0u);
+	
+	return true;
+}
+
+bool VUMeter::Engine::RequestReset(const int32_t PK)
+{
+	const Slot *const Target = this->Find(PK);
+	
+	if (!Target) return false;
+	
+	Target->ResetRequested.store(true, std::memory_order_release);
+	
+	return true;
+}
@@ -0,0 +1,90 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifndef __LIBCOYOTE_VUMETERS_H__
+#define __LIBCOYOTE_VUMETERS_H__
+
+#include "include/common.h"
+#include "include/datastructures.h"
+
+#include <atomic>
+
+/**Audio meters per PK, computed once from the timecode stream instead of by every screen that shows them.
+ * The thread applying subscription events feeds every TimeCode in. It keeps its own working state per PK as plain float arrays,
+ * one entry per channel, so each step runs across four channels at a time. Results are published under a sequence lock
+ * the same way the timecode mailbox does it, so readers never block the feed and never allocate.**/
+
+namespace VUMeter
+{
+	static constexpr size_t MaxSlots = 128; //Power of two
+	static constexpr size_t MaxChannels = Coyote::VUMeterReading::MaxChannels; //Multiple of 4
+	static constexpr size_t MaxRMSWindow = 64;
+	static constexpr int32_t EmptyPK = INT32_MIN;
+	
+	class Engine
+	{
+	private:
+		struct State
+		{ //Writer only. Every channel up to MaxChannels is always stepped, missing ones as silence.
+			alignas(16) float Ballistic[MaxChannels];
+			alignas(16) float Peak[MaxChannels];
+			alignas(16) float HoldLeft[MaxChannels]; //Seconds until Peak starts to fall
+			alignas(16) float WasClipping[MaxChannels]; //All bits set or clear, a comparison mask
+			alignas(16) float SquareSum[MaxChannels];
+			alignas(16) float Squares[MaxRMSWindow][MaxChannels];
+			alignas(16) uint32_t Clips[MaxChannels];
+			uint32_t RingPos;
+			uint32_t Filled;
+			int64_t LastNs;
+		};
+		
+		struct Slot
+		{
+			std::atomic<int32_t> PK; //EmptyPK until claimed
+			std::atomic<bool> Published;
+			mutable std::atomic<bool> ResetRequested; //Set by readers, acted on by the writer with the next sample
+			std::atomic<uint32_t> Seq; //Odd while a write is in progress
+			std::unique_ptr<State> Work; //Allocated by the writer on its first sample
+			
+			std::atomic<uint32_t> NumChannels;
+			std::atomic<int64_t> UpdatedNs;
+			std::atomic<float> Level[MaxChannels];
+			std::atomic<float> Ballistic[MaxChannels];
+			std::atomic<float> Peak[MaxChannels];
+			std::atomic<float> RMS[MaxChannels];
+			std::atomic<uint32_t> Clips[MaxChannels];
+		};
+		
+		const Coyote::VUMeterConfig Config;
+		Slot Slots[MaxSlots];
+		
+		const Slot *Find(const int32_t PK) const;
+		Slot *Claim(const int32_t PK);
+	public:
+		static bool CheckConfig(const Coyote::VUMeterConfig &Config);
+		
+		void Feed(const Coyote::TimeCode &TC, const std::chrono::steady_clock::time_point ReceivedAt); //Single writer only
+		bool Load(const int32_t PK, Coyote::VUMeterReading &Out) const;
+		bool RequestReset(const int32_t PK); //Clears clip counts and held peaks
+		
+		Engine(const Coyote::VUMeterConfig &Config);
+		
+		Engine(const Engine &) = delete;
+		Engine &operator=(const Engine &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_VUMETERS_H__
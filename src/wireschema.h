@@ -0,0 +1,327 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**Single source of truth for what travels over the wire.
+ * Every table that maps the enums below to strings (ResolutionMap, RefreshMap, the reverse lookups, the pycoyote enums)
+ * is expanded from these lists. Adding a mode means one line here plus its enumerator in statuscodes.h, in the same position.
+ * The static_asserts further down refuse to compile if the two drift apart.
+ * The struct field lists drive the msgpack members declared in datastructures.h and the attribute bindings in pycoyote.
+ * Private to the library, nothing in include/ may pull this in.**/
+
+#ifndef __LIBCOYOTE_WIRESCHEMA_H__
+#define __LIBCOYOTE_WIRESCHEMA_H__
+
+#include "include/common.h"
+#include "include/statuscodes.h"
+
+//X(EnumValue, WireText, Width, Height)
+#define COYOTE_RESOLUTION_SCHEMA(X) \
+	X(COYOTE_RES_INVALID,		"",				0,		0) \
+	X(COYOTE_RES_720P,			"720p",			1280,	720) \
+	X(COYOTE_RES_1080P,			"1080p",		1920,	1080) \
+	X(COYOTE_RES_1080I,			"1080i",		1920,	1080) \
+	X(COYOTE_RES_1080PSF,		"1080psf",		1920,	1080) \
+	X(COYOTE_RES_DCI_2048,		"DCI 2048",		2048,	1080) \
+	X(COYOTE_RES_DCI_2048PSF,	"DCI 2048psf",	2048,	1080) \
+	X(COYOTE_RES_2160P,			"2160p",		3840,	2160) \
+	X(COYOTE_RES_2160PSF,		"2160psf",		3840,	2160) \
+	X(COYOTE_RES_DCI_4096,		"DCI 4096",		4096,	2160) \
+	X(COYOTE_RES_DCI_4096PSF,	"DCI 4096psf",	4096,	2160)
+
+//X(EnumValue, WireText)
+#define COYOTE_REFRESH_SCHEMA(X) \
+	X(COYOTE_REFRESH_INVALID,	"") \
+	X(COYOTE_REFRESH_23_98,		"23.98") \
+	X(COYOTE_REFRESH_24,		"24") \
+	X(COYOTE_REFRESH_25,		"25") \
+	X(COYOTE_REFRESH_29_97,		"29.97") \
+	X(COYOTE_REFRESH_30,		"30") \
+	X(COYOTE_REFRESH_50,		"50") \
+	X(COYOTE_REFRESH_59_94,		"59.94") \
+	X(COYOTE_REFRESH_60,		"60")
+
+//KEY(KeyName), interned map keys for the compact wire encoding. A key's ID is its position here, starting at 1.
+//Append only! Peers agree on how many of these they both know during the handshake, so reordering breaks old servers.
+#define COYOTE_WIRE_KEY_SCHEMA(KEY) \
+	KEY(CommandName) KEY(CoyoteAPIVersion) KEY(MsgID) KEY(Data) KEY(StatusInt) KEY(StatusText) KEY(SubscriptionEvent) \
+	KEY(PK) KEY(Time) KEY(VUData) \
+	KEY(FullPath) KEY(Checksum) KEY(LastModified) KEY(TotalSize) KEY(CurrentSize) KEY(Status) \
+	KEY(TRT) KEY(CurrentLoop) KEY(IsPlaying) KEY(IsPaused) KEY(IsSelected) \
+	KEY(Name) KEY(Notes) KEY(Color) KEY(Gotos) KEY(Countdowns) KEY(Loop) KEY(Link) KEY(DissolveInMS) KEY(DissolveOutMS) \
+	KEY(FadeInMS) KEY(FadeOutMS) KEY(InPosition) KEY(OutPosition) KEY(Dissolve) KEY(FreezeAtEnd) KEY(Volume) KEY(SinkOptions) \
+	KEY(Canvases) KEY(TabDisplayOrder) KEY(ID) KEY(TimeMS) \
+	KEY(Assets) KEY(SinkTypes) KEY(Index) KEY(CanvasCfg) KEY(Dimensions) KEY(NumOutputs) KEY(Orientation) \
+	KEY(Width) KEY(Height) KEY(X) KEY(Y) KEY(Z) KEY(Depth) \
+	KEY(PinnedCoords) KEY(Hue) KEY(Saturation) KEY(Brightness) KEY(Contrast) \
+	KEY(Resolutions) KEY(RefreshRate) KEY(HDRMode) KEY(EOTFSetting) KEY(ConstLumin) KEY(AudioConfig) \
+	KEY(Mountpoint) KEY(Total) KEY(Used) KEY(Free) KEY(IsExternal) KEY(Filename) KEY(FileSize) KEY(IsDirectory) \
+	KEY(FilePath) KEY(FPS) KEY(VideoFormat) KEY(AudioFormat) KEY(ContainerFormat) KEY(Resolution) \
+	KEY(VBitrate) KEY(ABitrate) KEY(ASampleRate) KEY(AChannels) KEY(Duration) \
+	KEY(CanvasIndex) KEY(OutputNum) KEY(Bytes) KEY(EType) KEY(NewTime) \
+	KEY(UnitType) KEY(HostOS) KEY(SupportedSinks) \
+	KEY(IP) KEY(Subnet) KEY(AdapterID) KEY(CableConnected) KEY(UnitID) KEY(Type) KEY(Busy) KEY(IsAlive) \
+	KEY(FormatString) KEY(HorzValue) KEY(VertValue) KEY(Genlocked) KEY(TimeIndex) KEY(TabID)
+
+//F(Struct, Field), the fields a struct sends as a map, in wire order. Members with a custom packer in msgpackproc.cpp aren't listed.
+#define COYOTE_SIZE2D_FIELDS(F) F(Size2D, Width) F(Size2D, Height)
+#define COYOTE_COORDS2D_FIELDS(F) F(Coords2D, X) F(Coords2D, Y)
+#define COYOTE_RECT_FIELDS(F) COYOTE_SIZE2D_FIELDS(F) COYOTE_COORDS2D_FIELDS(F)
+#define COYOTE_CUBE_FIELDS(F) COYOTE_RECT_FIELDS(F) F(Cube, Z) F(Cube, Depth)
+
+#define COYOTE_PINNEDASSET_FIELDS(F) \
+	F(PinnedAsset, FullPath) F(PinnedAsset, PinnedCoords) F(PinnedAsset, Hue) F(PinnedAsset, Saturation) F(PinnedAsset, Brightness) F(PinnedAsset, Contrast)
+
+#define COYOTE_PROJECTORCANVASCONFIG_FIELDS(F) F(ProjectorCanvasConfig, Dimensions) F(ProjectorCanvasConfig, NumOutputs) //Orientation is custom
+#define COYOTE_CANVASINFO_FIELDS(F) F(CanvasInfo, Assets) F(CanvasInfo, SinkTypes) F(CanvasInfo, Index) //CanvasCfg is custom
+#define COYOTE_PRESETMARK_FIELDS(F) F(PresetMark, ID) F(PresetMark, TimeMS) F(PresetMark, Name)
+
+#define COYOTE_LANCOYOTE_FIELDS(F) \
+	F(LANCoyote, APIVersion) F(LANCoyote, CommunicatorVersion) F(LANCoyote, GUID) F(LANCoyote, Nickname) F(LANCoyote, CurrentRole) F(LANCoyote, Type)
+
+#define COYOTE_TIMECODE_FIELDS(F) F(TimeCode, PK) F(TimeCode, Time) F(TimeCode, VUData)
+#define COYOTE_DRIVE_FIELDS(F) F(Drive, Mountpoint) F(Drive, Total) F(Drive, Used) F(Drive, Free) F(Drive, IsExternal)
+
+#define COYOTE_ASSET_FIELDS(F) \
+	F(Asset, FullPath) F(Asset, Checksum) F(Asset, LastModified) F(Asset, TotalSize) F(Asset, CurrentSize) F(Asset, Status)
+
+#define COYOTE_ASSETMETADATA_FIELDS(F) \
+	F(AssetMetadata, FilePath) F(AssetMetadata, FPS) F(AssetMetadata, VideoFormat) F(AssetMetadata, AudioFormat) \
+	F(AssetMetadata, ContainerFormat) F(AssetMetadata, Resolution) F(AssetMetadata, TotalSize) F(AssetMetadata, VBitrate) \
+	F(AssetMetadata, ABitrate) F(AssetMetadata, ASampleRate) F(AssetMetadata, AChannels) F(AssetMetadata, Duration)
+
+#define COYOTE_EXTERNALASSET_FIELDS(F) F(ExternalAsset, Filename) F(ExternalAsset, FullPath) F(ExternalAsset, FileSize) F(ExternalAsset, IsDirectory)
+
+#define COYOTE_PRESETSTATE_FIELDS(F) \
+	F(PresetState, PK) F(PresetState, TRT) F(PresetState, CurrentLoop) F(PresetState, IsPlaying) F(PresetState, IsPaused) F(PresetState, IsSelected)
+
+//Canvases and TabDisplayOrder are custom
+#define COYOTE_PRESET_FIELDS(F) \
+	F(Preset, Name) F(Preset, Notes) F(Preset, Color) F(Preset, Gotos) F(Preset, Countdowns) F(Preset, PK) \
+	F(Preset, Loop) F(Preset, Link) F(Preset, DissolveInMS) F(Preset, DissolveOutMS) F(Preset, FadeInMS) F(Preset, FadeOutMS) \
+	F(Preset, InPosition) F(Preset, OutPosition) F(Preset, Dissolve) F(Preset, FreezeAtEnd) F(Preset, Volume) F(Preset, SinkOptions)
+
+//Resolutions, RefreshRate and AudioConfig are custom
+#define COYOTE_KONAHARDWARESTATE_FIELDS(F) F(KonaHardwareState, HDRMode) F(KonaHardwareState, EOTFSetting) F(KonaHardwareState, ConstLumin)
+
+#define COYOTE_NETWORKINFO_FIELDS(F) F(NetworkInfo, IP) F(NetworkInfo, Subnet) F(NetworkInfo, AdapterID) F(NetworkInfo, CableConnected)
+#define COYOTE_MIRROR_FIELDS(F) F(Mirror, UnitID) F(Mirror, IP) F(Mirror, Type) F(Mirror, Busy) F(Mirror, IsAlive)
+#define COYOTE_GENLOCKSETTINGS_FIELDS(F) F(GenlockSettings, FormatString) F(GenlockSettings, HorzValue) F(GenlockSettings, VertValue) F(GenlockSettings, Genlocked)
+
+#define COYOTE_LICENSINGSTATUS_FIELDS(F) \
+	F(LicensingStatus, LicenseKey) F(LicensingStatus, ProductName) F(LicensingStatus, UserName) F(LicensingStatus, LicenseMachineUUID) \
+	F(LicensingStatus, LicenseCaps) F(LicensingStatus, UsedSeats) F(LicensingStatus, TotalSeats) F(LicensingStatus, ValidLicense)
+
+#define COYOTE_WIRE_FIELD_COUNT(Struct, Field) + 1
+#define COYOTE_WIRE_FIELD_PACK(Struct, Field) Pack.pack_str(sizeof #Field - 1); Pack.pack_str_body(#Field, sizeof #Field - 1); Pack.pack(this->Field);
+#define COYOTE_WIRE_FIELD_UNPACK(Struct, Field) \
+	if (Key.size == sizeof #Field - 1 && !memcmp(Key.ptr, #Field, sizeof #Field - 1)) { Iter->val.convert(this->Field); continue; }
+#define COYOTE_WIRE_FIELD_OBJECT(Struct, Field) \
+	KV->key.type = msgpack::type::STR; KV->key.via.str.size = sizeof #Field - 1; KV->key.via.str.ptr = #Field; \
+	KV->val = msgpack::object(this->Field, Zone); ++KV;
+
+//Defines the members COYOTE_WIRE_MEMBERS declares, from one of the field lists above. Same wire format as MSGPACK_DEFINE_MAP, but unpacking
+//is one pass over the map comparing keys in place, where msgpack's own version copies every key into a std::string first. Unknown keys are skipped.
+#define COYOTE_WIRE_DEFINE(Struct, SCHEMA) \
+	void Coyote::Struct::msgpack_pack(msgpack::packer<msgpack::sbuffer> &Pack) const \
+	{ \
+		Pack.pack_map(0 SCHEMA(COYOTE_WIRE_FIELD_COUNT)); \
+		SCHEMA(COYOTE_WIRE_FIELD_PACK) \
+	} \
+	void Coyote::Struct::msgpack_unpack(const msgpack::object &Obj) \
+	{ \
+		if (Obj.type != msgpack::type::MAP) throw msgpack::type_error{}; \
+		const msgpack::object_kv *const End = Obj.via.map.ptr + Obj.via.map.size; \
+		for (const msgpack::object_kv *Iter = Obj.via.map.ptr; Iter != End; ++Iter) \
+		{ \
+			if (Iter->key.type != msgpack::type::STR) continue; \
+			const msgpack::object_str &Key = Iter->key.via.str; \
+			SCHEMA(COYOTE_WIRE_FIELD_UNPACK) \
+		} \
+	} \
+	void Coyote::Struct::msgpack_object(msgpack::object *Out, msgpack::zone &Zone) const \
+	{ \
+		const uint32_t NumFields = 0 SCHEMA(COYOTE_WIRE_FIELD_COUNT); \
+		msgpack::object_kv *KV = static_cast<msgpack::object_kv*>(Zone.allocate_align(sizeof(msgpack::object_kv) * NumFields)); \
+		Out->type = msgpack::type::MAP; \
+		Out->via.map.size = NumFields; \
+		Out->via.map.ptr = KV; \
+		SCHEMA(COYOTE_WIRE_FIELD_OBJECT) \
+	}
+
+namespace WireSchema
+{
+	constexpr uint32_t Hash(const char *Text, const size_t Length, const uint32_t Seed)
+	{ //FNV-1a with a seed folded in, good enough to find a collision-free seed for a dozen strings.
+		uint32_t Value = 2166136261u ^ Seed;
+
+		for (size_t Inc = 0u; Inc < Length; ++Inc)
+		{
+			Value ^= static_cast<uint8_t>(Text[Inc]);
+			Value *= 16777619u;
+		}
+
+		return Value ^ (Value >> 15);
+	}
+
+	constexpr size_t Length(const char *Text)
+	{
+		size_t Len = 0u;
+
+		while (Text[Len]) ++Len;
+
+		return Len;
+	}
+
+	template <typename EnumType, size_t NumEntries, size_t NumSlots>
+	struct PerfectTable
+	{
+		static_assert((NumSlots & (NumSlots - 1)) == 0, "NumSlots must be a power of two");
+		static_assert(NumSlots >= NumEntries, "Not enough slots for every entry");
+
+		const char *Texts[NumEntries];
+		size_t Lengths[NumEntries];
+		EnumType Values[NumEntries];
+		int Slots[NumSlots];
+		uint32_t Seed;
+
+		inline bool Lookup(const char *Text, const size_t Len, EnumType &Out) const
+		{
+			const int Index = this->Slots[Hash(Text, Len, this->Seed) & (NumSlots - 1)];
+
+			if (Index < 0 || this->Lengths[Index] != Len || memcmp(this->Texts[Index], Text, Len) != 0) return false;
+
+			Out = this->Values[Index];
+
+			return true;
+		}
+	};
+
+	template <typename EnumType, size_t NumEntries, size_t NumSlots>
+	constexpr PerfectTable<EnumType, NumEntries, NumSlots> BuildPerfectTable(const char *const (&Texts)[NumEntries], const EnumType (&Values)[NumEntries])
+	{ //Evaluated by the compiler. Walks seeds until every string lands in its own slot.
+		PerfectTable<EnumType, NumEntries, NumSlots> Table{};
+
+		for (uint32_t Seed = 0u; Seed < 100000u; ++Seed)
+		{
+			bool Collision = false;
+
+			for (size_t Inc = 0u; Inc < NumSlots; ++Inc) Table.Slots[Inc] = -1;
+
+			for (size_t Inc = 0u; Inc < NumEntries && !Collision; ++Inc)
+			{
+				Table.Texts[Inc] = Texts[Inc];
+				Table.Lengths[Inc] = Length(Texts[Inc]);
+				Table.Values[Inc] = Values[Inc];
+
+				const size_t Slot = Hash(Texts[Inc], Table.Lengths[Inc], Seed) & (NumSlots - 1);
+
+				if (Table.Slots[Slot] != -1) Collision = true;
+				else Table.Slots[Slot] = static_cast<int>(Inc);
+			}
+
+			if (!Collision)
+			{
+				Table.Seed = Seed;
+				return Table;
+			}
+		}
+
+		throw std::logic_error("No perfect hash seed found"); //Fails the constant evaluation, so this is a compile error.
+	}
+
+#define COYOTE_SCHEMA_TEXT(Value, Text, ...) Text,
+#define COYOTE_SCHEMA_VALUE(Value, ...) Coyote::Value,
+#define COYOTE_SCHEMA_CASE(Value, Text, ...) case Coyote::Value: return Text;
+
+	constexpr const char *const ResolutionTexts[] = { COYOTE_RESOLUTION_SCHEMA(COYOTE_SCHEMA_TEXT) };
+	constexpr Coyote::ResolutionMode ResolutionValues[] = { COYOTE_RESOLUTION_SCHEMA(COYOTE_SCHEMA_VALUE) };
+	constexpr const char *const RefreshTexts[] = { COYOTE_REFRESH_SCHEMA(COYOTE_SCHEMA_TEXT) };
+	constexpr Coyote::RefreshMode RefreshValues[] = { COYOTE_REFRESH_SCHEMA(COYOTE_SCHEMA_VALUE) };
+
+	template <typename EnumType, size_t NumEntries>
+	constexpr bool IsSequential(const EnumType (&Values)[NumEntries])
+	{ //Row N has to be enumerator N, otherwise a row pairs its text with the wrong mode.
+		for (size_t Inc = 0u; Inc < NumEntries; ++Inc)
+		{
+			if (static_cast<size_t>(Values[Inc]) != Inc) return false;
+		}
+
+		return true;
+	}
+
+	static_assert(sizeof ResolutionValues / sizeof *ResolutionValues == Coyote::COYOTE_RES_MAX, "COYOTE_RESOLUTION_SCHEMA and ResolutionMode have a different number of modes");
+	static_assert(sizeof RefreshValues / sizeof *RefreshValues == Coyote::COYOTE_REFRESH_MAX, "COYOTE_REFRESH_SCHEMA and RefreshMode have a different number of modes");
+	static_assert(IsSequential(ResolutionValues), "COYOTE_RESOLUTION_SCHEMA rows are out of order with ResolutionMode");
+	static_assert(IsSequential(RefreshValues), "COYOTE_REFRESH_SCHEMA rows are out of order with RefreshMode");
+
+	constexpr auto ResolutionTable = BuildPerfectTable<Coyote::ResolutionMode, sizeof ResolutionValues / sizeof *ResolutionValues, 32>(ResolutionTexts, ResolutionValues);
+	constexpr auto RefreshTable = BuildPerfectTable<Coyote::RefreshMode, sizeof RefreshValues / sizeof *RefreshValues, 16>(RefreshTexts, RefreshValues);
+
+	inline const char *ResolutionText(const Coyote::ResolutionMode Mode)
+	{ //Returns nullptr for values not in the schema, so callers can tell "invalid" apart from "unknown".
+		switch (Mode)
+		{
+			COYOTE_RESOLUTION_SCHEMA(COYOTE_SCHEMA_CASE)
+			default:
+				return nullptr;
+		}
+	}
+
+	inline const char *RefreshText(const Coyote::RefreshMode Mode)
+	{
+		switch (Mode)
+		{
+			COYOTE_REFRESH_SCHEMA(COYOTE_SCHEMA_CASE)
+			default:
+				return nullptr;
+		}
+	}
+
+#define COYOTE_SCHEMA_KEY_ENUM(Name) Name,
+#define COYOTE_SCHEMA_KEY_TEXT(Name) #Name,
+#define COYOTE_SCHEMA_KEY_VALUE(Name) WireKey::Name,
+
+	enum class WireKey : uint16_t
+	{
+		Invalid = 0,
+		COYOTE_WIRE_KEY_SCHEMA(COYOTE_SCHEMA_KEY_ENUM)
+		Max
+	};
+	
+	constexpr const char *const KeyTexts[] = { COYOTE_WIRE_KEY_SCHEMA(COYOTE_SCHEMA_KEY_TEXT) };
+	constexpr WireKey KeyValues[] = { COYOTE_WIRE_KEY_SCHEMA(COYOTE_SCHEMA_KEY_VALUE) };
+	constexpr uint16_t NumWireKeys = static_cast<uint16_t>(WireKey::Max) - 1;
+	
+	static_assert(NumWireKeys < 256, "Interned keys are sent as one byte IDs");
+	
+	constexpr auto KeyTable = BuildPerfectTable<WireKey, NumWireKeys, 2048>(KeyTexts, KeyValues);
+	
+	inline const char *KeyText(const uint16_t ID)
+	{ //ID as it appears on the wire, nullptr if we don't know it.
+		if (ID == 0 || ID > NumWireKeys) return nullptr;
+		
+		return KeyTexts[ID - 1];
+	}
+
+#undef COYOTE_SCHEMA_KEY_VALUE
+#undef COYOTE_SCHEMA_KEY_TEXT
+#undef COYOTE_SCHEMA_KEY_ENUM
+#undef COYOTE_SCHEMA_CASE
+#undef COYOTE_SCHEMA_VALUE
+#undef COYOTE_SCHEMA_TEXT
+}
+
+#endif //__LIBCOYOTE_WIRESCHEMA_H__
@@ -0,0 +1,192 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#include "wiretrace.h"
+
+#include <cstring>
+
+static inline size_t PutVarint(uint8_t *Out, uint64_t Value)
+{
+	size_t Written = 0u;
+	
+	do
+	{
+		uint8_t Byte = Value & 0x7Fu;
+		Value >>= 7u;
+		
+		if (Value) Byte |= 0x80u;
+		
+		Out[Written++] = Byte;
+	} while (Value);
+	
+	return Written;
+}
+
+static inline bool GetVarint(FILE *Desc, uint64_t &Out)
+{
+	Out = 0u;
+	
+	for (unsigned Shift = 0u; Shift < 64u; Shift += 7u)
+	{
+		const int Byte = fgetc(Desc);
+		
+		if (Byte == EOF) return false;
+		
+		Out |= static_cast<uint64_t>(Byte & 0x7F) << Shift;
+		
+		if (!(Byte & 0x80)) return true;
+	}
+	
+	return false;
+}
+
+bool WireTrace::Recorder::Open(const std::string &Path)
+{
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	if (this->Desc) fclose(this->Desc);
+	
+	this->Desc = fopen(Path.c_str(), "wb");
+	
+	if (!this->Desc) return false;
+	
+	//Most messages are small, so let stdio batch them instead of hitting the disk for each one.
+	this->Buffer.resize(WriteBufferSize);
+	setvbuf(this->Desc, this->Buffer.data(), _IOFBF, this->Buffer.size());
+	
+	const int64_t StartedAtUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	
+	uint8_t Header[HeaderSize] {};
+	
+	memcpy(Header, Magic, sizeof Magic);
+	Header[4] = FormatVersion;
+	
+	for (size_t Inc = 0u; Inc < sizeof StartedAtUs; ++Inc) Header[8 + Inc] = static_cast<uint8_t>(static_cast<uint64_t>(StartedAtUs) >> (Inc * 8u));
+	
+	this->Last = std::chrono::steady_clock::now();
+	
+	if (fwrite(Header, 1u, sizeof Header, this->Desc) != sizeof Header)
+	{
+		fclose(this->Desc);
+		this->Desc = nullptr;
+		return false;
+	}
+	
+	return true;
+}
+
+void WireTrace::Recorder::Write(const enum Direction Direction, const void *Data, const size_t Length)
+{
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	if (!this->Desc) return;
+	
+	//Timestamped under the lock, so offsets always go forward in file order.
+	const std::chrono::steady_clock::time_point Now { std::chrono::steady_clock::now() };
+	const uint64_t DeltaUs = std::chrono::duration_cast<std::chrono::microseconds>(Now - this->Last).count();
+	
+	this->Last = Now;
+	
+	uint8_t Prefix[1 + 10 + 10];
+	size_t PrefixLength = 0u;
+	
+	Prefix[PrefixLength++] = Direction;
+	PrefixLength += PutVarint(Prefix + PrefixLength, DeltaUs);
+	PrefixLength += PutVarint(Prefix + PrefixLength, Length);
+	
+	if (fwrite(Prefix, 1u, PrefixLength, this->Desc) != PrefixLength || fwrite(Data, 1u, Length, this->Desc) != Length)
+	{ //Most likely a full disk. Stop rather than leave a capture with holes in it.
+		std::cerr << "libcoyote: Failed to write traffic capture, stopping it" << std::endl;
+		fclose(this->Desc);
+		this->Desc = nullptr;
+	}
+}
+
+void WireTrace::Recorder::Close(void)
+{
+	const std::lock_guard<std::mutex> G { this->Lock };
+	
+	if (!this->Desc) return;
+	
+	fclose(this->Desc);
+	this->Desc = nullptr;
+}
+
+WireTrace::Recorder::~Recorder(void)
+{
+	this->Close();
+}
+
+bool WireTrace::Reader::Open(const std::string &Path)
+{
+	if (this->Desc) fclose(this->Desc);
+	
+	this->OffsetUs = 0u;
+	this->StartedAtUs = 0;
+	this->Desc = fopen(Path.c_str(), "rb");
+	
+	if (!this->Desc) return false;
+	
+	uint8_t Header[HeaderSize];
+	
+	if (fread(Header, 1u, sizeof Header, this->Desc) != sizeof Header || memcmp(Header, Magic, sizeof Magic) != 0 || Header[4] != FormatVersion)
+	{
+		fclose(this->Desc);
+		this->Desc = nullptr;
+		return false;
+	}
+	
+	uint64_t StartedAtUs = 0u;
+	
+	for (size_t Inc = 0u; Inc < sizeof StartedAtUs; ++Inc) StartedAtUs |= static_cast<uint64_t>(Header[8 + Inc]) << (Inc * 8u);
+	
+	this->StartedAtUs = static_cast<int64_t>(StartedAtUs);
+	
+	return true;
+}
+
+bool WireTrace::Reader::Next(Record &Out)
+{
+	if (!this->Desc) return false;
+	
+	const int Dir = fgetc(this->Desc);
+	uint64_t DeltaUs = 0u, Length = 0u;
+	
+	if (Dir == EOF || !GetVarint(this->Desc, DeltaUs) || !GetVarint(this->Desc, Length)) return false;
+	
+	if ((Dir != Incoming && Dir != Outgoing) || Length > MaxRecordSize)
+	{
+		LDEBUG_MSG("Corrupt record in traffic capture, giving up on it");
+		return false;
+	}
+	
+	Out.Body.resize(Length);
+	
+	if (fread(Out.Body.data(), 1u, Length, this->Desc) != Length) return false; //Capture was cut off mid write
+	
+	this->OffsetUs += DeltaUs;
+	
+	Out.Direction = static_cast<enum Direction>(Dir);
+	Out.OffsetUs = this->OffsetUs;
+	
+	return true;
+}
+
+WireTrace::Reader::~Reader(void)
+{
+	if (this->Desc) fclose(this->Desc);
+}
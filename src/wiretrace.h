@@ -0,0 +1,89 @@
+/*
+   Copyright 2022 Sonoran Video Systems
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+
+#ifndef __LIBCOYOTE_WIRETRACE_H__
+#define __LIBCOYOTE_WIRETRACE_H__
+
+#include "include/common.h"
+
+#include <cstdio>
+
+/**Raw WebSocket traffic captures, for reproducing problems and benchmarking the decode and subscription layers offline.
+ * A capture is append only: a fixed header, then one record per whole message in either direction.
+ * Each record is a direction byte, the microseconds since the previous record and the body length (both LEB128 varints),
+ * then the message body as msgpack, minus the length prefix. Nothing is decoded on the way in, so recording costs a memcpy per message.**/
+
+namespace WireTrace
+{
+	static constexpr char Magic[4] = { 'L', 'C', 'W', 'T' };
+	static constexpr uint8_t FormatVersion = 1;
+	static constexpr size_t HeaderSize = 16; //Magic, version, three reserved bytes, then the Unix start time in microseconds
+	static constexpr size_t WriteBufferSize = 256 * 1024;
+	static constexpr uint64_t MaxRecordSize = 1ull << 30; //Anything claiming to be bigger is a corrupt capture
+	
+	enum Direction : uint8_t
+	{
+		Incoming = 0,
+		Outgoing = 1,
+	};
+	
+	struct Record
+	{
+		enum Direction Direction;
+		uint64_t OffsetUs; //Since the capture started
+		std::vector<uint8_t> Body;
+	};
+	
+	class Recorder
+	{ //Shared by everything that sends or receives on a connection, so every method may be called from any thread.
+	private:
+		std::mutex Lock;
+		FILE *Desc;
+		std::chrono::steady_clock::time_point Last; //When the previous record was written
+		std::vector<char> Buffer; //For setvbuf()
+	public:
+		bool Open(const std::string &Path);
+		void Write(const enum Direction Direction, const void *Data, const size_t Length);
+		void Close(void);
+		
+		Recorder(void) : Desc() {}
+		~Recorder(void);
+		
+		Recorder(const Recorder &) = delete;
+		Recorder &operator=(const Recorder &) = delete;
+	};
+	
+	class Reader
+	{
+	private:
+		FILE *Desc;
+		uint64_t OffsetUs;
+		int64_t StartedAtUs;
+	public:
+		bool Open(const std::string &Path);
+		bool Next(Record &Out); //Reuses Out.Body's storage. False at the end or on a truncated record.
+		inline int64_t GetStartedAt(void) const { return this->StartedAtUs; } //Unix time in microseconds
+		
+		Reader(void) : Desc(), OffsetUs(), StartedAtUs() {}
+		~Reader(void);
+		
+		Reader(const Reader &) = delete;
+		Reader &operator=(const Reader &) = delete;
+	};
+}
+
+#endif //__LIBCOYOTE_WIRETRACE_H__